@@ -0,0 +1,182 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           bench_common.c
+ * @ingroup        Persistence key value store
+ * @brief          Latency recording and report of the benchmarks
+ * @see            bench_common.h
+ */
+
+#include "bench_common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+uint64_t benchNow(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+
+int benchLatencyInit(BenchLatency_s* lat, const char* name, size_t capacity)
+{
+   memset(lat, 0, sizeof(BenchLatency_s));
+   lat->name = name;
+   lat->capacity = capacity;
+   if (capacity > 0)
+   {
+      lat->samples = (uint64_t*) malloc(capacity * sizeof(uint64_t));
+      if (lat->samples == NULL)
+      {
+         return -1;
+      }
+   }
+   return 0;
+}
+
+
+/* bucket n holds the latencies < 2^n ns */
+static int histBucket(uint64_t ns)
+{
+   int bucket = 0;
+
+   while (ns > 0 && bucket < BENCH_HIST_BUCKETS - 1)
+   {
+      ns >>= 1;
+      bucket++;
+   }
+   return bucket;
+}
+
+
+void benchLatencyAdd(BenchLatency_s* lat, uint64_t ns)
+{
+   if (lat->count < lat->capacity)
+   {
+      lat->samples[lat->count++] = ns;
+      lat->hist[histBucket(ns)]++;
+   }
+}
+
+
+void benchLatencyMerge(BenchLatency_s* dst, const BenchLatency_s* src)
+{
+   size_t i;
+
+   for (i = 0; i < src->count; i++)
+   {
+      benchLatencyAdd(dst, src->samples[i]);
+   }
+}
+
+
+void benchLatencyReset(BenchLatency_s* lat)
+{
+   lat->count = 0;
+   memset(lat->hist, 0, sizeof(lat->hist));
+}
+
+
+void benchLatencyFree(BenchLatency_s* lat)
+{
+   free(lat->samples);
+   lat->samples = NULL;
+   lat->count = 0;
+   lat->capacity = 0;
+}
+
+
+static int compareSamples(const void* a, const void* b)
+{
+   uint64_t x = *(const uint64_t*) a;
+   uint64_t y = *(const uint64_t*) b;
+
+   return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+
+static uint64_t percentile(const BenchLatency_s* lat, double p)
+{
+   size_t idx = (size_t) (p * (double) lat->count);
+
+   if (idx >= lat->count)
+   {
+      idx = lat->count - 1;
+   }
+   return lat->samples[idx];
+}
+
+
+uint64_t benchLatencyPercentile(BenchLatency_s* lat, double p)
+{
+   if (lat->count == 0)
+   {
+      return 0;
+   }
+   qsort(lat->samples, lat->count, sizeof(uint64_t), compareSamples);
+   return percentile(lat, p);
+}
+
+
+void benchLatencyReport(FILE* out, const char* bench, const char* phase, BenchLatency_s* lat, uint64_t wallNs)
+{
+   uint64_t sum = 0;
+   double seconds = (double) wallNs / 1e9;
+   size_t i;
+   int b, first = 1;
+
+   if (lat->count == 0)
+   {
+      return;
+   }
+   for (i = 0; i < lat->count; i++)
+   {
+      sum += lat->samples[i];
+   }
+   if (wallNs == 0) //operations executed one after the other
+   {
+      seconds = (double) sum / 1e9;
+   }
+   qsort(lat->samples, lat->count, sizeof(uint64_t), compareSamples);
+
+   fprintf(out, "{\"bench\":\"%s\",\"phase\":\"%s\",\"op\":\"%s\",\"count\":%zu,\"seconds\":%.6f,\"ops_per_s\":%.1f,"
+           "\"mean_ns\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu,\"hist\":[",
+           bench, phase, lat->name, lat->count, seconds, (seconds > 0.0) ? (double) lat->count / seconds : 0.0,
+           (unsigned long long) (sum / lat->count), (unsigned long long) percentile(lat, 0.50),
+           (unsigned long long) percentile(lat, 0.99), (unsigned long long) percentile(lat, 0.999),
+           (unsigned long long) lat->samples[lat->count - 1]);
+   for (b = 0; b < BENCH_HIST_BUCKETS; b++)
+   {
+      if (lat->hist[b] > 0)
+      {
+         fprintf(out, "%s[%llu,%llu]", first ? "" : ",", (unsigned long long) (1ULL << b), (unsigned long long) lat->hist[b]);
+         first = 0;
+      }
+   }
+   fprintf(out, "]}\n");
+}
+
+
+uint64_t benchRandom(uint64_t* state)
+{
+   uint64_t x = *state;
+
+   x ^= x >> 12;
+   x ^= x << 25;
+   x ^= x >> 27;
+   *state = x;
+   return x * 0x2545F4914F6CDD1DULL;
+}
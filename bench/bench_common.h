@@ -0,0 +1,93 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           bench_common.h
+ * @ingroup        Persistence key value store
+ * @brief          Latency recording and report of the benchmarks
+ * @see
+ *
+ * Every benchmark writes its results as JSON lines to stdout, one object per phase and
+ * operation:
+ *   {"bench":"kvs_bench","phase":"mixed","op":"read","count":1000,"seconds":0.01,"ops_per_s":100000,
+ *    "mean_ns":..,"p50_ns":..,"p99_ns":..,"p999_ns":..,"max_ns":..,"hist":[[<upper bound ns>,<count>],...]}
+ * The histogram has log2 buckets, only non empty buckets are printed.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BENCH_HIST_BUCKETS 40
+
+typedef struct
+{
+   const char* name;
+   uint64_t* samples;     /* latency of every operation in ns */
+   size_t count;
+   size_t capacity;
+   uint64_t hist[BENCH_HIST_BUCKETS];
+} BenchLatency_s;
+
+/**
+ * @brief CLOCK_MONOTONIC in ns
+ */
+uint64_t benchNow(void);
+
+/**
+ * @brief prepare the recording of up to capacity operations
+ * @return 0 on success, -1 if there is not enough memory
+ */
+int benchLatencyInit(BenchLatency_s* lat, const char* name, size_t capacity);
+
+/**
+ * @brief record the latency of one operation (ignored if the capacity is reached)
+ */
+void benchLatencyAdd(BenchLatency_s* lat, uint64_t ns);
+
+/**
+ * @brief add all operations of src to dst
+ */
+void benchLatencyMerge(BenchLatency_s* dst, const BenchLatency_s* src);
+
+/**
+ * @brief latency below which the fraction p (0.0 - 1.0) of the recorded operations lies, sorts the samples
+ * @return latency in ns, 0 if no operation was recorded
+ */
+uint64_t benchLatencyPercentile(BenchLatency_s* lat, double p);
+
+void benchLatencyReset(BenchLatency_s* lat);
+void benchLatencyFree(BenchLatency_s* lat);
+
+/**
+ * @brief print the result of one operation as JSON line (nothing if no operation was recorded)
+ * @param bench name of the benchmark
+ * @param phase name of the phase
+ * @param wallNs duration of the phase, used for ops/s (0: sum of the recorded latencies)
+ */
+void benchLatencyReport(FILE* out, const char* bench, const char* phase, BenchLatency_s* lat, uint64_t wallNs);
+
+/**
+ * @brief small and fast pseudo random generator (xorshift64*), state must not be 0
+ */
+uint64_t benchRandom(uint64_t* state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_COMMON_H */
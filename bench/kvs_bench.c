@@ -0,0 +1,455 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           kvs_bench.c
+ * @ingroup        Persistence key value store
+ * @brief          Throughput and latency of the key value store in a single process
+ * @see            bench_common.h
+ *
+ * Phases:
+ * - populate: create the database and write every key once, then close it
+ * - mixed:    reopen the database (page cache cold or warm) and run a random mix of
+ *             read / write / delete / key list operations on the keys, take point in time
+ *             copies of the database (persComDbSnapshot), then close it
+ *
+ * Usage: kvs_bench [options], see usage()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <math.h>
+
+#include "persComDbAccess.h"
+#include "persComErrors.h"
+#include "bench_common.h"
+
+#define BENCH_NAME "kvs_bench"
+
+#define OPEN_CREATE        0x01
+#define OPEN_WRITE_THROUGH 0x02
+
+#define SNAPSHOTS          5
+
+typedef enum
+{
+   SizeFixed,
+   SizeUniform,
+   SizeExponential
+} SizeDistribution_e;
+
+typedef struct
+{
+   const char* path;
+   unsigned int keys;
+   unsigned int ops;
+   SizeDistribution_e sizeDist;
+   unsigned int sizeMin;
+   unsigned int sizeMax;
+   unsigned int readPct;
+   unsigned int deletePct;
+   unsigned int listPct;
+   int writeThrough;
+   int cold;
+   int keep;
+   uint64_t seed;
+} BenchConfig_s;
+
+static BenchConfig_s gConfig = { "/tmp/kvs_bench.db", 1000, 10000, SizeFixed, 64, 64, 80, 0, 0, 0, 0, 0, 1 };
+static unsigned long gErrors = 0;
+
+
+static void usage(const char* prog)
+{
+   fprintf(stderr, "Usage: %s [options]\n", prog);
+   fprintf(stderr, "  -d path       database (default %s, removed before and after the run)\n", gConfig.path);
+   fprintf(stderr, "  -k keys       number of keys (default %u)\n", gConfig.keys);
+   fprintf(stderr, "  -o ops        operations of the mixed phase (default %u)\n", gConfig.ops);
+   fprintf(stderr, "  -v size       value size: N, MIN-MAX (uniform) or exp:MEAN (default %u)\n", gConfig.sizeMin);
+   fprintf(stderr, "  -r pct        reads in the mixed phase (default %u)\n", gConfig.readPct);
+   fprintf(stderr, "  -x pct        deletes in the mixed phase (default %u)\n", gConfig.deletePct);
+   fprintf(stderr, "  -l pct        key list reads in the mixed phase (default %u), the rest are writes\n", gConfig.listPct);
+   fprintf(stderr, "  -w            write through (default write cached)\n");
+   fprintf(stderr, "  -c            cold page cache for the mixed phase (default warm)\n");
+   fprintf(stderr, "  -s seed       seed of the random generator (default %llu)\n", (unsigned long long) gConfig.seed);
+   fprintf(stderr, "  -K            keep the database\n");
+}
+
+
+static int parseSize(const char* arg)
+{
+   unsigned int a, b;
+
+   if (sscanf(arg, "exp:%u", &a) == 1)
+   {
+      gConfig.sizeDist = SizeExponential;
+      gConfig.sizeMin = a;
+      gConfig.sizeMax = PERS_DB_MAX_SIZE_KEY_DATA;
+   }
+   else if (sscanf(arg, "%u-%u", &a, &b) == 2)
+   {
+      gConfig.sizeDist = SizeUniform;
+      gConfig.sizeMin = a;
+      gConfig.sizeMax = b;
+   }
+   else if (sscanf(arg, "%u", &a) == 1)
+   {
+      gConfig.sizeDist = SizeFixed;
+      gConfig.sizeMin = gConfig.sizeMax = a;
+   }
+   else
+   {
+      return -1;
+   }
+   return (gConfig.sizeMin > 0 && gConfig.sizeMin <= gConfig.sizeMax && gConfig.sizeMax <= PERS_DB_MAX_SIZE_KEY_DATA) ? 0 : -1;
+}
+
+
+static int valueSize(uint64_t* rnd)
+{
+   uint64_t size;
+
+   switch (gConfig.sizeDist)
+   {
+      case SizeUniform:
+         size = gConfig.sizeMin + (benchRandom(rnd) % (gConfig.sizeMax - gConfig.sizeMin + 1));
+         break;
+      case SizeExponential:
+      {
+         /* inverse transform of a uniform value in (0, 1] */
+         double u = (double) ((benchRandom(rnd) >> 11) + 1) / 9007199254740992.0;
+
+         size = (uint64_t) (-log(u) * gConfig.sizeMin) + 1;
+         break;
+      }
+      default:
+         size = gConfig.sizeMin;
+         break;
+   }
+   return (int) ((size > gConfig.sizeMax) ? gConfig.sizeMax : size);
+}
+
+
+static void keyName(char* key, unsigned int idx)
+{
+   (void) snprintf(key, PERS_DB_MAX_LENGTH_KEY_NAME, "bench/key_%08u", idx);
+}
+
+
+static void countError(const char* op, int ret)
+{
+   if (gErrors++ == 0)
+   {
+      fprintf(stderr, "%s: first error: %s returned %d\n", BENCH_NAME, op, ret);
+   }
+}
+
+
+static void dropPageCache(const char* path)
+{
+   int fd = open(path, O_RDONLY);
+
+   if (fd >= 0)
+   {
+      (void) fdatasync(fd);
+      (void) posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+   }
+}
+
+
+static int openDb(unsigned char option, BenchLatency_s* lat)
+{
+   uint64_t start = benchNow();
+   int handle = persComDbOpen(gConfig.path, option | (gConfig.writeThrough ? OPEN_WRITE_THROUGH : 0));
+
+   benchLatencyAdd(lat, benchNow() - start);
+   if (handle < 0)
+   {
+      fprintf(stderr, "%s: opening %s failed: %d\n", BENCH_NAME, gConfig.path, handle);
+   }
+   return handle;
+}
+
+
+static void closeDb(int handle, BenchLatency_s* lat)
+{
+   uint64_t start = benchNow();
+   int ret = persComDbClose(handle);
+
+   benchLatencyAdd(lat, benchNow() - start);
+   if (ret < 0)
+   {
+      countError("close", ret);
+   }
+}
+
+
+static int runPopulate(char* value, uint64_t* rnd)
+{
+   BenchLatency_s openLat, writeLat, closeLat;
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME];
+   uint64_t writeStart, writeEnd;
+   unsigned int i;
+   int handle, ret;
+
+   if (benchLatencyInit(&openLat, "open", 1) != 0 || benchLatencyInit(&writeLat, "write", gConfig.keys) != 0
+       || benchLatencyInit(&closeLat, "close", 1) != 0)
+   {
+      return -1;
+   }
+
+   handle = openDb(OPEN_CREATE, &openLat);
+   if (handle < 0)
+   {
+      return -1;
+   }
+   writeStart = benchNow();
+   for (i = 0; i < gConfig.keys; i++)
+   {
+      uint64_t opStart;
+
+      keyName(key, i);
+      opStart = benchNow();
+      ret = persComDbWriteKey(handle, key, value, valueSize(rnd));
+      benchLatencyAdd(&writeLat, benchNow() - opStart);
+      if (ret < 0)
+      {
+         countError("write", ret);
+      }
+   }
+   writeEnd = benchNow();
+   closeDb(handle, &closeLat);
+
+   benchLatencyReport(stdout, BENCH_NAME, "populate", &openLat, 0);
+   benchLatencyReport(stdout, BENCH_NAME, "populate", &writeLat, writeEnd - writeStart);
+   benchLatencyReport(stdout, BENCH_NAME, "populate", &closeLat, 0);
+   benchLatencyFree(&openLat);
+   benchLatencyFree(&writeLat);
+   benchLatencyFree(&closeLat);
+   return 0;
+}
+
+
+static void warmUp(int handle, char* buffer)
+{
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME];
+   unsigned int i;
+
+   for (i = 0; i < gConfig.keys; i++)
+   {
+      keyName(key, i);
+      (void) persComDbReadKey(handle, key, buffer, PERS_DB_MAX_SIZE_KEY_DATA);
+   }
+}
+
+
+static int runMixed(char* value, char* buffer, uint64_t* rnd)
+{
+   BenchLatency_s openLat, readLat, writeLat, deleteLat, listLat, snapshotLat, closeLat, allLat;
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME];
+   char snapshotPath[PERS_DB_MAX_LENGTH_KEY_NAME + 256];
+   char* listBuffer = NULL;
+   uint64_t mixStart, mixEnd;
+   unsigned int i;
+   int handle, ret;
+
+   if (benchLatencyInit(&openLat, "open", 1) != 0 || benchLatencyInit(&readLat, "read", gConfig.ops) != 0
+       || benchLatencyInit(&writeLat, "write", gConfig.ops) != 0 || benchLatencyInit(&deleteLat, "delete", gConfig.ops) != 0
+       || benchLatencyInit(&listLat, "list", gConfig.ops) != 0 || benchLatencyInit(&snapshotLat, "snapshot", SNAPSHOTS) != 0
+       || benchLatencyInit(&closeLat, "close", 1) != 0 || benchLatencyInit(&allLat, "all", gConfig.ops) != 0)
+   {
+      return -1;
+   }
+
+   if (gConfig.cold)
+   {
+      dropPageCache(gConfig.path);
+   }
+
+   handle = openDb(0, &openLat);
+   if (handle < 0)
+   {
+      return -1;
+   }
+   if (!gConfig.cold)
+   {
+      warmUp(handle, buffer);
+   }
+
+   mixStart = benchNow();
+   for (i = 0; i < gConfig.ops; i++)
+   {
+      unsigned int pct = (unsigned int) (benchRandom(rnd) % 100);
+      uint64_t opStart, ns;
+
+      keyName(key, (unsigned int) (benchRandom(rnd) % gConfig.keys));
+      opStart = benchNow();
+      if (pct < gConfig.readPct)
+      {
+         ret = persComDbReadKey(handle, key, buffer, PERS_DB_MAX_SIZE_KEY_DATA);
+         ns = benchNow() - opStart;
+         benchLatencyAdd(&readLat, ns);
+         if (ret < 0 && ret != PERS_COM_ERR_NOT_FOUND)
+         {
+            countError("read", ret);
+         }
+      }
+      else if (pct < gConfig.readPct + gConfig.deletePct)
+      {
+         ret = persComDbDeleteKey(handle, key);
+         ns = benchNow() - opStart;
+         benchLatencyAdd(&deleteLat, ns);
+         if (ret < 0 && ret != PERS_COM_ERR_NOT_FOUND)
+         {
+            countError("delete", ret);
+         }
+      }
+      else if (pct < gConfig.readPct + gConfig.deletePct + gConfig.listPct)
+      {
+         ret = persComDbGetSizeKeysList(handle);
+         if (ret > 0)
+         {
+            char* tmp = (char*) realloc(listBuffer, (size_t) ret);
+
+            if (tmp != NULL)
+            {
+               listBuffer = tmp;
+               ret = persComDbGetKeysList(handle, listBuffer, ret);
+            }
+         }
+         ns = benchNow() - opStart;
+         benchLatencyAdd(&listLat, ns);
+         if (ret < 0)
+         {
+            countError("list", ret);
+         }
+      }
+      else
+      {
+         ret = persComDbWriteKey(handle, key, value, valueSize(rnd));
+         ns = benchNow() - opStart;
+         benchLatencyAdd(&writeLat, ns);
+         if (ret < 0)
+         {
+            countError("write", ret);
+         }
+      }
+      benchLatencyAdd(&allLat, ns);
+   }
+   mixEnd = benchNow();
+
+   //without reflinks the database stays locked while its file is copied into memory
+   (void) snprintf(snapshotPath, sizeof(snapshotPath), "%s.snapshot", gConfig.path);
+   for (i = 0; i < SNAPSHOTS; i++)
+   {
+      uint64_t opStart = benchNow();
+
+      ret = persComDbSnapshot(handle, snapshotPath);
+      benchLatencyAdd(&snapshotLat, benchNow() - opStart);
+      if (ret < 0)
+      {
+         countError("snapshot", ret);
+      }
+   }
+   (void) remove(snapshotPath);
+   closeDb(handle, &closeLat);
+
+   benchLatencyReport(stdout, BENCH_NAME, "mixed", &openLat, 0);
+   benchLatencyReport(stdout, BENCH_NAME, "mixed", &readLat, mixEnd - mixStart);
+   benchLatencyReport(stdout, BENCH_NAME, "mixed", &writeLat, mixEnd - mixStart);
+   benchLatencyReport(stdout, BENCH_NAME, "mixed", &deleteLat, mixEnd - mixStart);
+   benchLatencyReport(stdout, BENCH_NAME, "mixed", &listLat, mixEnd - mixStart);
+   benchLatencyReport(stdout, BENCH_NAME, "mixed", &allLat, mixEnd - mixStart);
+   benchLatencyReport(stdout, BENCH_NAME, "mixed", &snapshotLat, 0);
+   benchLatencyReport(stdout, BENCH_NAME, "mixed", &closeLat, 0);
+
+   free(listBuffer);
+   benchLatencyFree(&openLat);
+   benchLatencyFree(&readLat);
+   benchLatencyFree(&writeLat);
+   benchLatencyFree(&deleteLat);
+   benchLatencyFree(&listLat);
+   benchLatencyFree(&snapshotLat);
+   benchLatencyFree(&closeLat);
+   benchLatencyFree(&allLat);
+   return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+   static char value[PERS_DB_MAX_SIZE_KEY_DATA];
+   static char buffer[PERS_DB_MAX_SIZE_KEY_DATA];
+   uint64_t rnd;
+   unsigned int i;
+   int opt, result = 0;
+
+   while ((opt = getopt(argc, argv, "d:k:o:v:r:x:l:wcs:Kh")) != -1)
+   {
+      switch (opt)
+      {
+         case 'd': gConfig.path = optarg; break;
+         case 'k': gConfig.keys = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'o': gConfig.ops = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'r': gConfig.readPct = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'x': gConfig.deletePct = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'l': gConfig.listPct = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'w': gConfig.writeThrough = 1; break;
+         case 'c': gConfig.cold = 1; break;
+         case 's': gConfig.seed = strtoull(optarg, NULL, 0); break;
+         case 'K': gConfig.keep = 1; break;
+         case 'v':
+            if (parseSize(optarg) == 0)
+            {
+               break;
+            }
+            fprintf(stderr, "%s: invalid value size: %s\n", BENCH_NAME, optarg);
+            return 1;
+         default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+      }
+   }
+   if (gConfig.keys == 0 || gConfig.readPct + gConfig.deletePct + gConfig.listPct > 100)
+   {
+      usage(argv[0]);
+      return 1;
+   }
+
+   rnd = (gConfig.seed != 0) ? gConfig.seed : 1;
+   for (i = 0; i < sizeof(value); i++)
+   {
+      value[i] = (char) ('a' + (benchRandom(&rnd) % 26));
+   }
+
+   printf("{\"bench\":\"%s\",\"config\":{\"path\":\"%s\",\"keys\":%u,\"ops\":%u,\"value_size\":\"%s:%u-%u\","
+          "\"read_pct\":%u,\"delete_pct\":%u,\"list_pct\":%u,\"mode\":\"%s\",\"page_cache\":\"%s\",\"seed\":%llu}}\n",
+          BENCH_NAME, gConfig.path, gConfig.keys, gConfig.ops,
+          (gConfig.sizeDist == SizeFixed) ? "fixed" : ((gConfig.sizeDist == SizeUniform) ? "uniform" : "exp"),
+          gConfig.sizeMin, gConfig.sizeMax, gConfig.readPct, gConfig.deletePct, gConfig.listPct,
+          gConfig.writeThrough ? "wt" : "wc", gConfig.cold ? "cold" : "warm", (unsigned long long) gConfig.seed);
+
+   (void) remove(gConfig.path);
+   if (runPopulate(value, &rnd) != 0 || runMixed(value, buffer, &rnd) != 0)
+   {
+      result = 1;
+   }
+   printf("{\"bench\":\"%s\",\"errors\":%lu}\n", BENCH_NAME, gErrors);
+
+   if (!gConfig.keep)
+   {
+      (void) remove(gConfig.path);
+   }
+   return (result != 0 || gErrors > 0) ? 1 : 0;
+}
@@ -0,0 +1,692 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           kvs_contention_bench.c
+ * @ingroup        Persistence key value store
+ * @brief          Many processes and threads accessing one shared database
+ * @see            bench_common.h
+ *
+ * Models the persistence client library: N client processes open the same shared group
+ * database and M threads of every client use the handle of their process concurrently.
+ *
+ * Phases (all clients start a phase together):
+ * - populate: the parent creates the database and writes every key once
+ * - storm:    every client opens and closes the database repeatedly (nobody else has it open)
+ * - mixed:    every client opens the database once and its threads run a random mix of
+ *             read / write / key list operations on the same keys, the parent keeps the
+ *             database open to read the shared performance counters
+ *
+ * Besides the aggregated lines of bench_common.h one line per client is printed with its tail
+ * latency and one line with the lock counters of the database. The lock wait per client is only
+ * measured if the library is built with --with-slowoplog, the wait per lock only with
+ * --enable-lockprofile.
+ *
+ * Usage: kvs_contention_bench [options], see usage()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "persComDbAccess.h"
+#include "persComDataOrg.h"
+#include "persComErrors.h"
+#include "database/kissdb.h"
+#include "pers_lldb_trace.h"
+#include "bench_common.h"
+
+#define BENCH_NAME "kvs_contention_bench"
+
+#define OPEN_CREATE        0x01
+#define OPEN_WRITE_THROUGH 0x02
+
+typedef enum
+{
+   OpRead,
+   OpWrite,
+   OpList,
+   OpOpen,
+   OpClose,
+   OpCount
+} BenchOp_e;
+
+static const char* const gOpNames[OpCount] = { "read", "write", "list", "open", "close" };
+
+typedef struct
+{
+   const char* path;
+   unsigned int clients;
+   unsigned int threads;
+   unsigned int keys;
+   unsigned int ops;        /* per thread */
+   unsigned int storm;      /* open / close cycles per client */
+   unsigned int valueSize;
+   unsigned int readPct;
+   unsigned int listPct;
+   int writeThrough;
+   int keep;
+   uint64_t seed;
+} BenchConfig_s;
+
+/* result of a client process, written by the client and read by the parent after the client ended */
+typedef struct
+{
+   pid_t pid;
+   int failed;
+   uint64_t errors;
+   uint64_t count[OpCount];     /* samples stored in the sample area of the client */
+   uint64_t lockWaitNs;         /* only measured with PERS_LLDB_SLOW_OP_LOG */
+   uint64_t lockWaitMaxNs;
+} ClientResult_s;
+
+/* anonymous shared memory of the parent and all clients, followed by the samples of every client and operation */
+typedef struct
+{
+   pthread_barrier_t barrier;
+   size_t capacity;             /* samples per client and operation */
+   ClientResult_s clients[];
+} SharedResults_s;
+
+typedef struct
+{
+   pthread_t thread;
+   int handle;
+   uint64_t rnd;
+   BenchLatency_s lat[OpList + 1];
+   char* listBuffer;
+   uint64_t errors;
+   uint64_t lockWaitNs;
+   uint64_t lockWaitMaxNs;
+} Worker_s;
+
+typedef struct
+{
+   uint64_t lockWaits;
+   uint64_t lockWaitNs;
+   uint64_t cacheHits;
+   uint64_t cacheMisses;
+   uint64_t remaps;
+   uint64_t writebacks;
+   uint64_t lockAcquisitions[KDB_LOCK_COUNT];
+   uint64_t lockWaitNsPerLock[KDB_LOCK_COUNT];
+} DbSnapshot_s;
+
+static BenchConfig_s gConfig = { "/tmp/kvs_contention_bench.db", 4, 2, 1000, 10000, 100, 64, 80, 5, 0, 0, 1 };
+static char gValue[PERS_DB_MAX_SIZE_KEY_DATA];
+static char gGroupPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME];
+
+
+static void usage(const char* prog)
+{
+   fprintf(stderr, "Usage: %s [options]\n", prog);
+   fprintf(stderr, "  -d path       database (default %s, removed before and after the run)\n", gConfig.path);
+   fprintf(stderr, "  -g group      use the shared group database of the group (hex), e.g. " PERS_ORG_SHARED_CACHE_PATH_FORMAT "\n",
+           0x20, PERS_ORG_SHARED_CACHE_DB_NAME_);
+   fprintf(stderr, "  -p clients    client processes (default %u)\n", gConfig.clients);
+   fprintf(stderr, "  -t threads    threads per client (default %u)\n", gConfig.threads);
+   fprintf(stderr, "  -k keys       number of keys (default %u)\n", gConfig.keys);
+   fprintf(stderr, "  -o ops        operations per thread in the mixed phase (default %u)\n", gConfig.ops);
+   fprintf(stderr, "  -n cycles     open / close cycles per client in the storm phase (default %u)\n", gConfig.storm);
+   fprintf(stderr, "  -v size       value size (default %u)\n", gConfig.valueSize);
+   fprintf(stderr, "  -r pct        reads in the mixed phase (default %u)\n", gConfig.readPct);
+   fprintf(stderr, "  -l pct        key list reads in the mixed phase (default %u), the rest are writes\n", gConfig.listPct);
+   fprintf(stderr, "  -w            write through (default write cached)\n");
+   fprintf(stderr, "  -s seed       seed of the random generator (default %llu)\n", (unsigned long long) gConfig.seed);
+   fprintf(stderr, "  -K            keep the database\n");
+}
+
+
+static void keyName(char* key, unsigned int idx)
+{
+   (void) snprintf(key, PERS_DB_MAX_LENGTH_KEY_NAME, "bench/key_%08u", idx);
+}
+
+
+static void reportError(uint64_t* errors, const char* op, int ret)
+{
+   if ((*errors)++ == 0)
+   {
+      fprintf(stderr, "%s: pid %d: first error: %s returned %d\n", BENCH_NAME, (int) getpid(), op, ret);
+   }
+}
+
+
+static uint64_t* clientSamples(SharedResults_s* shared, unsigned int client, int op)
+{
+   uint64_t* area = (uint64_t*) &shared->clients[gConfig.clients];
+
+   return area + (((size_t) client * OpCount) + (size_t) op) * shared->capacity;
+}
+
+
+static void storeSamples(SharedResults_s* shared, unsigned int client, int op, const BenchLatency_s* lat)
+{
+   ClientResult_s* result = &shared->clients[client];
+   size_t n = lat->count;
+
+   if (result->count[op] + n > shared->capacity)
+   {
+      n = shared->capacity - result->count[op];
+   }
+   memcpy(clientSamples(shared, client, op) + result->count[op], lat->samples, n * sizeof(uint64_t));
+   result->count[op] += n;
+}
+
+
+static void barrierWait(SharedResults_s* shared)
+{
+   (void) pthread_barrier_wait(&shared->barrier);
+}
+
+
+/* lock wait of the last operation of the calling thread */
+static void addLockWait(Worker_s* worker)
+{
+#ifdef PERS_LLDB_SLOW_OP_LOG
+   uint64_t ns = lldb_op_ctx.lockWaitNs;
+
+   worker->lockWaitNs += ns;
+   if (ns > worker->lockWaitMaxNs)
+   {
+      worker->lockWaitMaxNs = ns;
+   }
+#else
+   (void) worker;
+#endif
+}
+
+
+static void* workerRun(void* arg)
+{
+   static char buffer[PERS_DB_MAX_SIZE_KEY_DATA];   /* read data is not checked, may be shared by all threads */
+   Worker_s* worker = (Worker_s*) arg;
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME];
+   unsigned int i;
+   int ret;
+
+   for (i = 0; i < gConfig.ops; i++)
+   {
+      unsigned int pct = (unsigned int) (benchRandom(&worker->rnd) % 100);
+      uint64_t opStart;
+
+      keyName(key, (unsigned int) (benchRandom(&worker->rnd) % gConfig.keys));
+      opStart = benchNow();
+      if (pct < gConfig.readPct)
+      {
+         ret = persComDbReadKey(worker->handle, key, buffer, PERS_DB_MAX_SIZE_KEY_DATA);
+         benchLatencyAdd(&worker->lat[OpRead], benchNow() - opStart);
+         addLockWait(worker);
+         if (ret < 0 && ret != PERS_COM_ERR_NOT_FOUND)
+         {
+            reportError(&worker->errors, "read", ret);
+         }
+      }
+      else if (pct < gConfig.readPct + gConfig.listPct)
+      {
+         ret = persComDbGetSizeKeysList(worker->handle);
+         addLockWait(worker);
+         if (ret > 0)
+         {
+            char* tmp = (char*) realloc(worker->listBuffer, (size_t) ret);
+
+            if (tmp != NULL)
+            {
+               worker->listBuffer = tmp;
+               ret = persComDbGetKeysList(worker->handle, worker->listBuffer, ret);
+               addLockWait(worker);
+            }
+         }
+         benchLatencyAdd(&worker->lat[OpList], benchNow() - opStart);
+         if (ret < 0)
+         {
+            reportError(&worker->errors, "list", ret);
+         }
+      }
+      else
+      {
+         ret = persComDbWriteKey(worker->handle, key, gValue, (int) gConfig.valueSize);
+         benchLatencyAdd(&worker->lat[OpWrite], benchNow() - opStart);
+         addLockWait(worker);
+         if (ret < 0)
+         {
+            reportError(&worker->errors, "write", ret);
+         }
+      }
+   }
+   return NULL;
+}
+
+
+static int openDb(unsigned char option, BenchLatency_s* lat)
+{
+   uint64_t start = benchNow();
+   int handle = persComDbOpen(gConfig.path, option | (gConfig.writeThrough ? OPEN_WRITE_THROUGH : 0));
+
+   if (lat != NULL)
+   {
+      benchLatencyAdd(lat, benchNow() - start);
+   }
+   return handle;
+}
+
+
+static void runStorm(SharedResults_s* shared, unsigned int client)
+{
+   ClientResult_s* result = &shared->clients[client];
+   BenchLatency_s openLat, closeLat;
+   unsigned int i;
+   int handle, ret;
+
+   if (benchLatencyInit(&openLat, "open", gConfig.storm) != 0 || benchLatencyInit(&closeLat, "close", gConfig.storm) != 0)
+   {
+      result->failed = 1;
+   }
+   barrierWait(shared);
+   for (i = 0; i < gConfig.storm && !result->failed; i++)
+   {
+      uint64_t start;
+
+      handle = openDb(0, &openLat);
+      if (handle < 0)
+      {
+         reportError(&result->errors, "open", handle);
+         continue;
+      }
+      start = benchNow();
+      ret = persComDbClose(handle);
+      benchLatencyAdd(&closeLat, benchNow() - start);
+      if (ret < 0)
+      {
+         reportError(&result->errors, "close", ret);
+      }
+   }
+   barrierWait(shared);
+
+   storeSamples(shared, client, OpOpen, &openLat);
+   storeSamples(shared, client, OpClose, &closeLat);
+   benchLatencyFree(&openLat);
+   benchLatencyFree(&closeLat);
+}
+
+
+static void runMixed(SharedResults_s* shared, unsigned int client)
+{
+   ClientResult_s* result = &shared->clients[client];
+   Worker_s* workers = (Worker_s*) calloc(gConfig.threads, sizeof(Worker_s));
+   unsigned int started = 0;
+   unsigned int t;
+   int op, handle;
+
+   handle = openDb(0, NULL);
+   if (handle < 0)
+   {
+      reportError(&result->errors, "open", handle);
+   }
+   for (t = 0; t < gConfig.threads && workers != NULL; t++)
+   {
+      workers[t].handle = handle;
+      workers[t].rnd = (gConfig.seed * 0x9E3779B97F4A7C15ULL) + ((uint64_t) client << 20) + t + 1;
+      for (op = OpRead; op <= OpList; op++)
+      {
+         if (benchLatencyInit(&workers[t].lat[op], gOpNames[op], gConfig.ops) != 0)
+         {
+            result->failed = 1;
+         }
+      }
+   }
+   if (workers == NULL || handle < 0)
+   {
+      result->failed = 1;
+   }
+
+   barrierWait(shared);
+   for (t = 0; t < gConfig.threads && !result->failed; t++)
+   {
+      if (pthread_create(&workers[t].thread, NULL, workerRun, &workers[t]) != 0)
+      {
+         result->failed = 1;
+         break;
+      }
+      started++;
+   }
+   for (t = 0; t < started; t++)
+   {
+      (void) pthread_join(workers[t].thread, NULL);
+   }
+   barrierWait(shared);
+
+   if (handle >= 0)
+   {
+      (void) persComDbClose(handle);
+   }
+   for (t = 0; t < gConfig.threads && workers != NULL; t++)
+   {
+      for (op = OpRead; op <= OpList; op++)
+      {
+         storeSamples(shared, client, op, &workers[t].lat[op]);
+         benchLatencyFree(&workers[t].lat[op]);
+      }
+      result->errors += workers[t].errors;
+      result->lockWaitNs += workers[t].lockWaitNs;
+      if (workers[t].lockWaitMaxNs > result->lockWaitMaxNs)
+      {
+         result->lockWaitMaxNs = workers[t].lockWaitMaxNs;
+      }
+      free(workers[t].listBuffer);
+   }
+   free(workers);
+}
+
+
+static int populate(void)
+{
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME];
+   uint64_t errors = 0;
+   unsigned int i;
+   int handle, ret;
+
+   handle = openDb(OPEN_CREATE, NULL);
+   if (handle < 0)
+   {
+      fprintf(stderr, "%s: opening %s failed: %d\n", BENCH_NAME, gConfig.path, handle);
+      return -1;
+   }
+   for (i = 0; i < gConfig.keys; i++)
+   {
+      keyName(key, i);
+      ret = persComDbWriteKey(handle, key, gValue, (int) gConfig.valueSize);
+      if (ret < 0)
+      {
+         reportError(&errors, "write", ret);
+      }
+   }
+   ret = persComDbClose(handle);
+   return (errors == 0 && ret >= 0) ? 0 : -1;
+}
+
+
+static void takeSnapshot(Shared_Data_s* info, DbSnapshot_s* snap)
+{
+   int lock;
+
+   memset(snap, 0, sizeof(DbSnapshot_s));
+   if (info == NULL)
+   {
+      return;
+   }
+   snap->lockWaits = KDB_STAT_GET(&info->stats, lockWaits);
+   snap->lockWaitNs = KDB_STAT_GET(&info->stats, lockWaitNs);
+   snap->cacheHits = KDB_STAT_GET(&info->stats, cacheHits);
+   snap->cacheMisses = KDB_STAT_GET(&info->stats, cacheMisses);
+   snap->remaps = KDB_STAT_GET(&info->stats, remaps);
+   snap->writebacks = KDB_STAT_GET(&info->stats, writebacks);
+   for (lock = 0; lock < KDB_LOCK_COUNT; lock++)
+   {
+      snap->lockAcquisitions[lock] = KDB_STAT_GET(&info->stats.locks[lock], acquisitions);
+      snap->lockWaitNsPerLock[lock] = KDB_STAT_GET(&info->stats.locks[lock], waitNs);
+   }
+}
+
+
+static void reportDb(Shared_Data_s* info, const DbSnapshot_s* before, const DbSnapshot_s* after)
+{
+   if (info == NULL)
+   {
+      fprintf(stderr, "%s: no shared information of %s\n", BENCH_NAME, gConfig.path);
+      return;
+   }
+   printf("{\"bench\":\"%s\",\"phase\":\"mixed\",\"db\":{\"lock_waits\":%llu,\"lock_wait_ns\":%llu,\"cache_hits\":%llu,"
+          "\"cache_misses\":%llu,\"remaps\":%llu,\"writebacks\":%llu",
+          BENCH_NAME, (unsigned long long) (after->lockWaits - before->lockWaits),
+          (unsigned long long) (after->lockWaitNs - before->lockWaitNs),
+          (unsigned long long) (after->cacheHits - before->cacheHits),
+          (unsigned long long) (after->cacheMisses - before->cacheMisses),
+          (unsigned long long) (after->remaps - before->remaps),
+          (unsigned long long) (after->writebacks - before->writebacks));
+#ifdef PERS_LLDB_LOCK_PROFILE
+   {
+      static const char* const lockNames[KDB_LOCK_COUNT] = { "rwlock", "mutex", "semaphore" };
+      int lock;
+
+      printf(",\"locks\":{");
+      for (lock = 0; lock < KDB_LOCK_COUNT; lock++)
+      {
+         printf("%s\"%s\":{\"acquisitions\":%llu,\"wait_ns\":%llu}", (lock == 0) ? "" : ",", lockNames[lock],
+                (unsigned long long) (after->lockAcquisitions[lock] - before->lockAcquisitions[lock]),
+                (unsigned long long) (after->lockWaitNsPerLock[lock] - before->lockWaitNsPerLock[lock]));
+      }
+      printf("}");
+   }
+#endif
+   printf("}}\n");
+}
+
+
+/* aggregated lines of the operations first..last and one line per client (all operations of the range) */
+static int reportPhase(SharedResults_s* shared, const char* phase, int first, int last, uint64_t wallNs, int perClient)
+{
+   size_t capacity = shared->capacity * (size_t) (last - first + 1);
+   BenchLatency_s total, client;
+   unsigned int c;
+   int op;
+
+   if (benchLatencyInit(&client, "all", capacity) != 0)
+   {
+      return -1;
+   }
+   for (op = first; op <= last; op++)
+   {
+      if (benchLatencyInit(&total, gOpNames[op], shared->capacity * gConfig.clients) != 0)
+      {
+         benchLatencyFree(&client);
+         return -1;
+      }
+      for (c = 0; c < gConfig.clients; c++)
+      {
+         BenchLatency_s samples;
+
+         memset(&samples, 0, sizeof(samples));
+         samples.samples = clientSamples(shared, c, op);
+         samples.count = shared->clients[c].count[op];
+         benchLatencyMerge(&total, &samples);
+      }
+      benchLatencyReport(stdout, BENCH_NAME, phase, &total, wallNs);
+      benchLatencyFree(&total);
+   }
+
+   for (c = 0; c < gConfig.clients && perClient; c++)
+   {
+      ClientResult_s* result = &shared->clients[c];
+
+      benchLatencyReset(&client);
+      for (op = first; op <= last; op++)
+      {
+         BenchLatency_s samples;
+
+         memset(&samples, 0, sizeof(samples));
+         samples.samples = clientSamples(shared, c, op);
+         samples.count = result->count[op];
+         benchLatencyMerge(&client, &samples);
+      }
+      printf("{\"bench\":\"%s\",\"phase\":\"%s\",\"client\":%u,\"pid\":%d,\"count\":%zu,\"ops_per_s\":%.1f,"
+             "\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu",
+             BENCH_NAME, phase, c, (int) result->pid, client.count,
+             (wallNs > 0) ? (double) client.count / ((double) wallNs / 1e9) : 0.0,
+             (unsigned long long) benchLatencyPercentile(&client, 0.50), (unsigned long long) benchLatencyPercentile(&client, 0.99),
+             (unsigned long long) benchLatencyPercentile(&client, 0.999), (unsigned long long) benchLatencyPercentile(&client, 1.0));
+#ifdef PERS_LLDB_SLOW_OP_LOG
+      printf(",\"lock_wait_ns\":%llu,\"lock_wait_max_ns\":%llu", (unsigned long long) result->lockWaitNs,
+             (unsigned long long) result->lockWaitMaxNs);
+#endif
+      printf(",\"errors\":%llu}\n", (unsigned long long) result->errors);
+   }
+   benchLatencyFree(&client);
+   return 0;
+}
+
+
+static void runClient(SharedResults_s* shared, unsigned int client)
+{
+   shared->clients[client].pid = getpid();
+   runStorm(shared, client);
+   runMixed(shared, client);
+}
+
+
+int main(int argc, char* argv[])
+{
+   SharedResults_s* shared;
+   Shared_Data_s* info = NULL;
+   DbSnapshot_s before, after;
+   pthread_barrierattr_t attr;
+   uint64_t stormStart, stormEnd, mixStart, mixEnd, errors = 0;
+   uint64_t rnd;
+   size_t sharedSize;
+   unsigned int c, i;
+   int opt, handle, status, result = 0;
+
+   while ((opt = getopt(argc, argv, "d:g:p:t:k:o:n:v:r:l:ws:Kh")) != -1)
+   {
+      switch (opt)
+      {
+         case 'd': gConfig.path = optarg; break;
+         case 'g':
+            (void) snprintf(gGroupPath, sizeof(gGroupPath), PERS_ORG_SHARED_CACHE_PATH_FORMAT,
+                            (unsigned int) strtoul(optarg, NULL, 16), PERS_ORG_SHARED_CACHE_DB_NAME_);
+            gConfig.path = gGroupPath;
+            break;
+         case 'p': gConfig.clients = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 't': gConfig.threads = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'k': gConfig.keys = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'o': gConfig.ops = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'n': gConfig.storm = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'v': gConfig.valueSize = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'r': gConfig.readPct = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'l': gConfig.listPct = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'w': gConfig.writeThrough = 1; break;
+         case 's': gConfig.seed = strtoull(optarg, NULL, 0); break;
+         case 'K': gConfig.keep = 1; break;
+         default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+      }
+   }
+   if (gConfig.clients == 0 || gConfig.threads == 0 || gConfig.keys == 0 || gConfig.readPct + gConfig.listPct > 100
+       || gConfig.valueSize == 0 || gConfig.valueSize > PERS_DB_MAX_SIZE_KEY_DATA)
+   {
+      usage(argv[0]);
+      return 1;
+   }
+
+   rnd = (gConfig.seed != 0) ? gConfig.seed : 1;
+   for (i = 0; i < sizeof(gValue); i++)
+   {
+      gValue[i] = (char) ('a' + (benchRandom(&rnd) % 26));
+   }
+
+   printf("{\"bench\":\"%s\",\"config\":{\"path\":\"%s\",\"clients\":%u,\"threads\":%u,\"keys\":%u,\"ops\":%u,\"storm\":%u,"
+          "\"value_size\":%u,\"read_pct\":%u,\"list_pct\":%u,\"mode\":\"%s\",\"seed\":%llu}}\n",
+          BENCH_NAME, gConfig.path, gConfig.clients, gConfig.threads, gConfig.keys, gConfig.ops, gConfig.storm,
+          gConfig.valueSize, gConfig.readPct, gConfig.listPct, gConfig.writeThrough ? "wt" : "wc",
+          (unsigned long long) gConfig.seed);
+   fflush(stdout);
+
+   (void) remove(gConfig.path);
+   if (populate() != 0)
+   {
+      return 1;
+   }
+
+   sharedSize = sizeof(SharedResults_s) + (gConfig.clients * sizeof(ClientResult_s));
+   sharedSize += (size_t) gConfig.clients * OpCount * sizeof(uint64_t)
+                 * (((size_t) gConfig.threads * gConfig.ops > gConfig.storm) ? (size_t) gConfig.threads * gConfig.ops : gConfig.storm);
+   shared = (SharedResults_s*) mmap(NULL, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+   if (shared == MAP_FAILED)
+   {
+      fprintf(stderr, "%s: no memory for the results\n", BENCH_NAME);
+      return 1;
+   }
+   shared->capacity = ((size_t) gConfig.threads * gConfig.ops > gConfig.storm) ? (size_t) gConfig.threads * gConfig.ops : gConfig.storm;
+   (void) pthread_barrierattr_init(&attr);
+   (void) pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+   (void) pthread_barrier_init(&shared->barrier, &attr, gConfig.clients + 1);
+   (void) pthread_barrierattr_destroy(&attr);
+
+   for (c = 0; c < gConfig.clients; c++)
+   {
+      pid_t pid = fork();
+
+      if (pid == 0)
+      {
+         runClient(shared, c);
+         _exit(0);
+      }
+      if (pid < 0)
+      {
+         /* the barriers would never be passed */
+         fprintf(stderr, "%s: fork of client %u failed\n", BENCH_NAME, c);
+         kill(0, SIGKILL);
+      }
+   }
+
+   barrierWait(shared);
+   stormStart = benchNow();
+   barrierWait(shared);
+   stormEnd = benchNow();
+
+   handle = openDb(0, NULL);
+   if (handle >= 0)
+   {
+      info = kdbSharedInfoLookup(gConfig.path);
+   }
+   barrierWait(shared);
+   takeSnapshot(info, &before);
+   mixStart = benchNow();
+   barrierWait(shared);
+   mixEnd = benchNow();
+   takeSnapshot(info, &after);
+
+   for (c = 0; c < gConfig.clients; c++)
+   {
+      if (waitpid(shared->clients[c].pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0
+          || shared->clients[c].failed)
+      {
+         fprintf(stderr, "%s: client %u failed\n", BENCH_NAME, c);
+         result = 1;
+      }
+      errors += shared->clients[c].errors;
+   }
+   if (handle >= 0)
+   {
+      (void) persComDbClose(handle);
+   }
+
+   if (reportPhase(shared, "storm", OpOpen, OpClose, stormEnd - stormStart, 0) != 0
+       || reportPhase(shared, "mixed", OpRead, OpList, mixEnd - mixStart, 1) != 0)
+   {
+      result = 1;
+   }
+   reportDb(info, &before, &after);
+   printf("{\"bench\":\"%s\",\"errors\":%llu}\n", BENCH_NAME, (unsigned long long) errors);
+
+   (void) pthread_barrier_destroy(&shared->barrier);
+   (void) munmap(shared, sharedSize);
+   if (!gConfig.keep)
+   {
+      (void) remove(gConfig.path);
+   }
+   return (result != 0 || errors > 0) ? 1 : 0;
+}
@@ -0,0 +1,613 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           kvs_micro_bench.c
+ * @ingroup        Persistence key value store
+ * @brief          Microbenchmarks of the hash, checksum and qhasharr primitives
+ * @see            bench_common.h
+ *
+ * hash:     KISSDB_hash (djb2, hashtable index and bloom filter), qhashmurmur3_32 (cache) and
+ *           pcoCrc32 (checksums of the data blocks and hashtables) for every buffer size
+ * qhasharr: a table with -n slots is filled with keys like the ones of the resource configuration
+ *           (20 - 60 chars) up to every fill level, then measured are
+ *           - get_hit / get_miss: lookup of stored / not stored keys in random order (incl. free of the copy)
+ *           - update:             put of stored keys with a value of the same size
+ *           - remove / put:       remove of a random tenth of the keys, put of them again
+ *           - getnext:            iteration over the whole table (per returned key)
+ *           By default the *_hashed functions are used like by the cache, -S selects the functions
+ *           which hash the key themselves.
+ *
+ * Every operation is timed in a loop, one JSON line is printed per primitive and buffer size or
+ * per operation and fill level with the median of the runs. Cycles are read from the time stamp
+ * counter (reference cycles, not scaled by frequency changes of the core), they are null on
+ * other architectures than x86.
+ *
+ * Usage: kvs_micro_bench [options], see usage()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#endif
+
+#include "persComDbAccess.h"
+#include "crc32.h"
+#include "database/kissdb.h"
+#include "hashtable/qhash.h"
+#include "hashtable/qhasharr.h"
+#include "bench_common.h"
+
+#define BENCH_NAME "kvs_micro_bench"
+
+#define MAX_RUNS        31
+#define MAX_VALUE_SIZE  256
+
+typedef enum
+{
+   HashKissdb,
+   HashMurmur3,
+   HashCrc32,
+   HashCount
+} Hash_e;
+
+static const char* const gHashNames[HashCount] = { "KISSDB_hash", "qhashmurmur3_32", "pcoCrc32" };
+
+typedef struct
+{
+   const char* sizes;
+   const char* fills;
+   unsigned int slots;
+   unsigned int valueSize;
+   unsigned int runs;
+   unsigned long long bytes;
+   int stringApi;
+   uint64_t seed;
+} BenchConfig_s;
+
+static BenchConfig_s gConfig = { "8,16,32,64,128,256,1024,4096,16384", "10,25,50,75,90,95", 10000, 16, 5,
+                                 16 * 1024 * 1024, 0, 1 };
+static unsigned long gErrors = 0;
+
+/* keeps the compiler from dropping the results */
+static volatile uint64_t gSink;
+
+typedef struct
+{
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME];
+   size_t length;
+   uint32_t hash;
+} BenchKey_s;
+
+/* duration of one run of a measurement */
+typedef struct
+{
+   uint64_t ns;
+   uint64_t cycles;
+} BenchSample_s;
+
+
+static void usage(const char* prog)
+{
+   fprintf(stderr, "Usage: %s [options]\n", prog);
+   fprintf(stderr, "  -b list       buffer sizes of the hash functions (default %s)\n", gConfig.sizes);
+   fprintf(stderr, "  -f list       fill levels of the qhasharr in %% (default %s)\n", gConfig.fills);
+   fprintf(stderr, "  -n slots      slots of the qhasharr (default %u)\n", gConfig.slots);
+   fprintf(stderr, "  -v size       value size (default %u, max %d)\n", gConfig.valueSize, MAX_VALUE_SIZE);
+   fprintf(stderr, "  -r runs       runs per measurement, the median is reported (default %u, max %d)\n", gConfig.runs, MAX_RUNS);
+   fprintf(stderr, "  -B bytes      bytes hashed per run and buffer size (default %llu)\n", gConfig.bytes);
+   fprintf(stderr, "  -S            use put/get/remove instead of the *_hashed functions\n");
+   fprintf(stderr, "  -s seed       seed of the random generator (default %llu)\n", (unsigned long long) gConfig.seed);
+}
+
+
+static void countError(const char* op, int ret)
+{
+   if (gErrors++ == 0)
+   {
+      fprintf(stderr, "%s: first error: %s returned %d\n", BENCH_NAME, op, ret);
+   }
+}
+
+
+static inline uint64_t readCycles(void)
+{
+#ifdef BENCH_HAVE_TSC
+   return (uint64_t) __rdtsc();
+#else
+   return 0;
+#endif
+}
+
+
+static void sampleStart(BenchSample_s* sample)
+{
+   sample->ns = benchNow();
+   sample->cycles = readCycles();
+}
+
+
+static void sampleStop(BenchSample_s* sample)
+{
+   sample->cycles = readCycles() - sample->cycles;
+   sample->ns = benchNow() - sample->ns;
+}
+
+
+static int compareSamples(const void* a, const void* b)
+{
+   const BenchSample_s* x = (const BenchSample_s*) a;
+   const BenchSample_s* y = (const BenchSample_s*) b;
+
+   return (x->ns < y->ns) ? -1 : ((x->ns > y->ns) ? 1 : 0);
+}
+
+
+static BenchSample_s median(BenchSample_s* samples, unsigned int count)
+{
+   qsort(samples, count, sizeof(BenchSample_s), compareSamples);
+   return samples[count / 2];
+}
+
+
+/* prints the cycles divided by units, null if there is no cycle counter */
+static void printCycles(const char* name, const BenchSample_s* sample, double units)
+{
+#ifdef BENCH_HAVE_TSC
+   printf(",\"%s\":%.3f", name, (units > 0.0) ? (double) sample->cycles / units : 0.0);
+#else
+   (void) sample;
+   (void) units;
+   printf(",\"%s\":null", name);
+#endif
+}
+
+
+static uint64_t runHash(Hash_e hash, const unsigned char* buf, size_t size, uint64_t iterations)
+{
+   uint64_t acc = 0;
+   uint64_t i;
+
+   switch (hash)
+   {
+      case HashKissdb:
+         for (i = 0; i < iterations; i++)
+         {
+            acc += KISSDB_hash(buf, (unsigned long) size);
+         }
+         break;
+      case HashMurmur3:
+         for (i = 0; i < iterations; i++)
+         {
+            acc += qhashmurmur3_32(buf, size);
+         }
+         break;
+      case HashCrc32:
+         for (i = 0; i < iterations; i++)
+         {
+            acc += pcoCrc32(0, buf, size);
+         }
+         break;
+      default:
+         break;
+   }
+   return acc;
+}
+
+
+static int benchHashes(const unsigned char* buf, size_t bufSize)
+{
+   char sizeList[256];
+   char *token, *save = NULL;
+   BenchSample_s samples[MAX_RUNS];
+   int hash;
+   unsigned int run;
+
+   (void) snprintf(sizeList, sizeof(sizeList), "%s", gConfig.sizes);
+   for (token = strtok_r(sizeList, ",", &save); token != NULL; token = strtok_r(NULL, ",", &save))
+   {
+      size_t size = (size_t) strtoul(token, NULL, 0);
+      uint64_t iterations;
+
+      if (size == 0 || size > bufSize)
+      {
+         fprintf(stderr, "%s: invalid buffer size %s (1 - %zu)\n", BENCH_NAME, token, bufSize);
+         return 1;
+      }
+      iterations = gConfig.bytes / size;
+      if (iterations == 0)
+      {
+         iterations = 1;
+      }
+      for (hash = 0; hash < HashCount; hash++)
+      {
+         BenchSample_s result;
+
+         gSink += runHash((Hash_e) hash, buf, size, iterations / 16 + 1); //warm up
+         for (run = 0; run < gConfig.runs; run++)
+         {
+            sampleStart(&samples[run]);
+            gSink += runHash((Hash_e) hash, buf, size, iterations);
+            sampleStop(&samples[run]);
+         }
+         result = median(samples, gConfig.runs);
+
+         printf("{\"bench\":\"%s\",\"group\":\"hash\",\"func\":\"%s\",\"bytes\":%zu,\"iterations\":%llu,"
+                "\"ns_per_call\":%.3f,\"ns_per_byte\":%.4f,\"mb_per_s\":%.1f",
+                BENCH_NAME, gHashNames[hash], size, (unsigned long long) iterations,
+                (double) result.ns / (double) iterations, (double) result.ns / ((double) iterations * (double) size),
+                (result.ns > 0) ? ((double) iterations * (double) size * 1e3) / (double) result.ns : 0.0);
+         printCycles("cycles_per_call", &result, (double) iterations);
+         printCycles("cycles_per_byte", &result, (double) iterations * (double) size);
+         printf("}\n");
+      }
+   }
+   return 0;
+}
+
+
+/* keys similar to the resource configuration, 20 - 60 chars */
+static void generateKeys(BenchKey_s* keys, unsigned int count, unsigned int firstId, uint64_t* rnd)
+{
+   static const char* const sections[] = { "setting", "status", "navigation/lastDestination", "media/lastSource",
+                                           "hmi/theme", "phone/favorites/entry" };
+   unsigned int i;
+
+   for (i = 0; i < count; i++)
+   {
+      uint64_t r = benchRandom(rnd);
+
+      (void) snprintf(keys[i].key, sizeof(keys[i].key), "/node/user/%u/seat/%u/%s_%u",
+                      (unsigned int) (r % 4), (unsigned int) ((r >> 8) % 4),
+                      sections[(r >> 16) % (sizeof(sections) / sizeof(sections[0]))], firstId + i);
+      keys[i].length = strlen(keys[i].key);
+      keys[i].hash = qhashmurmur3_32(keys[i].key, keys[i].length);
+   }
+}
+
+
+static bool tablePut(qhasharr_t* tbl, const BenchKey_s* key, const void* value)
+{
+   if (gConfig.stringApi)
+   {
+      return tbl->put(tbl, key->key, value, gConfig.valueSize);
+   }
+   return tbl->put_hashed(tbl, key->key, key->length, key->hash, value, gConfig.valueSize);
+}
+
+
+static void* tableGet(qhasharr_t* tbl, const BenchKey_s* key, size_t* size)
+{
+   if (gConfig.stringApi)
+   {
+      return tbl->get(tbl, key->key, size);
+   }
+   return tbl->get_hashed(tbl, key->key, key->length, key->hash, size);
+}
+
+
+static bool tableRemove(qhasharr_t* tbl, const BenchKey_s* key)
+{
+   if (gConfig.stringApi)
+   {
+      return tbl->remove(tbl, key->key);
+   }
+   return tbl->remove_hashed(tbl, key->key, key->length, key->hash);
+}
+
+
+static void shuffle(unsigned int* order, unsigned int count, uint64_t* rnd)
+{
+   unsigned int i;
+
+   for (i = 0; i < count; i++)
+   {
+      order[i] = i;
+   }
+   for (i = count; i > 1; i--)
+   {
+      unsigned int j = (unsigned int) (benchRandom(rnd) % i);
+      unsigned int tmp = order[i - 1];
+
+      order[i - 1] = order[j];
+      order[j] = tmp;
+   }
+}
+
+
+static void reportTableOp(const char* op, unsigned int fill, int usedSlots, unsigned int keyCount,
+                          BenchSample_s* samples, unsigned int ops)
+{
+   BenchSample_s result = median(samples, gConfig.runs);
+
+   printf("{\"bench\":\"%s\",\"group\":\"qhasharr\",\"api\":\"%s\",\"op\":\"%s\",\"fill_pct\":%u,\"slots\":%u,"
+          "\"used_slots\":%d,\"keys\":%u,\"ops\":%u,\"ns_per_op\":%.3f",
+          BENCH_NAME, gConfig.stringApi ? "string" : "hashed", op, fill, gConfig.slots, usedSlots, keyCount, ops,
+          (ops > 0) ? (double) result.ns / (double) ops : 0.0);
+   printCycles("cycles_per_op", &result, (double) ops);
+   printf("}\n");
+}
+
+
+static int benchTable(unsigned int fill, BenchKey_s* keys, BenchKey_s* missing, unsigned int* order,
+                      const unsigned char* value, uint64_t* rnd)
+{
+   BenchSample_s samples[MAX_RUNS];
+   size_t memsize = qhasharr_calculate_memsize((int) gConfig.slots);
+   void* memory = malloc(memsize);
+   qhasharr_t* tbl;
+   unsigned int keyCount = 0, batch, i, run;
+   unsigned int targetSlots = (unsigned int) (((unsigned long long) gConfig.slots * fill) / 100);
+   int maxSlots = 0, usedSlots = 0;
+
+   if (memory == NULL)
+   {
+      fprintf(stderr, "%s: no memory for %u slots\n", BENCH_NAME, gConfig.slots);
+      return 1;
+   }
+   memset(memory, 0, memsize);
+   tbl = qhasharr(memory, memsize);
+   if (tbl == NULL)
+   {
+      fprintf(stderr, "%s: qhasharr failed for %u slots\n", BENCH_NAME, gConfig.slots);
+      free(memory);
+      return 1;
+   }
+
+   //values larger than a slot use linked slots, the fill level is counted in slots.
+   //small tables may refuse new keys before (used_slots shows the reached level)
+   while (keyCount < gConfig.slots && usedSlots < (int) targetSlots)
+   {
+      if (tablePut(tbl, &keys[keyCount], value) == false)
+      {
+         break;
+      }
+      keyCount++;
+      (void) tbl->size(tbl, &maxSlots, &usedSlots);
+   }
+   if (keyCount == 0)
+   {
+      tbl->free(tbl);
+      free(memory);
+      return 0;
+   }
+   shuffle(order, keyCount, rnd);
+
+   for (run = 0; run < gConfig.runs; run++)
+   {
+      size_t size;
+
+      sampleStart(&samples[run]);
+      for (i = 0; i < keyCount; i++)
+      {
+         void* data = tableGet(tbl, &keys[order[i]], &size);
+
+         if (data == NULL)
+         {
+            countError("get", (int) i);
+         }
+         free(data); //the value is returned as copy, like for the cache the free is part of the measurement
+      }
+      sampleStop(&samples[run]);
+   }
+   reportTableOp("get_hit", fill, usedSlots, keyCount, samples, keyCount);
+
+   for (run = 0; run < gConfig.runs; run++)
+   {
+      size_t size;
+
+      sampleStart(&samples[run]);
+      for (i = 0; i < keyCount; i++)
+      {
+         if (tableGet(tbl, &missing[i], &size) != NULL)
+         {
+            countError("get (missing key)", (int) i);
+         }
+      }
+      sampleStop(&samples[run]);
+   }
+   reportTableOp("get_miss", fill, usedSlots, keyCount, samples, keyCount);
+
+   for (run = 0; run < gConfig.runs; run++)
+   {
+      sampleStart(&samples[run]);
+      for (i = 0; i < keyCount; i++)
+      {
+         if (tablePut(tbl, &keys[order[i]], value) == false)
+         {
+            countError("put (update)", (int) i);
+         }
+      }
+      sampleStop(&samples[run]);
+   }
+   reportTableOp("update", fill, usedSlots, keyCount, samples, keyCount);
+
+   //a random tenth of the keys is removed and put again, the fill level changes only by this tenth
+   batch = (keyCount >= 10) ? keyCount / 10 : 1;
+   {
+      BenchSample_s putSamples[MAX_RUNS];
+
+      for (run = 0; run < gConfig.runs; run++)
+      {
+         unsigned int* victims = order + ((run * batch) % (keyCount - batch + 1));
+
+         sampleStart(&samples[run]);
+         for (i = 0; i < batch; i++)
+         {
+            if (tableRemove(tbl, &keys[victims[i]]) == false)
+            {
+               countError("remove", (int) i);
+            }
+         }
+         sampleStop(&samples[run]);
+
+         sampleStart(&putSamples[run]);
+         for (i = 0; i < batch; i++)
+         {
+            if (tablePut(tbl, &keys[victims[i]], value) == false)
+            {
+               countError("put", (int) i);
+            }
+         }
+         sampleStop(&putSamples[run]);
+      }
+      reportTableOp("remove", fill, usedSlots, keyCount, samples, batch);
+      reportTableOp("put", fill, usedSlots, keyCount, putSamples, batch);
+   }
+
+   for (run = 0; run < gConfig.runs; run++)
+   {
+      qnobj_t obj;
+      int idx = 0;
+      unsigned int found = 0;
+
+      sampleStart(&samples[run]);
+      while (tbl->getnext(tbl, &obj, &idx) == true)
+      {
+         gSink += obj.size;
+         free(obj.name);
+         free(obj.data);
+         found++;
+      }
+      sampleStop(&samples[run]);
+      if (found != keyCount)
+      {
+         countError("getnext (number of keys)", (int) found);
+      }
+   }
+   reportTableOp("getnext", fill, usedSlots, keyCount, samples, keyCount);
+
+   tbl->free(tbl);
+   free(memory);
+   return 0;
+}
+
+
+static int benchTables(void)
+{
+   char fillList[256];
+   char *token, *save = NULL;
+   unsigned char value[MAX_VALUE_SIZE];
+   BenchKey_s* keys = (BenchKey_s*) malloc(gConfig.slots * sizeof(BenchKey_s));
+   BenchKey_s* missing = (BenchKey_s*) malloc(gConfig.slots * sizeof(BenchKey_s));
+   unsigned int* order = (unsigned int*) malloc(gConfig.slots * sizeof(unsigned int));
+   uint64_t rnd = (gConfig.seed != 0) ? gConfig.seed : 1;
+   unsigned int i;
+   int result = 0;
+
+   if (keys == NULL || missing == NULL || order == NULL)
+   {
+      fprintf(stderr, "%s: no memory for %u keys\n", BENCH_NAME, gConfig.slots);
+      result = 1;
+   }
+   else
+   {
+      for (i = 0; i < sizeof(value); i++)
+      {
+         value[i] = (unsigned char) benchRandom(&rnd);
+      }
+      generateKeys(keys, gConfig.slots, 0, &rnd);
+      generateKeys(missing, gConfig.slots, gConfig.slots, &rnd);
+
+      (void) snprintf(fillList, sizeof(fillList), "%s", gConfig.fills);
+      for (token = strtok_r(fillList, ",", &save); token != NULL && result == 0; token = strtok_r(NULL, ",", &save))
+      {
+         unsigned int fill = (unsigned int) strtoul(token, NULL, 0);
+
+         if (fill == 0 || fill > 99)
+         {
+            fprintf(stderr, "%s: invalid fill level %s (1 - 99)\n", BENCH_NAME, token);
+            result = 1;
+         }
+         else
+         {
+            result = benchTable(fill, keys, missing, order, value, &rnd);
+         }
+      }
+   }
+   free(order);
+   free(missing);
+   free(keys);
+   return result;
+}
+
+
+/* ratio of the time stamp counter to CLOCK_MONOTONIC, 0 if there is no cycle counter */
+static double cyclesPerNs(void)
+{
+#ifdef BENCH_HAVE_TSC
+   BenchSample_s sample;
+
+   sampleStart(&sample);
+   (void) usleep(50000);
+   sampleStop(&sample);
+   return (sample.ns > 0) ? (double) sample.cycles / (double) sample.ns : 0.0;
+#else
+   return 0.0;
+#endif
+}
+
+
+int main(int argc, char* argv[])
+{
+   static unsigned char buf[64 * 1024];
+   uint64_t rnd;
+   unsigned int i;
+   int opt, result;
+
+   while ((opt = getopt(argc, argv, "b:f:n:v:r:B:Ss:h")) != -1)
+   {
+      switch (opt)
+      {
+         case 'b': gConfig.sizes = optarg; break;
+         case 'f': gConfig.fills = optarg; break;
+         case 'n': gConfig.slots = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'v': gConfig.valueSize = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'r': gConfig.runs = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'B': gConfig.bytes = strtoull(optarg, NULL, 0); break;
+         case 'S': gConfig.stringApi = 1; break;
+         case 's': gConfig.seed = strtoull(optarg, NULL, 0); break;
+         default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+      }
+   }
+   if (gConfig.runs == 0 || gConfig.runs > MAX_RUNS || gConfig.slots == 0 || gConfig.valueSize == 0
+       || gConfig.valueSize > MAX_VALUE_SIZE || gConfig.bytes == 0)
+   {
+      usage(argv[0]);
+      return 1;
+   }
+
+   rnd = (gConfig.seed != 0) ? gConfig.seed : 1;
+   for (i = 0; i < sizeof(buf); i++)
+   {
+      buf[i] = (unsigned char) benchRandom(&rnd);
+   }
+
+   printf("{\"bench\":\"%s\",\"config\":{\"sizes\":\"%s\",\"fills\":\"%s\",\"slots\":%u,\"value_size\":%u,"
+          "\"runs\":%u,\"bytes\":%llu,\"api\":\"%s\",\"seed\":%llu,\"tsc_per_ns\":%.3f}}\n",
+          BENCH_NAME, gConfig.sizes, gConfig.fills, gConfig.slots, gConfig.valueSize, gConfig.runs, gConfig.bytes,
+          gConfig.stringApi ? "string" : "hashed", (unsigned long long) gConfig.seed, cyclesPerNs());
+
+   result = benchHashes(buf, sizeof(buf));
+   if (result == 0)
+   {
+      result = benchTables();
+   }
+
+   printf("{\"bench\":\"%s\",\"errors\":%lu}\n", BENCH_NAME, gErrors);
+   return (result != 0 || gErrors != 0) ? 1 : 0;
+}
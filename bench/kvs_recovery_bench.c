@@ -0,0 +1,489 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           kvs_recovery_bench.c
+ * @ingroup        Persistence key value store
+ * @brief          Duration of the recovery of damaged databases in KISSDB_open
+ * @see            bench_common.h
+ *
+ * For every database size a clean database is written once. For every kind of damage a copy
+ * of it is damaged like after a power loss and opened, the duration of the open and of its
+ * steps (Kdb_stats_s.recoveryNs) is measured. All damaged databases have the close flags of
+ * an unclean close, in addition:
+ * - none:       nothing (database closed correctly, no recovery)
+ * - closeflag:  nothing
+ * - htcrc:      invalid checksum of one hashtable -> hashtables are rebuilt from the data blocks
+ * - torn_a:     invalid data in block A of a part of the keys (torn write)
+ * - torn_b:     invalid data in block B of a part of the keys
+ * - delimiter:  missing delimiters of block A of a part of the keys and invalid checksum of
+ *               one hashtable (the rebuild searches the data blocks by their delimiters)
+ *
+ * One JSON line is printed per database size and damage with the median of the runs.
+ *
+ * Usage: kvs_recovery_bench [options], see usage()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "persComDbAccess.h"
+#include "persComDataOrg.h"
+#include "persComErrors.h"
+#include "database/kissdb.h"
+#include "bench_common.h"
+
+#define BENCH_NAME "kvs_recovery_bench"
+
+#define OPEN_CREATE        0x01
+#define OPEN_WRITE_THROUGH 0x02
+
+typedef enum
+{
+   DamageNone,
+   DamageCloseFlag,
+   DamageHashtableCrc,
+   DamageTornA,
+   DamageTornB,
+   DamageDelimiter,
+   DamageCount
+} Damage_e;
+
+static const char* const gDamageNames[DamageCount] = { "none", "closeflag", "htcrc", "torn_a", "torn_b", "delimiter" };
+
+static const char* const gStepNames[KDB_RECOVERY_STEPS] =
+{
+   "check_error_flags", "verify_hashtables", "rebuild_hashtables", "recover_datablocks", "rebuild_bloom_filter"
+};
+
+typedef struct
+{
+   const char* path;
+   const char* keyCounts;
+   const char* damages;
+   double damagePct;
+   unsigned int valueSize;
+   unsigned int runs;
+   int warm;
+   int keep;
+   uint64_t seed;
+} BenchConfig_s;
+
+static BenchConfig_s gConfig = { "/tmp/kvs_recovery_bench.db", "1000,10000,100000", "none,closeflag,htcrc,torn_a,torn_b,delimiter",
+                                 1.0, 64, 3, 0, 0, 1 };
+static unsigned long gErrors = 0;
+
+
+static void usage(const char* prog)
+{
+   fprintf(stderr, "Usage: %s [options]\n", prog);
+   fprintf(stderr, "  -d path       damaged database (default %s), the clean database is <path>.clean\n", gConfig.path);
+   fprintf(stderr, "  -k list       numbers of keys (default %s)\n", gConfig.keyCounts);
+   fprintf(stderr, "  -D list       kinds of damage (default %s)\n", gConfig.damages);
+   fprintf(stderr, "  -p pct        percentage of the keys with damaged data blocks (default %.1f)\n", gConfig.damagePct);
+   fprintf(stderr, "  -v size       value size (default %u)\n", gConfig.valueSize);
+   fprintf(stderr, "  -r runs       opens per database size and damage (default %u)\n", gConfig.runs);
+   fprintf(stderr, "  -w            warm page cache (default cold, like the first open after a reboot)\n");
+   fprintf(stderr, "  -s seed       seed of the random generator (default %llu)\n", (unsigned long long) gConfig.seed);
+   fprintf(stderr, "  -K            keep the databases\n");
+}
+
+
+static void countError(const char* op, int ret)
+{
+   if (gErrors++ == 0)
+   {
+      fprintf(stderr, "%s: first error: %s returned %d\n", BENCH_NAME, op, ret);
+   }
+}
+
+
+static int parseDamage(const char* name)
+{
+   int damage;
+
+   for (damage = 0; damage < DamageCount; damage++)
+   {
+      if (strcmp(name, gDamageNames[damage]) == 0)
+      {
+         return damage;
+      }
+   }
+   return -1;
+}
+
+
+static int generate(const char* path, unsigned int keys, const char* value)
+{
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME];
+   uint64_t start = benchNow();
+   struct stat st;
+   unsigned int i;
+   int handle, ret;
+
+   (void) remove(path);
+   handle = persComDbOpen(path, OPEN_CREATE | OPEN_WRITE_THROUGH);
+   if (handle < 0)
+   {
+      fprintf(stderr, "%s: creating %s failed: %d\n", BENCH_NAME, path, handle);
+      return -1;
+   }
+   for (i = 0; i < keys; i++)
+   {
+      (void) snprintf(key, sizeof(key), "recovery/key_%08u", i);
+      ret = persComDbWriteKey(handle, key, (char*) value, (int) gConfig.valueSize);
+      if (ret < 0)
+      {
+         countError("write", ret);
+      }
+   }
+   ret = persComDbClose(handle);
+   if (ret < 0 || stat(path, &st) != 0)
+   {
+      countError("close", ret);
+      return -1;
+   }
+   printf("{\"bench\":\"%s\",\"phase\":\"generate\",\"keys\":%u,\"file_bytes\":%lld,\"seconds\":%.3f}\n",
+          BENCH_NAME, keys, (long long) st.st_size, (double) (benchNow() - start) / 1e9);
+   return 0;
+}
+
+
+static int copyFile(const char* from, const char* to)
+{
+   static char buffer[1024 * 1024];
+   ssize_t n = 0;
+   int in, out, result = 0;
+
+   in = open(from, O_RDONLY);
+   if (in < 0)
+   {
+      return -1;
+   }
+   out = open(to, O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+   if (out < 0)
+   {
+      close(in);
+      return -1;
+   }
+   while ((n = read(in, buffer, sizeof(buffer))) > 0)
+   {
+      if (write(out, buffer, (size_t) n) != n)
+      {
+         result = -1;
+         break;
+      }
+   }
+   if (n < 0 || fdatasync(out) != 0)
+   {
+      result = -1;
+   }
+   close(in);
+   close(out);
+   return result;
+}
+
+
+/* damages the data block at offset if it lies inside the file */
+static int damageBlock(char* memory, off_t size, int64_t offset, Damage_e damage)
+{
+   DataBlock_s* block;
+
+   if (offset <= 0 || (off_t) (offset + (int64_t) sizeof(DataBlock_s)) > size)
+   {
+      return 0;
+   }
+   block = (DataBlock_s*) (memory + offset);
+   if (damage == DamageDelimiter)
+   {
+      block->delimStart = 0;
+      block->delimEnd = 0;
+   }
+   else
+   {
+      block->value[0] = (char) ~block->value[0]; //checksum does not match anymore
+   }
+   return 1;
+}
+
+
+/* damage the database like a power loss would, returns the number of damaged data blocks or -1 */
+static int injectDamage(const char* path, Damage_e damage, uint64_t* rnd)
+{
+   Header_s* header;
+   Hashtable_s* hashtables[4096];
+   unsigned int htCount = 0;
+   uint64_t threshold = (uint64_t) (gConfig.damagePct * 100.0);
+   int64_t offset = (int64_t) sizeof(Header_s);
+   struct stat st;
+   char* memory;
+   int fd, slot, damaged = 0;
+   unsigned int i;
+
+   fd = open(path, O_RDWR);
+   if (fd < 0 || fstat(fd, &st) != 0)
+   {
+      return -1;
+   }
+   memory = (char*) mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (memory == MAP_FAILED)
+   {
+      close(fd);
+      return -1;
+   }
+   header = (Header_s*) memory;
+
+   //follow the linked hashtables
+   while (offset > 0 && (off_t) (offset + (int64_t) sizeof(Hashtable_s)) <= st.st_size && htCount < sizeof(hashtables) / sizeof(hashtables[0]))
+   {
+      hashtables[htCount] = (Hashtable_s*) (memory + offset);
+      offset = hashtables[htCount]->slots[header->htSize].offsetA;
+      htCount++;
+   }
+
+   if (damage != DamageNone)
+   {
+      header->closeFailed = 0x01;
+      header->closeOk = 0x00;
+   }
+   if ((damage == DamageHashtableCrc || damage == DamageDelimiter) && htCount > 0)
+   {
+      hashtables[benchRandom(rnd) % htCount]->crc ^= 0x5A5A5A5AULL;
+   }
+   if (damage == DamageTornA || damage == DamageTornB || damage == DamageDelimiter)
+   {
+      for (i = 0; i < htCount; i++)
+      {
+         for (slot = 0; slot < (int) header->htSize; slot++)
+         {
+            Hashtable_slot_s* entry = &hashtables[i]->slots[slot];
+
+            if (entry->offsetA > 0 && (benchRandom(rnd) % 10000) < threshold)
+            {
+               damaged += damageBlock(memory, st.st_size, (damage == DamageTornB) ? entry->offsetB : entry->offsetA, damage);
+            }
+         }
+      }
+   }
+
+   (void) msync(memory, (size_t) st.st_size, MS_SYNC);
+   (void) munmap(memory, (size_t) st.st_size);
+   if (!gConfig.warm)
+   {
+      (void) fdatasync(fd);
+      (void) posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+   }
+   close(fd);
+   return damaged;
+}
+
+
+static int countKeys(int handle)
+{
+   char* list;
+   int size, count = 0, i;
+
+   size = persComDbGetSizeKeysList(handle);
+   if (size <= 0)
+   {
+      return size;
+   }
+   list = (char*) malloc((size_t) size);
+   if (list == NULL)
+   {
+      return PERS_COM_ERR_MALLOC;
+   }
+   size = persComDbGetKeysList(handle, list, size);
+   for (i = 0; i < size; i++)
+   {
+      if (list[i] == '\0')
+      {
+         count++;
+      }
+   }
+   free(list);
+   return count;
+}
+
+
+static int runDamage(const char* cleanPath, unsigned int keys, Damage_e damage, uint64_t* rnd)
+{
+   BenchLatency_s openLat, stepLat[KDB_RECOVERY_STEPS];
+   uint64_t recoveries = 0;
+   int keysAfter = 0, damaged = 0;
+   unsigned int run;
+   int step, handle, result = 0;
+
+   if (benchLatencyInit(&openLat, "open", gConfig.runs) != 0)
+   {
+      return -1;
+   }
+   for (step = 0; step < KDB_RECOVERY_STEPS; step++)
+   {
+      if (benchLatencyInit(&stepLat[step], gStepNames[step], gConfig.runs) != 0)
+      {
+         return -1;
+      }
+   }
+
+   for (run = 0; run < gConfig.runs && result == 0; run++)
+   {
+      Shared_Data_s* info;
+      uint64_t start;
+
+      if (copyFile(cleanPath, gConfig.path) != 0)
+      {
+         fprintf(stderr, "%s: copying %s failed\n", BENCH_NAME, cleanPath);
+         result = -1;
+         break;
+      }
+      damaged = injectDamage(gConfig.path, damage, rnd);
+      if (damaged < 0)
+      {
+         fprintf(stderr, "%s: damaging %s failed\n", BENCH_NAME, gConfig.path);
+         result = -1;
+         break;
+      }
+
+      start = benchNow();
+      handle = persComDbOpen(gConfig.path, OPEN_WRITE_THROUGH);
+      benchLatencyAdd(&openLat, benchNow() - start);
+      if (handle < 0)
+      {
+         countError("open", handle);
+         result = -1;
+         break;
+      }
+      info = kdbSharedInfoLookup(gConfig.path);
+      if (info != NULL)
+      {
+         for (step = 0; step < KDB_RECOVERY_STEPS; step++)
+         {
+            benchLatencyAdd(&stepLat[step], KDB_STAT_GET(&info->stats, recoveryNs[step]));
+         }
+         recoveries = KDB_STAT_GET(&info->stats, recoveries);
+      }
+      keysAfter = countKeys(handle);
+      (void) persComDbClose(handle);
+   }
+
+   if (result == 0)
+   {
+      printf("{\"bench\":\"%s\",\"phase\":\"recovery\",\"keys\":%u,\"damage\":\"%s\",\"damaged_blocks\":%d,\"page_cache\":\"%s\","
+             "\"runs\":%u,\"recovered\":%s,\"keys_after\":%d,\"open_p50_ns\":%llu,\"open_max_ns\":%llu,\"steps_p50_ns\":{",
+             BENCH_NAME, keys, gDamageNames[damage], damaged, gConfig.warm ? "warm" : "cold", gConfig.runs,
+             (recoveries > 0) ? "true" : "false", keysAfter,
+             (unsigned long long) benchLatencyPercentile(&openLat, 0.5), (unsigned long long) benchLatencyPercentile(&openLat, 1.0));
+      for (step = 0; step < KDB_RECOVERY_STEPS; step++)
+      {
+         printf("%s\"%s\":%llu", (step == 0) ? "" : ",", gStepNames[step],
+                (unsigned long long) benchLatencyPercentile(&stepLat[step], 0.5));
+      }
+      printf("}}\n");
+   }
+
+   benchLatencyFree(&openLat);
+   for (step = 0; step < KDB_RECOVERY_STEPS; step++)
+   {
+      benchLatencyFree(&stepLat[step]);
+   }
+   return result;
+}
+
+
+int main(int argc, char* argv[])
+{
+   static char value[PERS_DB_MAX_SIZE_KEY_DATA];
+   char cleanPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME];
+   char keyList[256], damageList[256];
+   char *keyToken, *keySave = NULL;
+   uint64_t rnd;
+   unsigned int i;
+   int opt, result = 0;
+
+   while ((opt = getopt(argc, argv, "d:k:D:p:v:r:ws:Kh")) != -1)
+   {
+      switch (opt)
+      {
+         case 'd': gConfig.path = optarg; break;
+         case 'k': gConfig.keyCounts = optarg; break;
+         case 'D': gConfig.damages = optarg; break;
+         case 'p': gConfig.damagePct = strtod(optarg, NULL); break;
+         case 'v': gConfig.valueSize = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'r': gConfig.runs = (unsigned int) strtoul(optarg, NULL, 0); break;
+         case 'w': gConfig.warm = 1; break;
+         case 's': gConfig.seed = strtoull(optarg, NULL, 0); break;
+         case 'K': gConfig.keep = 1; break;
+         default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+      }
+   }
+   if (gConfig.runs == 0 || gConfig.valueSize == 0 || gConfig.valueSize > PERS_DB_MAX_SIZE_KEY_DATA
+       || gConfig.damagePct < 0.0 || gConfig.damagePct > 100.0)
+   {
+      usage(argv[0]);
+      return 1;
+   }
+   (void) snprintf(cleanPath, sizeof(cleanPath), "%s.clean", gConfig.path);
+   (void) snprintf(keyList, sizeof(keyList), "%s", gConfig.keyCounts);
+
+   rnd = (gConfig.seed != 0) ? gConfig.seed : 1;
+   for (i = 0; i < sizeof(value); i++)
+   {
+      value[i] = (char) ('a' + (benchRandom(&rnd) % 26));
+   }
+
+   printf("{\"bench\":\"%s\",\"config\":{\"path\":\"%s\",\"keys\":\"%s\",\"damages\":\"%s\",\"damage_pct\":%.2f,"
+          "\"value_size\":%u,\"runs\":%u,\"page_cache\":\"%s\",\"seed\":%llu}}\n",
+          BENCH_NAME, gConfig.path, gConfig.keyCounts, gConfig.damages, gConfig.damagePct, gConfig.valueSize,
+          gConfig.runs, gConfig.warm ? "warm" : "cold", (unsigned long long) gConfig.seed);
+
+   for (keyToken = strtok_r(keyList, ",", &keySave); keyToken != NULL && result == 0; keyToken = strtok_r(NULL, ",", &keySave))
+   {
+      unsigned int keys = (unsigned int) strtoul(keyToken, NULL, 0);
+      char *damageToken, *damageSave = NULL;
+
+      if (keys == 0 || generate(cleanPath, keys, value) != 0)
+      {
+         result = 1;
+         break;
+      }
+      (void) snprintf(damageList, sizeof(damageList), "%s", gConfig.damages);
+      for (damageToken = strtok_r(damageList, ",", &damageSave); damageToken != NULL; damageToken = strtok_r(NULL, ",", &damageSave))
+      {
+         int damage = parseDamage(damageToken);
+
+         if (damage < 0)
+         {
+            fprintf(stderr, "%s: unknown damage: %s\n", BENCH_NAME, damageToken);
+            result = 1;
+            break;
+         }
+         if (runDamage(cleanPath, keys, (Damage_e) damage, &rnd) != 0)
+         {
+            result = 1;
+         }
+      }
+   }
+   printf("{\"bench\":\"%s\",\"errors\":%lu}\n", BENCH_NAME, gErrors);
+
+   if (!gConfig.keep)
+   {
+      (void) remove(cleanPath);
+      (void) remove(gConfig.path);
+   }
+   return (result != 0 || gErrors > 0) ? 1 : 0;
+}
@@ -29,8 +29,9 @@ extern "C"
 #endif  /* #ifdef __cplusplus */
 
 #include "persComTypes.h"
+#include "persComDbAccess.h"
 
-#define PERSIST_LOW_LEVEL_DB_ACCESS_INTERFACE_VERSION  (0x03000000U)
+#define PERSIST_LOW_LEVEL_DB_ACCESS_INTERFACE_VERSION  (0x03010000U)
 
 /* The supported purposes of low level DBs 
  * Needed to allow different setups of DBs according to their purposes
@@ -147,6 +148,253 @@ sint_t pers_lldb_get_size_keys_list(sint_t handlerDB, pers_lldb_purpose_e ePurpo
  */
  sint_t pers_lldb_get_keys_list(sint_t handlerDB, pers_lldb_purpose_e ePurpose, pstr_t listingBuffer_out, sint_t bufSize) ;
 
+/**
+ * @brief fill a key descriptor: key's name, its length and the hash used by the database
+ *
+ * @param key               [in] key's name
+ * @param pKey_out          [out]key descriptor
+ *
+ * @return 0 for success, negative value otherway (see pers_error_codes.h)
+ */
+sint_t pers_lldb_prepare_key(str_t const * key, persComDbKey_t * pKey_out) ;
+
+/**
+ * @brief write a key-value pair into database, the key is given as key descriptor
+ *
+ * @param handlerDB     [in] handler obtained with pers_lldb_open
+ * @param ePurpose      [in] see pers_lldb_purpose_e
+ * @param pKey          [in] key descriptor filled by pers_lldb_prepare_key
+ * @param data          [in] buffer with key's data
+ * @param dataSize      [in] size of key's data
+ *
+ * @return bytes written for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_write_key_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const * pKey, str_t const * data, sint_t dataSize) ;
+
+/**
+ * @brief queue the write of a key-value pair, the key is written by the write worker thread of the process
+ *
+ * @param handlerDB     [in] handler obtained with pers_lldb_open
+ * @param ePurpose      [in] see pers_lldb_purpose_e
+ * @param pKey          [in] key descriptor filled by pers_lldb_prepare_key
+ * @param data          [in] buffer with key's data, copied
+ * @param dataSize      [in] size of key's data
+ * @param callback      [in] called by the worker thread with the result of the write (can be NIL)
+ * @param ctx           [in] context passed to the callback
+ *
+ * @return 0 if the write is queued, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_write_key_async(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const * pKey, str_t const * data, sint_t dataSize,
+                                 persComDbWriteCallback_t callback, void * ctx) ;
+
+/**
+ * @brief eventfd signaled when queued writes are done, its counter is increased by one per write
+ *
+ * @return file descriptor, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_get_async_write_fd(void) ;
+
+/**
+ * @brief read a key's value from database, the key is given as key descriptor
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param pKey              [in] key descriptor filled by pers_lldb_prepare_key
+ * @param dataBuffer_out    [out]buffer where to return the read data
+ * @param bufSize           [in] size of dataBuffer_out
+ *
+ * @return read size, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_read_key_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const * pKey, pstr_t dataBuffer_out, sint_t bufSize) ;
+
+/**
+ * @brief read a key's value from database into a buffer returned by allocator, the key is looked up once
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param pKey              [in] key descriptor filled by pers_lldb_prepare_key
+ * @param allocator         [in] function returning the buffer for the data (NIL: malloc)
+ * @param ctx               [in] context passed to the allocator
+ * @param dataBuffer_out    [out]buffer returned by the allocator (NIL for empty data)
+ *
+ * @return read size, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_read_key_alloc_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const * pKey,
+                                         persComDbAllocCallback_t allocator, void * ctx, pstr_t * dataBuffer_out) ;
+
+/**
+ * @brief reads the size of a value that corresponds to a key, the key is given as key descriptor
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param pKey              [in] key descriptor filled by pers_lldb_prepare_key
+ *
+ * @return size of the value corresponding to the key, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_get_key_size_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const * pKey) ;
+
+/**
+ * @brief delete key from database, the key is given as key descriptor
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param pKey              [in] key descriptor filled by pers_lldb_prepare_key
+ *
+ * @return 0 for success, negative value otherway (see pers_error_codes.h)
+ */
+sint_t pers_lldb_delete_key_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const * pKey) ;
+
+/**
+ * @brief read the values of several keys from database
+ * @note : the key-value-store backend locks the database once for all keys
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param keys              [in] keys' names
+ * @param dataBuffers_out   [out]buffers where to return the read data, one per key
+ * @param bufSizes          [in] sizes of the buffers
+ * @param results_out       [out]per key: read size, or negative value in case of error
+ * @param count             [in] number of keys
+ *
+ * @return number of keys read, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_read_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * const * keys, pstr_t const * dataBuffers_out,
+                           sint_t const * bufSizes, sint_t * results_out, sint_t count) ;
+
+/**
+ * @brief write several key-value pairs into database
+ * @note : the key-value-store backend locks the database once for all keys
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param keys              [in] keys' names
+ * @param data              [in] buffers with the keys' data
+ * @param dataSizes         [in] sizes of the keys' data
+ * @param results_out       [out]per key: bytes written, or negative value in case of error
+ * @param count             [in] number of keys
+ *
+ * @return number of keys written, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_write_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * const * keys, str_t const * const * data,
+                            sint_t const * dataSizes, sint_t * results_out, sint_t count) ;
+
+/**
+ * @brief delete several keys from database
+ * @note : the key-value-store backend locks the database once for all keys
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param keys              [in] keys' names
+ * @param results_out       [out]per key: 0 or bytes deleted for success, or negative value in case of error
+ * @param count             [in] number of keys
+ *
+ * @return number of keys deleted, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_delete_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * const * keys, sint_t * results_out, sint_t count) ;
+
+/**
+ * @brief call a function for every key-value pair in database
+ * @note : the database is locked during the iteration, the callback must not access the same database
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param prefix            [in] only keys starting with prefix are passed to the callback (NIL or "" for all keys)
+ * @param callback          [in] function called for every key-value pair
+ * @param ctx               [in] context passed to the callback
+ *
+ * @return number of key-value pairs passed to the callback, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_for_each(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * prefix, persComDbForEachCallback_t callback, void * ctx) ;
+
+/**
+ * @brief list one page of the keys' names in database, the pages are listed in the order of the keys' hashes
+ * @note : keys are separated by '\0'; the keys of one hash are never split over two pages
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ * @param cursor            [in] 0 for the first page, otherwise the cursor returned by the previous page
+ * @param listingBuffer_out [out]buffer where to return the page
+ * @param bufSize           [in] size of listingBuffer_out
+ * @param pNextCursor_out   [out]cursor of the next page, 0 after the last page
+ *
+ * @return size of the page, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_list_keys_page(sint_t handlerDB, pers_lldb_purpose_e ePurpose, unsigned long long cursor, pstr_t listingBuffer_out,
+                                sint_t bufSize, unsigned long long * pNextCursor_out) ;
+
+/**
+ * @brief start a transaction: its puts and deletes are applied all together or not at all by pers_lldb_tx_commit
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param ePurpose          [in] see pers_lldb_purpose_e
+ *
+ * @return transaction id (positive value), or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_tx_begin(sint_t handlerDB, pers_lldb_purpose_e ePurpose) ;
+
+/**
+ * @brief add the write of a key-value pair to a transaction
+ *
+ * @param txId          [in] transaction id obtained with pers_lldb_tx_begin
+ * @param pKey          [in] key descriptor filled by pers_lldb_prepare_key
+ * @param data          [in] buffer with key's data, copied
+ * @param dataSize      [in] size of key's data
+ *
+ * @return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_tx_put(sint_t txId, persComDbKey_t const * pKey, str_t const * data, sint_t dataSize) ;
+
+/**
+ * @brief add the delete of a key to a transaction
+ *
+ * @param txId          [in] transaction id obtained with pers_lldb_tx_begin
+ * @param pKey          [in] key descriptor filled by pers_lldb_prepare_key
+ *
+ * @return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_tx_delete(sint_t txId, persComDbKey_t const * pKey) ;
+
+/**
+ * @brief commit a transaction, the transaction is released in any case
+ *
+ * @param txId          [in] transaction id obtained with pers_lldb_tx_begin
+ *
+ * @return number of operations of the transaction, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_tx_commit(sint_t txId) ;
+
+/**
+ * @brief release a transaction without applying its operations
+ *
+ * @param txId          [in] transaction id obtained with pers_lldb_tx_begin
+ *
+ * @return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_tx_abort(sint_t txId) ;
+
+/**
+ * @brief write the data of a database to its file while the database stays open.
+ *        In write cached mode only the entries of the cache modified since the previous sync are written back.
+ *
+ * @param handlerDB     [in] handler obtained with pers_lldb_open
+ * @param ePurpose      [in] see pers_lldb_purpose_e (only PersLldbPurpose_DB is supported)
+ *
+ * @return number of cache entries written back or deleted, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_sync(sint_t handlerDB, pers_lldb_purpose_e ePurpose) ;
+
+/**
+ * @brief write a consistent copy of a database to a file while the database stays open.
+ *        The database is locked only to write back the cache and to clone or copy into memory the database file.
+ *
+ * @param handlerDB     [in] handler obtained with pers_lldb_open
+ * @param ePurpose      [in] see pers_lldb_purpose_e (only PersLldbPurpose_DB is supported)
+ * @param destPath      [in] path of the copy, replaced when the copy is complete
+ *
+ * @return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_snapshot(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* destPath) ;
+
 
 
 #ifdef __cplusplus
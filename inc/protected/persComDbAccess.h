@@ -39,7 +39,7 @@ extern "C"
 /** \defgroup PERS_DB_ACCESS_IF_VERSION Interface version
  *  \{
  */
-#define PERS_COM_DB_ACCESS_INTERFACE_VERSION  (0x05000000U)
+#define PERS_COM_DB_ACCESS_INTERFACE_VERSION  (0x05010000U)
 /** \} */ 
 
 
@@ -53,6 +53,59 @@ extern "C"
 /** \} */
 
 
+/** \defgroup PERS_DB_ACCESS_TYPES Types
+ *  \{
+ */
+/**
+ * \brief prepared key: key's name together with its length and hash
+ * \note : filled by \ref persComDbPrepareKey, the members must not be modified by the caller.
+ *         The key's name is referenced, not copied, and must stay valid as long as the prepared key is used.
+ */
+typedef struct
+{
+   char const *       key ;     /**< key's name */
+   unsigned int       length ;  /**< length of the key's name (without '\0') */
+   unsigned long long hash ;    /**< hash of the key's name as used by the backend database */
+   unsigned int       cacheHash ; /**< hash of the key's name as used by the backend's cache */
+} persComDbKey_t ;
+
+/**
+ * \brief function called by \ref persComDbForEach for every key-value pair
+ * \note : the database is locked during the call, the function must not access the same database
+ *
+ * \param key       [in] key's name
+ * \param data      [in] key's data, valid only during the call
+ * \param dataSize  [in] size of key's data
+ * \param ctx       [in] context given to \ref persComDbForEach
+ *
+ * \return 0 to continue with the next key, other value to stop the iteration
+ */
+typedef signed int (*persComDbForEachCallback_t)(char const * key, char const * data, signed int dataSize, void * ctx) ;
+
+/**
+ * \brief function called by \ref persComDbReadKeyAlloc to get the buffer for the key's data
+ * \note : the database is not locked during the call
+ *
+ * \param size      [in] size of the key's data (> 0)
+ * \param ctx       [in] context given to \ref persComDbReadKeyAlloc
+ *
+ * \return buffer of at least size bytes, or NIL if no memory is available
+ */
+typedef void * (*persComDbAllocCallback_t)(signed int size, void * ctx) ;
+
+/**
+ * \brief function called by the write worker of the process when a write queued with \ref persComDbWriteKeyAsync is done
+ * \note : called by the write worker thread, the next queued writes wait until the function returns
+ *
+ * \param handlerDB [in] handler given to \ref persComDbWriteKeyAsync
+ * \param key       [in] key's name
+ * \param result    [in] same value as returned by \ref persComDbWriteKey
+ * \param ctx       [in] context given to \ref persComDbWriteKeyAsync
+ */
+typedef void (*persComDbWriteCallback_t)(signed int handlerDB, char const * key, signed int result, void * ctx) ;
+/** \} */
+
+
 /** \defgroup PERS_DB_ACCESS_FUNCTIONS Functions
  *  \{
  */
@@ -70,7 +123,7 @@ int persComDbgetMaxKeyValueSize(void);
  * \note : DB is created if it does not exist and (bForceCreationIfNotPresent != 0)
  *
  * \param dbPathname    [in] absolute path to database (length limited to \ref PERS_ORG_MAX_LENGTH_PATH_FILENAME)
- * \param bOption       [in] bitfield option: 0x01: create if not exists, 0x02: write through, 0x04: read only
+ * \param bOption       [in] bitfield option: 0x01: create if not exists, 0x02: write through, 0x04: read only, 0x10: process private (no shared memory, exclusive use by one handle)
  * \Remarks the support of the option depends from backend database realisation
  * \return >= 0 for valid handler, negative value for error (\ref PERS_COM_ERROR_CODES_DEFINES)
  */
@@ -120,6 +173,22 @@ signed int persComDbReadKey(signed int handlerDB, char const * key, char* dataBu
  */
 signed int persComDbGetKeySize(signed int handlerDB, char const * key) ;
 
+/**
+ * \brief read a key's value from local/shared database into a buffer of the key's size
+ * \note : the key is looked up once, replaces \ref persComDbGetKeySize followed by \ref persComDbReadKey.
+ *         No buffer is allocated for a key with empty data (*dataBuffer_out is set to NIL).
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param key               [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param allocator         [in] function returning the buffer for the data, see \ref persComDbAllocCallback_t
+ *                               (NIL: the buffer is allocated with malloc and must be released with free)
+ * \param ctx               [in] context passed to the allocator
+ * \param dataBuffer_out    [out]buffer returned by the allocator, filled with the key's data
+ *
+ * \return read size, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbReadKeyAlloc(signed int handlerDB, char const * key, persComDbAllocCallback_t allocator, void * ctx, char ** dataBuffer_out) ;
+
 /**
  * \brief delete key from local/shared database
  *
@@ -152,6 +221,246 @@ signed int persComDbGetSizeKeysList(signed int handlerDB) ;
  */
 signed int persComDbGetKeysList(signed int handlerDB, char* listBuffer_out, signed int listBufferSize) ;
 
+/**
+ * \brief prepare a key for repeated access: length and hash of the key's name are computed only once
+ *
+ * \param key           [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param pKey_out      [out]prepared key to be used with the persComDb...Prepared functions
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbPrepareKey(char const * key, persComDbKey_t * pKey_out) ;
+
+/**
+ * \brief write a key-value pair into local/shared database, the key is given as prepared key
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param pKey          [in] key prepared with \ref persComDbPrepareKey
+ * \param data          [in] buffer with key's data
+ * \param dataSize      [in] size of key's data (max allowed \ref PERS_DB_MAX_SIZE_KEY_DATA)
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbWriteKeyPrepared(signed int handlerDB, persComDbKey_t const * pKey, char const * data, signed int dataSize) ;
+
+/**
+ * \brief write a key-value pair into local/shared database without waiting for the write
+ * \note : the write is queued and done by the write worker thread of the process, in the order of the calls.
+ *         Until it is done, reads of the key in this process return the queued data; all other accesses to
+ *         the database (writes, deletes, lists, close) wait until the queued writes are done.
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param key           [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param data          [in] buffer with key's data, copied
+ * \param dataSize      [in] size of key's data (max allowed \ref PERS_DB_MAX_SIZE_KEY_DATA)
+ * \param callback      [in] function called when the write is done, see \ref persComDbWriteCallback_t (can be NIL)
+ * \param ctx           [in] context passed to the callback
+ *
+ * \return 0 if the write is queued, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbWriteKeyAsync(signed int handlerDB, char const * key, char const * data, signed int dataSize,
+                                  persComDbWriteCallback_t callback, void * ctx) ;
+
+/**
+ * \brief file descriptor to poll for the end of writes queued with \ref persComDbWriteKeyAsync
+ * \note : eventfd (non blocking) readable when writes are done, reading it returns the number of writes done
+ *         since the last read. The descriptor belongs to the library and must not be closed.
+ *
+ * \return file descriptor, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbGetAsyncWriteFd(void) ;
+
+/**
+ * \brief read a key's value from local/shared database, the key is given as prepared key
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param pKey              [in] key prepared with \ref persComDbPrepareKey
+ * \param dataBuffer_out    [out]buffer where to return the read data
+ * \param dataBufferSize    [in] size of dataBuffer_out
+ *
+ * \return read size, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbReadKeyPrepared(signed int handlerDB, persComDbKey_t const * pKey, char* dataBuffer_out, signed int dataBufferSize) ;
+
+/**
+ * \brief read a key's size from local/shared database, the key is given as prepared key
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param pKey              [in] key prepared with \ref persComDbPrepareKey
+ *
+ * \return key's size, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbGetKeySizePrepared(signed int handlerDB, persComDbKey_t const * pKey) ;
+
+/**
+ * \brief delete key from local/shared database, the key is given as prepared key
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param pKey          [in] key prepared with \ref persComDbPrepareKey
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbDeleteKeyPrepared(signed int handlerDB, persComDbKey_t const * pKey) ;
+
+/**
+ * \brief read the values of several keys from local/shared database with one access to the database
+ * \note : the keys are read one after the other, an error of one key does not stop the others
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param keys              [in] keys' names (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param dataBuffers_out   [out]buffers where to return the read data, one per key
+ * \param dataBufferSizes   [in] sizes of the buffers
+ * \param results_out       [out]per key: read size, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ * \param count             [in] number of keys (size of the arrays)
+ *
+ * \return number of keys read, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbReadKeys(signed int handlerDB, char const * const * keys, char * const * dataBuffers_out,
+                             signed int const * dataBufferSizes, signed int * results_out, signed int count) ;
+
+/**
+ * \brief write several key-value pairs into local/shared database with one access to the database
+ * \note : the keys are written one after the other, an error of one key does not stop the others
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param keys              [in] keys' names (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param data              [in] buffers with the keys' data
+ * \param dataSizes         [in] sizes of the keys' data (max allowed \ref PERS_DB_MAX_SIZE_KEY_DATA)
+ * \param results_out       [out]per key: same value as returned by \ref persComDbWriteKey
+ * \param count             [in] number of keys (size of the arrays)
+ *
+ * \return number of keys written, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbWriteKeys(signed int handlerDB, char const * const * keys, char const * const * data,
+                              signed int const * dataSizes, signed int * results_out, signed int count) ;
+
+/**
+ * \brief delete several keys from local/shared database with one access to the database
+ * \note : the keys are deleted one after the other, an error of one key does not stop the others
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param keys              [in] keys' names (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param results_out       [out]per key: same value as returned by \ref persComDbDeleteKey
+ * \param count             [in] number of keys (size of the arrays)
+ *
+ * \return number of keys deleted, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbDeleteKeys(signed int handlerDB, char const * const * keys, signed int * results_out, signed int count) ;
+
+/**
+ * \brief call a function for every key-value pair in local/shared database
+ * \note : the keys are passed in no particular order, without building the list of keys.
+ *         The database is locked during the iteration, the callback must not access the same database.
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param prefix        [in] only keys starting with prefix are passed to the callback (NIL or "" for all keys)
+ * \param callback      [in] function called for every key-value pair, see \ref persComDbForEachCallback_t
+ * \param ctx           [in] context passed to the callback
+ *
+ * \return number of key-value pairs passed to the callback, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbForEach(signed int handlerDB, char const * prefix, persComDbForEachCallback_t callback, void * ctx) ;
+
+/**
+ * \brief list the keys' names of local/shared database page by page
+ * \note : keys are separated by '\0'.
+ *         The pages are listed in the order of the keys' hashes, not in alphabetical order.
+ *         A key existing during the whole listing is returned exactly once, keys written or deleted
+ *         during the listing may be returned or not.
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param cursor            [in] 0 for the first page, otherwise the value of nextCursor_out of the previous page
+ * \param listBuffer_out    [out]buffer where to return the page
+ * \param listBufferSize    [in] size of listBuffer_out
+ * \param nextCursor_out    [out]cursor of the next page, 0 after the last page
+ *
+ * \return size of the page (can be 0 only for the last page), or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES).
+ *         \ref PERS_COM_ERR_BUFFER_TOO_SMALL if the next key does not fit in listBuffer_out
+ */
+signed int persComDbListKeysPage(signed int handlerDB, unsigned long long cursor, char* listBuffer_out, signed int listBufferSize,
+                                 unsigned long long * nextCursor_out) ;
+
+/**
+ * \brief start a transaction on local/shared database
+ * \note : the puts and deletes of the transaction are not visible before \ref persComDbTxCommit, which applies
+ *         all of them or none of them, also after a crash. The commit costs one sync of the transaction log whatever
+ *         the number of operations (plus one sync of the database file in write through mode).
+ *         A transaction is used by one thread at a time.
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ *
+ * \return transaction id (positive value), or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbTxBegin(signed int handlerDB) ;
+
+/**
+ * \brief add the write of a key-value pair to a transaction
+ *
+ * \param txId          [in] transaction id obtained with \ref persComDbTxBegin
+ * \param key           [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param data          [in] buffer with key's data, copied
+ * \param dataSize      [in] size of key's data (max allowed \ref PERS_DB_MAX_SIZE_KEY_DATA)
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbTxPut(signed int txId, char const * key, char const * data, signed int dataSize) ;
+
+/**
+ * \brief add the delete of a key to a transaction
+ * \note : the delete of a key which does not exist is not an error of the commit
+ *
+ * \param txId          [in] transaction id obtained with \ref persComDbTxBegin
+ * \param key           [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbTxDelete(signed int txId, char const * key) ;
+
+/**
+ * \brief apply all the puts and deletes of a transaction, in the order they were added
+ * \note : the transaction is released, also in case of error
+ *
+ * \param txId          [in] transaction id obtained with \ref persComDbTxBegin
+ *
+ * \return number of operations of the transaction, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbTxCommit(signed int txId) ;
+
+/**
+ * \brief release a transaction without applying its puts and deletes
+ *
+ * \param txId          [in] transaction id obtained with \ref persComDbTxBegin
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbTxAbort(signed int txId) ;
+
+/**
+ * \brief write the data of a local/shared database to its file without closing the database
+ * \note : in write cached mode the data written or deleted since the previous sync is written back; the written data stays
+ *         in the cache for reading. In both modes the index of the database file is updated and the file is synced.
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ *
+ * \return number of keys written back or deleted, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbSync(signed int handlerDB) ;
+
+/**
+ * \brief write a consistent copy of a local/shared database to a file, e.g. for a backup, without closing the database
+ * \note : the copy contains the data written before the call, the writers are blocked only while the database file is
+ *         cloned (on filesystems with reflinks) or copied into memory; the copy is written to the file afterwards.
+ *         The copy into memory needs memory of the size of the database file and blocks the writers for a time
+ *         proportional to it (about 0.2 ms per MiB measured on a 2.1 GHz x86_64).
+ *         The copy is written to "<destPath>.tmp" and renamed to destPath when it is complete.
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param destPath      [in] path of the copy, not the path of the database (length limited to \ref PERS_ORG_MAX_LENGTH_PATH_FILENAME)
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbSnapshot(signed int handlerDB, char const * destPath) ;
+
 /** \} */ /* End of PERS_DB_ACCESS_FUNCTIONS */
 
 
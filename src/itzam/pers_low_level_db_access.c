@@ -517,6 +517,287 @@ sint_t pers_lldb_get_size_keys_list(sint_t handlerDB, pers_lldb_purpose_e ePurpo
     return eErrorCode ;
 }
 
+/**
+ * \brief fill a key descriptor: key's name, its length and the hash used by the database
+ * \note : the hash is not used by this backend
+ *
+ * \param key               [in] key's name
+ * \param pKey_out          [out]key descriptor
+ *
+ * \return 0 for success, negative value otherway (see pers_error_codes.h)
+ */
+sint_t pers_lldb_prepare_key(str_t const * key, persComDbKey_t * pKey_out)
+{
+    sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM ;
+
+    if((NIL != key) && (NIL != pKey_out))
+    {
+        pKey_out->key = key ;
+        pKey_out->length = (unsigned int) strlen(key) ;
+        pKey_out->hash = 0 ;
+        pKey_out->cacheHash = 0 ;
+        eErrorCode = PERS_COM_SUCCESS ;
+    }
+    return eErrorCode ;
+}
+
+/* the prepared key variants are mapped to the key's name for this backend */
+sint_t pers_lldb_write_key_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const * pKey, str_t const * data, sint_t dataSize)
+{
+    return pers_lldb_write_key(handlerDB, ePurpose, (NIL != pKey) ? pKey->key : NIL, data, dataSize) ;
+}
+
+/* no write worker in this backend */
+sint_t pers_lldb_write_key_async(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const * pKey, str_t const * data, sint_t dataSize,
+                                 persComDbWriteCallback_t callback, void * ctx)
+{
+    (void)handlerDB ;
+    (void)ePurpose ;
+    (void)pKey ;
+    (void)data ;
+    (void)dataSize ;
+    (void)callback ;
+    (void)ctx ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+sint_t pers_lldb_get_async_write_fd(void)
+{
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+sint_t pers_lldb_read_key_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const * pKey, pstr_t dataBuffer_out, sint_t bufSize)
+{
+    return pers_lldb_read_key(handlerDB, ePurpose, (NIL != pKey) ? pKey->key : NIL, dataBuffer_out, bufSize) ;
+}
+
+sint_t pers_lldb_get_key_size_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const * pKey)
+{
+    return pers_lldb_get_key_size(handlerDB, ePurpose, (NIL != pKey) ? pKey->key : NIL) ;
+}
+
+/* no single lookup in this backend: the size is read first, then the data */
+sint_t pers_lldb_read_key_alloc_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const * pKey,
+                                         persComDbAllocCallback_t allocator, void * ctx, pstr_t * dataBuffer_out)
+{
+    sint_t size = PERS_COM_ERR_INVALID_PARAM ;
+    pstr_t buffer = NIL ;
+
+    if(NIL == dataBuffer_out)
+    {
+        return PERS_COM_ERR_INVALID_PARAM ;
+    }
+    *dataBuffer_out = NIL ;
+    size = pers_lldb_get_key_size_prepared(handlerDB, ePurpose, pKey) ;
+    if(size > 0)
+    {
+        buffer = (NIL != allocator) ? (pstr_t)allocator(size, ctx) : (pstr_t)malloc((size_t)size) ;
+        if(NIL == buffer)
+        {
+            return PERS_COM_ERR_MALLOC ;
+        }
+        size = pers_lldb_read_key_prepared(handlerDB, ePurpose, pKey, buffer, size) ;
+        if(size >= 0)
+        {
+            *dataBuffer_out = buffer ;
+        }
+        else if(NIL == allocator)
+        {
+            free(buffer) ;
+        }
+    }
+    return size ;
+}
+
+sint_t pers_lldb_delete_key_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const * pKey)
+{
+    return pers_lldb_delete_key(handlerDB, ePurpose, (NIL != pKey) ? pKey->key : NIL) ;
+}
+
+
+/* no common lock in this backend: the keys are accessed one after the other */
+sint_t pers_lldb_read_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * const * keys, pstr_t const * dataBuffers_out,
+                           sint_t const * bufSizes, sint_t * results_out, sint_t count)
+{
+    sint_t done = 0 ;
+    sint_t i = 0 ;
+
+    if((NIL == keys) || (NIL == dataBuffers_out) || (NIL == bufSizes) || (NIL == results_out) || (count < 0))
+    {
+        return PERS_COM_ERR_INVALID_PARAM ;
+    }
+    for(i = 0 ; i < count ; i++)
+    {
+        results_out[i] = pers_lldb_read_key(handlerDB, ePurpose, keys[i], dataBuffers_out[i], bufSizes[i]) ;
+        if(results_out[i] >= 0)
+        {
+            done++ ;
+        }
+    }
+    return done ;
+}
+
+sint_t pers_lldb_write_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * const * keys, str_t const * const * data,
+                            sint_t const * dataSizes, sint_t * results_out, sint_t count)
+{
+    sint_t done = 0 ;
+    sint_t i = 0 ;
+
+    if((NIL == keys) || (NIL == data) || (NIL == dataSizes) || (NIL == results_out) || (count < 0))
+    {
+        return PERS_COM_ERR_INVALID_PARAM ;
+    }
+    for(i = 0 ; i < count ; i++)
+    {
+        results_out[i] = pers_lldb_write_key(handlerDB, ePurpose, keys[i], data[i], dataSizes[i]) ;
+        if(results_out[i] >= 0)
+        {
+            done++ ;
+        }
+    }
+    return done ;
+}
+
+sint_t pers_lldb_delete_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * const * keys, sint_t * results_out, sint_t count)
+{
+    sint_t done = 0 ;
+    sint_t i = 0 ;
+
+    if((NIL == keys) || (NIL == results_out) || (count < 0))
+    {
+        return PERS_COM_ERR_INVALID_PARAM ;
+    }
+    for(i = 0 ; i < count ; i++)
+    {
+        results_out[i] = pers_lldb_delete_key(handlerDB, ePurpose, keys[i]) ;
+        if(results_out[i] >= 0)
+        {
+            done++ ;
+        }
+    }
+    return done ;
+}
+
+/* the database is not locked between the keys in this backend: the keys are listed, then read one after the other */
+sint_t pers_lldb_for_each(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * prefix, persComDbForEachCallback_t callback, void * ctx)
+{
+    sint_t count = 0 ;
+    sint_t listSize = 0 ;
+    sint_t dataSize = 0 ;
+    size_t prefixLen = (NIL != prefix) ? strlen(prefix) : 0 ;
+    pstr_t list = NIL ;
+    pstr_t data = NIL ;
+    pstr_t key = NIL ;
+
+    if(NIL == callback)
+    {
+        return PERS_COM_ERR_INVALID_PARAM ;
+    }
+    listSize = pers_lldb_get_size_keys_list(handlerDB, ePurpose) ;
+    if(listSize <= 0)
+    {
+        return listSize ;
+    }
+    list = (pstr_t)malloc((size_t)listSize) ;
+    data = (pstr_t)malloc(PERS_DB_MAX_SIZE_KEY_DATA) ;
+    if((NIL == list) || (NIL == data))
+    {
+        free(list) ;
+        free(data) ;
+        return PERS_COM_ERR_MALLOC ;
+    }
+    listSize = pers_lldb_get_keys_list(handlerDB, ePurpose, list, listSize) ;
+    if(listSize < 0)
+    {
+        count = listSize ;
+    }
+    for(key = list ; (count >= 0) && (key < list + listSize) ; key += strlen(key) + 1)
+    {
+        if((0 == prefixLen) || (0 == strncmp(key, prefix, prefixLen)))
+        {
+            dataSize = pers_lldb_read_key(handlerDB, ePurpose, key, data, PERS_DB_MAX_SIZE_KEY_DATA) ;
+            if(dataSize >= 0)
+            {
+                count++ ;
+                if(0 != callback(key, data, dataSize, ctx))
+                {
+                    break ;
+                }
+            }
+        }
+    }
+    free(list) ;
+    free(data) ;
+    return count ;
+}
+
+/* the keys have no stable order usable as cursor in this backend */
+sint_t pers_lldb_list_keys_page(sint_t handlerDB, pers_lldb_purpose_e ePurpose, unsigned long long cursor, pstr_t listingBuffer_out,
+                                sint_t bufSize, unsigned long long * pNextCursor_out)
+{
+    (void)handlerDB ;
+    (void)ePurpose ;
+    (void)cursor ;
+    (void)listingBuffer_out ;
+    (void)bufSize ;
+    (void)pNextCursor_out ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+/* no transactions in this backend */
+sint_t pers_lldb_tx_begin(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+    (void)handlerDB ;
+    (void)ePurpose ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+sint_t pers_lldb_tx_put(sint_t txId, persComDbKey_t const * pKey, str_t const * data, sint_t dataSize)
+{
+    (void)txId ;
+    (void)pKey ;
+    (void)data ;
+    (void)dataSize ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+sint_t pers_lldb_tx_delete(sint_t txId, persComDbKey_t const * pKey)
+{
+    (void)txId ;
+    (void)pKey ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+sint_t pers_lldb_tx_commit(sint_t txId)
+{
+    (void)txId ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+sint_t pers_lldb_tx_abort(sint_t txId)
+{
+    (void)txId ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+/* no incremental sync in this backend */
+sint_t pers_lldb_sync(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+    (void)handlerDB ;
+    (void)ePurpose ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+/* no snapshots in this backend */
+sint_t pers_lldb_snapshot(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const * destPath)
+{
+    (void)handlerDB ;
+    (void)ePurpose ;
+    (void)destPath ;
+    return PERS_COM_ERR_OPERATION_NOT_SUPPORTED ;
+}
+
+
 static sint_t DeleteDataFromItzamDB( sint_t dbHandler, pconststr_t key ) 
 {
     bool_t bCanContinue = true ;
@@ -20,11 +20,12 @@
 #define _FILE_OFFSET_BITS 64
 #define KISSDB_HEADER_SIZE sizeof(Header_s)
 
-#define FILE_DIR_NOT_SELF_OR_PARENT(s) ((s)[0]!='.'&&(((s)[1]!='.'||(s)[2]!='\0')||(s)[1]=='\0'))
-
 
 #include "./kissdb.h"
+#include "./kissdb_arena.h"
 #include "../crc32.h"
+#include "../pers_lldb_probes.h"
+#include "../pers_lldb_trace.h"
 #include <string.h>
 #include <stdlib.h>
 #include <inttypes.h>
@@ -32,13 +33,15 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/mman.h>
+#include <sys/file.h>
 #include <unistd.h>
 #include <ctype.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/syscall.h>
+#include <time.h>
 #include <semaphore.h>
 #include <dlt.h>
-#include <dirent.h>
 #include "persComErrors.h"
 
 //
@@ -46,6 +49,15 @@
 //extern void __gcov_flush(void);
 //#endif
 
+/* open file description locks (linux/fcntl.h), not defined by older C libraries */
+#ifndef F_OFD_GETLK
+#define F_OFD_GETLK 36
+#define F_OFD_SETLK 37
+#endif
+
+/* a remap is counted in the statistics of the database and reported to the slow operation log */
+#define KDB_COUNT_REMAP(db) do { KDB_STAT_ADD(&(db)->shared->stats, remaps, 1); LLDB_OP_FLAG(LLDB_OP_FLAG_REMAP); } while (0)
+
 //#define PFS_TEST
 //extern DltContext persComLldbDLTCtx;
 DLT_IMPORT_CONTEXT (persComLldbDLTCtx)
@@ -58,7 +70,7 @@ inline long long getNsDuration(struct timespec* start, struct timespec* end)
 #endif
 
 /* djb2 hash function */
-static uint64_t KISSDB_hash(const void* b, unsigned long len)
+uint64_t KISSDB_hash(const void* b, unsigned long len)
 {
    unsigned long i;
    uint64_t hash = 5381;
@@ -108,6 +120,38 @@ char* kdbGetShmName(const char* tailing, const char* path)
 #endif
 
 
+//read only mapping of the shared information of a database opened by any process (used by diagnostic tools and benchmarks)
+//returns NULL if the database is not opened or is opened process private
+Shared_Data_s* kdbSharedInfoLookup(const char* path)
+{
+   Shared_Data_s* shared = NULL;
+   char* name;
+   int fd;
+
+#ifdef PERS_SHM_ARENA_ROOT
+   shared = kdbArenaLookup(PERS_SHM_ARENA_ROOT, path);
+   if (shared != NULL)
+   {
+      return shared;
+   }
+#endif
+   name = kdbGetShmName("-shm-info", path);
+   if (name == NULL)
+   {
+      return NULL;
+   }
+   fd = shm_open(name, O_RDONLY, 0);
+   free(name);
+   if (fd < 0)
+   {
+      return NULL;
+   }
+   shared = (Shared_Data_s*) mmap(NULL, sizeof(Shared_Data_s), PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   return (shared == MAP_FAILED) ? NULL : shared;
+}
+
+
 
 //returns -1 on error and positive value for success
 int kdbShmemOpen(const char* name, size_t length, Kdb_bool* shmCreator)
@@ -137,18 +181,103 @@ int kdbShmemOpen(const char* name, size_t length, Kdb_bool* shmCreator)
    return result;
 }
 
-void Kdb_wrlock(pthread_rwlock_t* wrlock)
+#ifdef PERS_LLDB_LOCK_PROFILE
+uint64_t kdbLockProfileNow(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+static uint32_t lockProfileBucket(uint64_t ns)
+{
+   uint64_t us = ns / 1000;
+   uint32_t bucket = 0;
+
+   while (us > 0 && bucket < KDB_LOCK_HIST_BUCKETS - 1)
+   {
+      us >>= 1;
+      bucket++;
+   }
+   return bucket;
+}
+
+//must be called by the new holder of the lock
+void kdbLockProfileAcquired(Kdb_stats_s* stats, int lock, uint64_t startNs, uint64_t acquiredNs)
 {
+   Kdb_lock_prof_s* prof = &stats->locks[lock];
+
+   KDB_STAT_ADD(prof, acquisitions, 1);
+   KDB_STAT_ADD(prof, waitNs, acquiredNs - startNs);
+   KDB_STAT_ADD(prof, waitHist[lockProfileBucket(acquiredNs - startNs)], 1);
+   prof->acquiredNs = acquiredNs;
+   prof->holderTid = (uint32_t) syscall(SYS_gettid);
+   __atomic_store_n(&prof->holderPid, (uint32_t) getpid(), __ATOMIC_RELAXED);
+}
+
+//must be called by the holder of the lock before the lock is released
+void kdbLockProfileRelease(Kdb_stats_s* stats, int lock)
+{
+   Kdb_lock_prof_s* prof = &stats->locks[lock];
+   uint64_t holdNs;
+   int i, shortest = 0;
+
+   if (prof->holderPid == 0) //acquisition was not recorded
+   {
+      return;
+   }
+   holdNs = kdbLockProfileNow() - prof->acquiredNs;
+   KDB_STAT_ADD(prof, holdNs, holdNs);
+   KDB_STAT_ADD(prof, holdHist[lockProfileBucket(holdNs)], 1);
+
+   //the list is only modified by the holder of the lock
+   for (i = 1; i < KDB_LOCK_TOP_HOLDERS; i++)
+   {
+      if (prof->longest[i].holdNs < prof->longest[shortest].holdNs)
+      {
+         shortest = i;
+      }
+   }
+   if (holdNs > prof->longest[shortest].holdNs)
+   {
+      prof->longest[shortest].pid = prof->holderPid;
+      prof->longest[shortest].tid = prof->holderTid;
+      prof->longest[shortest].holdNs = holdNs;
+   }
+   __atomic_store_n(&prof->holderPid, 0, __ATOMIC_RELAXED);
+}
+#endif
+
+void Kdb_wrlock(pthread_rwlock_t* wrlock, Kdb_stats_s* stats)
+{
+#ifdef PERS_LLDB_LOCK_PROFILE
+   uint64_t startNs = kdbLockProfileNow();
+#else
+   (void) stats;
+#endif
+   LLDB_OP_WAIT_START(waitStartNs);
+   PERS_PROBE1(lock_acquire, wrlock);
    pthread_rwlock_wrlock(wrlock);
+   PERS_PROBE1(lock_acquired, wrlock);
+   LLDB_OP_WAIT_END(waitStartNs);
+#ifdef PERS_LLDB_LOCK_PROFILE
+   kdbLockProfileAcquired(stats, KDB_LOCK_RWLOCK, startNs, kdbLockProfileNow());
+#endif
 }
 
-//void Kdb_rdlock(pthread_rwlock_t* rdlock)
+//void Kdb_rdlock(pthread_rwlock_t* rdlock, Kdb_stats_s* stats)
 //{
 //   pthread_rwlock_rdlock(rdlock);
 //}
 
-void Kdb_unlock(pthread_rwlock_t* lock)
+void Kdb_unlock(pthread_rwlock_t* lock, Kdb_stats_s* stats)
 {
+#ifdef PERS_LLDB_LOCK_PROFILE
+   kdbLockProfileRelease(stats, KDB_LOCK_RWLOCK);
+#else
+   (void) stats;
+#endif
    pthread_rwlock_unlock(lock);
 }
 
@@ -175,6 +304,17 @@ void* getKdbShmemPtr(int shmem, size_t length)
    return result;
 }
 
+//returns zero initialized memory of the process (replaces shared memory in process private mode), free with freeKdbShmemPtr
+void* getKdbPrivatePtr(size_t length)
+{
+   void* result = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (result == MAP_FAILED)
+   {
+      return ((void*) -1);
+   }
+   return result;
+}
+
 
 Kdb_bool freeKdbShmemPtr(void* shmem_ptr, size_t length)
 {
@@ -211,6 +351,35 @@ Kdb_bool resizeKdbShmem(int shmem, Hashtable_s** shmem_ptr, size_t oldLength, si
 }
 
 
+//resize the memory holding the hashtables of this instance to newLength
+Kdb_bool resizeHashtableMemory(KISSDB* db, size_t newLength)
+{
+   Kdb_bool temp;
+   void* ptr;
+
+   KDB_COUNT_REMAP(db);
+   if (db->privateMode == Kdb_true)
+   {
+      ptr = mremap(db->hashTables, db->htMappedSize, newLength, MREMAP_MAYMOVE);
+      if (ptr == MAP_FAILED)
+      {
+         return Kdb_false;
+      }
+      db->hashTables = (Hashtable_s*) ptr;
+      return Kdb_true;
+   }
+   if (db->htFd <= 0)
+   {
+      db->htFd = kdbShmemOpen(db->htName, db->htMappedSize, &temp);
+      if (db->htFd < 0)
+      {
+         return Kdb_false;
+      }
+   }
+   return resizeKdbShmem(db->htFd, &db->hashTables, db->htMappedSize, newLength);
+}
+
+
 Kdb_bool remapSharedHashtable(int shmem, Hashtable_s** shmem_ptr, size_t oldLength, size_t newLength )
 {
    //unmap hashtable with old size
@@ -259,6 +428,101 @@ void printKdb(KISSDB* db)
 #endif
 
 
+#ifdef PERS_LLDB_USDT
+static const char* const gRecoveryStepNames[KDB_RECOVERY_STEPS] =
+{
+   "check_error_flags", "verify_hashtables", "rebuild_hashtables", "recover_datablocks", "rebuild_bloom_filter"
+};
+#endif
+
+//begin of a step of KISSDB_open that may be part of the recovery after a power loss (path and step are only used by the probe)
+static uint64_t recoveryStepStart(const char* path, int step)
+{
+   struct timespec ts;
+
+   (void) path;
+   (void) step;
+   PERS_PROBE2(recovery_start, path, gRecoveryStepNames[step]);
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+//end of the step: store the duration in the performance counters (read by pers-kvs-stat and kvs_recovery_bench)
+static void recoveryStepEnd(KISSDB* db, const char* path, int step, int result, uint64_t startNs)
+{
+   struct timespec ts;
+
+   (void) path;
+   (void) result;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   KDB_STAT_SET(&db->shared->stats, recoveryNs[step], ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec - startNs);
+   PERS_PROBE3(recovery_end, path, gRecoveryStepNames[step], result);
+}
+
+
+//an attached instance holds a read lock on the byte of its registry entry (open file description lock, independent
+//of the flock of the file): the kernel releases the lock when the instance closes the file or its process ends
+static Kdb_bool attachLock(KISSDB* db, int slot, int cmd, short type, short* type_out)
+{
+   struct flock lock;
+
+   memset(&lock, 0, sizeof(lock));
+   lock.l_type = type;
+   lock.l_whence = SEEK_SET;
+   lock.l_start = KISSDB_ATTACH_LOCK_OFFSET + slot;
+   lock.l_len = 1;
+   if (fcntl(db->fd, cmd, &lock) == -1)
+   {
+      return Kdb_false;
+   }
+   if (type_out != NULL)
+   {
+      *type_out = lock.l_type;
+   }
+   return Kdb_true;
+}
+
+//register this instance in the registry of attached instances, the caller holds the write lock
+//the references of instances that ended without closing the database (application crash) are released
+static void attachInstance(KISSDB* db, const char* path)
+{
+   int i;
+   int crashed = 0;
+   short type;
+
+   for (i = 0; i < KISSDB_MAX_ATTACHED; i++)
+   {
+      //nobody holds the lock of a used entry: the instance ended without closing the database
+      if (   (db->shared->attached[i] != 0)
+          && (attachLock(db, i, F_OFD_GETLK, F_WRLCK, &type) == Kdb_true) && (type == F_UNLCK))
+      {
+         db->shared->attached[i] = 0;
+         if (db->shared->refCount > 0)
+         {
+            db->shared->refCount--;
+         }
+         crashed++;
+      }
+   }
+   if (crashed > 0)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": <"); DLT_STRING(path); DLT_STRING(">: "); DLT_INT(crashed);
+              DLT_STRING(" instance(s) ended without closing the database"));
+   }
+
+   for (i = 0; i < KISSDB_MAX_ATTACHED; i++)
+   {
+      if ((db->shared->attached[i] == 0) && (attachLock(db, i, F_OFD_SETLK, F_RDLCK, NULL) == Kdb_true))
+      {
+         db->shared->attached[i] = (int32_t) getpid();
+         db->attachSlot = i;
+         return;
+      }
+   }
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": <"); DLT_STRING(path); DLT_STRING(">: "); DLT_STRING("registry of attached instances is full, instance is not tracked"));
+}
+
+
 int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint16_t hash_table_size, uint64_t key_size, uint64_t value_size)
 {
    Hashtable_s* htptr;
@@ -271,20 +535,44 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
 
    if (db->alreadyOpen == Kdb_false) //check if this instance has already opened the db before
    {
+      db->attachSlot = -1;
       db->sharedName = kdbGetShmName("-shm-info", path);
       if (db->sharedName == NULL)
       {
          return KISSDB_ERROR_MALLOC;
       }
-      db->sharedFd = kdbShmemOpen(db->sharedName, sizeof(Shared_Data_s), &db->shmCreator);
-      if (db->sharedFd < 0)
+      db->sharedInArena = Kdb_false;
+      if (db->privateMode == Kdb_true)
       {
-         return KISSDB_ERROR_OPEN_SHM;
+         //process private: the shared information is not shared with other processes
+         db->shared = (Shared_Data_s*) getKdbPrivatePtr(sizeof(Shared_Data_s));
+         if (db->shared == ((void*) -1))
+         {
+            return KISSDB_ERROR_MAP_SHM;
+         }
+         db->shmCreator = Kdb_true;
+         db->sharedFd = 0;
       }
-      db->shared = (Shared_Data_s*) getKdbShmemPtr(db->sharedFd, sizeof(Shared_Data_s));
-      if (db->shared == ((void*) -1))
+#ifdef PERS_SHM_ARENA_ROOT
+      //keep the shared information in the arena of the persistence root if possible
+      else if ((db->shared = kdbArenaAttach(PERS_SHM_ARENA_ROOT, path, &db->shmCreator)) != NULL)
       {
-         return KISSDB_ERROR_MAP_SHM;
+         db->sharedInArena = Kdb_true;
+         db->sharedFd = 0;
+      }
+#endif
+      else
+      {
+         db->sharedFd = kdbShmemOpen(db->sharedName, sizeof(Shared_Data_s), &db->shmCreator);
+         if (db->sharedFd < 0)
+         {
+            return KISSDB_ERROR_OPEN_SHM;
+         }
+         db->shared = (Shared_Data_s*) getKdbShmemPtr(db->sharedFd, sizeof(Shared_Data_s));
+         if (db->shared == ((void*) -1))
+         {
+            return KISSDB_ERROR_MAP_SHM;
+         }
       }
 
       db->sharedCacheFd = -1;
@@ -295,14 +583,18 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
          //[Initialize rwlock attributes]
          pthread_rwlockattr_t rwlattr;
          pthread_rwlockattr_init(&rwlattr);
-         pthread_rwlockattr_setpshared(&rwlattr, PTHREAD_PROCESS_SHARED);
+         if (db->privateMode == Kdb_false)
+         {
+            pthread_rwlockattr_setpshared(&rwlattr, PTHREAD_PROCESS_SHARED);
+         }
          pthread_rwlock_init(&db->shared->rwlock, &rwlattr);
 
-         Kdb_wrlock(&db->shared->rwlock);
+         Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);
 
          //init cache filedescriptor, reference counter and hashtable number
          db->sharedCacheFd = -1;
          db->shared->refCount = 0;
+         memset(db->shared->attached, 0, sizeof(db->shared->attached));
          db->shared->htNum = 0;
          db->shared->mappedDbSize = 0;
          db->shared->writeMode = writeMode;
@@ -310,12 +602,12 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
       }
       else
       {
-         Kdb_wrlock(&db->shared->rwlock);
+         Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);
       }
    }
    else
    {
-      Kdb_wrlock(&db->shared->rwlock);
+      Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);
    }
 
    switch (db->shared->openMode)
@@ -348,6 +640,13 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
       return KISSDB_ERROR_IO;
    }
 
+   //ownership check: a database opened in process private mode is used by exactly one instance
+   if (flock(db->fd, ((db->privateMode == Kdb_true) ? LOCK_EX : LOCK_SH) | LOCK_NB) != 0)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": Database file: <"); DLT_STRING(path); DLT_STRING("> is used exclusively by another instance"));
+      return KISSDB_ERROR_ACCESS_VIOLATION;
+   }
+
    if( 0 != fstat(db->fd, &sb))
    {
       return KISSDB_ERROR_IO;
@@ -420,6 +719,11 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
       {
          return KISSDB_ERROR_MALLOC;
       }
+      db->keyDirName = kdbGetShmName("-keys", path);
+      if(db->keyDirName == NULL)
+      {
+         return KISSDB_ERROR_MALLOC;
+      }
       //check if more than one hashtable is already in shared memory
       if(db->shared->htShmSize > db->htSizeBytes )
       {
@@ -436,12 +740,20 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
       {
          return KISSDB_ERROR_MALLOC;
       }
-      db->htFd = kdbShmemOpen(db->htName,  firstMappSize, &tmpCreator);
-      if(db->htFd < 0)
+      if (db->privateMode == Kdb_true)
       {
-         return KISSDB_ERROR_OPEN_SHM;
+         db->htFd = 0;
+         db->hashTables = (Hashtable_s*) getKdbPrivatePtr(firstMappSize);
+      }
+      else
+      {
+         db->htFd = kdbShmemOpen(db->htName,  firstMappSize, &tmpCreator);
+         if(db->htFd < 0)
+         {
+            return KISSDB_ERROR_OPEN_SHM;
+         }
+         db->hashTables = (Hashtable_s*) getKdbShmemPtr(db->htFd, firstMappSize);
       }
-      db->hashTables = (Hashtable_s*) getKdbShmemPtr(db->htFd, firstMappSize);
       if(db->hashTables == ((void*) -1))
       {
          return KISSDB_ERROR_MAP_SHM;
@@ -471,16 +783,7 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
                Kdb_bool result = Kdb_false;
                if ( (db->htSizeBytes * (db->shared->htNum + 1)) > db->htMappedSize)
                {
-                  Kdb_bool temp;
-                  if (db->htFd <= 0)
-                  {
-                     db->htFd = kdbShmemOpen(db->htName,  db->htMappedSize, &temp);
-                     if(db->htFd < 0)
-                     {
-                        return KISSDB_ERROR_OPEN_SHM;
-                     }
-                  }
-                  result = resizeKdbShmem(db->htFd, &db->hashTables, db->htMappedSize, db->htMappedSize + db->htSizeBytes);
+                  result = resizeHashtableMemory(db, db->htMappedSize + db->htSizeBytes);
                   if (result == Kdb_false)
                   {
                      return KISSDB_ERROR_RESIZE_SHM;
@@ -518,13 +821,26 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
        */
       if (db->shared->openMode != KISSDB_OPEN_MODE_RDONLY)
       {
-         if (checkErrorFlags(db) != 0)
+         int result;
+         uint64_t stepStart;
+
+         stepStart = recoveryStepStart(path, KDB_RECOVERY_CHECK_FLAGS);
+         result = checkErrorFlags(db);
+         recoveryStepEnd(db, path, KDB_RECOVERY_CHECK_FLAGS, result, stepStart);
+         if (result != 0)
          {
             DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": database was not closed correctly in last lifecycle!"));
-            if (verifyHashtableCS(db) != 0)
+            KDB_STAT_ADD(&db->shared->stats, recoveries, 1);
+            stepStart = recoveryStepStart(path, KDB_RECOVERY_VERIFY_HASHTABLES);
+            result = verifyHashtableCS(db);
+            recoveryStepEnd(db, path, KDB_RECOVERY_VERIFY_HASHTABLES, result, stepStart);
+            if (result != 0)
             {
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": A hashtable is invalid -> Start rebuild of hashtables!"));
-               if (rebuildHashtables(db) != 0) //hashtables are corrupt, walk through the database and search for data blocks -> then rebuild the hashtables
+               stepStart = recoveryStepStart(path, KDB_RECOVERY_REBUILD_HASHTABLES);
+               result = rebuildHashtables(db);
+               recoveryStepEnd(db, path, KDB_RECOVERY_REBUILD_HASHTABLES, result, stepStart);
+               if (result != 0) //hashtables are corrupt, walk through the database and search for data blocks -> then rebuild the hashtables
                {
                   DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": hashtable rebuild failed!"));
                }
@@ -532,31 +848,109 @@ int KISSDB_open(KISSDB* db, const char* path, int openMode, int writeMode, uint1
                {
                   DLT_LOG(persComLldbDLTCtx, DLT_LOG_DEBUG, DLT_STRING(__FUNCTION__); DLT_STRING(": hashtable rebuild successful!"));
                }
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":Start datablock check / recovery!"));
-               recoverDataBlocks(db);
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":End datablock check / recovery!"));
-            }
-            else
-            {
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":Start datablock check / recovery!"));
-               recoverDataBlocks(db);
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":End datablock check / recovery!"));
             }
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":Start datablock check / recovery!"));
+            stepStart = recoveryStepStart(path, KDB_RECOVERY_DATABLOCKS);
+            result = recoverDataBlocks(db);
+            recoveryStepEnd(db, path, KDB_RECOVERY_DATABLOCKS, result, stepStart);
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":End datablock check / recovery!"));
          }
       }
+      {
+         uint64_t stepStart = recoveryStepStart(path, KDB_RECOVERY_BLOOM_FILTER);
+
+         rebuildBloomFilter(db);
+         recoveryStepEnd(db, path, KDB_RECOVERY_BLOOM_FILTER, 0, stepStart);
+      }
    }
-   else
+   if (db->privateMode == Kdb_false)
+   {
+      attachInstance(db, path);
+   }
+   Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
+   return 0;
+}
+
+
+int KISSDB_remap(KISSDB* db)
+{
+   struct stat sb;
+   void* ptr;
+
+   if (0 != fstat(db->fd, &sb))
+   {
+      return KISSDB_ERROR_IO;
+   }
+   //also a read only instance: the size of the file is taken from the file, not from the shared information
+   if ((uint64_t) sb.st_size > db->dbMappedSize)
+   {
+      KDB_COUNT_REMAP(db);
+      ptr = mremap(db->mappedDb, db->dbMappedSize, (size_t) sb.st_size, MREMAP_MAYMOVE);
+      if (ptr == MAP_FAILED)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":mremap error: !"), DLT_STRING(strerror(errno)));
+         return KISSDB_ERROR_IO;
+      }
+      db->mappedDb = ptr;
+      db->dbMappedSize = (uint64_t) sb.st_size;
+   }
+   return 0;
+}
+
+
+int KISSDB_checkpoint(KISSDB* db)
+{
+   Hashtable_s* htptr = NULL;
+   uint64_t  crc = 0;
+
+   if(db->htMappedSize < db->shared->htShmSize)
+   {
+      KDB_COUNT_REMAP(db);
+      if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
+      {
+         return KISSDB_ERROR_RESIZE_SHM;
+      }
+      else
+      {
+         db->htMappedSize = db->shared->htShmSize;
+      }
+   }
+   //remap database file if in the meanwhile another process added new data (key value pairs / hashtables) to the file (only happens if writethrough is used)
+   if (db->dbMappedSize < db->shared->mappedDbSize)
+   {
+      KDB_COUNT_REMAP(db);
+      db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize, MREMAP_MAYMOVE);
+      if (db->mappedDb == MAP_FAILED)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":mremap error: !"), DLT_STRING(strerror(errno)));
+         return KISSDB_ERROR_IO;
+      }
+      else
+      {
+         db->dbMappedSize = db->shared->mappedDbSize;
+      }
+   }
+
+   // generate checksum for every hashtable and write crc to file
+   if (db->fd)
    {
-      // we are not the shm creator, now check if someone else has the file open
-      // if num of open fd's and ref count does not match, report an error and don't increment ref counter
-      //printf("#### Database closed  N O T  O K - %d!!!!!\n\n", db->shared->refCount);
-      if(searchOpenFDs(path) != db->shared->refCount)
+      int i = 0;
+      int offset = sizeof(Header_s); //offset in file to first hashtable
+      if (db->shared->htNum > 0) //if hashtables exist
       {
-         Kdb_unlock(&db->shared->rwlock);
-         return KISSDB_ERROR_APPCRASH;
+         //write hashtables and crc to file
+         for (i = 0; i < db->shared->htNum; i++)
+         {
+            crc = 0;
+            crc = (uint64_t) pcoCrc32(crc, (unsigned char*) db->hashTables[i].slots, sizeof(db->hashTables[i].slots));
+            db->hashTables[i].crc = crc;
+            htptr = (Hashtable_s*) (db->mappedDb +  offset);
+            //copy hashtable and generated crc from shared memory to mapped hashtable in file
+            memcpy(htptr, &db->hashTables[i], db->htSizeBytes);
+            offset = db->hashTables[i].slots[db->htSize].offsetA;
+         }
       }
    }
-   Kdb_unlock(&db->shared->rwlock);
    return 0;
 }
 
@@ -567,62 +961,27 @@ int KISSDB_close(KISSDB* db)
    printf("  START: KISSDB_CLOSE \n");
 #endif
 
-   Hashtable_s* htptr = NULL;
    Header_s* ptr = 0;
-   uint64_t  crc = 0;
+   int result = 0;
 
-   Kdb_wrlock(&db->shared->rwlock);
+   Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);
+
+   //the lock of the entry is released when the database file is closed
+   if (db->attachSlot >= 0)
+   {
+      db->shared->attached[db->attachSlot] = 0;
+      db->attachSlot = -1;
+   }
 
    //if no other instance has opened the database
    if( db->shared->refCount == 0)
    {
       if (db->shared->openMode != KISSDB_OPEN_MODE_RDONLY)
       {
-         if(db->htMappedSize < db->shared->htShmSize)
-         {
-            if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
-            {
-               return KISSDB_ERROR_RESIZE_SHM;
-            }
-            else
-            {
-               db->htMappedSize = db->shared->htShmSize;
-            }
-         }
-         //remap database file if in the meanwhile another process added new data (key value pairs / hashtables) to the file (only happens if writethrough is used)
-         if (db->dbMappedSize < db->shared->mappedDbSize)
+         result = KISSDB_checkpoint(db);
+         if (result != 0)
          {
-            db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize, MREMAP_MAYMOVE);
-            if (db->mappedDb == MAP_FAILED)
-            {
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(":mremap error: !"), DLT_STRING(strerror(errno)));
-               return KISSDB_ERROR_IO;
-            }
-            else
-            {
-               db->dbMappedSize = db->shared->mappedDbSize;
-            }
-         }
-
-         // generate checksum for every hashtable and write crc to file
-         if (db->fd)
-         {
-            int i = 0;
-            int offset = sizeof(Header_s); //offset in file to first hashtable
-            if (db->shared->htNum > 0) //if hashtables exist
-            {
-               //write hashtables and crc to file
-               for (i = 0; i < db->shared->htNum; i++)
-               {
-                  crc = 0;
-                  crc = (uint64_t) pcoCrc32(crc, (unsigned char*) db->hashTables[i].slots, sizeof(db->hashTables[i].slots));
-                  db->hashTables[i].crc = crc;
-                  htptr = (Hashtable_s*) (db->mappedDb +  offset);
-                  //copy hashtable and generated crc from shared memory to mapped hashtable in file
-                  memcpy(htptr, &db->hashTables[i], db->htSizeBytes);
-                  offset = db->hashTables[i].slots[db->htSize].offsetA;
-               }
-            }
+            return result;
          }
          //update header (close flags)
          ptr = (Header_s*) db->mappedDb;
@@ -640,10 +999,10 @@ int KISSDB_close(KISSDB* db)
       db->hashTables = NULL;
 
       //close shared memory for hashtables
-      if( kdbShmemClose(db->htFd, db->htName) == Kdb_false)
+      if( db->privateMode == Kdb_false && kdbShmemClose(db->htFd, db->htName) == Kdb_false)
       {
          close(db->fd);
-         Kdb_unlock(&db->shared->rwlock);
+         Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
          return KISSDB_ERROR_CLOSE_SHM;
       }
       db->htFd = 0;
@@ -655,17 +1014,26 @@ int KISSDB_close(KISSDB* db)
       }
 
       //free rwlocks
-      Kdb_unlock(&db->shared->rwlock);
+      Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
       pthread_rwlock_destroy(&db->shared->rwlock);
 
-      // unmap shared information
-      munmap(db->shared, sizeof(Shared_Data_s));
-      db->shared = NULL;
-
-      if (kdbShmemClose(db->sharedFd, db->sharedName) == Kdb_false)
+      if (db->sharedInArena == Kdb_true)
       {
-         close(db->fd);
-         return KISSDB_ERROR_CLOSE_SHM;
+         kdbArenaRemove(db->shared);
+         db->shared = NULL;
+         db->sharedInArena = Kdb_false;
+      }
+      else
+      {
+         // unmap shared information
+         munmap(db->shared, sizeof(Shared_Data_s));
+         db->shared = NULL;
+
+         if (db->privateMode == Kdb_false && kdbShmemClose(db->sharedFd, db->sharedName) == Kdb_false)
+         {
+            close(db->fd);
+            return KISSDB_ERROR_CLOSE_SHM;
+         }
       }
       db->sharedFd =0;
       if(db->sharedName != NULL)
@@ -678,6 +1046,11 @@ int KISSDB_close(KISSDB* db)
         free(db->cacheName); //free memory for name  obtained by kdbGetShmName() function
         db->cacheName = NULL;
       }
+      if(db->keyDirName != NULL)
+      {
+        free(db->keyDirName);
+        db->keyDirName = NULL;
+      }
 
       if( db->fd)
       {
@@ -709,13 +1082,17 @@ int KISSDB_close(KISSDB* db)
                  DLT_STRING(__FUNCTION__); DLT_STRING(": sem_post() failed: "),
                  DLT_STRING(strerror(errno)));
       }
-      if (-1 == sem_close(db->kdbSem))
+      if (db->privateMode == Kdb_true)
+      {
+         (void) sem_destroy(db->kdbSem);
+      }
+      else if (-1 == sem_close(db->kdbSem))
       {
          DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
                  DLT_STRING(__FUNCTION__); DLT_STRING(": sem_close() failed: "),
                  DLT_STRING(strerror(errno)));
       }
-      if (-1 == sem_unlink(db->semName))
+      if (db->privateMode == Kdb_false && -1 == sem_unlink(db->semName))
       {
          DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
                  DLT_STRING(__FUNCTION__); DLT_STRING(": sem_unlink() failed: "),
@@ -762,11 +1139,15 @@ int KISSDB_close(KISSDB* db)
       db->shmCreator = 0;
       db->alreadyOpen = 0;
 
-      Kdb_unlock(&db->shared->rwlock);
+      Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
 
-      // unmap shared information
-      munmap(db->shared, sizeof(Shared_Data_s));
+      // unmap shared information (the arena stays mapped)
+      if (db->sharedInArena == Kdb_false)
+      {
+         munmap(db->shared, sizeof(Shared_Data_s));
+      }
       db->shared = NULL;
+      db->sharedInArena = Kdb_false;
 
       if(db->sharedFd)
       {
@@ -788,6 +1169,11 @@ int KISSDB_close(KISSDB* db)
         free(db->cacheName); //free memory for name  obtained by kdbGetShmName() function
         db->cacheName = NULL;
       }
+      if(db->keyDirName != NULL)
+      {
+        free(db->keyDirName);
+        db->keyDirName = NULL;
+      }
       //clean struct
       if (-1 == sem_post(db->kdbSem))
       {
@@ -815,8 +1201,26 @@ int KISSDB_close(KISSDB* db)
 }
 
 
+void KISSDB_key_init(persComDbKey_t* kdesc, const char* key)
+{
+   kdesc->key = key;
+   kdesc->length = (unsigned int) strlen(key);
+   kdesc->hash = KISSDB_hash(key, kdesc->length);
+}
+
+
 int KISSDB_get(KISSDB* db, const void* key, void* vbuf, uint32_t bufsize, uint32_t* vsize)
 {
+   persComDbKey_t kdesc;
+
+   KISSDB_key_init(&kdesc, key);
+   return KISSDB_get_hashed(db, &kdesc, vbuf, bufsize, vsize);
+}
+
+
+static int getHashed(KISSDB* db, const persComDbKey_t* kdesc, void* vbuf, uint32_t bufsize, uint32_t* vsize)
+{
+   const void* key = kdesc->key;
    const uint8_t* kptr;
    DataBlock_s* block;
    Hashtable_slot_s* hashTable;
@@ -826,11 +1230,17 @@ int KISSDB_get(KISSDB* db, const void* key, void* vbuf, uint32_t bufsize, uint32
    uint64_t hash = 0;
    unsigned long klen, i;
 
-   klen = strlen(key);
-   hash = KISSDB_hash(key, klen) % (uint64_t) db->htSize;
+   klen = kdesc->length;
+   hash = kdesc->hash % (uint64_t) db->htSize;
+
+   if (Kdb_false == bloomFilterMayContain(db, kdesc->hash))
+   {
+      return 1; /* not found */
+   }
 
    if(db->htMappedSize < db->shared->htShmSize)
    {
+      KDB_COUNT_REMAP(db);
       if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
       {
          return KISSDB_ERROR_RESIZE_SHM;
@@ -845,6 +1255,7 @@ int KISSDB_get(KISSDB* db, const void* key, void* vbuf, uint32_t bufsize, uint32
 
    if (db->dbMappedSize < db->shared->mappedDbSize)
    {
+      KDB_COUNT_REMAP(db);
       db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize, MREMAP_MAYMOVE);
       if (db->mappedDb == MAP_FAILED)
       {
@@ -884,7 +1295,7 @@ int KISSDB_get(KISSDB* db, const void* key, void* vbuf, uint32_t bufsize, uint32
             if (klen > 0)
             {
                if (memcmp(kptr, block->key, klen)
-                     || strlen(block->key) != klen) //if search key does not match with key in file
+                     || block->key[klen] != '\0') //if search key does not match with key in file
                {
                   bKeyFound = Kdb_false;
                }
@@ -915,8 +1326,30 @@ int KISSDB_get(KISSDB* db, const void* key, void* vbuf, uint32_t bufsize, uint32
 }
 
 
+int KISSDB_get_hashed(KISSDB* db, const persComDbKey_t* kdesc, void* vbuf, uint32_t bufsize, uint32_t* vsize)
+{
+   int result;
+
+   PERS_PROBE3(kissdb_get_entry, db->dbPath, kdesc->key, bufsize);
+   LLDB_OP_FLAG(LLDB_OP_FLAG_FILE);
+   result = getHashed(db, kdesc, vbuf, bufsize, vsize);
+   PERS_PROBE4(kissdb_get_return, db->dbPath, kdesc->key, result, (result == 0) ? *vsize : 0);
+   return result;
+}
+
+
 int KISSDB_delete(KISSDB* db, const void* key, int32_t* bytesDeleted)
 {
+   persComDbKey_t kdesc;
+
+   KISSDB_key_init(&kdesc, key);
+   return KISSDB_delete_hashed(db, &kdesc, bytesDeleted);
+}
+
+
+static int deleteHashed(KISSDB* db, const persComDbKey_t* kdesc, int32_t* bytesDeleted)
+{
+   const void* key = kdesc->key;
    const uint8_t* kptr;
    DataBlock_s* backupBlock;
    DataBlock_s* block;
@@ -929,12 +1362,18 @@ int KISSDB_delete(KISSDB* db, const void* key, int32_t* bytesDeleted)
    uint64_t crc = 0x00;
    unsigned long klen, i;
 
-   klen = strlen(key);
-   hash = KISSDB_hash(key, klen) % (uint64_t) db->htSize;
+   klen = kdesc->length;
+   hash = kdesc->hash % (uint64_t) db->htSize;
    *(bytesDeleted) = PERS_COM_ERR_NOT_FOUND;
 
+   if (Kdb_false == bloomFilterMayContain(db, kdesc->hash))
+   {
+      return 1; /* not found */
+   }
+
    if(db->htMappedSize < db->shared->htShmSize)
    {
+      KDB_COUNT_REMAP(db);
       if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
       {
          return KISSDB_ERROR_RESIZE_SHM;
@@ -950,6 +1389,7 @@ int KISSDB_delete(KISSDB* db, const void* key, int32_t* bytesDeleted)
    //remap database file if in the meanwhile another process added new data (key value pairs / hashtables) to the file
    if (db->dbMappedSize < db->shared->mappedDbSize)
    {
+      KDB_COUNT_REMAP(db);
       db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize, MREMAP_MAYMOVE);
       if (db->mappedDb == MAP_FAILED)
       {
@@ -993,7 +1433,7 @@ int KISSDB_delete(KISSDB* db, const void* key, int32_t* bytesDeleted)
             kptr = (const uint8_t*) key;  //pointer to search key
             if (klen > 0)
             {
-               if (memcmp(kptr, block->key, klen) || strlen(block->key) != klen) //if search key does not match with key in file
+               if (memcmp(kptr, block->key, klen) || block->key[klen] != '\0') //if search key does not match with key in file
                {
                   bKeyFound = Kdb_false;
                }
@@ -1046,6 +1486,18 @@ int KISSDB_delete(KISSDB* db, const void* key, int32_t* bytesDeleted)
    return 1; /* not found */
 }
 
+
+int KISSDB_delete_hashed(KISSDB* db, const persComDbKey_t* kdesc, int32_t* bytesDeleted)
+{
+   int result;
+
+   PERS_PROBE2(kissdb_delete_entry, db->dbPath, kdesc->key);
+   LLDB_OP_FLAG(LLDB_OP_FLAG_FILE);
+   result = deleteHashed(db, kdesc, bytesDeleted);
+   PERS_PROBE4(kissdb_delete_return, db->dbPath, kdesc->key, result, (result == 0) ? *bytesDeleted : 0);
+   return result;
+}
+
 // To improve write amplifiction: sort the keys at writeback for sequential write
 //return offset where key would be written if Kissdb_put with same key is called
 //int determineKeyOffset(KISSDB* db, const void* key)
@@ -1064,6 +1516,16 @@ int KISSDB_delete(KISSDB* db, const void* key, int32_t* bytesDeleted)
 
 int KISSDB_put(KISSDB* db, const void* key, const void* value, int valueSize, int32_t* bytesWritten)
 {
+   persComDbKey_t kdesc;
+
+   KISSDB_key_init(&kdesc, key);
+   return KISSDB_put_hashed(db, &kdesc, value, valueSize, bytesWritten);
+}
+
+
+static int putHashed(KISSDB* db, const persComDbKey_t* kdesc, const void* value, int valueSize, int32_t* bytesWritten)
+{
+   const void* key = kdesc->key;
    const uint8_t* kptr;
    DataBlock_s* backupBlock;
    DataBlock_s* block;
@@ -1073,17 +1535,19 @@ int KISSDB_put(KISSDB* db, const void* key, const void* value, int valueSize, in
    int64_t offset, backupOffset, endoffset;
    Kdb_bool bKeyFound = Kdb_false;
    Kdb_bool result = Kdb_false;
-   Kdb_bool temp = Kdb_false;
    uint64_t crc = 0x00;
    uint64_t hash = 0;
    unsigned long klen, i;
 
-   klen = strlen(key);
-   hash = KISSDB_hash(key, klen) % (uint64_t) db->htSize;
+   klen = kdesc->length;
+   hash = kdesc->hash % (uint64_t) db->htSize;
    *(bytesWritten) = 0;
 
+   bloomFilterAdd(db, kdesc->hash); //a set bit only costs a lookup, so it is set before the data is written
+
    if(db->htMappedSize < db->shared->htShmSize)
    {
+      KDB_COUNT_REMAP(db);
       if ( Kdb_false == remapSharedHashtable(db->htFd, &db->hashTables, db->htMappedSize, db->shared->htShmSize))
       {
          return KISSDB_ERROR_RESIZE_SHM;
@@ -1099,6 +1563,7 @@ int KISSDB_put(KISSDB* db, const void* key, const void* value, int valueSize, in
    //remap database file (only necessary here in writethrough mode) if in the meanwhile another process added new data (key value pairs / hashtables) to the file
    if (db->dbMappedSize < db->shared->mappedDbSize)
    {
+      KDB_COUNT_REMAP(db);
       db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize, MREMAP_MAYMOVE);
       if (db->mappedDb == MAP_FAILED)
       {
@@ -1140,7 +1605,7 @@ int KISSDB_put(KISSDB* db, const void* key, const void* value, int valueSize, in
          if (klen > 0)
          {
             if (memcmp(kptr, block->key, klen)
-                  || strlen(block->key) != klen) //if search key does not match with key in file
+                  || block->key[klen] != '\0') //if search key does not match with key in file
             {
                //if key does not match -> search in next hashtable
                bKeyFound = Kdb_false;
@@ -1180,6 +1645,7 @@ int KISSDB_put(KISSDB* db, const void* key, const void* value, int valueSize, in
             // check current flag and decide what parts of hashtable slot in file must be updated
             hashTable[hash].current = (hashTable[hash].current == 0x00) ? 0x01 : 0x00; // if 0x00 -> offsetA is latest -> set to 0x01 else /offsetB is latest -> modify settings of A set 0x00
             *(bytesWritten) = valueSize;
+            KDB_STAT_ADD(&db->shared->stats, fileBytesWritten, sizeof(DataBlock_s) * 2);
 
             return 0; //success
          }
@@ -1198,7 +1664,9 @@ int KISSDB_put(KISSDB* db, const void* key, const void* value, int valueSize, in
          {
             return KISSDB_ERROR_IO;
          }
+         LLDB_OP_FLAG(LLDB_OP_FLAG_GROWTH);
 
+         KDB_COUNT_REMAP(db);
          db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize + (sizeof(DataBlock_s) * 2), MREMAP_MAYMOVE);
          if (db->mappedDb == MAP_FAILED)
          {
@@ -1218,6 +1686,7 @@ int KISSDB_put(KISSDB* db, const void* key, const void* value, int valueSize, in
          hashTable[hash].current = 0x00;
 
          *(bytesWritten) = valueSize;
+         KDB_STAT_ADD(&db->shared->stats, fileBytesWritten, sizeof(DataBlock_s) * 2);
          return 0; /* success */
       }
       hashTable = (Hashtable_slot_s*) ((char*) hashTable + sizeof(Hashtable_s));  //pointer to the next memory-hashtable
@@ -1227,15 +1696,7 @@ int KISSDB_put(KISSDB* db, const void* key, const void* value, int valueSize, in
    if( (db->htSizeBytes * (db->shared->htNum + 1)) > db->shared->htShmSize)
    {
       //munlockall();
-      if (db->htFd <= 0)
-      {
-         db->htFd = kdbShmemOpen(db->htName,  db->htMappedSize, &temp);
-         if(db->htFd < 0)
-         {
-            return KISSDB_ERROR_OPEN_SHM;
-         }
-      }
-      result = resizeKdbShmem(db->htFd, &db->hashTables, db->htMappedSize, db->htMappedSize + db->htSizeBytes);
+      result = resizeHashtableMemory(db, db->htMappedSize + db->htSizeBytes);
       if (result == Kdb_false)
       {
          return KISSDB_ERROR_RESIZE_SHM;
@@ -1259,7 +1720,9 @@ int KISSDB_put(KISSDB* db, const void* key, const void* value, int valueSize, in
    {
       return KISSDB_ERROR_IO;
    }
+   LLDB_OP_FLAG(LLDB_OP_FLAG_GROWTH);
 
+   KDB_COUNT_REMAP(db);
    db->mappedDb = mremap(db->mappedDb, db->dbMappedSize, db->shared->mappedDbSize + (db->htSizeBytes + (sizeof(DataBlock_s) * 2)), MREMAP_MAYMOVE);
    if (db->mappedDb == MAP_FAILED)
    {
@@ -1293,11 +1756,24 @@ int KISSDB_put(KISSDB* db, const void* key, const void* value, int valueSize, in
    ++db->shared->htNum;
 
    *(bytesWritten) = valueSize;
+   KDB_STAT_ADD(&db->shared->stats, fileBytesWritten, db->htSizeBytes + (sizeof(DataBlock_s) * 2));
 
    return 0; /* success */
 }
 
 
+int KISSDB_put_hashed(KISSDB* db, const persComDbKey_t* kdesc, const void* value, int valueSize, int32_t* bytesWritten)
+{
+   int result;
+
+   PERS_PROBE3(kissdb_put_entry, db->dbPath, kdesc->key, valueSize);
+   LLDB_OP_FLAG(LLDB_OP_FLAG_FILE);
+   result = putHashed(db, kdesc, value, valueSize, bytesWritten);
+   PERS_PROBE4(kissdb_put_return, db->dbPath, kdesc->key, result, (result == 0) ? *bytesWritten : 0);
+   return result;
+}
+
+
 
 #if 0
 /*
@@ -1338,6 +1814,7 @@ int KISSDB_Iterator_next(KISSDB_Iterator* dbi, void* kbuf, void* vbuf)
 
    if(dbi->db->htMappedSize < dbi->db->shared->htShmSize)
    {
+      KDB_COUNT_REMAP(dbi->db);
       if ( Kdb_false == remapSharedHashtable(dbi->db->htFd, &dbi->db->hashTables, dbi->db->htMappedSize, dbi->db->shared->htShmSize))
       {
          return KISSDB_ERROR_RESIZE_SHM;
@@ -1351,6 +1828,7 @@ int KISSDB_Iterator_next(KISSDB_Iterator* dbi, void* kbuf, void* vbuf)
    //remap database file if in the meanwhile another process added new data (key value pairs / hashtables) to the file
    if (dbi->db->dbMappedSize < dbi->db->shared->mappedDbSize)
    {
+      KDB_COUNT_REMAP(dbi->db);
       dbi->db->mappedDb = mremap(dbi->db->mappedDb, dbi->db->dbMappedSize, dbi->db->shared->mappedDbSize, MREMAP_MAYMOVE);
       if (dbi->db->mappedDb == MAP_FAILED)
       {
@@ -1430,7 +1908,8 @@ int readHeader(KISSDB* db, uint16_t* htSize, uint64_t* keySize, uint64_t* valSiz
    {
       return KISSDB_ERROR_CORRUPT_DBFILE;
    }
-   if( (ptr->KdbV[3] != KISSDB_MAJOR_VERSION) || (ptr->KdbV[4] != '.') || (ptr->KdbV[5] != KISSDB_MINOR_VERSION))
+   if(   (ptr->KdbV[3] != KISSDB_MAJOR_VERSION) || (ptr->KdbV[4] != '.')
+      || ((ptr->KdbV[5] != KISSDB_MINOR_VERSION) && (ptr->KdbV[5] != KISSDB_MINOR_VERSION_NO_TXLOG)))
    {
       return KISSDB_ERROR_WRONG_DATABASE_VERSION;
    }
@@ -1450,6 +1929,16 @@ int readHeader(KISSDB* db, uint16_t* htSize, uint64_t* keySize, uint64_t* valSiz
       return KISSDB_ERROR_CORRUPT_DBFILE;
    }
    (*valSize) = (uint64_t) ptr->valSize;
+
+   //the bytes of txApplied were padding before: no transaction of the intent log is applied yet
+   if (ptr->KdbV[5] == KISSDB_MINOR_VERSION_NO_TXLOG)
+   {
+      if (db->shared->openMode != KISSDB_OPEN_MODE_RDONLY)
+      {
+         ptr->txApplied = 0;
+         ptr->KdbV[5] = KISSDB_MINOR_VERSION;
+      }
+   }
    return 0;
 }
 
@@ -1527,97 +2016,6 @@ int checkErrorFlags(KISSDB* db)
 
 
 
-int searchProcFileSys(pid_t pid, const char* path)
-{
-   int rval = 0;
-   DIR* procdir;
-   struct dirent* procDirEnt;
-   char procPidDir[128] = {0};
-
-   memset(procPidDir, 0, 128);
-   snprintf(procPidDir, 128, "/proc/%d/fd", pid);
-
-   if((procdir = opendir(procPidDir)) != NULL)  // search for open fd's
-   {
-      for(procDirEnt = readdir(procdir); NULL != procDirEnt; procDirEnt = readdir(procdir))
-      {
-         if(FILE_DIR_NOT_SELF_OR_PARENT(procDirEnt->d_name))
-         {
-            char buffer[128] = {0};
-            char fullPath[256] = {0};
-            memset(buffer, 0, 128);
-            memset(fullPath, 0, 256);
-
-            snprintf(fullPath, 256, "%s/%s", procPidDir, procDirEnt->d_name);
-            if(readlink(fullPath, buffer, 128) != -1)
-            {
-               if(strcmp(path, buffer) == 0)
-               {
-                  //printf("   FOUND         [%d]: %s | %s | %s\n", pid, path, fullPath, buffer);
-                  rval = 1;
-                  break;
-               }
-            }
-            else
-            {
-               printf("Error readlink: %s\n", strerror(errno));
-            }
-         }
-      }
-      closedir(procdir);
-   }
-
-   return rval;
-}
-
-
-int searchOpenFDs(const char* path)
-{
-   DIR* dir;
-   struct dirent* ent;
-   int rval = 0;
-   int fd = -1;
-
-   if ((dir = opendir(PIDFILEDIR)) != NULL)  // search for pidfiles
-   {
-      for(ent = readdir(dir); NULL != ent; ent = readdir(dir))
-      {
-         if(FILE_DIR_NOT_SELF_OR_PARENT(ent->d_name))
-         {
-            if(strstr(ent->d_name, PIDFILE_PREFIX) != NULL)
-            {
-               // extract the PID form filename
-               char pidArray[10] = {0};
-               char* pidArrayPtr = pidArray;
-               pid_t pid = 0;
-               int start = strlen(PIDFILE_PREFIX);
-               memset(pidArray, 0, 10);
-
-               while(ent->d_name[start] != '.')
-               {
-                  *(pidArrayPtr)++ = ent->d_name[start++];
-               }
-               pid = atoi(pidArray);
-               if(getpid() != pid) // check only other pids not own
-               {
-                  if(searchProcFileSys(pid, path) == 1)
-                  {
-                     rval++;  // count number of open fd's
-                  }
-               }
-            }
-         }
-      }
-      closedir(dir);
-   }
-   else
-   {
-      printf("Failed to open directory %s: %s\n", PIDFILEDIR, strerror(errno));
-   }
-
-   return rval;
-}
-
 int verifyHashtableCS(KISSDB* db)
 {
    char* ptr;
@@ -1672,7 +2070,7 @@ int verifyHashtableCS(KISSDB* db)
                //if new size would exceed old shared memory size-> allocate additional memory page to shared memory
                if (db->htSizeBytes * (db->shared->htNum + 1) > db->htMappedSize)
                {
-                  result = resizeKdbShmem(db->htFd, &db->hashTables, db->htMappedSize, db->htMappedSize + db->htSizeBytes);
+                  result = resizeHashtableMemory(db, db->htMappedSize + db->htSizeBytes);
                   if (result == Kdb_false)
                   {
                      return KISSDB_ERROR_RESIZE_SHM;
@@ -2150,6 +2548,95 @@ int recoverDataBlocks(KISSDB* db)
 }
 
 
+/* 64 bit finalizer of murmur3: spreads the bits of the djb2 key hash before they are used by the bloom filter */
+static uint64_t bloomFilterMix(uint64_t keyHash)
+{
+   keyHash ^= keyHash >> 33;
+   keyHash *= 0xff51afd7ed558ccdULL;
+   keyHash ^= keyHash >> 33;
+   keyHash *= 0xc4ceb9fe1a85ec53ULL;
+   keyHash ^= keyHash >> 33;
+   return keyHash;
+}
+
+
+//set the bits for a key in the shared bloom filter (caller must hold the write lock)
+void bloomFilterAdd(KISSDB* db, uint64_t keyHash)
+{
+   uint64_t mixed = bloomFilterMix(keyHash);
+   uint32_t h1 = (uint32_t) mixed;
+   uint32_t h2 = (uint32_t) (mixed >> 32) | 1;
+   uint32_t bit;
+   int i;
+
+   for (i = 0; i < KISSDB_BLOOM_FILTER_HASHES; i++)
+   {
+      bit = (h1 + (uint32_t) i * h2) & (KISSDB_BLOOM_FILTER_BITS - 1);
+      db->shared->bloomFilter[bit >> 6] |= (1ULL << (bit & 63));
+   }
+}
+
+
+//returns Kdb_false only if the key is definitely not stored in the database file
+Kdb_bool bloomFilterMayContain(KISSDB* db, uint64_t keyHash)
+{
+   uint64_t mixed;
+   uint32_t h1, h2, bit;
+   int i;
+
+   if (db->shared->bloomValid != Kdb_true)
+   {
+      return Kdb_true;
+   }
+   mixed = bloomFilterMix(keyHash);
+   h1 = (uint32_t) mixed;
+   h2 = (uint32_t) (mixed >> 32) | 1;
+   for (i = 0; i < KISSDB_BLOOM_FILTER_HASHES; i++)
+   {
+      bit = (h1 + (uint32_t) i * h2) & (KISSDB_BLOOM_FILTER_BITS - 1);
+      if ((db->shared->bloomFilter[bit >> 6] & (1ULL << (bit & 63))) == 0)
+      {
+         return Kdb_false;
+      }
+   }
+   return Kdb_true;
+}
+
+
+//build the bloom filter from the keys referenced by the hashtables (deleted keys are dropped from the filter)
+void rebuildBloomFilter(KISSDB* db)
+{
+   DataBlock_s* block;
+   Hashtable_slot_s* hashTable;
+   int64_t offset;
+   uint32_t i, k;
+
+   db->shared->bloomValid = Kdb_false;
+   memset(db->shared->bloomFilter, 0, sizeof(db->shared->bloomFilter));
+
+   for (i = 0; i < db->shared->htNum; i++)
+   {
+      hashTable = db->hashTables[i].slots;
+      for (k = 0; k < db->htSize; k++)
+      {
+         offset = (hashTable[k].current == 0x00) ? hashTable[k].offsetA : hashTable[k].offsetB;
+         if (offset >= KISSDB_HEADER_SIZE)
+         {
+            if ((uint64_t) offset + sizeof(DataBlock_s) > db->dbMappedSize)
+            {
+               //invalid offset -> the filter would not be reliable, keep it disabled
+               DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": invalid offset in hashtable -> bloom filter disabled"));
+               return;
+            }
+            block = (DataBlock_s*) (db->mappedDb + offset);
+            bloomFilterAdd(db, KISSDB_hash(block->key, strnlen(block->key, db->keySize)));
+         }
+      }
+   }
+   db->shared->bloomValid = Kdb_true;
+}
+
+
 int checkIsLink(const char* path, char* linkBuffer)
 {
    char fileName[64] = { 0 };
@@ -2169,9 +2656,8 @@ int checkIsLink(const char* path, char* linkBuffer)
          len = i; // remember the position of the last '/'
       }
    }
-   strncpy(truncPath, path, len);
-   truncPath[len + 1] = '\0'; // set end of string
-   strncpy(fileName, (const char*) path + len, 64);
+   snprintf(truncPath, sizeof(truncPath), "%.*s", len, path); // path up to the last '/', always terminated
+   snprintf(fileName, sizeof(fileName), "%s", (const char*) path + len);
 
    if (lstat(truncPath, &statBuf) != -1)
    {
@@ -2225,6 +2711,11 @@ void cleanKdbStruct(KISSDB* db)
          free(db->cacheName);
          db->cacheName = NULL;
       }
+      if(db->keyDirName != NULL)
+      {
+         free(db->keyDirName);
+         db->keyDirName = NULL;
+      }
       if (db->fd)
       {
          close(db->fd);
@@ -2245,7 +2736,7 @@ void cleanKdbStruct(KISSDB* db)
       db->dbMappedSize = 0;
       db->shmCreator = 0;
 
-      Kdb_unlock(&db->shared->rwlock);
+      Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
 
       //Clean up for last instance referencing the database
       if (db->shared->refCount == 0)
@@ -2263,6 +2754,12 @@ void cleanKdbStruct(KISSDB* db)
          }
          //free rwlocks
          pthread_rwlock_destroy(&db->shared->rwlock);
+         if (db->sharedInArena == Kdb_true)
+         {
+            kdbArenaRemove(db->shared);
+            db->shared = NULL;
+            db->sharedInArena = Kdb_false;
+         }
          if (db->shared != NULL)
          {
             munmap(db->shared, sizeof(Shared_Data_s));
@@ -2285,12 +2782,16 @@ void cleanKdbStruct(KISSDB* db)
             DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_post() in cleanup failed: "),
                   DLT_STRING(strerror(errno)));
          }
-         if (-1 == sem_close(db->kdbSem))
+         if (db->privateMode == Kdb_true)
+         {
+            (void) sem_destroy(db->kdbSem);
+         }
+         else if (-1 == sem_close(db->kdbSem))
          {
             DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_close() in cleanup failed: "),
                   DLT_STRING(strerror(errno)));
          }
-         if (-1 == sem_unlink(db->semName))
+         if (db->privateMode == Kdb_false && -1 == sem_unlink(db->semName))
          {
             DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_unlink() in cleanup failed: "),
                   DLT_STRING(strerror(errno)));
@@ -2309,11 +2810,12 @@ void cleanKdbStruct(KISSDB* db)
             close(db->htFd);
             db->htFd = 0;
          }
-         if (db->shared != NULL)
+         if (db->shared != NULL && db->sharedInArena == Kdb_false)
          {
             munmap(db->shared, sizeof(Shared_Data_s));
-            db->shared = NULL;
          }
+         db->shared = NULL;
+         db->sharedInArena = Kdb_false;
          if(db->htName != NULL)
          {
             free(db->htName);
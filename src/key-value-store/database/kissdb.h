@@ -52,6 +52,10 @@ extern "C" {
 
 #define HASHTABLE_SLOT_COUNT 510
 
+/* bloom filter over the keys stored in the database file (kept in the -shm-info shared memory) */
+#define KISSDB_BLOOM_FILTER_BITS   65536 /* must be a power of two */
+#define KISSDB_BLOOM_FILTER_HASHES 4
+
 #ifdef __showTimeMeasurements
 #define SECONDS2NANO 1000000000L
 #define NANO2MIL        1000000L
@@ -62,22 +66,96 @@ extern "C" {
 #endif
 
 
-#define PIDFILE_PREFIX "perslib_"
-#define PIDFILE_TEMPLATE PIDFILEDIR "/" PIDFILE_PREFIX"%d.pid"   // PIDFILEDIR is defined via configure switch -pidfiledir (default is /var/run if not set)
+/* number of instances tracked in the registry of attached instances (see Shared_Data_s) */
+#ifndef KISSDB_MAX_ATTACHED
+#define KISSDB_MAX_ATTACHED 64
+#endif
+
+/* offset of the bytes of the database file locked by the attached instances (one byte per registry entry, beyond any data) */
+#define KISSDB_ATTACH_LOCK_OFFSET 0x40000000L
 
 /**
- * Version: 2.3
+ * Version: 2.4
  *
  * This is the file format identifier, and changes any time the file
  * format changes.
  */
 #define KISSDB_MAJOR_VERSION 2
-#define KISSDB_MINOR_VERSION 3
+#define KISSDB_MINOR_VERSION 4
+
+/* version 2.3 has no sequence number of the intent log in the header (Header_s.txApplied),
+ * it is converted by the first open for writing */
+#define KISSDB_MINOR_VERSION_NO_TXLOG 3
 
 typedef int16_t Kdb_bool;
 static const int16_t Kdb_true  = -1;
 static const int16_t Kdb_false =  0;
 
+/* locks serializing the users of a database (index into Kdb_stats_s.locks) */
+#define KDB_LOCK_RWLOCK        0  /* rwlock of the shared information (Kdb_wrlock) */
+#define KDB_LOCK_MUTEX         1  /* mutex of the shared information (cache access) */
+#define KDB_LOCK_SEM           2  /* named semaphore taken during open and close */
+#define KDB_LOCK_COUNT         3
+
+/* steps of KISSDB_open run by the first instance (index into Kdb_stats_s.recoveryNs) */
+#define KDB_RECOVERY_CHECK_FLAGS        0  /* checkErrorFlags */
+#define KDB_RECOVERY_VERIFY_HASHTABLES  1  /* verifyHashtableCS, only after an unclean close */
+#define KDB_RECOVERY_REBUILD_HASHTABLES 2  /* rebuildHashtables, only if a hashtable checksum is invalid */
+#define KDB_RECOVERY_DATABLOCKS         3  /* recoverDataBlocks, only after an unclean close */
+#define KDB_RECOVERY_BLOOM_FILTER       4  /* rebuildBloomFilter */
+#define KDB_RECOVERY_STEPS              5
+
+/* histogram bucket 0: < 1 us, bucket n: < 2^n us, last bucket: everything above */
+#define KDB_LOCK_HIST_BUCKETS  20
+#define KDB_LOCK_TOP_HOLDERS   4
+
+typedef struct
+{
+      uint64_t holdNs;
+      uint32_t pid;
+      uint32_t tid;
+} Kdb_lock_holder_s;
+
+/* contention profile of one lock, only filled with PERS_LLDB_LOCK_PROFILE */
+typedef struct
+{
+      uint64_t acquisitions;
+      uint64_t waitNs;                               /* sum of the wait times */
+      uint64_t holdNs;                               /* sum of the hold times */
+      uint64_t waitHist[KDB_LOCK_HIST_BUCKETS];
+      uint64_t holdHist[KDB_LOCK_HIST_BUCKETS];
+      uint64_t acquiredNs;                           /* CLOCK_MONOTONIC when the current holder got the lock */
+      uint32_t holderPid;                            /* current holder, 0 if the lock is free */
+      uint32_t holderTid;
+      Kdb_lock_holder_s longest[KDB_LOCK_TOP_HOLDERS]; /* longest hold times so far, unsorted */
+} Kdb_lock_prof_s;
+
+/* performance counters of a database, updated with relaxed atomics (read live by pers-kvs-stat) */
+typedef struct
+{
+      uint64_t reads;            /* read accesses (value and size) */
+      uint64_t writes;
+      uint64_t deletes;
+      uint64_t cacheHits;        /* key found in the write cache (value or delete marker) */
+      uint64_t cacheMisses;      /* key read from the database file */
+      uint64_t cacheSlotsUsed;   /* slots of the write cache in use after the last cache modification */
+      uint64_t cacheSlotsMax;
+      uint64_t cacheFull;        /* writes rejected by the cache with ENOBUFS */
+      uint64_t fileBytesWritten; /* data blocks and hashtables written to the database file */
+      uint64_t remaps;           /* remaps of the database file or the hashtable memory */
+      uint64_t lockWaits;        /* database mutex was already locked by another thread or process */
+      uint64_t lockWaitNs;       /* time spent waiting for the database mutex */
+      uint64_t writebacks;       /* write backs of the cache into the database file */
+      uint64_t writebackNs;
+      uint64_t recoveries;       /* opens of the first instance that found the database not closed correctly */
+      uint64_t recoveryNs[KDB_RECOVERY_STEPS]; /* duration of the steps of the last open of the first instance, 0 if not run */
+      Kdb_lock_prof_s locks[KDB_LOCK_COUNT];
+} Kdb_stats_s;
+
+#define KDB_STAT_ADD(stats, field, n) ((void) __atomic_fetch_add(&(stats)->field, (uint64_t) (n), __ATOMIC_RELAXED))
+#define KDB_STAT_SET(stats, field, n) __atomic_store_n(&(stats)->field, (uint64_t) (n), __ATOMIC_RELAXED)
+#define KDB_STAT_GET(stats, field)    __atomic_load_n(&(stats)->field, __ATOMIC_RELAXED)
+
 typedef struct
 {
       uint64_t htShmSize; /* shared info about current size of hashtable shared memory */
@@ -92,6 +170,15 @@ typedef struct
       pthread_mutex_t mutex;
       Kdb_bool mutexInit;
       uint64_t mappedDbSize; /* shared information about current mapped size of database file */
+      Kdb_bool bloomValid; /* flag to indicate if the bloom filter was built for the database file */
+      uint64_t bloomFilter[KISSDB_BLOOM_FILTER_BITS / 64]; /* shared bloom filter: a cleared bit means the key is not in the database file */
+      Kdb_bool keyDirValid; /* flag to indicate if the key directory holds all keys of the database (cache and file) */
+      int32_t keyDirListSize; /* size of the list of all keys ('\0' separated), maintained with the key directory */
+      uint64_t keyDirShmSize; /* shared info about current size of the key directory shared memory */
+      uint64_t txLastSeq; /* sequence number of the last transaction written to the intent log */
+      uint64_t txReplaySeq; /* first transaction of the intent log neither applied nor undone by its commit (0: none), replayed by the next first open */
+      int32_t attached[KISSDB_MAX_ATTACHED]; /* registry of attached instances: pid of the instance, 0 for a free entry */
+      Kdb_stats_s stats; /* performance counters of all instances using the database */
 } Shared_Data_s;
 
 
@@ -108,7 +195,8 @@ typedef struct
       uint64_t keySize;
       uint64_t valSize;
       char delimiter[8];
-      char padding[4032]; /* TODO remove padding*/
+      uint64_t txApplied; /* sequence number of the last transaction of the intent log applied to the database file */
+      char padding[4024]; /* TODO remove padding*/
 } Header_s;
 
 typedef struct
@@ -160,6 +248,8 @@ typedef struct {
         uint64_t dbMappedSize; //local info about currently mapped database  size for this process
         Kdb_bool shmCreator;   //local information if this instance is the creator of the shared memory
         Kdb_bool alreadyOpen;
+        Kdb_bool sharedInArena; //local information if the shared information is located in the shared memory arena
+        Kdb_bool privateMode;   //local information if the database is used exclusively by this process (no shared memory, no named semaphore)
         Hashtable_s* hashTables; //local pointer to hashtables in shared memory
         char* mappedDb; // local mapping of database file for every process
         void* sharedCache; //shared: memory for key-value pair caching
@@ -172,8 +262,16 @@ typedef struct {
         char* htName;
         Shared_Data_s* shared;
         qhasharr_t *tbl[1];   //reference to cache
+        void* keyDir; //shared: directory of all keys of the database, built on the first key listing
+        int keyDirFd;
+        uint64_t keyDirMappedSize; //local info about currently mapped key directory size for this process
+        char* keyDirName;
+        qhasharr_t* keyDirTbl; //reference to key directory
         sem_t* kdbSem;
+        sem_t privateSem; //unnamed semaphore used instead of the named semaphore in process private mode
         int fd; //local fd
+        int attachSlot; //local: entry of this instance in the registry of attached instances, -1 if not registered
+        const char* dbPath; //local: path of the database, set by the user of the database (only used for tracing)
 } KISSDB;
 
 /**
@@ -252,10 +350,6 @@ typedef struct {
 #define KISSDB_ERROR_WRONG_BUFSIZE -13
 
 
-/**
- * don't increment ref counter, possible application detected
- */
-#define KISSDB_ERROR_APPCRASH -14
    
 
 /**
@@ -325,6 +419,25 @@ extern int KISSDB_open(
  */
 extern int KISSDB_close(KISSDB *db);
 
+/**
+ * Write the hashtables with their checksums to the database file, the
+ * database stays open. The caller holds the write lock of the database and
+ * syncs the file afterwards.
+ *
+ * @param db Database struct
+ * @return negative on error (see kissdb.h for error codes), 0 on success
+ */
+extern int KISSDB_checkpoint(KISSDB *db);
+
+/**
+ * Map the whole database file again if it grew since this instance mapped
+ * it. The caller holds the write lock of the database.
+ *
+ * @param db Database struct
+ * @return negative on error (see kissdb.h for error codes), 0 on success
+ */
+extern int KISSDB_remap(KISSDB *db);
+
 /**
  * Get an entry
  *
@@ -359,6 +472,41 @@ extern int KISSDB_delete(KISSDB *db,const void *key, int32_t* bytesDeleted);
  */
 extern int KISSDB_put(KISSDB *db,const void *key,const void *value, int valueSize, int32_t* bytesWritten);
 
+/**
+ * djb2 hash of the key, used for the hashtable index and the bloom filter
+ *
+ * @param b Key
+ * @param len Length of the key in bytes
+ */
+extern uint64_t KISSDB_hash(const void* b, unsigned long len);
+
+/**
+ * Fill a key descriptor (key, length and 64 bit hash) so that
+ * the key is measured and hashed only once per access
+ *
+ * @param kdesc Key descriptor to fill
+ * @param key Key (null terminated)
+ */
+extern void KISSDB_key_init(persComDbKey_t *kdesc, const char *key);
+
+/**
+ * Same as KISSDB_get but the key is given as key descriptor
+ * filled by KISSDB_key_init
+ */
+extern int KISSDB_get_hashed(KISSDB *db, const persComDbKey_t *kdesc, void *vbuf, uint32_t bufsize, uint32_t* vsize);
+
+/**
+ * Same as KISSDB_delete but the key is given as key descriptor
+ * filled by KISSDB_key_init
+ */
+extern int KISSDB_delete_hashed(KISSDB *db, const persComDbKey_t *kdesc, int32_t* bytesDeleted);
+
+/**
+ * Same as KISSDB_put but the key is given as key descriptor
+ * filled by KISSDB_key_init
+ */
+extern int KISSDB_put_hashed(KISSDB *db, const persComDbKey_t *kdesc, const void *value, int valueSize, int32_t* bytesWritten);
+
 /**
  * Cursor used for iterating over all entries in database
  */
@@ -390,12 +538,20 @@ extern void KISSDB_Iterator_init(KISSDB *db,KISSDB_Iterator *dbi);
 extern int KISSDB_Iterator_next(KISSDB_Iterator *dbi,void *kbuf,void *vbuf);
 extern Kdb_bool freeKdbShmemPtr(void * shmem_ptr, size_t length);
 extern void * getKdbShmemPtr(int shmem, size_t length);
+extern void * getKdbPrivatePtr(size_t length);
+extern Kdb_bool resizeHashtableMemory(KISSDB* db, size_t newLength);
 extern Kdb_bool kdbShmemClose(int shmem, const char * shmName);
 extern int kdbShmemOpen(const char * name, size_t length, Kdb_bool* shmCreator);
 extern char * kdbGetShmName(const char * format, const char * path);
-extern void Kdb_wrlock(pthread_rwlock_t * wrlock);
-extern void Kdb_rdlock(pthread_rwlock_t * rdlock);
-extern void Kdb_unlock(pthread_rwlock_t * lock);
+extern Shared_Data_s* kdbSharedInfoLookup(const char* path);
+extern void Kdb_wrlock(pthread_rwlock_t * wrlock, Kdb_stats_s* stats);
+extern void Kdb_rdlock(pthread_rwlock_t * rdlock, Kdb_stats_s* stats);
+extern void Kdb_unlock(pthread_rwlock_t * lock, Kdb_stats_s* stats);
+#ifdef PERS_LLDB_LOCK_PROFILE
+extern uint64_t kdbLockProfileNow(void);
+extern void kdbLockProfileAcquired(Kdb_stats_s* stats, int lock, uint64_t startNs, uint64_t acquiredNs);
+extern void kdbLockProfileRelease(Kdb_stats_s* stats, int lock);
+#endif
 extern int readHeader(KISSDB* db, uint16_t* htSize, uint64_t* keySize, uint64_t* valSize);
 extern int writeHeader(KISSDB* db, uint16_t* htSize, uint64_t* keySize, uint64_t* valSize);
 extern int writeDualDataBlock(KISSDB* db, int64_t offset, int htNumber, const void* key, unsigned long klen, const void* value, int valueSize);
@@ -408,6 +564,9 @@ extern void invertBlockOffsets(DataBlock_s* data, KISSDB* db, int64_t offsetA, i
 extern void rebuildWithBlockB(DataBlock_s* data, KISSDB* db, int64_t offsetA, int64_t offsetB);
 extern void rebuildWithBlockA(DataBlock_s* data, KISSDB* db, int64_t offsetA, int64_t offsetB);
 extern int recoverDataBlocks(KISSDB* db);
+extern void bloomFilterAdd(KISSDB* db, uint64_t keyHash);
+extern Kdb_bool bloomFilterMayContain(KISSDB* db, uint64_t keyHash);
+extern void rebuildBloomFilter(KISSDB* db);
 extern int checkIsLink(const char* path, char* linkBuffer);
 extern void cleanKdbStruct(KISSDB* db);
 
@@ -0,0 +1,376 @@
+ /******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/* Shared memory arena for the KISSDB shared information
+*
+* Layout of the arena segment:
+*   - header with a process shared robust mutex protecting the directory
+*   - directory: hash of the database path and state of every slot
+*   - slots (page aligned): path of the database and its Shared_Data_s
+* Directory entry i describes slot i, lookup is done with linear probing. */
+
+
+#include "./kissdb_arena.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dlt.h>
+
+DLT_IMPORT_CONTEXT (persComLldbDLTCtx)
+
+#define KISSDB_ARENA_MAGIC   0x414E455241424B44ULL /* "DKBARENA" */
+#define KISSDB_ARENA_VERSION 1
+
+/* max. time in ms to wait for the creator of the arena to initialize it */
+#define KISSDB_ARENA_INIT_TIMEOUT 1000
+
+#define ARENA_ENTRY_FREE    0
+#define ARENA_ENTRY_USED    1
+#define ARENA_ENTRY_REMOVED 2
+
+typedef struct
+{
+   uint64_t pathHash;
+   uint32_t state;
+   uint32_t padding;
+} ArenaDirEntry_s;
+
+typedef struct
+{
+   char path[KISSDB_ARENA_MAX_PATH];
+   Shared_Data_s shared;
+} ArenaSlot_s;
+
+typedef struct
+{
+   uint64_t magic; /* written last by the creator of the arena */
+   uint32_t version;
+   uint32_t slotCount;
+   uint64_t slotSize;
+   pthread_mutex_t mutex;
+   ArenaDirEntry_s dir[PERS_SHM_ARENA_MAX_DBS];
+} ArenaHeader_s;
+
+#define ARENA_SLOTS_OFFSET  (((sizeof(ArenaHeader_s) + 4095) / 4096) * 4096)
+#define ARENA_SIZE          (ARENA_SLOTS_OFFSET + (PERS_SHM_ARENA_MAX_DBS * sizeof(ArenaSlot_s)))
+
+/* arena of this process: mapped on first use and kept until the process ends */
+static pthread_mutex_t gArenaMapLock = PTHREAD_MUTEX_INITIALIZER;
+static ArenaHeader_s* gArena = NULL;
+static const char* gArenaRoot = NULL;
+/* read only mapping of the arena used by kdbArenaLookup: mapped on first lookup and kept until the process ends */
+static ArenaHeader_s* gArenaRead = NULL;
+static const char* gArenaReadRoot = NULL;
+
+
+static ArenaSlot_s* arenaSlot(ArenaHeader_s* arena, uint32_t idx)
+{
+   return (ArenaSlot_s*) ((char*) arena + ARENA_SLOTS_OFFSET + (idx * sizeof(ArenaSlot_s)));
+}
+
+/* FNV-1a hash of the database path */
+static uint64_t arenaHash(const char* path)
+{
+   uint64_t hash = 0xcbf29ce484222325ULL;
+
+   while (*path != '\0')
+   {
+      hash ^= (uint8_t) *path++;
+      hash *= 0x100000001b3ULL;
+   }
+   return hash;
+}
+
+static void arenaSleepMs(long ms)
+{
+   struct timespec ts;
+
+   ts.tv_sec = 0;
+   ts.tv_nsec = ms * 1000000L;
+   nanosleep(&ts, NULL);
+}
+
+static Kdb_bool arenaLock(pthread_mutex_t* mutex)
+{
+   int err = pthread_mutex_lock(mutex);
+
+   if (EOWNERDEAD == err)
+   {
+      //previous owner died while holding the lock, the directory is only modified by single stores -> keep it
+      err = pthread_mutex_consistent(mutex);
+   }
+   if (0 != err)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": locking arena failed with error: "); DLT_INT(err));
+      return Kdb_false;
+   }
+   return Kdb_true;
+}
+
+static ArenaHeader_s* arenaMap(const char* root)
+{
+   ArenaHeader_s* arena;
+   Kdb_bool creator = Kdb_false;
+   char* name;
+   int fd;
+   int waited = 0;
+   struct stat sb;
+
+   name = kdbGetShmName("-arena", root);
+   if (name == NULL)
+   {
+      return NULL;
+   }
+   fd = kdbShmemOpen(name, ARENA_SIZE, &creator);
+   free(name);
+   if (fd < 0)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": opening shared memory arena failed: "); DLT_STRING(strerror(errno)));
+      return NULL;
+   }
+
+   //wait until the creator has set the size of the arena
+   while (creator == Kdb_false && fstat(fd, &sb) == 0 && (size_t) sb.st_size < ARENA_SIZE && waited < KISSDB_ARENA_INIT_TIMEOUT)
+   {
+      arenaSleepMs(1);
+      waited++;
+   }
+
+   arena = (ArenaHeader_s*) getKdbShmemPtr(fd, ARENA_SIZE);
+   close(fd); //the mapping stays valid, no file descriptor is kept per process
+   if (arena == ((void*) -1))
+   {
+      return NULL;
+   }
+
+   if (creator == Kdb_true)
+   {
+      pthread_mutexattr_t mattr;
+
+      pthread_mutexattr_init(&mattr);
+      pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST);
+      pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+      pthread_mutex_init(&arena->mutex, &mattr);
+      pthread_mutexattr_destroy(&mattr);
+
+      arena->version = KISSDB_ARENA_VERSION;
+      arena->slotCount = PERS_SHM_ARENA_MAX_DBS;
+      arena->slotSize = sizeof(ArenaSlot_s);
+      __atomic_store_n(&arena->magic, KISSDB_ARENA_MAGIC, __ATOMIC_RELEASE);
+   }
+   else
+   {
+      while (__atomic_load_n(&arena->magic, __ATOMIC_ACQUIRE) != KISSDB_ARENA_MAGIC && waited < KISSDB_ARENA_INIT_TIMEOUT)
+      {
+         arenaSleepMs(1);
+         waited++;
+      }
+      if (arena->magic != KISSDB_ARENA_MAGIC || arena->version != KISSDB_ARENA_VERSION
+          || arena->slotCount != PERS_SHM_ARENA_MAX_DBS || arena->slotSize != sizeof(ArenaSlot_s))
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": shared memory arena is not initialized or has a different layout"));
+         munmap(arena, ARENA_SIZE);
+         return NULL;
+      }
+   }
+   return arena;
+}
+
+
+Shared_Data_s* kdbArenaAttach(const char* root, const char* path, Kdb_bool* shmCreator)
+{
+   ArenaHeader_s* arena;
+   ArenaSlot_s* slot;
+   Shared_Data_s* result = NULL;
+   size_t rootLen = strlen(root);
+   uint64_t hash;
+   uint32_t idx, n;
+   int64_t freeIdx = -1;
+
+   //only databases below the persistence root are kept in the arena
+   if (strlen(path) >= KISSDB_ARENA_MAX_PATH || strncmp(path, root, rootLen) != 0
+       || (path[rootLen] != '/' && (rootLen == 0 || root[rootLen - 1] != '/')))
+   {
+      return NULL;
+   }
+
+   pthread_mutex_lock(&gArenaMapLock);
+   if (gArena == NULL && gArenaRoot == NULL)
+   {
+      gArenaRoot = root;
+      gArena = arenaMap(root);
+   }
+   arena = (gArenaRoot == root || strcmp(gArenaRoot, root) == 0) ? gArena : NULL;
+   pthread_mutex_unlock(&gArenaMapLock);
+
+   if (arena == NULL || arenaLock(&arena->mutex) == Kdb_false)
+   {
+      return NULL;
+   }
+
+   hash = arenaHash(path);
+   idx = (uint32_t) (hash % PERS_SHM_ARENA_MAX_DBS);
+   for (n = 0; n < PERS_SHM_ARENA_MAX_DBS; n++, idx = (idx + 1) % PERS_SHM_ARENA_MAX_DBS)
+   {
+      if (arena->dir[idx].state == ARENA_ENTRY_FREE)
+      {
+         if (freeIdx < 0)
+         {
+            freeIdx = idx;
+         }
+         break; //end of probe sequence
+      }
+      if (arena->dir[idx].state == ARENA_ENTRY_REMOVED)
+      {
+         if (freeIdx < 0)
+         {
+            freeIdx = idx;
+         }
+      }
+      else if (arena->dir[idx].pathHash == hash && strcmp(arenaSlot(arena, idx)->path, path) == 0)
+      {
+         *shmCreator = Kdb_false;
+         result = &arenaSlot(arena, idx)->shared;
+         break;
+      }
+   }
+
+   if (result == NULL)
+   {
+      if (freeIdx >= 0)
+      {
+         slot = arenaSlot(arena, (uint32_t) freeIdx);
+         memset(slot, 0, sizeof(ArenaSlot_s));
+         strcpy(slot->path, path);
+         arena->dir[freeIdx].pathHash = hash;
+         arena->dir[freeIdx].state = ARENA_ENTRY_USED;
+         *shmCreator = Kdb_true;
+         result = &slot->shared;
+      }
+      else
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": shared memory arena is full -> use own segment for: "); DLT_STRING(path));
+      }
+   }
+   pthread_mutex_unlock(&arena->mutex);
+
+   return result;
+}
+
+
+void kdbArenaRemove(Shared_Data_s* shared)
+{
+   ArenaHeader_s* arena = gArena;
+   uint32_t idx;
+
+   if (arena == NULL || arenaLock(&arena->mutex) == Kdb_false)
+   {
+      return;
+   }
+   idx = (uint32_t) (((char*) shared - offsetof(ArenaSlot_s, shared) - ((char*) arena + ARENA_SLOTS_OFFSET)) / sizeof(ArenaSlot_s));
+   if (idx < PERS_SHM_ARENA_MAX_DBS)
+   {
+      //a removed entry is only needed to keep the probe sequence of following entries intact
+      if (arena->dir[(idx + 1) % PERS_SHM_ARENA_MAX_DBS].state == ARENA_ENTRY_FREE)
+      {
+         arena->dir[idx].state = ARENA_ENTRY_FREE;
+      }
+      else
+      {
+         arena->dir[idx].state = ARENA_ENTRY_REMOVED;
+      }
+   }
+   pthread_mutex_unlock(&arena->mutex);
+}
+
+
+//read only mapping of the arena of root, NULL if it does not exist or has another layout
+static ArenaHeader_s* arenaMapReadOnly(const char* root)
+{
+   ArenaHeader_s* arena;
+   char* name;
+   int fd;
+
+   name = kdbGetShmName("-arena", root);
+   if (name == NULL)
+   {
+      return NULL;
+   }
+   fd = shm_open(name, O_RDONLY, 0);
+   free(name);
+   if (fd < 0)
+   {
+      return NULL;
+   }
+   arena = (ArenaHeader_s*) mmap(NULL, ARENA_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (arena == MAP_FAILED)
+   {
+      return NULL;
+   }
+   if (arena->magic != KISSDB_ARENA_MAGIC || arena->version != KISSDB_ARENA_VERSION
+       || arena->slotCount != PERS_SHM_ARENA_MAX_DBS || arena->slotSize != sizeof(ArenaSlot_s))
+   {
+      munmap(arena, ARENA_SIZE);
+      return NULL;
+   }
+   return arena;
+}
+
+
+Shared_Data_s* kdbArenaLookup(const char* root, const char* path)
+{
+   ArenaHeader_s* arena = NULL;
+   Shared_Data_s* result = NULL;
+   uint64_t hash;
+   uint32_t idx, n;
+
+   //one mapping per process for all lookups: the arena attached by this process, else a read only mapping
+   pthread_mutex_lock(&gArenaMapLock);
+   if (gArena != NULL && (gArenaRoot == root || strcmp(gArenaRoot, root) == 0))
+   {
+      arena = gArena;
+   }
+   else
+   {
+      if (gArenaRead == NULL && gArenaReadRoot == NULL)
+      {
+         gArenaRead = arenaMapReadOnly(root);
+         if (gArenaRead != NULL)
+         {
+            gArenaReadRoot = root;
+         }
+      }
+      if (gArenaRead != NULL && (gArenaReadRoot == root || strcmp(gArenaReadRoot, root) == 0))
+      {
+         arena = gArenaRead;
+      }
+   }
+   pthread_mutex_unlock(&gArenaMapLock);
+   if (arena == NULL)
+   {
+      return NULL;
+   }
+
+   //no lock: the directory is only read, an entry being removed concurrently is reported as found
+   hash = arenaHash(path);
+   idx = (uint32_t) (hash % PERS_SHM_ARENA_MAX_DBS);
+   for (n = 0; n < PERS_SHM_ARENA_MAX_DBS && arena->dir[idx].state != ARENA_ENTRY_FREE; n++, idx = (idx + 1) % PERS_SHM_ARENA_MAX_DBS)
+   {
+      if (arena->dir[idx].state == ARENA_ENTRY_USED && arena->dir[idx].pathHash == hash && strcmp(arenaSlot(arena, idx)->path, path) == 0)
+      {
+         result = &arenaSlot(arena, idx)->shared;
+         break;
+      }
+   }
+   return result;
+}
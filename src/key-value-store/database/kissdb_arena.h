@@ -0,0 +1,62 @@
+ /******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/* Shared memory arena for the KISSDB shared information
+*
+* All databases below one persistence root keep their Shared_Data_s in a
+* single shared memory segment instead of one "-shm-info" segment per
+* database. The segment holds a directory (open addressing over the hash
+* of the database path) and a fixed size slot for every entry, so a
+* database already present in the arena is found in constant time and no
+* file descriptor is kept open per database. */
+
+
+#ifndef ___KISSDB_ARENA_H
+#define ___KISSDB_ARENA_H
+
+#include "./kissdb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* max. number of databases sharing one arena */
+#ifndef PERS_SHM_ARENA_MAX_DBS
+#define PERS_SHM_ARENA_MAX_DBS 1024
+#endif
+
+/* max. length of a database path stored in the arena (longer paths use their own segment) */
+#define KISSDB_ARENA_MAX_PATH 256
+
+/**
+ * Attach to the shared information of a database in the arena of a persistence root
+ * The entry is created (zero initialized) if the database is not yet present in the arena.
+ * @param root Persistence root the arena belongs to
+ * @param path Path of the database file (must be located below root)
+ * @param shmCreator Set to Kdb_true if the entry was created by this call
+ * @return pointer to the shared information or NULL if the database can not be kept in the arena
+ */
+extern Shared_Data_s* kdbArenaAttach(const char* root, const char* path, Kdb_bool* shmCreator);
+
+/**
+ * Remove the shared information of a database from the arena (called by the last instance closing the database)
+ * @param shared Pointer obtained with kdbArenaAttach
+ */
+extern void kdbArenaRemove(Shared_Data_s* shared);
+
+/**
+ * Read only lookup of the shared information of a database in the arena (used by diagnostic tools)
+ * Nothing is created, the arena is mapped read only on the first lookup and stays mapped as long as the process runs.
+ * @param root Persistence root the arena belongs to
+ * @param path Path of the database file
+ * @return pointer to the shared information or NULL if the database is not present in the arena
+ */
+extern Shared_Data_s* kdbArenaLookup(const char* root, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //___KISSDB_ARENA_H
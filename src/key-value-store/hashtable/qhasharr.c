@@ -162,6 +162,15 @@ static bool getnext(qhasharr_t *tbl, qnobj_t *obj, int *idx);
 
 static bool remove_(qhasharr_t *tbl, const char *key);
 
+static bool put_hashed(qhasharr_t *tbl, const char *key, size_t keylen,
+                       uint32_t keyhash, const void *value, size_t size);
+
+static void *get_hashed(qhasharr_t *tbl, const char *key, size_t keylen,
+                        uint32_t keyhash, size_t *size);
+
+static bool remove_hashed(qhasharr_t *tbl, const char *key, size_t keylen,
+                          uint32_t keyhash);
+
 static int size(qhasharr_t *tbl, int *maxslots, int *usedslots);
 
 static void free_(qhasharr_t *tbl);
@@ -170,11 +179,14 @@ static void free_(qhasharr_t *tbl);
 
 // internal usages
 static int _find_empty(qhasharr_t *tbl, int startidx);
-static int _get_idx(qhasharr_t *tbl, const char *key, unsigned int hash);
+static int _get_idx(qhasharr_t *tbl, const char *key, size_t keylen,
+                    uint32_t keyhash, unsigned int hash);
 static void *_get_data(qhasharr_t *tbl, int idx, size_t *size);
 static bool _put_data(qhasharr_t *tbl, int idx, unsigned int hash,
-                      const char *key, const void *value, size_t size,
-                      int count);
+                      const char *key, size_t keylen, uint32_t keyhash,
+                      const void *value, size_t size, int count);
+static bool _update_data(qhasharr_t *tbl, int idx, const void *value,
+                         size_t size);
 static bool _copy_slot(qhasharr_t *tbl, int idx1, int idx2);
 static bool _remove_slot(qhasharr_t *tbl, int idx);
 static bool _remove_data(qhasharr_t *tbl, int idx);
@@ -259,6 +271,9 @@ qhasharr_t *qhasharr(void *memory, size_t memsize)
    tbl->get = get;
    tbl->getnext = getnext;
    tbl->remove = remove_;
+   tbl->put_hashed = put_hashed;
+   tbl->get_hashed = get_hashed;
+   tbl->remove_hashed = remove_hashed;
    tbl->size = size;
    tbl->free = free_;
    tbl->data = data;
@@ -294,6 +309,11 @@ void setMemoryAddress(void* memory, qhasharr_t *tbl )
  *  - ENOBUFS   : Table doesn't have enough space to store the object.
  *  - EINVAL    : Invalid argument.
  *  - EFAULT    : Unexpected error. Data structure is not constant.
+ *
+ * @note
+ *  If the key is already stored, the value is replaced in place: the slot
+ *  chain of the key is reused, extended or shortened as needed. If the table
+ *  cannot hold a grown value, the old value is left untouched.
  */
 static bool put(qhasharr_t *tbl, const char *key, const void *value,
                 size_t size) {
@@ -302,8 +322,45 @@ static bool put(qhasharr_t *tbl, const char *key, const void *value,
         return false;
     }
 
+    size_t keylen = strlen(key);
+    return put_hashed(tbl, key, keylen, qhashmurmur3_32(key, keylen), value,
+                      size);
+}
+
+/**
+ * qhasharr->put_hashed(): Put an object into this table using a key hash
+ * computed by the caller.
+ *
+ * @param tbl       qhasharr_t container pointer.
+ * @param key       key string
+ * @param keylen    length of the key string
+ * @param keyhash   32 bit hash of the key
+ * @param value     value object data
+ * @param size      size of value
+ *
+ * @return true if successful, otherwise returns false
+ */
+static bool put_hashed(qhasharr_t *tbl, const char *key, size_t keylen,
+                       uint32_t keyhash, const void *value, size_t size) {
+    if (tbl == NULL || key == NULL || value == NULL) {
+        errno = EINVAL;
+        return false;
+    }
+
     qhasharr_data_t *data = tbl->data;
     //printf("put data-> ptr= %p ---- MAXSLOTS = %d \n", data, data->maxslots);
+
+    // get hash integer
+    unsigned int hash = keyhash % data->maxslots;
+
+    // same key: overwrite the value in place, _update_data checks the space itself
+    if (data->slots[hash].count > 0) {
+        int idx = _get_idx(tbl, key, keylen, keyhash, hash);
+        if (idx >= 0) {
+            return _update_data(tbl, idx, value, size);
+        }
+    }
+
     // check full
     if (data->usedslots >= data->maxslots || ((data->usedslots + (size / 32)) >= data->maxslots))  {
         //DEBUG("hasharr: put %s - FULL", key);
@@ -312,45 +369,33 @@ static bool put(qhasharr_t *tbl, const char *key, const void *value,
         return false;
     }
 
-
-    // get hash integer
-    unsigned int hash = qhashmurmur3_32(key, strlen(key)) % data->maxslots;
-
     // check, is slot empty
     if (data->slots[hash].count == 0) {  // empty slot
         // put data
-        if (_put_data(tbl, hash, hash, key, value, size, 1) == false) {
+        if (_put_data(tbl, hash, hash, key, keylen, keyhash, value, size, 1) == false) {
             //DEBUG("hasharr: FAILED put(new) %s", key);
             return false;
         } //DEBUG("hasharr: put(new) %s (idx=%d,hash=%u,tot=%d)",
           //      key, hash, hash, data->usedslots);
-    } else if (data->slots[hash].count > 0) {  // same key or hash collision
-        // check same key;
-        int idx = _get_idx(tbl, key, hash);
-        if (idx >= 0) {  // same key
-            // remove and recall
-            remove_(tbl, key);
-            return put(tbl, key, value, size);
-        } else {  // no same key, just hash collision
-            // find empty slot
-            int idx = _find_empty(tbl, hash);
-            if (idx < 0) {
-                errno = ENOBUFS;
-                return false;
-            }
+    } else if (data->slots[hash].count > 0) {  // hash collision, same key is handled above
+        // find empty slot
+        int idx = _find_empty(tbl, hash);
+        if (idx < 0) {
+            errno = ENOBUFS;
+            return false;
+        }
 
-            // put data. -1 is used for collision resolution (idx != hash);
-            if (_put_data(tbl, idx, hash, key, value, size, -1) == false) {
-                //DEBUG("hasharr: FAILED put(col) %s", key);
-                return false;
-            }
+        // put data. -1 is used for collision resolution (idx != hash);
+        if (_put_data(tbl, idx, hash, key, keylen, keyhash, value, size, -1) == false) {
+            //DEBUG("hasharr: FAILED put(col) %s", key);
+            return false;
+        }
 
-            // increase counter from leading slot
-            data->slots[hash].count++;
+        // increase counter from leading slot
+        data->slots[hash].count++;
 
-            //DEBUG("hasharr: put(col) %s (idx=%d,hash=%u,tot=%d)",
-            //        key, idx, hash, data->usedslots);
-        }
+        //DEBUG("hasharr: put(col) %s (idx=%d,hash=%u,tot=%d)",
+        //        key, idx, hash, data->usedslots);
     } else {
         // in case of -1 or -2, move it. -1 used for collision resolution,
         // -2 used for oversized value data.
@@ -368,13 +413,14 @@ static bool put(qhasharr_t *tbl, const char *key, const void *value,
         // in case of -2, adjust link of mother
         if (data->slots[idx].count == -2) {
             data->slots[data->slots[idx].hash].link = idx;
-            if (data->slots[idx].link != -1) {
-                data->slots[data->slots[idx].link].hash = idx;
-            }
+        }
+        // in both cases the next linked block must point back to the new slot
+        if (data->slots[idx].link != -1) {
+            data->slots[data->slots[idx].link].hash = idx;
         }
 
         // store data
-        if (_put_data(tbl, hash, hash, key, value, size, 1) == false) {
+        if (_put_data(tbl, hash, hash, key, keylen, keyhash, value, size, 1) == false) {
             //DEBUG("hasharr: FAILED put(swp) %s", key);
             return false;
         }
@@ -410,10 +456,33 @@ static void *get(qhasharr_t *tbl, const char *key, size_t *size) {
         //errno = EINVAL;
         return NULL;
     }
+    size_t keylen = strlen(key);
+    return get_hashed(tbl, key, keylen, qhashmurmur3_32(key, keylen), size);
+}
+
+/**
+ * qhasharr->get_hashed(): Get an object from this table using a key hash
+ * computed by the caller.
+ *
+ * @param tbl       qhasharr_t container pointer.
+ * @param key       key string
+ * @param keylen    length of the key string
+ * @param keyhash   32 bit hash of the key
+ * @param size      if not NULL, oject size will be stored
+ *
+ * @return malloced object pointer if successful, otherwise(not found)
+ *  returns NULL
+ */
+static void *get_hashed(qhasharr_t *tbl, const char *key, size_t keylen,
+                        uint32_t keyhash, size_t *size) {
+    if (tbl == NULL || key == NULL) {
+        //errno = EINVAL;
+        return NULL;
+    }
     qhasharr_data_t *data = tbl->data;
     // get hash integer
-    unsigned int hash = qhashmurmur3_32(key, strlen(key)) % data->maxslots;
-    int idx = _get_idx(tbl, key, hash);
+    unsigned int hash = keyhash % data->maxslots;
+    int idx = _get_idx(tbl, key, keylen, keyhash, hash);
     if (idx < 0) {
         //errno = ENOENT;
         return NULL;
@@ -505,12 +574,34 @@ static bool remove_(qhasharr_t *tbl, const char *key) {
         return false;
     }
 
+    size_t keylen = strlen(key);
+    return remove_hashed(tbl, key, keylen, qhashmurmur3_32(key, keylen));
+}
+
+/**
+ * qhasharr->remove_hashed(): Remove an object from this table using a key
+ * hash computed by the caller.
+ *
+ * @param tbl       qhasharr_t container pointer.
+ * @param key       key string
+ * @param keylen    length of the key string
+ * @param keyhash   32 bit hash of the key
+ *
+ * @return true if successful, otherwise(not found) returns false
+ */
+static bool remove_hashed(qhasharr_t *tbl, const char *key, size_t keylen,
+                          uint32_t keyhash) {
+    if (tbl == NULL || key == NULL) {
+        //errno = EINVAL;
+        return false;
+    }
+
     qhasharr_data_t *data = tbl->data;
 
     // get hash integer
-    unsigned int hash = qhashmurmur3_32(key, strlen(key)) % data->maxslots;
+    unsigned int hash = keyhash % data->maxslots;
 
-    int idx = _get_idx(tbl, key, hash);
+    int idx = _get_idx(tbl, key, keylen, keyhash, hash);
     if (idx < 0) {
         //DEBUG("not found %s", key);
         //errno = ENOENT;
@@ -633,7 +724,8 @@ static int _find_empty(qhasharr_t *tbl, int startidx) {
     return -1;
 }
 
-static int _get_idx(qhasharr_t *tbl, const char *key, unsigned int hash) {
+static int _get_idx(qhasharr_t *tbl, const char *key, size_t keylen,
+                    uint32_t keyhash, unsigned int hash) {
     qhasharr_data_t *data = tbl->data;
 
     if (data->slots[hash].count > 0) {
@@ -645,10 +737,9 @@ static int _get_idx(qhasharr_t *tbl, const char *key, unsigned int hash) {
                 // same hash
                 count++;
 
-                // is same key?
-                size_t keylen = strlen(key);
-                // first check key length
-                if (keylen == data->slots[idx].data.pair.keylen) {
+                // is same key? first check full hash and key length
+                if (keyhash == data->slots[idx].keyhash
+                        && keylen == data->slots[idx].data.pair.keylen) {
                     if (keylen <= _Q_HASHARR_KEYSIZE) {
                         // original key is stored
                         if (!memcmp(key, data->slots[idx].data.pair.key, keylen))
@@ -721,8 +812,8 @@ static void *_get_data(qhasharr_t *tbl, int idx, size_t *size) {
 }
 
 static bool _put_data(qhasharr_t *tbl, int idx, unsigned int hash,
-                      const char *key, const void *value, size_t size,
-                      int count) {
+                      const char *key, size_t keylen, uint32_t keyhash,
+                      const void *value, size_t size, int count) {
     qhasharr_data_t *data = tbl->data;
 
     // check if used
@@ -732,11 +823,10 @@ static bool _put_data(qhasharr_t *tbl, int idx, unsigned int hash,
         return false;
     }
 
-    size_t keylen = strlen(key);
-
     // store key
     data->slots[idx].count = count;
     data->slots[idx].hash = hash;
+    data->slots[idx].keyhash = keyhash;
     strncpy(data->slots[idx].data.pair.key, key, _Q_HASHARR_KEYSIZE);
     data->slots[idx].data.pair.keylen = keylen;
     data->slots[idx].link = -1;
@@ -801,6 +891,83 @@ static bool _put_data(qhasharr_t *tbl, int idx, unsigned int hash,
     return true;
 }
 
+// overwrite the value of an existing element : reuses the slot chain of the
+// element, links additional slots or releases surplus ones.
+static bool _update_data(qhasharr_t *tbl, int idx, const void *value,
+                         size_t size) {
+    qhasharr_data_t *data = tbl->data;
+
+    // number of slots currently linked to the element
+    int oldslots, newidx;
+    for (oldslots = 1, newidx = idx; data->slots[newidx].link != -1;
+            newidx = data->slots[newidx].link) {
+        oldslots++;
+    }
+
+    // number of slots needed for the new value
+    int newslots = 1;
+    if (size > _Q_HASHARR_VALUESIZE) {
+        newslots += (size - _Q_HASHARR_VALUESIZE
+                     + sizeof(struct _Q_HASHARR_SLOT_EXT) - 1)
+                     / sizeof(struct _Q_HASHARR_SLOT_EXT);
+    }
+
+    // check space before touching the old value
+    if (newslots - oldslots > data->maxslots - data->usedslots) {
+        errno = ENOBUFS;
+        return false;
+    }
+
+    size_t savesize = 0;
+    size_t copysize = size;
+    if (copysize > _Q_HASHARR_VALUESIZE) {
+        copysize = _Q_HASHARR_VALUESIZE;
+    }
+    memcpy(data->slots[idx].data.pair.value, value, copysize);
+    data->slots[idx].size = copysize;
+    savesize += copysize;
+
+    for (newidx = idx; savesize < size;) {
+        int tmpidx = data->slots[newidx].link;
+        if (tmpidx == -1) {  // chain exhausted, link next empty slot
+            tmpidx = _find_empty(tbl, newidx + 1);
+            if (tmpidx < 0) {
+                //DEBUG("hasharr: [BUG] no empty slot after space check.");
+                errno = EFAULT;
+                return false;
+            }
+
+            memset((void *) (&data->slots[tmpidx]), '\0',
+                   sizeof(qhasharr_slot_t));
+            data->slots[tmpidx].count = -2;      // extended data block
+            data->slots[tmpidx].hash = newidx;   // prev link
+            data->slots[tmpidx].link = -1;       // end block mark
+            data->slots[newidx].link = tmpidx;   // link chain
+            data->usedslots++;
+        }
+        newidx = tmpidx;
+
+        copysize = size - savesize;
+        if (copysize > sizeof(struct _Q_HASHARR_SLOT_EXT)) {
+            copysize = sizeof(struct _Q_HASHARR_SLOT_EXT);
+        }
+        memcpy(data->slots[newidx].data.ext.value, value + savesize, copysize);
+        data->slots[newidx].size = copysize;
+        savesize += copysize;
+    }
+
+    // release slots which are not needed anymore
+    int link = data->slots[newidx].link;
+    data->slots[newidx].link = -1;
+    while (link != -1) {
+        int next = data->slots[link].link;
+        _remove_slot(tbl, link);
+        link = next;
+    }
+
+    return true;
+}
+
 static bool _copy_slot(qhasharr_t *tbl, int idx1, int idx2) {
     qhasharr_data_t *data = tbl->data;
 
@@ -75,10 +75,13 @@ struct qhasharr_slot_s {
     short  count;   /*!< hash collision counter. 0 indicates empty slot,
                      -1 is used for collision resolution, -2 is used for
                      indicating linked block */
-    uint32_t  hash; /*!< key hash. we use FNV32 */
-
-    uint8_t size;   /*!< value size in this slot*/
+    uint8_t size;   /*!< value size in this slot (kept next to count so
+                     that it fits into the alignment gap) */
+    uint32_t  hash; /*!< home slot index of the key (hash % maxslots),
+                     previous link for linked blocks */
     int link;       /*!< next link */
+    uint32_t  keyhash; /*!< full 32 bit murmur3 hash of the key, compared
+                        before the key itself on lookup */
 
     union {
         /*!< key/value data */
@@ -129,6 +132,18 @@ struct qhasharr_s {
 
     /* private variables */
     qhasharr_data_t *data;
+
+    /* variants for callers which already know key length and key hash
+       (qhashmurmur3_32 of the key, as computed by the functions above).
+       Appended after the original members to keep their offsets. */
+    bool (*put_hashed) (qhasharr_t *tbl, const char *key, size_t keylen,
+                        uint32_t keyhash, const void *value, size_t size);
+
+    void *(*get_hashed) (qhasharr_t *tbl, const char *key, size_t keylen,
+                         uint32_t keyhash, size_t *size);
+
+    bool (*remove_hashed) (qhasharr_t *tbl, const char *key, size_t keylen,
+                           uint32_t keyhash);
 };
 
 #ifdef __cplusplus
@@ -0,0 +1,387 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           pers_lldb_async.c
+ * @ingroup        Persistence key value store
+ * @brief          Queue and worker thread of the asynchronous writes
+ * @see            pers_lldb_async.h
+ */
+
+#include "pers_lldb_async.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <dlt.h>
+#include "persComErrors.h"
+#include "pers_low_level_db_access_if.h"
+
+DLT_IMPORT_CONTEXT (persComLldbDLTCtx)
+
+#define LT_HDR "[persComLLDB]"
+
+
+typedef struct lldb_async_node_s
+{
+   struct lldb_async_node_s* next;       /* newer node, linked by the producer after the exchange of the head */
+   sint_t handlerDB;
+   persComDbKey_t key;                   /* key.key points to keyName */
+   sint_t dataSize;
+   persComDbWriteCallback_t callback;
+   void* ctx;
+   str_t keyName[PERS_DB_MAX_LENGTH_KEY_NAME];
+   str_t data[];
+} lldb_async_node_s;
+
+typedef struct
+{
+   lldb_async_node_s* head;              /* newest node, exchanged by the producers */
+   lldb_async_node_s* tail;              /* oldest node, only changed by the worker with scanMutex */
+   lldb_async_node_s* current;           /* node written by the worker, still visible to the readers */
+   uint64_t queued;                      /* number of writes queued so far */
+   uint64_t done;                        /* number of writes finished so far */
+   pthread_mutex_t scanMutex;            /* the worker does not free a node while a reader walks the queue */
+   pthread_mutex_t doneMutex;
+   pthread_cond_t doneCond;
+   sem_t sem;                            /* one post per queued node */
+   pthread_t worker;
+   bool_t bStarted;
+   bool_t bAtforkRegistered;
+   int eventFd;
+} lldb_async_s;
+
+/* stub of the queue (Vyukov intrusive MPSC queue), the queue is never empty */
+static lldb_async_node_s g_sAsyncStub = { .handlerDB = -1 };
+
+static lldb_async_s g_sAsync =
+{
+   .head = &g_sAsyncStub,
+   .tail = &g_sAsyncStub,
+   .scanMutex = PTHREAD_MUTEX_INITIALIZER,
+   .doneMutex = PTHREAD_MUTEX_INITIALIZER,
+   .doneCond = PTHREAD_COND_INITIALIZER,
+   .eventFd = -1
+};
+
+static pthread_mutex_t g_asyncInitMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+static void asyncPush(lldb_async_node_s* pNode)
+{
+   lldb_async_node_s* pPrev;
+
+   __atomic_store_n(&pNode->next, NIL, __ATOMIC_RELAXED);
+   pPrev = __atomic_exchange_n(&g_sAsync.head, pNode, __ATOMIC_ACQ_REL);
+   __atomic_store_n(&pPrev->next, pNode, __ATOMIC_RELEASE);
+}
+
+/* oldest node, NIL if the queue is empty or a producer has not yet linked its node. Called by the worker with scanMutex */
+static lldb_async_node_s* asyncPop(void)
+{
+   lldb_async_node_s* pTail = g_sAsync.tail;
+   lldb_async_node_s* pNext = __atomic_load_n(&pTail->next, __ATOMIC_ACQUIRE);
+
+   if (pTail == &g_sAsyncStub)
+   {
+      if (pNext == NIL)
+      {
+         return NIL;
+      }
+      g_sAsync.tail = pNext;
+      pTail = pNext;
+      pNext = __atomic_load_n(&pTail->next, __ATOMIC_ACQUIRE);
+   }
+   if (pNext != NIL)
+   {
+      g_sAsync.tail = pNext;
+      return pTail;
+   }
+   if (pTail != __atomic_load_n(&g_sAsync.head, __ATOMIC_ACQUIRE))
+   {
+      return NIL;
+   }
+   //last node: the stub is queued again so the node can be removed
+   asyncPush(&g_sAsyncStub);
+   pNext = __atomic_load_n(&pTail->next, __ATOMIC_ACQUIRE);
+   if (pNext != NIL)
+   {
+      g_sAsync.tail = pNext;
+      return pTail;
+   }
+   return NIL;
+}
+
+static void* asyncWorker(void* arg)
+{
+   lldb_async_node_s* pNode;
+   uint64_t one = 1;
+   sint_t result;
+
+   (void) arg;
+   for (;;)
+   {
+      while (sem_wait(&g_sAsync.sem) != 0)
+      {
+         //EINTR
+      }
+      (void) pthread_mutex_lock(&g_sAsync.scanMutex);
+      while ((pNode = asyncPop()) == NIL)
+      {
+         //the node is queued, its producer is between the exchange of the head and the link
+         (void) pthread_mutex_unlock(&g_sAsync.scanMutex);
+         (void) sched_yield();
+         (void) pthread_mutex_lock(&g_sAsync.scanMutex);
+      }
+      g_sAsync.current = pNode;
+      (void) pthread_mutex_unlock(&g_sAsync.scanMutex);
+
+      result = pers_lldb_write_key_prepared(pNode->handlerDB, PersLldbPurpose_DB, &pNode->key, pNode->data, pNode->dataSize);
+
+      (void) pthread_mutex_lock(&g_sAsync.scanMutex);
+      g_sAsync.current = NIL;
+      (void) pthread_mutex_unlock(&g_sAsync.scanMutex);
+
+      if (result < 0)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
+                 DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(pNode->handlerDB); DLT_STRING("key=<"); DLT_STRING(pNode->keyName); DLT_STRING(">, "); DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
+      }
+      if (pNode->callback != NIL)
+      {
+         pNode->callback(pNode->handlerDB, pNode->keyName, result, pNode->ctx);
+      }
+      free(pNode);
+      if (g_sAsync.eventFd >= 0)
+      {
+         (void) write(g_sAsync.eventFd, &one, sizeof(one));
+      }
+
+      (void) pthread_mutex_lock(&g_sAsync.doneMutex);
+      __atomic_add_fetch(&g_sAsync.done, 1, __ATOMIC_RELEASE);
+      (void) pthread_cond_broadcast(&g_sAsync.doneCond);
+      (void) pthread_mutex_unlock(&g_sAsync.doneMutex);
+   }
+   return NIL;
+}
+
+/* the worker thread does not exist in the child process: the queue of the parent is dropped */
+static void asyncAtforkChild(void)
+{
+   lldb_async_s sInit =
+   {
+      .head = &g_sAsyncStub,
+      .tail = &g_sAsyncStub,
+      .scanMutex = PTHREAD_MUTEX_INITIALIZER,
+      .doneMutex = PTHREAD_MUTEX_INITIALIZER,
+      .doneCond = PTHREAD_COND_INITIALIZER,
+      .bAtforkRegistered = true,
+      .eventFd = -1
+   };
+
+   if (g_sAsync.eventFd >= 0)
+   {
+      (void) close(g_sAsync.eventFd);
+   }
+   g_sAsyncStub.next = NIL;
+   g_sAsync = sInit;
+   (void) pthread_mutex_init(&g_asyncInitMutex, NULL);
+}
+
+/* start the worker thread with the first use. returns true if the worker is running */
+static bool_t asyncStart(void)
+{
+   bool_t bStarted = __atomic_load_n(&g_sAsync.bStarted, __ATOMIC_ACQUIRE);
+   pthread_attr_t attr;
+
+   if (bStarted)
+   {
+      return true;
+   }
+   (void) pthread_mutex_lock(&g_asyncInitMutex);
+   if (!g_sAsync.bStarted)
+   {
+      if (!g_sAsync.bAtforkRegistered)
+      {
+         g_sAsync.bAtforkRegistered = (pthread_atfork(NULL, NULL, asyncAtforkChild) == 0);
+      }
+      g_sAsync.eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if ((g_sAsync.eventFd >= 0) && (sem_init(&g_sAsync.sem, 0, 0) == 0))
+      {
+         (void) pthread_attr_init(&attr);
+         (void) pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+         if (pthread_create(&g_sAsync.worker, &attr, asyncWorker, NIL) == 0)
+         {
+            __atomic_store_n(&g_sAsync.bStarted, true, __ATOMIC_RELEASE);
+         }
+         else
+         {
+            (void) sem_destroy(&g_sAsync.sem);
+         }
+         (void) pthread_attr_destroy(&attr);
+      }
+      if ((!g_sAsync.bStarted) && (g_sAsync.eventFd >= 0))
+      {
+         (void) close(g_sAsync.eventFd);
+         g_sAsync.eventFd = -1;
+      }
+      if (!g_sAsync.bStarted)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                 DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("start of the asynchronous write worker failed: "); DLT_STRING(strerror(errno)));
+      }
+   }
+   bStarted = g_sAsync.bStarted;
+   (void) pthread_mutex_unlock(&g_asyncInitMutex);
+   return bStarted;
+}
+
+sint_t lldb_async_write(sint_t handlerDB, persComDbKey_t const* pKey, pconststr_t data, sint_t dataSize,
+                        persComDbWriteCallback_t callback, void* ctx)
+{
+   lldb_async_node_s* pNode;
+
+   if ((NIL == pKey) || (NIL == pKey->key) || (pKey->length >= PERS_DB_MAX_LENGTH_KEY_NAME) || (NIL == data) || (dataSize <= 0)
+       || (dataSize > PERS_DB_MAX_SIZE_KEY_DATA))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   if (!asyncStart())
+   {
+      return PERS_COM_FAILURE;
+   }
+   pNode = (lldb_async_node_s*) malloc(sizeof(lldb_async_node_s) + (size_t) dataSize);
+   if (pNode == NIL)
+   {
+      return PERS_COM_ERR_MALLOC;
+   }
+   pNode->handlerDB = handlerDB;
+   pNode->key = *pKey;
+   (void) memcpy(pNode->keyName, pKey->key, pKey->length);
+   pNode->keyName[pKey->length] = '\0';
+   pNode->key.key = pNode->keyName;
+   pNode->dataSize = dataSize;
+   pNode->callback = callback;
+   pNode->ctx = ctx;
+   (void) memcpy(pNode->data, data, (size_t) dataSize);
+
+   //counted before the push: a drain started now waits for this write
+   __atomic_add_fetch(&g_sAsync.queued, 1, __ATOMIC_ACQ_REL);
+   asyncPush(pNode);
+   (void) sem_post(&g_sAsync.sem);
+   return 0;
+}
+
+static bool_t asyncMatch(lldb_async_node_s const* pNode, sint_t handlerDB, persComDbKey_t const* pKey)
+{
+   return (pNode != &g_sAsyncStub) && (pNode->handlerDB == handlerDB) && (pNode->key.length == pKey->length)
+          && (pNode->key.hash == pKey->hash) && (memcmp(pNode->keyName, pKey->key, pKey->length) == 0);
+}
+
+bool_t lldb_async_find(sint_t handlerDB, persComDbKey_t const* pKey, pstr_t buffer_out, sint_t bufSize, sint_t* pResult_out)
+{
+   lldb_async_node_s* pFound = NIL;
+   lldb_async_node_s* pNode;
+   lldb_async_node_s* pNext;
+   lldb_async_node_s* pHead;
+
+   if (!lldb_async_pending())
+   {
+      return false;
+   }
+   (void) pthread_mutex_lock(&g_sAsync.scanMutex);
+   //the nodes queued before the scan are all linked up to this head, the newest write of the key is used
+   pHead = __atomic_load_n(&g_sAsync.head, __ATOMIC_ACQUIRE);
+   if ((g_sAsync.current != NIL) && asyncMatch(g_sAsync.current, handlerDB, pKey))
+   {
+      pFound = g_sAsync.current;
+   }
+   pNode = g_sAsync.tail;
+   for (;;)
+   {
+      if (asyncMatch(pNode, handlerDB, pKey))
+      {
+         pFound = pNode;
+      }
+      if (pNode == pHead)
+      {
+         break;
+      }
+      while ((pNext = __atomic_load_n(&pNode->next, __ATOMIC_ACQUIRE)) == NIL)
+      {
+         (void) sched_yield();
+      }
+      pNode = pNext;
+   }
+   if (pFound != NIL)
+   {
+      *pResult_out = pFound->dataSize;
+      if (buffer_out != NIL)
+      {
+         if (bufSize < pFound->dataSize)
+         {
+            *pResult_out = PERS_COM_ERR_BUFFER_TOO_SMALL;
+         }
+         else
+         {
+            (void) memcpy(buffer_out, pFound->data, (size_t) pFound->dataSize);
+         }
+      }
+   }
+   (void) pthread_mutex_unlock(&g_sAsync.scanMutex);
+   return (pFound != NIL);
+}
+
+bool_t lldb_async_pending(void)
+{
+   return __atomic_load_n(&g_sAsync.done, __ATOMIC_ACQUIRE) != __atomic_load_n(&g_sAsync.queued, __ATOMIC_ACQUIRE);
+}
+
+void lldb_async_drain(void)
+{
+   uint64_t target = __atomic_load_n(&g_sAsync.queued, __ATOMIC_ACQUIRE);
+
+   if (__atomic_load_n(&g_sAsync.done, __ATOMIC_ACQUIRE) >= target)
+   {
+      return;
+   }
+   //the worker writes through the same functions, it must not wait for itself
+   if (__atomic_load_n(&g_sAsync.bStarted, __ATOMIC_ACQUIRE) && pthread_equal(pthread_self(), g_sAsync.worker))
+   {
+      return;
+   }
+   (void) pthread_mutex_lock(&g_sAsync.doneMutex);
+   while (__atomic_load_n(&g_sAsync.done, __ATOMIC_ACQUIRE) < target)
+   {
+      (void) pthread_cond_wait(&g_sAsync.doneCond, &g_sAsync.doneMutex);
+   }
+   (void) pthread_mutex_unlock(&g_sAsync.doneMutex);
+}
+
+sint_t lldb_async_event_fd(void)
+{
+   return asyncStart() ? g_sAsync.eventFd : PERS_COM_FAILURE;
+}
+
+/* the pending writes are done before the process ends normally */
+__attribute__((destructor))
+static void asyncExit(void)
+{
+   if (__atomic_load_n(&g_sAsync.bStarted, __ATOMIC_ACQUIRE))
+   {
+      lldb_async_drain();
+   }
+}
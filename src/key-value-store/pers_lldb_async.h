@@ -0,0 +1,84 @@
+#ifndef PERS_LLDB_ASYNC_H
+#define PERS_LLDB_ASYNC_H
+
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           pers_lldb_async.h
+ * @ingroup        Persistence key value store
+ * @brief          Asynchronous writes of the key value store
+ * @see
+ *
+ * The writes are queued in a lock free multi producer / single consumer queue and
+ * executed one after the other by a worker thread of the process, started with the
+ * first asynchronous write. The queue is visible to the readers of the process:
+ * a key with a pending write is read from the queue (read your writes).
+ * All other accesses to a database wait until the pending writes are done, so the
+ * writes are executed in the order of the calls.
+ */
+
+#include "persComTypes.h"
+#include "persComDbAccess.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief queue the write of a key, the worker thread writes it with pers_lldb_write_key_prepared
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open (PersLldbPurpose_DB)
+ * @param pKey              [in] key descriptor, the key's name is copied
+ * @param data              [in] data of the key, copied
+ * @param dataSize          [in] size of data (1 .. PERS_DB_MAX_SIZE_KEY_DATA)
+ * @param callback          [in] called by the worker thread after the write (can be NIL)
+ * @param ctx               [in] context passed to the callback
+ *
+ * @return 0 if queued, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t lldb_async_write(sint_t handlerDB, persComDbKey_t const* pKey, pconststr_t data, sint_t dataSize,
+                        persComDbWriteCallback_t callback, void* ctx);
+
+/**
+ * @brief look for the latest pending write of a key
+ *
+ * @param handlerDB         [in] handler obtained with pers_lldb_open
+ * @param pKey              [in] key descriptor
+ * @param buffer_out        [out]buffer where to copy the data (NIL: size only)
+ * @param bufSize           [in] size of buffer_out
+ * @param pResult_out       [out]size of the data, or PERS_COM_ERR_BUFFER_TOO_SMALL
+ *
+ * @return true if a write of the key is pending
+ */
+bool_t lldb_async_find(sint_t handlerDB, persComDbKey_t const* pKey, pstr_t buffer_out, sint_t bufSize, sint_t* pResult_out);
+
+/**
+ * @brief wait until the writes queued before the call are done (nothing if called by the worker thread)
+ */
+void lldb_async_drain(void);
+
+/**
+ * @brief true if asynchronous writes are queued or executed (lock free check)
+ */
+bool_t lldb_async_pending(void);
+
+/**
+ * @brief eventfd whose counter is increased for every finished asynchronous write
+ * @return file descriptor, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t lldb_async_event_fd(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERS_LLDB_ASYNC_H */
@@ -0,0 +1,56 @@
+#ifndef PERS_LLDB_PROBES_H
+#define PERS_LLDB_PROBES_H
+
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           pers_lldb_probes.h
+ * @ingroup        Persistence key value store
+ * @brief          USDT (user space statically defined tracing) probes of the key value store
+ * @see
+ *
+ * The probes are only compiled in with PERS_LLDB_USDT (configure --enable-usdt) and use <sys/sdt.h>
+ * of systemtap. A probe is a single nop instruction in the code and a note in the ELF file, the
+ * arguments are only evaluated by an attached tracer (perf, bpftrace, systemtap), e.g.:
+ *    bpftrace -e 'usdt:libpers_common.so:pers_kvs:kissdb_put_entry { printf("%s %s\n", str(arg0), str(arg1)); }'
+ *
+ * Provider: pers_kvs
+ * - kissdb_get_entry(path, key, bufsize)            kissdb_get_return(path, key, result, valueSize)
+ * - kissdb_put_entry(path, key, valueSize)          kissdb_put_return(path, key, result, bytesWritten)
+ * - kissdb_delete_entry(path, key)                  kissdb_delete_return(path, key, result, bytesDeleted)
+ * - cache_get_entry(path, key, bufsize)             cache_get_return(path, key, result)
+ * - cache_put_entry(path, key, dataSize)            cache_put_return(path, key, result)
+ * - writeback_start(path)                           writeback_end(path, result)
+ * - recovery_start(path, phase)                     recovery_end(path, phase, result)
+ * - lock_acquire(lock)                              lock_acquired(lock)
+ *
+ * path and key are strings, phase is the name of the recovery step, lock the address of the rwlock.
+ */
+
+#ifdef PERS_LLDB_USDT
+
+#include <sys/sdt.h>
+
+#define PERS_PROBE1(NAME, A1)                     DTRACE_PROBE1(pers_kvs, NAME, A1)
+#define PERS_PROBE2(NAME, A1, A2)                 DTRACE_PROBE2(pers_kvs, NAME, A1, A2)
+#define PERS_PROBE3(NAME, A1, A2, A3)             DTRACE_PROBE3(pers_kvs, NAME, A1, A2, A3)
+#define PERS_PROBE4(NAME, A1, A2, A3, A4)         DTRACE_PROBE4(pers_kvs, NAME, A1, A2, A3, A4)
+
+#else
+
+#define PERS_PROBE1(NAME, A1)                     do { } while (0)
+#define PERS_PROBE2(NAME, A1, A2)                 do { } while (0)
+#define PERS_PROBE3(NAME, A1, A2, A3)             do { } while (0)
+#define PERS_PROBE4(NAME, A1, A2, A3, A4)         do { } while (0)
+
+#endif /* PERS_LLDB_USDT */
+
+#endif /* PERS_LLDB_PROBES_H */
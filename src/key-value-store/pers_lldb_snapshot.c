@@ -0,0 +1,172 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           pers_lldb_snapshot.c
+ * @ingroup        Persistence key value store
+ * @brief          Point in time copies of a database file
+ * @see            pers_lldb_snapshot.h
+ */
+
+#include "pers_lldb_snapshot.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <dlt.h>
+#include "persComErrors.h"
+#include "persComDataOrg.h"
+
+DLT_IMPORT_CONTEXT (persComLldbDLTCtx)
+
+#define LT_HDR "[persComLLDB]"
+
+#define PERS_LLDB_SNAPSHOT_SUFFIX   ".tmp"
+
+/* clone of a whole file (linux/fs.h), not defined by older kernel headers */
+#ifndef FICLONE
+#define FICLONE                     _IOW(0x94, 9, int)
+#endif
+
+
+static bool_t snapshotPathname(str_t const* destPath, str_t* pathname_out, size_t size)
+{
+   int len = snprintf(pathname_out, size, "%s%s", destPath, PERS_LLDB_SNAPSHOT_SUFFIX);
+
+   return (len > 0) && ((size_t) len < size);
+}
+
+static bool_t snapshotWriteAll(int fd, char const* buffer, size_t size, off_t offset)
+{
+   ssize_t written;
+
+   while (size > 0)
+   {
+      written = pwrite(fd, buffer, size, offset);
+      if (written < 0)
+      {
+         if (errno == EINTR)
+         {
+            continue;
+         }
+         return false;
+      }
+      buffer += written;
+      offset += written;
+      size -= (size_t) written;
+   }
+   return true;
+}
+
+sint_t lldb_snapshot_open(str_t const* destPath)
+{
+   str_t pathname[PERS_ORG_MAX_LENGTH_PATH_FILENAME + sizeof(PERS_LLDB_SNAPSHOT_SUFFIX)];
+   int fd;
+
+   if (!snapshotPathname(destPath, pathname, sizeof(pathname)))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   fd = open(pathname, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+   if (fd < 0)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("open of <"); DLT_STRING(pathname); DLT_STRING("> failed: "); DLT_STRING(strerror(errno)));
+      return (errno == EACCES) ? PERS_COM_ERR_ACCESS_DENIED : PERS_COM_FAILURE;
+   }
+   return fd;
+}
+
+bool_t lldb_snapshot_clone(sint_t destFd, int srcFd)
+{
+   //EOPNOTSUPP / EINVAL: filesystem without reflinks, EXDEV: copy on another filesystem
+   return (ioctl(destFd, FICLONE, srcFd) == 0) ? true : false;
+}
+
+void* lldb_snapshot_image_map(size_t size)
+{
+   void* image = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+
+   return (MAP_FAILED != image) ? image : NIL;
+}
+
+void* lldb_snapshot_image_remap(void* image, size_t oldSize, size_t size)
+{
+   void* newImage;
+
+   if (NIL == image)
+   {
+      return lldb_snapshot_image_map(size);
+   }
+   newImage = mremap(image, oldSize, size, MREMAP_MAYMOVE);
+   return (MAP_FAILED != newImage) ? newImage : NIL;
+}
+
+void lldb_snapshot_image_unmap(void* image, size_t size)
+{
+   if (NIL != image)
+   {
+      (void) munmap(image, size);
+   }
+}
+
+sint_t lldb_snapshot_close(sint_t destFd, str_t const* destPath, void const* image, size_t imageSize, void const* header, size_t headerSize)
+{
+   str_t pathname[PERS_ORG_MAX_LENGTH_PATH_FILENAME + sizeof(PERS_LLDB_SNAPSHOT_SUFFIX)];
+   sint_t result = PERS_COM_SUCCESS;
+
+   if (!snapshotPathname(destPath, pathname, sizeof(pathname)))
+   {
+      (void) close(destFd);
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   //the header of the image is overwritten afterwards, a cloned file gets a private copy of its first block only
+   if (   ((NIL != image) && (!snapshotWriteAll(destFd, (char const*) image, imageSize, 0)))
+       || (!snapshotWriteAll(destFd, (char const*) header, headerSize, 0)))
+   {
+      result = PERS_COM_FAILURE;
+   }
+#if USE_FSYNC
+   else if (fsync(destFd) != 0)
+#else
+   else if (fdatasync(destFd) != 0)
+#endif
+   {
+      result = PERS_COM_FAILURE;
+   }
+   (void) close(destFd);
+
+   if ((PERS_COM_SUCCESS == result) && (rename(pathname, destPath) != 0))
+   {
+      result = (errno == EACCES) ? PERS_COM_ERR_ACCESS_DENIED : PERS_COM_FAILURE;
+   }
+   if (PERS_COM_SUCCESS != result)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("write of <"); DLT_STRING(destPath); DLT_STRING("> failed: "); DLT_STRING(strerror(errno)));
+      (void) remove(pathname);
+   }
+   return result;
+}
+
+void lldb_snapshot_abort(sint_t destFd, str_t const* destPath)
+{
+   str_t pathname[PERS_ORG_MAX_LENGTH_PATH_FILENAME + sizeof(PERS_LLDB_SNAPSHOT_SUFFIX)];
+
+   (void) close(destFd);
+   if (snapshotPathname(destPath, pathname, sizeof(pathname)))
+   {
+      (void) remove(pathname);
+   }
+}
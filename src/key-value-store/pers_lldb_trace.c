@@ -0,0 +1,219 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           pers_lldb_trace.c
+ * @ingroup        Persistence key value store
+ * @brief          Trace ring and slow operation log of the key value store in shared memory
+ * @see            pers_lldb_trace.h
+ */
+
+#include "pers_lldb_trace.h"
+
+#if defined(PERS_LLDB_TRACE_RING) || defined(PERS_LLDB_SLOW_OP_LOG)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+DLT_IMPORT_CONTEXT (persComLldbDLTCtx)
+
+
+uint64_t lldb_trace_now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+
+/* creates the shared memory of a ring, the ring is kept after the process ends */
+static void* lldb_ring_create(const char* prefix, size_t size)
+{
+   char name[64];
+   int fd;
+   void* ring = NULL;
+
+   (void) snprintf(name, sizeof(name), "%s-%d", prefix, (int) getpid());
+   fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+   if (fd >= 0)
+   {
+      if (ftruncate(fd, size) == 0)
+      {
+         ring = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+         if (ring == MAP_FAILED)
+         {
+            ring = NULL;
+         }
+      }
+      close(fd);
+   }
+   if (ring == NULL)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN, DLT_STRING(__FUNCTION__); DLT_STRING(": ring not available: "); DLT_STRING(name));
+   }
+   return ring;
+}
+
+#endif
+
+
+#ifdef PERS_LLDB_TRACE_RING
+
+static pthread_once_t gTraceOnce = PTHREAD_ONCE_INIT;
+static LldbTraceRing_s* gTraceRing = NULL;
+
+
+static void lldb_trace_init(void)
+{
+   LldbTraceRing_s* ring = (LldbTraceRing_s*) lldb_ring_create("/pers-lldb-trace", sizeof(LldbTraceRing_s));
+
+   if (ring != NULL)
+   {
+      ring->version = LLDB_TRACE_RING_VERSION;
+      ring->entryCount = PERS_LLDB_TRACE_RING_ENTRIES;
+      ring->pid = (uint32_t) getpid();
+      __atomic_store_n(&ring->magic, LLDB_TRACE_RING_MAGIC, __ATOMIC_RELEASE);
+      gTraceRing = ring;
+   }
+}
+
+
+void lldb_trace_event(uint8_t op, int32_t handle, uint32_t keyHash, int32_t result, uint64_t startNs)
+{
+   LldbTraceEntry_s* entry;
+   uint64_t seq;
+
+   (void) pthread_once(&gTraceOnce, lldb_trace_init);
+   if (gTraceRing == NULL)
+   {
+      return;
+   }
+
+   seq = __atomic_fetch_add(&gTraceRing->head, 1, __ATOMIC_RELAXED);
+   entry = &gTraceRing->entries[seq & (PERS_LLDB_TRACE_RING_ENTRIES - 1)];
+
+   __atomic_store_n(&entry->seq, 0, __ATOMIC_RELAXED); //entry is being overwritten
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+   entry->timestampNs = startNs;
+   entry->durationNs = (uint32_t) (lldb_trace_now() - startNs);
+   entry->keyHash = keyHash;
+   entry->handle = handle;
+   entry->result = result;
+   entry->tid = (uint32_t) syscall(SYS_gettid);
+   entry->op = op;
+   __atomic_store_n(&entry->seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+#endif /* PERS_LLDB_TRACE_RING */
+
+
+#ifdef PERS_LLDB_SLOW_OP_LOG
+
+static const char* const gOpNames[] = { "?", "open", "close", "read", "write", "delete", "size", "list", "commit", "sync", "snapshot" };
+
+__thread LldbOpContext_s lldb_op_ctx;
+
+static pthread_once_t gSlowOpOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t gSlowOpMutex = PTHREAD_MUTEX_INITIALIZER;
+static LldbSlowOpRing_s* gSlowOpRing = NULL;
+static uint64_t gSlowOpThresholdNs = (uint64_t) (PERS_LLDB_SLOW_OP_LOG) * 1000000ULL;
+
+
+static void lldb_slow_op_init(void)
+{
+   const char* env = getenv("PERS_LLDB_SLOW_OP_MS");
+
+   if (env != NULL)
+   {
+      gSlowOpThresholdNs = (uint64_t) strtoul(env, NULL, 10) * 1000000ULL;
+   }
+}
+
+
+static void lldb_slow_op_record(uint8_t op, const char* path, const char* key, int32_t size, uint64_t startNs, uint64_t durationNs)
+{
+   LldbSlowOpEntry_s* entry;
+   uint64_t seq;
+
+   (void) pthread_mutex_lock(&gSlowOpMutex);
+   if (gSlowOpRing == NULL)
+   {
+      LldbSlowOpRing_s* ring = (LldbSlowOpRing_s*) lldb_ring_create("/pers-lldb-slowops", sizeof(LldbSlowOpRing_s));
+
+      if (ring != NULL)
+      {
+         ring->version = LLDB_SLOW_OP_VERSION;
+         ring->entryCount = PERS_LLDB_SLOW_OP_ENTRIES;
+         ring->pid = (uint32_t) getpid();
+         ring->thresholdUs = (uint32_t) (gSlowOpThresholdNs / 1000);
+         __atomic_store_n(&ring->magic, LLDB_SLOW_OP_MAGIC, __ATOMIC_RELEASE);
+         gSlowOpRing = ring;
+      }
+   }
+   if (gSlowOpRing != NULL)
+   {
+      seq = gSlowOpRing->head;
+      entry = &gSlowOpRing->entries[seq & (PERS_LLDB_SLOW_OP_ENTRIES - 1)];
+
+      __atomic_store_n(&entry->seq, 0, __ATOMIC_RELAXED); //entry is being overwritten
+      __atomic_thread_fence(__ATOMIC_RELEASE);
+      entry->timestampNs = startNs;
+      entry->durationNs = durationNs;
+      entry->lockWaitNs = lldb_op_ctx.lockWaitNs;
+      entry->size = size;
+      entry->tid = (uint32_t) syscall(SYS_gettid);
+      entry->op = op;
+      entry->flags = (uint8_t) lldb_op_ctx.flags;
+      (void) snprintf(entry->path, sizeof(entry->path), "%s", (path != NULL) ? path : "");
+      (void) snprintf(entry->key, sizeof(entry->key), "%s", (key != NULL) ? key : "");
+      __atomic_store_n(&entry->seq, seq + 1, __ATOMIC_RELEASE);
+      __atomic_store_n(&gSlowOpRing->head, seq + 1, __ATOMIC_RELEASE);
+   }
+   (void) pthread_mutex_unlock(&gSlowOpMutex);
+}
+
+
+uint64_t lldb_op_begin(void)
+{
+   lldb_op_ctx.lockWaitNs = 0;
+   lldb_op_ctx.flags = 0;
+   return lldb_trace_now();
+}
+
+
+void lldb_slow_op_check(uint8_t op, const char* path, const char* key, int32_t size, uint64_t startNs)
+{
+   uint64_t durationNs = lldb_trace_now() - startNs;
+
+   (void) pthread_once(&gSlowOpOnce, lldb_slow_op_init);
+   if (gSlowOpThresholdNs == 0 || durationNs < gSlowOpThresholdNs)
+   {
+      return;
+   }
+
+   DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
+           DLT_STRING(__FUNCTION__); DLT_STRING(": slow"); DLT_STRING(gOpNames[(op < (sizeof(gOpNames) / sizeof(gOpNames[0]))) ? op : 0]);
+           DLT_STRING("of"); DLT_STRING((path != NULL) ? path : ""); DLT_STRING("key=<"); DLT_STRING((key != NULL) ? key : ""); DLT_STRING(">");
+           DLT_STRING("duration us:"); DLT_UINT64(durationNs / 1000); DLT_STRING("lock wait us:"); DLT_UINT64(lldb_op_ctx.lockWaitNs / 1000);
+           DLT_STRING("size:"); DLT_INT(size); DLT_STRING("flags:"); DLT_UINT(lldb_op_ctx.flags));
+
+   lldb_slow_op_record(op, path, key, size, startNs, durationNs);
+}
+
+#endif /* PERS_LLDB_SLOW_OP_LOG */
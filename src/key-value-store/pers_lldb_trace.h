@@ -0,0 +1,215 @@
+#ifndef PERS_LLDB_TRACE_H
+#define PERS_LLDB_TRACE_H
+
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           pers_lldb_trace.h
+ * @ingroup        Persistence key value store
+ * @brief          Low overhead logging and tracing of the key value store operations
+ * @see
+ *
+ * - LLDB_HOT_LOG: DLT log for code executed on every key access. The log level of the context
+ *   is checked before any argument is built; with PERS_LLDB_NO_HOTPATH_LOG the log is compiled out.
+ * - LLDB_TRACE_xxx: binary trace of every operation into a ring buffer in shared memory
+ *   (only with PERS_LLDB_TRACE_RING). The ring of a process is named "/pers-lldb-trace-<pid>"
+ *   and is kept after the process ends, so it can be dumped later.
+ * - LLDB_SLOW_OP / LLDB_OP_xxx: log of the operations slower than a threshold (only with
+ *   PERS_LLDB_SLOW_OP_LOG, its value is the default threshold in ms, the environment variable
+ *   PERS_LLDB_SLOW_OP_MS overrides it). Every slow operation is logged to DLT and stored in the
+ *   ring "/pers-lldb-slowops-<pid>", which is dumped with pers-kvs-slowlog.
+ */
+
+#include <stdint.h>
+#include <dlt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* operations recorded in the trace ring */
+#define LLDB_TRACE_OP_OPEN     1
+#define LLDB_TRACE_OP_CLOSE    2
+#define LLDB_TRACE_OP_READ     3
+#define LLDB_TRACE_OP_WRITE    4
+#define LLDB_TRACE_OP_DELETE   5
+#define LLDB_TRACE_OP_SIZE     6
+#define LLDB_TRACE_OP_LIST     7
+#define LLDB_TRACE_OP_COMMIT   8
+#define LLDB_TRACE_OP_SYNC     9
+#define LLDB_TRACE_OP_SNAPSHOT 10
+
+#ifndef PERS_LLDB_TRACE_RING_ENTRIES
+#define PERS_LLDB_TRACE_RING_ENTRIES 4096   /* must be a power of two */
+#endif
+
+#define LLDB_TRACE_RING_MAGIC   0x474E495243524C50ULL /* "PLRCRING" */
+#define LLDB_TRACE_RING_VERSION 1
+
+typedef struct
+{
+   uint64_t seq;          /* number of the event + 1, written last (0: entry not yet written) */
+   uint64_t timestampNs;  /* CLOCK_MONOTONIC at the begin of the operation */
+   uint32_t durationNs;
+   uint32_t keyHash;      /* cache hash of the key, 0 if the operation has no key */
+   int32_t handle;
+   int32_t result;
+   uint32_t tid;
+   uint8_t op;
+   uint8_t padding[3];
+} LldbTraceEntry_s;
+
+typedef struct
+{
+   uint64_t magic;
+   uint32_t version;
+   uint32_t entryCount;
+   uint32_t pid;
+   uint32_t padding;
+   uint64_t head;         /* number of events written so far */
+   LldbTraceEntry_s entries[PERS_LLDB_TRACE_RING_ENTRIES];
+} LldbTraceRing_s;
+
+
+#ifdef DLT_IS_LOG_LEVEL_ENABLED
+/* public level check of the DLT library (dlt_user_is_logLevel_enabled) */
+#define LLDB_LOG_ENABLED(CONTEXT, LEVEL) DLT_IS_LOG_LEVEL_ENABLED(CONTEXT, LEVEL)
+#else
+/* older DLT versions: DLT_LOG checks the level in dlt_user_log_write_start before any argument is built */
+#define LLDB_LOG_ENABLED(CONTEXT, LEVEL) (1)
+#endif
+
+#ifdef PERS_LLDB_NO_HOTPATH_LOG
+#define LLDB_HOT_LOG(CONTEXT, LEVEL, ARGS...) do { } while (0)
+#else
+#define LLDB_HOT_LOG(CONTEXT, LEVEL, ARGS...) \
+   do { if (LLDB_LOG_ENABLED(CONTEXT, LEVEL)) { DLT_LOG(CONTEXT, LEVEL, ARGS); } } while (0)
+#endif
+
+
+/* details of a slow operation */
+#define LLDB_OP_FLAG_CACHE     0x01   /* served by the write cache */
+#define LLDB_OP_FLAG_FILE      0x02   /* database file was accessed */
+#define LLDB_OP_FLAG_REMAP     0x04   /* database file or hashtables were remapped */
+#define LLDB_OP_FLAG_GROWTH    0x08   /* database file was extended */
+
+#ifndef PERS_LLDB_SLOW_OP_ENTRIES
+#define PERS_LLDB_SLOW_OP_ENTRIES 128   /* must be a power of two */
+#endif
+
+#define LLDB_SLOW_OP_MAX_PATH  128
+#define LLDB_SLOW_OP_MAX_KEY   64
+
+#define LLDB_SLOW_OP_MAGIC     0x504F574F4C534C50ULL /* "PLSLOWOP" */
+#define LLDB_SLOW_OP_VERSION   1
+
+typedef struct
+{
+   uint64_t seq;          /* number of the record + 1, written last (0: entry not yet written) */
+   uint64_t timestampNs;  /* CLOCK_MONOTONIC at the begin of the operation */
+   uint64_t durationNs;
+   uint64_t lockWaitNs;   /* time spent waiting for the database locks */
+   int32_t size;          /* bytes read / written or the error code */
+   uint32_t tid;
+   uint8_t op;            /* LLDB_TRACE_OP_xxx */
+   uint8_t flags;         /* LLDB_OP_FLAG_xxx */
+   uint8_t padding[6];
+   char path[LLDB_SLOW_OP_MAX_PATH];
+   char key[LLDB_SLOW_OP_MAX_KEY];
+} LldbSlowOpEntry_s;
+
+typedef struct
+{
+   uint64_t magic;
+   uint32_t version;
+   uint32_t entryCount;
+   uint32_t pid;
+   uint32_t thresholdUs;
+   uint64_t head;         /* number of records written so far */
+   LldbSlowOpEntry_s entries[PERS_LLDB_SLOW_OP_ENTRIES];
+} LldbSlowOpRing_s;
+
+
+#if defined(PERS_LLDB_TRACE_RING) || defined(PERS_LLDB_SLOW_OP_LOG)
+/**
+ * @brief current time for the trace
+ * @return CLOCK_MONOTONIC in ns
+ */
+uint64_t lldb_trace_now(void);
+#endif
+
+#ifdef PERS_LLDB_TRACE_RING
+
+/**
+ * @brief record one operation in the trace ring of this process (lock free, the ring is created on first use)
+ * @param op LLDB_TRACE_OP_xxx
+ * @param handle handler of the database
+ * @param keyHash hash of the key or 0
+ * @param result return value of the operation
+ * @param startNs time returned by lldb_trace_now at the begin of the operation
+ */
+void lldb_trace_event(uint8_t op, int32_t handle, uint32_t keyHash, int32_t result, uint64_t startNs);
+
+#define LLDB_TRACE_EVENT(OP, HANDLE, KEYHASH, RESULT, VAR) lldb_trace_event((OP), (HANDLE), (KEYHASH), (RESULT), (VAR))
+#else
+#define LLDB_TRACE_EVENT(OP, HANDLE, KEYHASH, RESULT, VAR) do { } while (0)
+#endif
+
+#ifdef PERS_LLDB_SLOW_OP_LOG
+typedef struct
+{
+   uint64_t lockWaitNs;
+   uint32_t flags;
+} LldbOpContext_s;
+
+/* details of the current operation of the thread */
+extern __thread LldbOpContext_s lldb_op_ctx;
+
+/**
+ * @brief begin of an operation: reset the details of the thread
+ * @return CLOCK_MONOTONIC in ns
+ */
+uint64_t lldb_op_begin(void);
+
+/**
+ * @brief end of an operation: record it if it took longer than the threshold
+ * @param op LLDB_TRACE_OP_xxx
+ * @param path path of the database or NULL
+ * @param key key or NULL
+ * @param size bytes read / written or the error code
+ * @param startNs time returned by lldb_op_begin
+ */
+void lldb_slow_op_check(uint8_t op, const char* path, const char* key, int32_t size, uint64_t startNs);
+
+#define LLDB_TRACE_START(VAR) uint64_t VAR = lldb_op_begin()
+#define LLDB_SLOW_OP(OP, PATH, KEY, SIZE, VAR) lldb_slow_op_check((OP), (PATH), (KEY), (SIZE), (VAR))
+#define LLDB_OP_FLAG(FLAG) (lldb_op_ctx.flags |= (FLAG))
+#define LLDB_OP_WAIT_START(VAR) uint64_t VAR = lldb_trace_now()
+#define LLDB_OP_WAIT_END(VAR) (lldb_op_ctx.lockWaitNs += lldb_trace_now() - (VAR))
+#define LLDB_OP_LOCK_WAIT(NS) (lldb_op_ctx.lockWaitNs += (NS))
+#else
+#ifdef PERS_LLDB_TRACE_RING
+#define LLDB_TRACE_START(VAR) uint64_t VAR = lldb_trace_now()
+#else
+#define LLDB_TRACE_START(VAR)
+#endif
+#define LLDB_SLOW_OP(OP, PATH, KEY, SIZE, VAR) do { } while (0)
+#define LLDB_OP_FLAG(FLAG) do { } while (0)
+#define LLDB_OP_WAIT_START(VAR)
+#define LLDB_OP_WAIT_END(VAR) do { } while (0)
+#define LLDB_OP_LOCK_WAIT(NS) do { } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERS_LLDB_TRACE_H */
@@ -0,0 +1,522 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           pers_lldb_tx.c
+ * @ingroup        Persistence key value store
+ * @brief          Transactions of the key value store and their intent log
+ * @see            pers_lldb_tx.h
+ */
+
+#include "pers_lldb_tx.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <dlt.h>
+#include "persComErrors.h"
+#include "persComDataOrg.h"
+#include "crc32.h"
+
+DLT_IMPORT_CONTEXT (persComLldbDLTCtx)
+
+#define LT_HDR "[persComLLDB]"
+
+/* max number of open transactions per process */
+#define PERS_LLDB_NO_OF_TX          32
+
+/* a transaction id is composed of the index in the transaction table (low bits) and the generation of the entry (high bits) */
+#define PERS_LLDB_TX_INDEX_BITS     5
+#define PERS_LLDB_TX_INDEX_MASK     ((1 << PERS_LLDB_TX_INDEX_BITS) - 1)
+#define PERS_LLDB_TX_GEN_MASK       ((1 << (31 - PERS_LLDB_TX_INDEX_BITS)) - 1)
+
+#define PERS_LLDB_TX_MIN_CAPACITY   1024
+
+#define PERS_LLDB_TXLOG_SUFFIX      ".txlog"
+#define PERS_LLDB_TXLOG_MAGIC       0x31585450U /* "PTX1" */
+
+
+/* header of a record of the intent log, followed by size bytes of operations */
+typedef struct
+{
+   uint32_t magic;
+   uint32_t size;                        /* size of the operations */
+   uint64_t seq;
+   uint32_t count;                       /* number of operations */
+   uint32_t crc;                         /* over the header (crc set to 0) and the operations */
+} lldb_txlog_header_s;
+
+/* operation of a record, followed by the key's name ('\0' terminated) and the data */
+typedef struct
+{
+   int32_t dataSize;                     /* negative for a delete */
+   uint32_t keySize;                     /* size of the key's name including the '\0' */
+} lldb_txlog_op_s;
+
+typedef struct
+{
+   bool_t bInUse;
+   sint_t txId;
+   sint_t handlerDB;
+   str_t* buffer;                        /* record: header followed by the operations */
+   uint32_t size;
+   uint32_t capacity;
+   uint32_t count;
+   off_t logSize;                        /* size of the intent log before the record of the transaction */
+} lldb_tx_s;
+
+static lldb_tx_s g_asTx[PERS_LLDB_NO_OF_TX];
+static sint_t g_txGeneration = 0;
+static pthread_mutex_t g_txMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* transaction of a valid transaction id, NIL otherwise. A transaction is used by one thread at a time */
+static lldb_tx_s* txFind(sint_t txId)
+{
+   lldb_tx_s* pTx = NIL;
+
+   if (txId >= 0)
+   {
+      (void) pthread_mutex_lock(&g_txMutex);
+      pTx = &g_asTx[txId & PERS_LLDB_TX_INDEX_MASK];
+      if ((!pTx->bInUse) || (pTx->txId != txId))
+      {
+         pTx = NIL;
+      }
+      (void) pthread_mutex_unlock(&g_txMutex);
+   }
+   return pTx;
+}
+
+static bool_t txLogPathname(str_t const* dbPathname, str_t* pathname_out, size_t size)
+{
+   int len = snprintf(pathname_out, size, "%s%s", dbPathname, PERS_LLDB_TXLOG_SUFFIX);
+
+   return (len > 0) && ((size_t) len < size);
+}
+
+static uint32_t txRecordCrc(lldb_txlog_header_s const* pHeader, str_t const* ops)
+{
+   lldb_txlog_header_s header = *pHeader;
+   uint32_t crc;
+
+   header.crc = 0;
+   crc = pcoCrc32(0, (unsigned char const*) &header, sizeof(header));
+   return pcoCrc32(crc, (unsigned char const*) ops, header.size);
+}
+
+/* check the operations of a record and call apply for every operation (apply NIL: check only), up to the first error
+ * of apply if bStopOnError. Returns number of operations, or the first error returned by apply */
+static sint_t txApplyOps(str_t const* ops, uint32_t size, uint32_t count, lldb_tx_apply_t apply, void* ctx, bool_t bStopOnError)
+{
+   lldb_txlog_op_s op;
+   sint_t result = (sint_t) count;
+   sint_t opResult;
+   uint32_t offset = 0;
+   uint32_t i;
+
+   for (i = 0; i < count; i++)
+   {
+      if (size - offset < sizeof(op))
+      {
+         return PERS_COM_FAILURE;
+      }
+      (void) memcpy(&op, ops + offset, sizeof(op));
+      offset += (uint32_t) sizeof(op);
+      if (   (op.keySize < 2) || (op.keySize > PERS_DB_MAX_LENGTH_KEY_NAME) || (op.dataSize > PERS_DB_MAX_SIZE_KEY_DATA)
+          || (size - offset < op.keySize + (uint32_t) ((op.dataSize > 0) ? op.dataSize : 0))
+          || (ops[offset + op.keySize - 1] != '\0'))
+      {
+         return PERS_COM_FAILURE;
+      }
+      if (NIL != apply)
+      {
+         opResult = apply(ops + offset, (op.dataSize >= 0) ? ops + offset + op.keySize : NIL, op.dataSize, ctx);
+         if ((opResult < 0) && (result >= 0))
+         {
+            result = opResult;
+            if (bStopOnError)
+            {
+               return result;
+            }
+         }
+      }
+      offset += op.keySize + (uint32_t) ((op.dataSize > 0) ? op.dataSize : 0);
+   }
+   return (offset == size) ? result : PERS_COM_FAILURE;
+}
+
+static bool_t txWriteAll(int fd, str_t const* buffer, size_t size)
+{
+   ssize_t written;
+
+   while (size > 0)
+   {
+      written = write(fd, buffer, size);
+      if (written < 0)
+      {
+         if (errno == EINTR)
+         {
+            continue;
+         }
+         return false;
+      }
+      buffer += written;
+      size -= (size_t) written;
+   }
+   return true;
+}
+
+static bool_t txReadAll(int fd, void* buffer, size_t size)
+{
+   ssize_t bytesRead;
+   str_t* ptr = (str_t*) buffer;
+
+   while (size > 0)
+   {
+      bytesRead = read(fd, ptr, size);
+      if (bytesRead < 0)
+      {
+         if (errno == EINTR)
+         {
+            continue;
+         }
+         return false;
+      }
+      if (bytesRead == 0)
+      {
+         return false;
+      }
+      ptr += bytesRead;
+      size -= (size_t) bytesRead;
+   }
+   return true;
+}
+
+sint_t lldb_tx_begin(sint_t handlerDB)
+{
+   sint_t txId = PERS_COM_ERR_OUT_OF_MEMORY; //transaction table is full
+   str_t* buffer;
+   int i;
+
+   buffer = (str_t*) malloc(PERS_LLDB_TX_MIN_CAPACITY);
+   if (NIL == buffer)
+   {
+      return PERS_COM_ERR_MALLOC;
+   }
+   (void) pthread_mutex_lock(&g_txMutex);
+   for (i = 0; i < PERS_LLDB_NO_OF_TX; i++)
+   {
+      if (!g_asTx[i].bInUse)
+      {
+         g_txGeneration = (g_txGeneration + 1) & PERS_LLDB_TX_GEN_MASK;
+         g_asTx[i].bInUse = true;
+         g_asTx[i].txId = (g_txGeneration << PERS_LLDB_TX_INDEX_BITS) | i;
+         g_asTx[i].handlerDB = handlerDB;
+         g_asTx[i].buffer = buffer;
+         g_asTx[i].size = (uint32_t) sizeof(lldb_txlog_header_s);
+         g_asTx[i].capacity = PERS_LLDB_TX_MIN_CAPACITY;
+         g_asTx[i].count = 0;
+         txId = g_asTx[i].txId;
+         break;
+      }
+   }
+   (void) pthread_mutex_unlock(&g_txMutex);
+   if (txId < 0)
+   {
+      free(buffer);
+   }
+   return txId;
+}
+
+sint_t lldb_tx_add(sint_t txId, persComDbKey_t const* pKey, pconststr_t data, sint_t dataSize)
+{
+   lldb_tx_s* pTx = txFind(txId);
+   lldb_txlog_op_s op;
+   uint32_t needed;
+   uint32_t capacity;
+   str_t* buffer;
+
+   if (NIL == pTx)
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   if (   (NIL == pKey) || (NIL == pKey->key) || (pKey->length == 0) || (pKey->length >= PERS_DB_MAX_LENGTH_KEY_NAME)
+       || ((NIL != data) && ((dataSize <= 0) || (dataSize > PERS_DB_MAX_SIZE_KEY_DATA))))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   op.dataSize = (NIL != data) ? dataSize : -1;
+   op.keySize = pKey->length + 1;
+   needed = (uint32_t) sizeof(op) + op.keySize + (uint32_t) ((NIL != data) ? dataSize : 0);
+   if (pTx->capacity - pTx->size < needed)
+   {
+      capacity = pTx->capacity;
+      while (capacity - pTx->size < needed)
+      {
+         capacity *= 2;
+      }
+      buffer = (str_t*) realloc(pTx->buffer, capacity);
+      if (NIL == buffer)
+      {
+         return PERS_COM_ERR_MALLOC;
+      }
+      pTx->buffer = buffer;
+      pTx->capacity = capacity;
+   }
+   (void) memcpy(pTx->buffer + pTx->size, &op, sizeof(op));
+   pTx->size += (uint32_t) sizeof(op);
+   (void) memcpy(pTx->buffer + pTx->size, pKey->key, pKey->length);
+   pTx->buffer[pTx->size + pKey->length] = '\0';
+   pTx->size += op.keySize;
+   if (NIL != data)
+   {
+      (void) memcpy(pTx->buffer + pTx->size, data, (size_t) dataSize);
+      pTx->size += (uint32_t) dataSize;
+   }
+   pTx->count++;
+   return PERS_COM_SUCCESS;
+}
+
+sint_t lldb_tx_handler(sint_t txId)
+{
+   lldb_tx_s* pTx = txFind(txId);
+
+   return (NIL != pTx) ? pTx->handlerDB : PERS_COM_ERR_INVALID_PARAM;
+}
+
+sint_t lldb_tx_count(sint_t txId)
+{
+   lldb_tx_s* pTx = txFind(txId);
+
+   return (NIL != pTx) ? (sint_t) pTx->count : PERS_COM_ERR_INVALID_PARAM;
+}
+
+sint_t lldb_tx_write_log(sint_t txId, str_t const* dbPathname, uint64_t seq)
+{
+   lldb_tx_s* pTx = txFind(txId);
+   lldb_txlog_header_s header;
+   str_t pathname[PERS_ORG_MAX_LENGTH_PATH_FILENAME + sizeof(PERS_LLDB_TXLOG_SUFFIX)];
+   struct stat statBuf;
+   sint_t result = PERS_COM_SUCCESS;
+   int fd;
+
+   if ((NIL == pTx) || (!txLogPathname(dbPathname, pathname, sizeof(pathname))))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   header.magic = PERS_LLDB_TXLOG_MAGIC;
+   header.size = pTx->size - (uint32_t) sizeof(header);
+   header.seq = seq;
+   header.count = pTx->count;
+   header.crc = txRecordCrc(&header, pTx->buffer + sizeof(header));
+   (void) memcpy(pTx->buffer, &header, sizeof(header));
+
+   fd = open(pathname, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+   if (fd < 0)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("open of <"); DLT_STRING(pathname); DLT_STRING("> failed: "); DLT_STRING(strerror(errno)));
+      return (errno == EACCES) ? PERS_COM_ERR_ACCESS_DENIED : PERS_COM_FAILURE;
+   }
+   if (fstat(fd, &statBuf) != 0)
+   {
+      result = PERS_COM_FAILURE;
+   }
+   else if (!txWriteAll(fd, pTx->buffer, pTx->size))
+   {
+      //a torn record would hide the records appended after it
+      (void) ftruncate(fd, statBuf.st_size);
+      result = PERS_COM_FAILURE;
+   }
+   else
+   {
+      pTx->logSize = statBuf.st_size;
+#if USE_FSYNC
+      if (fsync(fd) != 0)
+#else
+      if (fdatasync(fd) != 0)
+#endif
+      {
+         result = PERS_COM_FAILURE;
+      }
+   }
+   if (result != PERS_COM_SUCCESS)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("write of <"); DLT_STRING(pathname); DLT_STRING("> failed: "); DLT_STRING(strerror(errno)));
+   }
+   (void) close(fd);
+   return result;
+}
+
+uint64_t lldb_tx_log_size(sint_t txId)
+{
+   lldb_tx_s* pTx = txFind(txId);
+
+   return (NIL != pTx) ? (uint64_t) pTx->logSize + pTx->size : 0;
+}
+
+sint_t lldb_tx_drop_log(sint_t txId, str_t const* dbPathname)
+{
+   lldb_tx_s* pTx = txFind(txId);
+   str_t pathname[PERS_ORG_MAX_LENGTH_PATH_FILENAME + sizeof(PERS_LLDB_TXLOG_SUFFIX)];
+   sint_t result = PERS_COM_SUCCESS;
+   int fd;
+
+   if ((NIL == pTx) || (!txLogPathname(dbPathname, pathname, sizeof(pathname))))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   fd = open(pathname, O_WRONLY | O_CLOEXEC);
+   if (fd < 0)
+   {
+      result = PERS_COM_FAILURE;
+   }
+   else
+   {
+      //synced: the record must not be replayed after a crash
+#if USE_FSYNC
+      if ((ftruncate(fd, pTx->logSize) != 0) || (fsync(fd) != 0))
+#else
+      if ((ftruncate(fd, pTx->logSize) != 0) || (fdatasync(fd) != 0))
+#endif
+      {
+         result = PERS_COM_FAILURE;
+      }
+      (void) close(fd);
+   }
+   if (result != PERS_COM_SUCCESS)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("truncate of <"); DLT_STRING(pathname); DLT_STRING("> failed: "); DLT_STRING(strerror(errno)));
+   }
+   return result;
+}
+
+sint_t lldb_tx_apply(sint_t txId, lldb_tx_apply_t apply, void* ctx)
+{
+   lldb_tx_s* pTx = txFind(txId);
+
+   if ((NIL == pTx) || (NIL == apply))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   return txApplyOps(pTx->buffer + sizeof(lldb_txlog_header_s), pTx->size - (uint32_t) sizeof(lldb_txlog_header_s), pTx->count, apply, ctx, true);
+}
+
+void lldb_tx_end(sint_t txId)
+{
+   lldb_tx_s* pTx;
+   str_t* buffer = NIL;
+
+   if (txId >= 0)
+   {
+      (void) pthread_mutex_lock(&g_txMutex);
+      pTx = &g_asTx[txId & PERS_LLDB_TX_INDEX_MASK];
+      if (pTx->bInUse && (pTx->txId == txId))
+      {
+         buffer = pTx->buffer;
+         (void) memset(pTx, 0, sizeof(*pTx));
+      }
+      (void) pthread_mutex_unlock(&g_txMutex);
+      free(buffer);
+   }
+}
+
+sint_t lldb_tx_replay_log(str_t const* dbPathname, uint64_t appliedSeq, lldb_tx_apply_t apply, void* ctx, uint64_t* pLastSeq_out)
+{
+   lldb_txlog_header_s header;
+   str_t pathname[PERS_ORG_MAX_LENGTH_PATH_FILENAME + sizeof(PERS_LLDB_TXLOG_SUFFIX)];
+   struct stat statBuf;
+   str_t* ops = NIL;
+   off_t offset = 0;
+   sint_t replayed = 0;
+   sint_t result;
+   int fd;
+
+   *pLastSeq_out = appliedSeq;
+   if (!txLogPathname(dbPathname, pathname, sizeof(pathname)))
+   {
+      return PERS_COM_ERR_INVALID_PARAM;
+   }
+   fd = open(pathname, O_RDONLY | O_CLOEXEC);
+   if (fd < 0)
+   {
+      return (errno == ENOENT) ? 0 : PERS_COM_FAILURE;
+   }
+   if (fstat(fd, &statBuf) != 0)
+   {
+      (void) close(fd);
+      return PERS_COM_FAILURE;
+   }
+   if (statBuf.st_size > 0)
+   {
+      ops = (str_t*) malloc((size_t) statBuf.st_size);
+      if (NIL == ops)
+      {
+         (void) close(fd);
+         return PERS_COM_ERR_MALLOC;
+      }
+   }
+   //the records are replayed up to the first one not completely written
+   while ((statBuf.st_size - offset) >= (off_t) sizeof(header))
+   {
+      if (!txReadAll(fd, &header, sizeof(header)))
+      {
+         break;
+      }
+      offset += (off_t) sizeof(header);
+      if (   (header.magic != PERS_LLDB_TXLOG_MAGIC) || ((off_t) header.size > (statBuf.st_size - offset))
+          || (!txReadAll(fd, ops, header.size)) || (header.crc != txRecordCrc(&header, ops))
+          || (txApplyOps(ops, header.size, header.count, NIL, NIL, false) < 0))
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
+                 DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("incomplete record ignored in <"); DLT_STRING(pathname); DLT_STRING(">"));
+         break;
+      }
+      offset += (off_t) header.size;
+      if (header.seq > *pLastSeq_out)
+      {
+         //an operation which can not be applied does not stop the replay, the record is not replayed again
+         result = txApplyOps(ops, header.size, header.count, apply, ctx, false);
+         if (result < 0)
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                    DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("replay of <"); DLT_STRING(pathname); DLT_STRING("> failed, retval=<"); DLT_INT(result); DLT_STRING(">"));
+         }
+         *pLastSeq_out = header.seq;
+         replayed++;
+      }
+   }
+   free(ops);
+   (void) close(fd);
+   return replayed;
+}
+
+void lldb_tx_clear_log(str_t const* dbPathname)
+{
+   str_t pathname[PERS_ORG_MAX_LENGTH_PATH_FILENAME + sizeof(PERS_LLDB_TXLOG_SUFFIX)];
+
+   if (txLogPathname(dbPathname, pathname, sizeof(pathname)))
+   {
+      //not synced: the records still in the log after a crash are older than the sequence number of the database file
+      if ((truncate(pathname, 0) != 0) && (errno != ENOENT))
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
+                 DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("truncate of <"); DLT_STRING(pathname); DLT_STRING("> failed: "); DLT_STRING(strerror(errno)));
+      }
+   }
+}
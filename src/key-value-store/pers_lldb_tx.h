@@ -0,0 +1,149 @@
+#ifndef PERS_LLDB_TX_H
+#define PERS_LLDB_TX_H
+
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ ******************************************************************************/
+ /**
+ * @file           pers_lldb_tx.h
+ * @ingroup        Persistence key value store
+ * @brief          Transactions of the key value store and their intent log
+ * @see
+ *
+ * The puts and deletes of a transaction are collected in memory, already in the format of a record
+ * of the intent log "<database>.txlog". The commit appends the record to the log and syncs the log,
+ * which is the commit point, before the operations are applied to the database.
+ * Every record has a sequence number; the database file header keeps the sequence number of the last
+ * record applied to the database file, so a record is replayed by the first open only if it is newer.
+ * A torn record at the end of the log (crash during the commit) is ignored.
+ */
+
+#include <stdint.h>
+#include "persComTypes.h"
+#include "persComDbAccess.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* size of the intent log of a write cached database from which a commit writes the cache back to empty the log */
+#ifndef PERS_LLDB_TXLOG_MAX_SIZE
+#define PERS_LLDB_TXLOG_MAX_SIZE    (256 * 1024)
+#endif
+
+/**
+ * @brief apply one operation of a transaction
+ *
+ * @param key               [in] key's name ('\0' terminated)
+ * @param data              [in] data of the key (NIL for a delete)
+ * @param dataSize          [in] size of data, negative for a delete
+ * @param ctx               [in] context given to lldb_tx_apply / lldb_tx_replay_log
+ *
+ * @return 0 or positive value for success, negative value in case of error (see pers_error_codes.h)
+ */
+typedef sint_t (*lldb_tx_apply_t)(str_t const* key, pconststr_t data, sint_t dataSize, void* ctx);
+
+/**
+ * @brief start a transaction
+ *
+ * @param handlerDB         [in] handler of the database, only stored with the transaction
+ *
+ * @return transaction id (positive value), or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t lldb_tx_begin(sint_t handlerDB);
+
+/**
+ * @brief add a put or a delete to a transaction
+ *
+ * @param txId              [in] transaction id obtained with lldb_tx_begin
+ * @param pKey              [in] key descriptor, the key's name is copied
+ * @param data              [in] data of the key, copied (NIL for a delete)
+ * @param dataSize          [in] size of data (1 .. PERS_DB_MAX_SIZE_KEY_DATA), ignored for a delete
+ *
+ * @return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t lldb_tx_add(sint_t txId, persComDbKey_t const* pKey, pconststr_t data, sint_t dataSize);
+
+/**
+ * @brief database handler of a transaction
+ * @return handler given to lldb_tx_begin, or negative value if the transaction id is not valid
+ */
+sint_t lldb_tx_handler(sint_t txId);
+
+/**
+ * @brief number of operations of a transaction
+ * @return number of puts and deletes added, or negative value if the transaction id is not valid
+ */
+sint_t lldb_tx_count(sint_t txId);
+
+/**
+ * @brief append the record of a transaction to the intent log of the database and sync the log
+ *
+ * @param txId              [in] transaction id obtained with lldb_tx_begin
+ * @param dbPathname        [in] path of the database file
+ * @param seq               [in] sequence number of the record
+ *
+ * @return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t lldb_tx_write_log(sint_t txId, str_t const* dbPathname, uint64_t seq);
+
+/**
+ * @brief size of the intent log after the record of a transaction was appended by lldb_tx_write_log
+ * @return size in bytes, 0 if the transaction id is not valid
+ */
+uint64_t lldb_tx_log_size(sint_t txId);
+
+/**
+ * @brief remove the record of a transaction from the end of the intent log and sync the log,
+ *        when its operations could not be applied and were undone
+ *
+ * @param txId              [in] transaction id whose record was appended by lldb_tx_write_log
+ * @param dbPathname        [in] path of the database file
+ *
+ * @return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t lldb_tx_drop_log(sint_t txId, str_t const* dbPathname);
+
+/**
+ * @brief call apply for every operation of a transaction, in the order they were added, up to the first error
+ * @return number of operations, or the first error returned by apply (the remaining operations are not applied)
+ */
+sint_t lldb_tx_apply(sint_t txId, lldb_tx_apply_t apply, void* ctx);
+
+/**
+ * @brief release a transaction, the transaction id is not valid anymore
+ */
+void lldb_tx_end(sint_t txId);
+
+/**
+ * @brief apply the valid records of the intent log newer than appliedSeq, in the order of the log
+ * @note : an error of apply is logged and does not stop the replay
+ *
+ * @param dbPathname        [in] path of the database file
+ * @param appliedSeq        [in] sequence number of the last record already applied to the database file
+ * @param apply             [in] function called for every operation of the records
+ * @param ctx               [in] context passed to apply
+ * @param pLastSeq_out      [out]sequence number of the last record applied (appliedSeq if none)
+ *
+ * @return number of records applied, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t lldb_tx_replay_log(str_t const* dbPathname, uint64_t appliedSeq, lldb_tx_apply_t apply, void* ctx, uint64_t* pLastSeq_out);
+
+/**
+ * @brief empty the intent log of the database, when all its records are applied to the database file
+ */
+void lldb_tx_clear_log(str_t const* dbPathname);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERS_LLDB_TX_H */
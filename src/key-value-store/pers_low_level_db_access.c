@@ -32,6 +32,11 @@
 #include "persComDbAccess.h"
 #include "persComRct.h"
 #include "pers_low_level_db_access_if.h"
+#include "pers_lldb_trace.h"
+#include "pers_lldb_async.h"
+#include "pers_lldb_tx.h"
+#include "pers_lldb_snapshot.h"
+#include "pers_lldb_probes.h"
 #include <dlt.h>
 #include <errno.h>
 #include <sys/time.h>
@@ -48,10 +53,19 @@ DLT_DECLARE_CONTEXT   (persComLldbDLTCtx)
 /* ---------------------- local definition  ---------------------------- */
 /* max number of open handlers per process */
 #define PERS_LLDB_NO_OF_STATIC_HANDLES 16
-#define PERS_LLDB_MAX_STATIC_HANDLES (PERS_LLDB_NO_OF_STATIC_HANDLES-1)
+#define PERS_LLDB_MAX_CHUNKS 256
+#define PERS_LLDB_MAX_HANDLES (PERS_LLDB_NO_OF_STATIC_HANDLES * PERS_LLDB_MAX_CHUNKS)
+
+/* a handler is composed of the index in the handle table (low bits) and the generation of the entry (high bits),
+ * so a closed handler is not valid anymore when its entry is reused */
+#define PERS_LLDB_HANDLE_INDEX_BITS 12
+#define PERS_LLDB_HANDLE_INDEX_MASK ((1 << PERS_LLDB_HANDLE_INDEX_BITS) - 1)
+#define PERS_LLDB_HANDLE_GEN_MASK   ((1 << (31 - PERS_LLDB_HANDLE_INDEX_BITS)) - 1)
 
 #define PERS_STATUS_KEY_NOT_IN_CACHE             -10        /* /!< key not in cache */
 
+#define PERS_LLDB_KEYDIR_MIN_SLOTS               256        /* minimum number of slots of the key directory */
+
 #define SEM_TIMEDWAIT_TIMEOUT                      5        // wait for seconds until sem_timedwait fails
 
 
@@ -64,7 +78,8 @@ typedef struct
 typedef enum pers_lldb_cache_flag_e
 {
    CachedDataDelete = 0, /* Resource-Configuration-Table */
-   CachedDataWrite /* Local/Shared DB */
+   CachedDataWrite, /* Local/Shared DB */
+   CachedDataWriteClean /* written back by pers_lldb_sync, kept in cache for reading */
 } pers_lldb_cache_flag_e;
 
 typedef struct
@@ -81,6 +96,36 @@ typedef struct
    char m_data[sizeof(PersistenceConfigurationKey_s)];
 } Data_Cached_RCT_s;
 
+/* operation of AccessKeysInKissLocalDB, also used as operation of the trace */
+typedef enum
+{
+   LldbKeysRead = LLDB_TRACE_OP_READ,
+   LldbKeysWrite = LLDB_TRACE_OP_WRITE,
+   LldbKeysDelete = LLDB_TRACE_OP_DELETE
+} lldb_keys_op_e;
+
+/* key of a page of keys: hash of the key and slot of the key in the key directory */
+typedef struct
+{
+   uint32_t hash;
+   int idx;
+} lldb_keydir_entry_s;
+
+/* previous value of a key changed by a committed transaction, followed by the key's name ('\0' terminated) and the data */
+typedef struct lldb_tx_undo_s
+{
+   struct lldb_tx_undo_s* next;          /* operation applied before */
+   sint_t dataSize;                      /* PERS_COM_ERR_NOT_FOUND if the key did not exist */
+} lldb_tx_undo_s;
+
+/* context of the operations of a committed transaction */
+typedef struct
+{
+   KISSDB* db;
+   Data_Cached_s* pDataCached;
+   lldb_tx_undo_s* pUndo;                /* operations applied, the last one first */
+} lldb_tx_apply_ctx_s;
+
 typedef struct
 {
    bool_t bIsAssigned;
@@ -90,51 +135,72 @@ typedef struct
    str_t dbPathname[PERS_ORG_MAX_LENGTH_PATH_FILENAME];
 } lldb_handler_s;
 
-typedef struct lldb_handles_list_el_s_
-{
-   lldb_handler_s sHandle;
-   struct lldb_handles_list_el_s_* pNext;
-} lldb_handles_list_el_s;
-
+/* handle table: chunks of PERS_LLDB_NO_OF_STATIC_HANDLES handlers, the first chunk is static, the others are
+ * allocated on demand and never freed, so a handler never moves and can be looked up without a lock */
 typedef struct
 {
-   lldb_handler_s asStaticHandles[PERS_LLDB_NO_OF_STATIC_HANDLES]; /* static area should be enough for most of the processes*/
-   lldb_handles_list_el_s* pListHead; /* for the processes with a large number of threads which use Persistency */
+   lldb_handler_s* apChunks[PERS_LLDB_MAX_CHUNKS];
+   sint_t aiFreeIndex[PERS_LLDB_MAX_HANDLES]; /* stack of released indexes */
+   sint_t iFreeCount;
+   sint_t iNextIndex; /* first index never used before */
+   pthread_mutex_t mutex; /* serializes allocation and release of handlers */
 } lldb_handlers_s;
 
 /* ---------------------- local variables  --------------------------------- */
 static const char ListItemsSeparator = '\0';
 
 /* shared by all the threads within a process */
-static lldb_handlers_s g_sHandlers; // initialize to 0 and NULL
-//static lldb_handlers_s g_sHandlers = { { { 0 } } };
+static lldb_handler_s g_asStaticHandles[PERS_LLDB_NO_OF_STATIC_HANDLES]; /* static area should be enough for most of the processes*/
+static lldb_handlers_s g_sHandlers = { .apChunks = { g_asStaticHandles }, .mutex = PTHREAD_MUTEX_INITIALIZER };
 
 static struct timespec gSemWaitTimeout;
 
 /* ---------------------- local macros  --------------------------------- */
 
 /* ---------------------- local functions  --------------------------------- */
-static sint_t DeleteDataFromKissDB(sint_t dbHandler, pconststr_t key);
+static sint_t DeleteDataFromKissDB(sint_t dbHandler, persComDbKey_t const* pKey);
 //static sint_t DeleteDataFromKissRCT(sint_t dbHandler, pconststr_t key);
 static sint_t GetAllKeysFromKissLocalDB(sint_t dbHandler, pstr_t buffer, sint_t size);
 static sint_t GetAllKeysFromKissRCT(sint_t dbHandler, pstr_t buffer, sint_t size);
-static sint_t GetKeySizeFromKissLocalDB(sint_t dbHandler, pconststr_t key);
-static sint_t GetDataFromKissLocalDB(sint_t dbHandler, pconststr_t key, pstr_t buffer_out, sint_t bufSize);
-static sint_t GetDataFromKissRCT(sint_t dbHandler, pconststr_t key, PersistenceConfigurationKey_s* pConfig);
-static sint_t SetDataInKissLocalDB(sint_t dbHandler, pconststr_t key, pconststr_t data, sint_t dataSize);
-static sint_t SetDataInKissRCT(sint_t dbHandler, pconststr_t key, PersistenceConfigurationKey_s const* pConfig);
+static sint_t GetKeySizeFromKissLocalDB(sint_t dbHandler, persComDbKey_t const* pKey);
+static sint_t GetDataAllocFromKissLocalDB(sint_t dbHandler, persComDbKey_t const* pKey, persComDbAllocCallback_t allocator, void* ctx,
+                                          pstr_t* pBuffer_out);
+static sint_t GetDataFromKissLocalDB(sint_t dbHandler, persComDbKey_t const* pKey, pstr_t buffer_out, sint_t bufSize);
+static sint_t GetDataFromKissRCT(sint_t dbHandler, persComDbKey_t const* pKey, PersistenceConfigurationKey_s* pConfig);
+static sint_t SetDataInKissLocalDB(sint_t dbHandler, persComDbKey_t const* pKey, pconststr_t data, sint_t dataSize);
+static sint_t SetDataInKissRCT(sint_t dbHandler, persComDbKey_t const* pKey, PersistenceConfigurationKey_s const* pConfig);
+static sint_t AccessKeysInKissLocalDB(sint_t dbHandler, lldb_keys_op_e eOp, str_t const* const* keys, pstr_t const* dataBuffers, str_t const* const* data, sint_t const* sizes, sint_t* results_out, sint_t count);
 static sint_t writeBackKissDB(KISSDB* db, lldb_handler_s* pLldbHandler);
 static sint_t writeBackKissRCT(KISSDB* db, lldb_handler_s* pLldbHandler);
-static sint_t getListandSize(KISSDB* db, pstr_t buffer, sint_t size, bool_t bOnlySizeNeeded, pers_lldb_purpose_e purpose);
-static sint_t putToCache(KISSDB* db, sint_t dataSize, char* metaKey, void* cachedData);
-static sint_t deleteFromCache(KISSDB* db, char* metaKey);
-static sint_t getFromCache(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize, bool_t sizeOnly);
-static sint_t getFromDatabaseFile(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize);
+static sint_t ForEachInKissLocalDB(sint_t dbHandler, pconststr_t prefix, persComDbForEachCallback_t callback, void* ctx);
+static sint_t ListKeysPageFromKissDB(sint_t dbHandler, pers_lldb_purpose_e ePurpose, uint64_t cursor, pstr_t buffer, sint_t size, uint64_t* pNextCursor);
+static sint_t CommitTxInKissLocalDB(sint_t txId);
+static sint_t SyncKissLocalDB(sint_t dbHandler);
+static sint_t SnapshotKissLocalDB(sint_t dbHandler, str_t const* destPath);
+static sint_t syncCacheLocked(KISSDB* db);
+static sint_t forEachLocked(KISSDB* db, pconststr_t prefix, bool_t bWithData, persComDbForEachCallback_t callback, void* ctx);
+static sint_t putToCache(KISSDB* db, sint_t dataSize, persComDbKey_t const* pKey, void* cachedData);
+static sint_t deleteFromCache(KISSDB* db, persComDbKey_t const* pKey);
+static sint_t getFromCache(KISSDB* db, persComDbKey_t const* pKey, void* readBuffer, sint_t bufsize, bool_t sizeOnly);
+static sint_t getFromDatabaseFile(KISSDB* db, persComDbKey_t const* pKey, void* readBuffer, sint_t bufsize);
+static sint_t readKeyLocked(KISSDB* db, persComDbKey_t const* pKey, pstr_t buffer_out, sint_t bufSize);
+static sint_t writeKeyLocked(KISSDB* db, persComDbKey_t const* pKey, pconststr_t data, sint_t dataSize, Data_Cached_s* pDataCached);
+static sint_t deleteKeyLocked(KISSDB* db, persComDbKey_t const* pKey);
+static void syncDatabaseFile(KISSDB* db);
+static sint_t deleteTxKey(KISSDB* db, persComDbKey_t const* pKey);
+static sint_t applyTxOp(str_t const* key, pconststr_t data, sint_t dataSize, void* ctx);
+static bool_t undoTxOps(lldb_tx_apply_ctx_s* pCtx);
+static void freeTxUndo(lldb_tx_apply_ctx_s* pCtx);
+static void markTxApplied(KISSDB* db, str_t const* dbPathname);
+static sint_t syncLocked(KISSDB* db, str_t const* dbPathname);
+static sint_t replayTxOp(str_t const* key, pconststr_t data, sint_t dataSize, void* ctx);
+static void recoverTransactions(KISSDB* db, str_t const* dbPathname);
+static void initKey(persComDbKey_t* pKey, str_t const* key);
 
 /* access to resources shared by the threads within a process */
 static bool_t lldb_handles_InitLock(pthread_mutex_t *mutex);
-static bool_t lldb_handles_Lock(pthread_mutex_t *mutex);
-static bool_t lldb_handles_Unlock(pthread_mutex_t *mutex);
+static bool_t lldb_handles_Lock(pthread_mutex_t *mutex, Kdb_stats_s* pStats);
+static bool_t lldb_handles_Unlock(pthread_mutex_t *mutex, Kdb_stats_s* pStats);
 static lldb_handler_s* lldb_handles_FindInUseHandle(sint_t dbHandler);
 static lldb_handler_s* lldb_handles_FindAvailableHandle(void);
 static void lldb_handles_InitHandle(lldb_handler_s* psHandle_inout, pers_lldb_purpose_e ePurpose, str_t const* dbPathname);
@@ -145,6 +211,12 @@ static int openCache(KISSDB* db);
 //static int addCache(KISSDB* db);
 static int closeCache(KISSDB* db);
 
+static sint_t keyDirList(KISSDB* db, pstr_t buffer, sint_t size);
+static sint_t keyDirListPage(KISSDB* db, uint64_t cursor, pstr_t buffer, sint_t size, uint64_t* pNextCursor);
+static void keyDirAdd(KISSDB* db, persComDbKey_t const* pKey);
+static void keyDirRemove(KISSDB* db, persComDbKey_t const* pKey);
+static void keyDirClose(KISSDB* db, bool_t bLastInstance);
+
 
 __attribute__((constructor))
 static void pco_library_init()
@@ -186,9 +258,12 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
    int kdbState = 0;
    int openMode  = KISSDB_OPEN_MODE_RDWR; //default is open existing in RDWR
    int writeMode = KISSDB_WRITE_MODE_WC;  //default is write cached
-   int incRefCounter = 1;  // default increment counter
    lldb_handler_s* pLldbHandler = NIL;
    sint_t returnValue = PERS_COM_FAILURE;
+#ifdef PERS_LLDB_LOCK_PROFILE
+   uint64_t semStartNs, semAcquiredNs;
+#endif
+   LLDB_TRACE_START(traceStart);
 
    path = dbPathname;
 
@@ -199,8 +274,7 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
    pLldbHandler = lldb_handles_FindAvailableHandle();
    if (NIL == pLldbHandler)
    {
-      bCanContinue = false;
-      returnValue = PERS_COM_ERR_OUT_OF_MEMORY;
+      return PERS_COM_ERR_OUT_OF_MEMORY; //handle table is full
    }
    if (bCanContinue)
    {
@@ -226,6 +300,16 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
          DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO, DLT_STRING(LT_HDR), DLT_STRING(__FUNCTION__), DLT_STRING("Opening in read only mode:"), DLT_STRING("<"),
                  DLT_STRING(dbPathname), DLT_STRING(">, "));
       }
+      if (pLldbHandler->kissDb.alreadyOpen == Kdb_false)
+      {
+         //bit 4 is set 0x10 -> process private mode: no shared memory, database is used exclusively by this instance
+         pLldbHandler->kissDb.privateMode = (bForceCreationIfNotPresent & (1 << 4)) ? Kdb_true : Kdb_false;
+         if (pLldbHandler->kissDb.privateMode == Kdb_true)
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO, DLT_STRING(LT_HDR), DLT_STRING(__FUNCTION__), DLT_STRING("Opening in process private mode:"), DLT_STRING("<"),
+                    DLT_STRING(dbPathname), DLT_STRING(">, "));
+         }
+      }
 
 
       if (1 == checkIsLink(dbPathname, linkBuffer))
@@ -239,12 +323,26 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
 
       //printKdb(&pLldbHandler->kissDb);
 
-      if (pLldbHandler->kissDb.alreadyOpen == Kdb_false) //check if this instance has already opened the db before
+      if (pLldbHandler->kissDb.alreadyOpen == Kdb_false && pLldbHandler->kissDb.privateMode == Kdb_true)
+      {
+         //unnamed semaphore, only used by this instance
+         pLldbHandler->kissDb.semName = NULL;
+         if (-1 == sem_init(&pLldbHandler->kissDb.privateSem, 0, 1))
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                    DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(": sem_init() failed:"); DLT_STRING(strerror(errno)));
+            (void) lldb_handles_DeinitHandle(pLldbHandler->dbHandler); //release the reserved handle
+            return -1;
+         }
+         pLldbHandler->kissDb.kdbSem = &pLldbHandler->kissDb.privateSem;
+      }
+      else if (pLldbHandler->kissDb.alreadyOpen == Kdb_false) //check if this instance has already opened the db before
       {
          pLldbHandler->kissDb.semName = kdbGetShmName("-sem", path);
 
          if (NULL == pLldbHandler->kissDb.semName)
          {
+            (void) lldb_handles_DeinitHandle(pLldbHandler->dbHandler); //release the reserved handle
             return -1;
          }
          pLldbHandler->kissDb.kdbSem = sem_open(pLldbHandler->kissDb.semName, O_CREAT | O_EXCL, 0644, 1);
@@ -264,6 +362,7 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
                {
                   DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
                           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(": sem_open() for existing semaphore failed with error: "); DLT_STRING(strerror(error)));
+                  (void) lldb_handles_DeinitHandle(pLldbHandler->dbHandler); //release the reserved handle
                   return -1;
                }
             }
@@ -271,6 +370,7 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
             {
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
                        DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":sem_open() failed:"); DLT_STRING(strerror(error)));
+               (void) lldb_handles_DeinitHandle(pLldbHandler->dbHandler); //release the reserved handle
                return -1;
             }
          }
@@ -278,13 +378,22 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
 
       clock_gettime(CLOCK_REALTIME, &gSemWaitTimeout);
       gSemWaitTimeout.tv_sec += SEM_TIMEDWAIT_TIMEOUT;
+#ifdef PERS_LLDB_LOCK_PROFILE
+      semStartNs = kdbLockProfileNow();
+#endif
+      LLDB_OP_WAIT_START(semWaitStart);
       if(-1 == sem_timedwait(pLldbHandler->kissDb.kdbSem, &gSemWaitTimeout))
       {
          DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_wait() in open failed: "),
                  DLT_STRING(strerror(errno)));
 
+         (void) lldb_handles_DeinitHandle(pLldbHandler->dbHandler); //release the reserved handle
          return PERS_COM_ERR_SEM_WAIT_TIMEOUT;
       }
+      LLDB_OP_WAIT_END(semWaitStart);
+#ifdef PERS_LLDB_LOCK_PROFILE
+      semAcquiredNs = kdbLockProfileNow();
+#endif
 
       kdbState = KISSDB_open(&pLldbHandler->kissDb, path, openMode, writeMode, HASHTABLE_SLOT_COUNT, keysize, datasize);
       if (kdbState != 0)
@@ -296,15 +405,6 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
 
             bCanContinue = false;
          }
-         else if(kdbState == KISSDB_ERROR_APPCRASH)
-         {
-            // possible appcrash detected:
-            // - don't increment counter
-            // - set kdbState back to 0
-            // - bCanContinue still true
-            incRefCounter = 0;
-            kdbState = 0;
-         }
          else
          {
             DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
@@ -325,16 +425,23 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
          db->shared->mutexInit = true;
       }
 
-      if (lldb_handles_Lock(&db->shared->mutex))
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
       {
          bLocked = true;
       }
 
-      if(incRefCounter == 1)
+      pLldbHandler->kissDb.shared->refCount++; //increment reference to opened databases
+      if ((db->shared->refCount == 1) && (PersLldbPurpose_DB == ePurpose))
       {
-         pLldbHandler->kissDb.shared->refCount++; //increment reference to opened databases
+         //first instance: the transactions committed before a crash are applied to the database file
+         recoverTransactions(db, path);
       }
 
+#ifdef PERS_LLDB_LOCK_PROFILE
+      //the shared information is only available after the database is opened
+      kdbLockProfileAcquired(&db->shared->stats, KDB_LOCK_SEM, semStartNs, semAcquiredNs);
+      kdbLockProfileRelease(&db->shared->stats, KDB_LOCK_SEM);
+#endif
       if (-1 == sem_post(pLldbHandler->kissDb.kdbSem)) //release semaphore
       {
          DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": End of open -> sem_post() failed: "),DLT_STRING(strerror(errno)));
@@ -369,7 +476,7 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
    else
    {
       /* clean up */
-      returnValue = PERS_COM_FAILURE;
+      returnValue = (kdbState == KISSDB_ERROR_ACCESS_VIOLATION) ? PERS_COM_ERR_ACCESS_DENIED : PERS_COM_FAILURE;
       (void) lldb_handles_DeinitHandle(pLldbHandler->dbHandler);
    }
    if (bCanContinue)
@@ -377,7 +484,7 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
       if (bLocked)
       {
          KISSDB* db = &pLldbHandler->kissDb;
-         (void) lldb_handles_Unlock(&db->shared->mutex);
+         (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
       }
    }
    DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO, DLT_STRING(LT_HDR), DLT_STRING(__FUNCTION__), DLT_STRING("End of open for:"), DLT_STRING("<"),
@@ -385,6 +492,8 @@ sint_t pers_lldb_open(str_t const* dbPathname, pers_lldb_purpose_e ePurpose, boo
            ((true == bForceCreationIfNotPresent) ? DLT_STRING("forced, ") : DLT_STRING("unforced, ")); DLT_STRING("retval=<"), DLT_INT(returnValue),
            DLT_STRING(">"));
 
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_OPEN, returnValue, 0, returnValue, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_OPEN, dbPathname, NIL, returnValue, traceStart);
    return returnValue;
 }
 
@@ -406,6 +515,10 @@ sint_t pers_lldb_close(sint_t handlerDB)
    int kdbState = 0;
    lldb_handler_s* pLldbHandler = NIL;
    sint_t returnValue = PERS_COM_SUCCESS;
+#ifdef PERS_LLDB_LOCK_PROFILE
+   uint64_t semStartNs;
+#endif
+   LLDB_TRACE_START(traceStart);
 
    DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
            DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(handlerDB));
@@ -422,6 +535,8 @@ sint_t pers_lldb_close(sint_t handlerDB)
    clock_gettime(CLOCK_ID, &writeStart);
 #endif
 
+   //the queued writes are done while the database is still open
+   lldb_async_drain();
    if (handlerDB >= 0)
    {
       pLldbHandler = lldb_handles_FindInUseHandle(handlerDB);
@@ -439,13 +554,14 @@ sint_t pers_lldb_close(sint_t handlerDB)
    if (PERS_COM_SUCCESS == returnValue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      if (lldb_handles_Lock(&db->shared->mutex))
-      {
-         bLocked = true;
-      }
 
+      //same lock order as pers_lldb_open (semaphore before mutex), otherwise a concurrent open in another process deadlocks
       clock_gettime(CLOCK_REALTIME, &gSemWaitTimeout);
       gSemWaitTimeout.tv_sec += SEM_TIMEDWAIT_TIMEOUT;
+#ifdef PERS_LLDB_LOCK_PROFILE
+      semStartNs = kdbLockProfileNow();
+#endif
+      LLDB_OP_WAIT_START(semWaitStart);
       if (-1 == sem_timedwait(db->kdbSem, &gSemWaitTimeout))   // wait for 5 seconds
       {
          DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(": sem_wait() in close failed: "),
@@ -453,11 +569,20 @@ sint_t pers_lldb_close(sint_t handlerDB)
 
          return PERS_COM_ERR_SEM_WAIT_TIMEOUT;
       }
+      LLDB_OP_WAIT_END(semWaitStart);
+#ifdef PERS_LLDB_LOCK_PROFILE
+      kdbLockProfileAcquired(&db->shared->stats, KDB_LOCK_SEM, semStartNs, kdbLockProfileNow());
+#endif
+
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
+      {
+         bLocked = true;
+      }
 
       DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
               DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("Closing database <"); DLT_STRING(pLldbHandler->dbPathname); DLT_STRING(">"));
 
-      Kdb_wrlock(&db->shared->rwlock);         //lock acces to shared status information
+      Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);         //lock acces to shared status information
 
       if (db->shared->refCount > 0)
       {
@@ -469,7 +594,7 @@ sint_t pers_lldb_close(sint_t handlerDB)
          {
             if (openCache(db) != 0)
             {
-               Kdb_unlock(&db->shared->rwlock);
+               Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
                return PERS_COM_FAILURE;
             }
 #ifdef __showTimeMeasurements
@@ -478,24 +603,38 @@ sint_t pers_lldb_close(sint_t handlerDB)
 
             if (db->shared->openMode != KISSDB_OPEN_MODE_RDONLY)
             {
+               struct timespec wbStart, wbEnd;
+               sint_t wbResult = PERS_COM_SUCCESS;
+
+               PERS_PROBE1(writeback_start, pLldbHandler->dbPathname);
+               clock_gettime(CLOCK_MONOTONIC, &wbStart);
 #ifdef PFS_TEST
                printf("  START: writeback of %d slots\n", pLldbHandler->kissDb.tbl->data->usedslots);
 #endif
 
                if (pLldbHandler->ePurpose == PersLldbPurpose_DB)  //write back to local database
                {
-                  writeBackKissDB(&pLldbHandler->kissDb, pLldbHandler);
+                  wbResult = writeBackKissDB(&pLldbHandler->kissDb, pLldbHandler);
                }
                else
                {
                   if (pLldbHandler->ePurpose == PersLldbPurpose_RCT) //write back to RCT database
                   {
-                     writeBackKissRCT(&pLldbHandler->kissDb, pLldbHandler);
+                     wbResult = writeBackKissRCT(&pLldbHandler->kissDb, pLldbHandler);
                   }
                }
 #ifdef PFS_TEST
                printf("  END: writeback \n");
 #endif
+               clock_gettime(CLOCK_MONOTONIC, &wbEnd);
+               if (wbResult < 0)
+               {
+                  DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                          DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("writeback of <"); DLT_STRING(pLldbHandler->dbPathname); DLT_STRING("> failed, retval=<"); DLT_INT(wbResult); DLT_STRING(">"));
+               }
+               KDB_STAT_ADD(&db->shared->stats, writebacks, 1);
+               KDB_STAT_ADD(&db->shared->stats, writebackNs, ((wbEnd.tv_sec - wbStart.tv_sec) * 1000000000LL) + (wbEnd.tv_nsec - wbStart.tv_nsec));
+               PERS_PROBE2(writeback_end, pLldbHandler->dbPathname, wbResult);
             }
 
 #ifdef __showTimeMeasurements
@@ -506,7 +645,7 @@ sint_t pers_lldb_close(sint_t handlerDB)
             db->tbl[0] = NULL;
             if (closeCache(db) != 0)
             {
-               Kdb_unlock(&db->shared->rwlock);
+               Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
                return PERS_COM_FAILURE;
             }
             db->sharedCache = NULL;
@@ -530,18 +669,29 @@ sint_t pers_lldb_close(sint_t handlerDB)
             }
          }
       }
+      //last instance: the committed transactions are in the database file now, the intent log is not needed anymore
+      if (   (db->shared->refCount == 0) && (PersLldbPurpose_DB == pLldbHandler->ePurpose)
+          && (db->shared->openMode != KISSDB_OPEN_MODE_RDONLY) && (db->shared->txLastSeq > ((Header_s*) db->mappedDb)->txApplied))
+      {
+         markTxApplied(db, pLldbHandler->dbPathname);
+      }
       //no cache exists
-      Kdb_unlock(&db->shared->rwlock);
+      keyDirClose(db, (db->shared->refCount == 0));
+      Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
 
       if (bLocked)
       {
          KISSDB* db = &pLldbHandler->kissDb;
-         (void) lldb_handles_Unlock(&db->shared->mutex);
+         (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
       }
 
 #ifdef __showTimeMeasurements
       clock_gettime(CLOCK_ID, &kdbStart);
 #endif
+#ifdef PERS_LLDB_LOCK_PROFILE
+      //the semaphore is released by KISSDB_close after the shared information is unmapped
+      kdbLockProfileRelease(&pLldbHandler->kissDb.shared->stats, KDB_LOCK_SEM);
+#endif
 
       kdbState = KISSDB_close(&pLldbHandler->kissDb);
 
@@ -597,6 +747,8 @@ sint_t pers_lldb_close(sint_t handlerDB)
    printf("END: pers_lldb_close for PID: %d \n", getpid());
 #endif
 
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_CLOSE, handlerDB, 0, returnValue, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_CLOSE, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, NIL, returnValue, traceStart);
    return returnValue;
 }
 
@@ -760,6 +912,26 @@ static sint_t writeBackKissDB(KISSDB* db, lldb_handler_s* pLldbHandler)
    return returnValue;
 }
 
+/**
+ * \brief fill a key descriptor: key's name, its length and the hash used by the database
+ *
+ * \param key               [in] key's name
+ * \param pKey_out          [out]key descriptor
+ *
+ * \return 0 for success, negative value otherway (see pers_error_codes.h)
+ */
+sint_t pers_lldb_prepare_key(str_t const* key, persComDbKey_t* pKey_out)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+
+   if ((NIL != key) && (NIL != pKey_out))
+   {
+      initKey(pKey_out, key);
+      eErrorCode = PERS_COM_SUCCESS;
+   }
+   return eErrorCode;
+}
+
 /**
  * \brief write a key-value pair into database
  * \note : DB type is identified from dbPathname (based on extension)
@@ -774,6 +946,30 @@ static sint_t writeBackKissDB(KISSDB* db, lldb_handler_s* pLldbHandler)
  * \return 0 for success, negative value otherway (see pers_error_codes.h)
  */
 sint_t pers_lldb_write_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* key, str_t const* data, sint_t dataSize)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+   persComDbKey_t sKey;
+
+   if (NIL != key)
+   {
+      initKey(&sKey, key);
+      eErrorCode = pers_lldb_write_key_prepared(handlerDB, ePurpose, &sKey, data, dataSize);
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief write a key-value pair into database, the key is given as key descriptor
+ *
+ * \param handlerDB     [in] handler obtained with pers_lldb_open
+ * \param ePurpose      [in] see pers_lldb_purpose_e
+ * \param pKey          [in] key descriptor filled by pers_lldb_prepare_key
+ * \param data          [in] buffer with key's data
+ * \param dataSize      [in] size of key's data
+ *
+ * \return bytes written for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_write_key_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const* pKey, str_t const* data, sint_t dataSize)
 {
    sint_t eErrorCode = PERS_COM_SUCCESS;
 
@@ -781,12 +977,12 @@ sint_t pers_lldb_write_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
    {
       case PersLldbPurpose_DB:
       {
-         eErrorCode = SetDataInKissLocalDB(handlerDB, key, data, dataSize);
+         eErrorCode = SetDataInKissLocalDB(handlerDB, pKey, data, dataSize);
          break;
       }
       case PersLldbPurpose_RCT:
       {
-         eErrorCode = SetDataInKissRCT(handlerDB, key, (PersistenceConfigurationKey_s const*) data);
+         eErrorCode = SetDataInKissRCT(handlerDB, pKey, (PersistenceConfigurationKey_s const*) data);
          break;
       }
       default:
@@ -798,6 +994,48 @@ sint_t pers_lldb_write_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
    return eErrorCode;
 }
 
+/**
+ * \brief queue the write of a key-value pair, the key is written by the worker thread of the process
+ * \note : reads of the key in this process return the queued data until it is written,
+ *         all other accesses to the database wait until the queued writes are done
+ *
+ * \param handlerDB     [in] handler obtained with pers_lldb_open
+ * \param ePurpose      [in] see pers_lldb_purpose_e (only PersLldbPurpose_DB is supported)
+ * \param pKey          [in] key descriptor filled by pers_lldb_prepare_key
+ * \param data          [in] buffer with key's data
+ * \param dataSize      [in] size of key's data
+ * \param callback      [in] called by the worker thread with the result of the write (can be NIL)
+ * \param ctx           [in] context passed to the callback
+ *
+ * \return 0 if the write is queued, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_write_key_async(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const* pKey, str_t const* data, sint_t dataSize,
+                                 persComDbWriteCallback_t callback, void* ctx)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+   lldb_handler_s* pLldbHandler = NIL;
+
+   if ((PersLldbPurpose_DB == ePurpose) && (handlerDB >= 0))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(handlerDB);
+      if ((NIL != pLldbHandler) && (PersLldbPurpose_DB == pLldbHandler->ePurpose))
+      {
+         eErrorCode = lldb_async_write(handlerDB, pKey, data, dataSize, callback, ctx);
+      }
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief eventfd signaled when queued writes are done, its counter is increased by one per write
+ *
+ * \return file descriptor, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_get_async_write_fd(void)
+{
+   return lldb_async_event_fd();
+}
+
 /**
  * \brief read a key's value from database
  * \note : DB type is identified from dbPathname (based on extension)
@@ -811,6 +1049,30 @@ sint_t pers_lldb_write_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
  * \return read size, or negative value in case of error (see pers_error_codes.h)
  */
 sint_t pers_lldb_read_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* key, pstr_t dataBuffer_out, sint_t bufSize)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+   persComDbKey_t sKey;
+
+   if (NIL != key)
+   {
+      initKey(&sKey, key);
+      eErrorCode = pers_lldb_read_key_prepared(handlerDB, ePurpose, &sKey, dataBuffer_out, bufSize);
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief read a key's value from database, the key is given as key descriptor
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param pKey              [in] key descriptor filled by pers_lldb_prepare_key
+ * \param dataBuffer_out    [out]buffer where to return the read data
+ * \param bufSize           [in] size of dataBuffer_out
+ *
+ * \return read size, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_read_key_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const* pKey, pstr_t dataBuffer_out, sint_t bufSize)
 {
    sint_t eErrorCode = PERS_COM_SUCCESS;
 
@@ -818,12 +1080,12 @@ sint_t pers_lldb_read_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
    {
       case PersLldbPurpose_DB:
       {
-         eErrorCode = GetDataFromKissLocalDB(handlerDB, key, dataBuffer_out, bufSize);
+         eErrorCode = GetDataFromKissLocalDB(handlerDB, pKey, dataBuffer_out, bufSize);
          break;
       }
       case PersLldbPurpose_RCT:
       {
-         eErrorCode = GetDataFromKissRCT(handlerDB, key, (PersistenceConfigurationKey_s*) dataBuffer_out);
+         eErrorCode = GetDataFromKissRCT(handlerDB, pKey, (PersistenceConfigurationKey_s*) dataBuffer_out);
          break;
       }
       default:
@@ -835,6 +1097,30 @@ sint_t pers_lldb_read_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
    return eErrorCode;
 }
 
+/**
+ * \brief read a key's value from database into a buffer returned by allocator, the key is looked up once
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param pKey              [in] key descriptor filled by pers_lldb_prepare_key
+ * \param allocator         [in] function returning the buffer for the data (NIL: malloc)
+ * \param ctx               [in] context passed to the allocator
+ * \param dataBuffer_out    [out]buffer returned by the allocator (NIL for empty data)
+ *
+ * \return read size, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_read_key_alloc_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const* pKey,
+                                         persComDbAllocCallback_t allocator, void* ctx, pstr_t* dataBuffer_out)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+
+   if ((PersLldbPurpose_DB == ePurpose) && (NIL != dataBuffer_out))
+   {
+      eErrorCode = GetDataAllocFromKissLocalDB(handlerDB, pKey, allocator, ctx, dataBuffer_out);
+   }
+   return eErrorCode;
+}
+
 /**
  * \brief reads the size of a value that corresponds to a key
  * \note : DB type is identified from dbPathname (based on extension)
@@ -845,6 +1131,27 @@ sint_t pers_lldb_read_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t
  * \return size of the value corresponding to the key, or negative value in case of error (see pers_error_codes.h)
  */
 sint_t pers_lldb_get_key_size(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* key)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+   persComDbKey_t sKey;
+
+   if (NIL != key)
+   {
+      initKey(&sKey, key);
+      eErrorCode = pers_lldb_get_key_size_prepared(handlerDB, ePurpose, &sKey);
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief reads the size of a value that corresponds to a key, the key is given as key descriptor
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param pKey              [in] key descriptor filled by pers_lldb_prepare_key
+ * \return size of the value corresponding to the key, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_get_key_size_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const* pKey)
 {
    sint_t eErrorCode = PERS_COM_SUCCESS;
 
@@ -852,7 +1159,7 @@ sint_t pers_lldb_get_key_size(sint_t handlerDB, pers_lldb_purpose_e ePurpose, st
    {
       case PersLldbPurpose_DB:
       {
-         eErrorCode = GetKeySizeFromKissLocalDB(handlerDB, key);
+         eErrorCode = GetKeySizeFromKissLocalDB(handlerDB, pKey);
          break;
       }
       default:
@@ -876,6 +1183,28 @@ sint_t pers_lldb_get_key_size(sint_t handlerDB, pers_lldb_purpose_e ePurpose, st
  * \return 0 for success, negative value otherway (see pers_error_codes.h)
  */
 sint_t pers_lldb_delete_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* key)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+   persComDbKey_t sKey;
+
+   if (NIL != key)
+   {
+      initKey(&sKey, key);
+      eErrorCode = pers_lldb_delete_key_prepared(handlerDB, ePurpose, &sKey);
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief delete key from database, the key is given as key descriptor
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param pKey              [in] key descriptor filled by pers_lldb_prepare_key
+ *
+ * \return 0 for success, negative value otherway (see pers_error_codes.h)
+ */
+sint_t pers_lldb_delete_key_prepared(sint_t handlerDB, pers_lldb_purpose_e ePurpose, persComDbKey_t const* pKey)
 {
    sint_t eErrorCode = PERS_COM_SUCCESS;
 
@@ -884,7 +1213,7 @@ sint_t pers_lldb_delete_key(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_
       case PersLldbPurpose_DB:
       case PersLldbPurpose_RCT:
       {
-         eErrorCode = DeleteDataFromKissDB(handlerDB, key);
+         eErrorCode = DeleteDataFromKissDB(handlerDB, pKey);
          break;
       }
       default:
@@ -967,88 +1296,331 @@ sint_t pers_lldb_get_keys_list(sint_t handlerDB, pers_lldb_purpose_e ePurpose, p
    return eErrorCode;
 }
 
-static sint_t DeleteDataFromKissDB(sint_t dbHandler, pconststr_t key)
+/**
+ * \brief read the values of several keys from database under one lock of the database
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e (only PersLldbPurpose_DB is supported)
+ * \param keys              [in] keys' names
+ * \param dataBuffers_out   [out]buffers where to return the read data, one per key
+ * \param bufSizes          [in] sizes of the buffers
+ * \param results_out       [out]per key: read size, or negative value in case of error
+ * \param count             [in] number of keys
+ *
+ * \return number of keys read, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_read_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* const* keys, pstr_t const* dataBuffers_out,
+                           sint_t const* bufSizes, sint_t* results_out, sint_t count)
 {
-   bool_t bCanContinue = true;
-   bool_t bLocked = false;
-   int kdbState = 0;
-   lldb_handler_s* pLldbHandler = NIL;
-   sint_t bytesDeleted = PERS_COM_FAILURE;
-
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("handlerDB="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">"));
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
 
-   if ((dbHandler >= 0) && (NIL != key))
-   {
-      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
-      if (NIL == pLldbHandler)
-      {
-         bCanContinue = false;
-      }
-   }
-   else
+   if (PersLldbPurpose_DB == ePurpose)
    {
-      bCanContinue = false;
+      eErrorCode = AccessKeysInKissLocalDB(handlerDB, LldbKeysRead, keys, dataBuffers_out, NIL, bufSizes, results_out, count);
    }
+   return eErrorCode;
+}
 
-   if (bCanContinue)
-   {
-      KISSDB* db = &pLldbHandler->kissDb;
-      if (lldb_handles_Lock(&db->shared->mutex))
-      {
-         bLocked = true;
-      }
-
-      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
-      if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
-      {
-         bytesDeleted = deleteFromCache(&pLldbHandler->kissDb, (char*) key);
-      }
-      else //write through
-      {
-
-         kdbState = KISSDB_delete(&pLldbHandler->kissDb, key, &bytesDeleted);
-         if (kdbState != 0)
-         {
-            if (kdbState == 1)
-            {
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
-                       DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_delete: key=<"); DLT_STRING(key); DLT_STRING(">, "); DLT_STRING("not found in database file, retval=<"); DLT_INT(kdbState);
-                       DLT_STRING(">"));
-            }
-            else
-            {
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
-                       DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_delete: key=<"); DLT_STRING(key); DLT_STRING(">, "); DLT_STRING("Error with retval=<"); DLT_INT(kdbState); DLT_STRING(">");
-                       DLT_STRING("Error Message: "); DLT_STRING(strerror(errno)));
-            }
-         }
-
+/**
+ * \brief write several key-value pairs into database under one lock of the database
+ * \note : in write through mode the database file is synced once for all keys
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e (only PersLldbPurpose_DB is supported)
+ * \param keys              [in] keys' names
+ * \param data              [in] buffers with the keys' data
+ * \param dataSizes         [in] sizes of the keys' data
+ * \param results_out       [out]per key: bytes written, or negative value in case of error
+ * \param count             [in] number of keys
+ *
+ * \return number of keys written, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_write_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* const* keys, str_t const* const* data,
+                            sint_t const* dataSizes, sint_t* results_out, sint_t count)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
 
-#if USE_FSYNC
-         fsync(pLldbHandler->kissDb.fd);
-#else
-         fdatasync(pLldbHandler->kissDb.fd);
-#endif
-      }
-      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
+   if (PersLldbPurpose_DB == ePurpose)
+   {
+      eErrorCode = AccessKeysInKissLocalDB(handlerDB, LldbKeysWrite, keys, NIL, data, dataSizes, results_out, count);
    }
+   return eErrorCode;
+}
 
-   if (bLocked)
+/**
+ * \brief delete several keys from database under one lock of the database
+ * \note : in write through mode the database file is synced once for all keys
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e (only PersLldbPurpose_DB is supported)
+ * \param keys              [in] keys' names
+ * \param results_out       [out]per key: 0 or bytes deleted for success, or negative value in case of error
+ * \param count             [in] number of keys
+ *
+ * \return number of keys deleted, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_delete_keys(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* const* keys, sint_t* results_out, sint_t count)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+
+   if (PersLldbPurpose_DB == ePurpose)
    {
-      KISSDB* db = &pLldbHandler->kissDb;
-      (void) lldb_handles_Unlock(&db->shared->mutex);
+      eErrorCode = AccessKeysInKissLocalDB(handlerDB, LldbKeysDelete, keys, NIL, NIL, NIL, results_out, count);
    }
+   return eErrorCode;
+}
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("handlerDB="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">, "); DLT_STRING("retval=<");
-           DLT_INT(bytesDeleted); DLT_STRING(">"));
+/**
+ * \brief call a function for every key-value pair in database, the database is locked during the iteration
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e (only PersLldbPurpose_DB is supported)
+ * \param prefix            [in] only keys starting with prefix are passed to the callback (NIL or "" for all keys)
+ * \param callback          [in] function called for every key-value pair
+ * \param ctx               [in] context passed to the callback
+ *
+ * \return number of key-value pairs passed to the callback, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_for_each(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* prefix, persComDbForEachCallback_t callback, void* ctx)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
 
-   return bytesDeleted;
+   if ((PersLldbPurpose_DB == ePurpose) && (NIL != callback))
+   {
+      eErrorCode = ForEachInKissLocalDB(handlerDB, prefix, callback, ctx);
+   }
+   return eErrorCode;
 }
 
-#if 0
-static sint_t DeleteDataFromKissRCT(sint_t dbHandler, pconststr_t key)
+/**
+ * \brief List one page of the keys' names in database, the pages are listed in the order of the keys' hashes
+ * \note : keys are separated by '\0'
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e
+ * \param cursor            [in] 0 for the first page, otherwise the cursor returned by the previous page
+ * \param listingBuffer_out [out]buffer where to return the page
+ * \param bufSize           [in] size of listingBuffer_out
+ * \param pNextCursor_out   [out]cursor of the next page, 0 after the last page
+ *
+ * \return size of the page, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_list_keys_page(sint_t handlerDB, pers_lldb_purpose_e ePurpose, unsigned long long cursor, pstr_t listingBuffer_out,
+                                sint_t bufSize, unsigned long long* pNextCursor_out)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+   uint64_t nextCursor = 0;
+
+   if (((PersLldbPurpose_DB == ePurpose) || (PersLldbPurpose_RCT == ePurpose)) && (NIL != listingBuffer_out) && (bufSize > 0)
+       && (NIL != pNextCursor_out) && (cursor <= ((unsigned long long) UINT32_MAX + 1)))
+   {
+      eErrorCode = ListKeysPageFromKissDB(handlerDB, ePurpose, (uint64_t) cursor, listingBuffer_out, bufSize, &nextCursor);
+      *pNextCursor_out = (unsigned long long) nextCursor;
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief start a transaction on a database: puts and deletes applied all together or not at all by pers_lldb_tx_commit
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e (only PersLldbPurpose_DB is supported)
+ *
+ * \return transaction id (positive value), or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_tx_begin(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+   lldb_handler_s* pLldbHandler = NIL;
+
+   if ((PersLldbPurpose_DB == ePurpose) && (handlerDB >= 0))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(handlerDB);
+      if ((NIL != pLldbHandler) && (PersLldbPurpose_DB == pLldbHandler->ePurpose))
+      {
+         if (KISSDB_OPEN_MODE_RDONLY == pLldbHandler->kissDb.shared->openMode)
+         {
+            eErrorCode = PERS_COM_ERR_READONLY;
+         }
+         else
+         {
+            eErrorCode = lldb_tx_begin(handlerDB);
+         }
+      }
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief add the write of a key-value pair to a transaction
+ *
+ * \param txId          [in] transaction id obtained with pers_lldb_tx_begin
+ * \param pKey          [in] key descriptor filled by pers_lldb_prepare_key
+ * \param data          [in] buffer with key's data, copied
+ * \param dataSize      [in] size of key's data
+ *
+ * \return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_tx_put(sint_t txId, persComDbKey_t const* pKey, str_t const* data, sint_t dataSize)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+
+   if (NIL != data)
+   {
+      eErrorCode = lldb_tx_add(txId, pKey, data, dataSize);
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief add the delete of a key to a transaction
+ *
+ * \param txId          [in] transaction id obtained with pers_lldb_tx_begin
+ * \param pKey          [in] key descriptor filled by pers_lldb_prepare_key
+ *
+ * \return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_tx_delete(sint_t txId, persComDbKey_t const* pKey)
+{
+   return lldb_tx_add(txId, pKey, NIL, 0);
+}
+
+/**
+ * \brief commit a transaction: its record is appended to the intent log of the database and synced, then the operations
+ *        are applied. The transaction is released in any case.
+ *
+ * \param txId          [in] transaction id obtained with pers_lldb_tx_begin
+ *
+ * \return number of operations of the transaction, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_tx_commit(sint_t txId)
+{
+   sint_t eErrorCode = CommitTxInKissLocalDB(txId);
+
+   lldb_tx_end(txId);
+   return eErrorCode;
+}
+
+/**
+ * \brief release a transaction without applying its operations
+ *
+ * \param txId          [in] transaction id obtained with pers_lldb_tx_begin
+ *
+ * \return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_tx_abort(sint_t txId)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+
+   if (lldb_tx_handler(txId) >= 0)
+   {
+      lldb_tx_end(txId);
+      eErrorCode = PERS_COM_SUCCESS;
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief write the data of the database to its file while the database stays open: in write cached mode the entries
+ *        of the cache modified since the previous sync are written back, then the hashtables are checkpointed to
+ *        the file and the file is synced
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e (only PersLldbPurpose_DB is supported)
+ *
+ * \return number of cache entries written back or deleted, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_sync(sint_t handlerDB, pers_lldb_purpose_e ePurpose)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+
+   if (PersLldbPurpose_DB == ePurpose)
+   {
+      eErrorCode = SyncKissLocalDB(handlerDB);
+   }
+   return eErrorCode;
+}
+
+/**
+ * \brief write a consistent copy of a database to destPath while the database stays open: the database is locked only
+ *        to write back the cache and to clone the file (reflink) or to copy it into memory
+ *
+ * \param handlerDB         [in] handler obtained with pers_lldb_open
+ * \param ePurpose          [in] see pers_lldb_purpose_e (only PersLldbPurpose_DB is supported)
+ * \param destPath          [in] path of the copy, replaced when the copy is complete
+ *
+ * \return 0 for success, or negative value in case of error (see pers_error_codes.h)
+ */
+sint_t pers_lldb_snapshot(sint_t handlerDB, pers_lldb_purpose_e ePurpose, str_t const* destPath)
+{
+   sint_t eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+
+   if ((PersLldbPurpose_DB == ePurpose) && (NIL != destPath))
+   {
+      eErrorCode = SnapshotKissLocalDB(handlerDB, destPath);
+   }
+   return eErrorCode;
+}
+
+static sint_t DeleteDataFromKissDB(sint_t dbHandler, persComDbKey_t const* pKey)
+{
+   bool_t bCanContinue = true;
+   bool_t bLocked = false;
+   lldb_handler_s* pLldbHandler = NIL;
+   sint_t bytesDeleted = PERS_COM_FAILURE;
+   LLDB_TRACE_START(traceStart);
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("handlerDB="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(pKey->key); DLT_STRING(">"));
+
+   if ((dbHandler >= 0) && (NIL != pKey))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+      if (NIL == pLldbHandler)
+      {
+         bCanContinue = false;
+      }
+   }
+   else
+   {
+      bCanContinue = false;
+   }
+
+   if (bCanContinue)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      lldb_async_drain(); //keep the order of the asynchronous writes
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
+      {
+         bLocked = true;
+      }
+
+      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+      bytesDeleted = deleteKeyLocked(db, pKey);
+      if ( KISSDB_WRITE_MODE_WC != pLldbHandler->kissDb.shared->writeMode)
+      {
+         syncDatabaseFile(db);
+      }
+      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+   }
+
+   if (bLocked)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
+   }
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("handlerDB="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("retval=<");
+           DLT_INT(bytesDeleted); DLT_STRING(">"));
+
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_DELETE, dbHandler, (NIL != pKey) ? pKey->cacheHash : 0, bytesDeleted, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_DELETE, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, (NIL != pKey) ? pKey->key : NIL, bytesDeleted, traceStart);
+   return bytesDeleted;
+}
+
+#if 0
+static sint_t DeleteDataFromKissRCT(sint_t dbHandler, pconststr_t key)
 {
    bool_t bCanContinue = true;
    bool_t bLocked = false;
@@ -1075,12 +1647,12 @@ static sint_t DeleteDataFromKissRCT(sint_t dbHandler, pconststr_t key)
    if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      if (lldb_handles_Lock(&db->shared->mutex))
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
       {
          bLocked = true;
       }
 
-      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
+      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
       if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
       {
          bytesDeleted = deleteFromCache(&pLldbHandler->kissDb, (char*) key);
@@ -1110,13 +1682,13 @@ static sint_t DeleteDataFromKissRCT(sint_t dbHandler, pconststr_t key)
          fdatasync(pLldbHandler->kissDb.fd);
 #endif
       }
-      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
+      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
    }
 
    if (bLocked)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      (void) lldb_handles_Unlock(&db->shared->mutex);
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
    }
 
    DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
@@ -1131,11 +1703,11 @@ static sint_t GetAllKeysFromKissLocalDB(sint_t dbHandler, pstr_t buffer, sint_t
 {
    bool_t bCanContinue = true;
    bool_t bLocked = false;
-   bool_t bOnlySizeNeeded = (NIL == buffer);
    lldb_handler_s* pLldbHandler = NIL;
    sint_t result = 0;
+   LLDB_TRACE_START(traceStart);
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
    DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("buffer="); DLT_UINT((uint_t)buffer); DLT_STRING("size="); DLT_INT(size));
 
    if (dbHandler >= 0)
@@ -1166,7 +1738,8 @@ static sint_t GetAllKeysFromKissLocalDB(sint_t dbHandler, pstr_t buffer, sint_t
    if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      if (lldb_handles_Lock(&db->shared->mutex))
+      lldb_async_drain(); //keep the order of the asynchronous writes
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
       {
          bLocked = true;
       }
@@ -1176,9 +1749,9 @@ static sint_t GetAllKeysFromKissLocalDB(sint_t dbHandler, pstr_t buffer, sint_t
          (void) memset(buffer, 0, (size_t) size);
       }
 
-      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
-      result = getListandSize(&pLldbHandler->kissDb, buffer, size, bOnlySizeNeeded, PersLldbPurpose_DB);
-      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
+      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+      result = keyDirList(&pLldbHandler->kissDb, buffer, size);
+      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
       if (result < 0)
       {
          result = PERS_COM_FAILURE;
@@ -1187,24 +1760,26 @@ static sint_t GetAllKeysFromKissLocalDB(sint_t dbHandler, pstr_t buffer, sint_t
    if (bLocked)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      (void) lldb_handles_Unlock(&db->shared->mutex);
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
    }
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
    DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_LIST, dbHandler, 0, result, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_LIST, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, NIL, result, traceStart);
    return result;
 }
 
-static sint_t GetAllKeysFromKissRCT(sint_t dbHandler, pstr_t buffer, sint_t size)
+static sint_t ForEachInKissLocalDB(sint_t dbHandler, pconststr_t prefix, persComDbForEachCallback_t callback, void* ctx)
 {
    bool_t bCanContinue = true;
    bool_t bLocked = false;
-   bool_t bOnlySizeNeeded = (NIL == buffer);
    lldb_handler_s* pLldbHandler = NIL;
    sint_t result = 0;
+   LLDB_TRACE_START(traceStart);
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("buffer="); DLT_UINT((uint_t)buffer); DLT_STRING("size="); DLT_INT(size));
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("prefix="); DLT_STRING((NIL != prefix) ? prefix : ""));
 
    if (dbHandler >= 0)
    {
@@ -1214,15 +1789,10 @@ static sint_t GetAllKeysFromKissRCT(sint_t dbHandler, pstr_t buffer, sint_t size
          bCanContinue = false;
          result = PERS_COM_ERR_INVALID_PARAM;
       }
-      else
+      else if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
       {
-         if (PersLldbPurpose_RCT != pLldbHandler->ePurpose)
-         {
-            /* this would be very bad */
-            bCanContinue = false;
-            result = PERS_COM_FAILURE;
-         }
-         /* to not use DLT while mutex locked */
+         bCanContinue = false;
+         result = PERS_COM_FAILURE;
       }
    }
    else
@@ -1234,375 +1804,444 @@ static sint_t GetAllKeysFromKissRCT(sint_t dbHandler, pstr_t buffer, sint_t size
    if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      if (lldb_handles_Lock(&db->shared->mutex))
+      lldb_async_drain(); //keep the order of the asynchronous writes
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
       {
          bLocked = true;
       }
 
-      if ((buffer != NIL) && (size > 0))
-      {
-         (void) memset(buffer, 0, (size_t) size);
-      }
-      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
-      result = getListandSize(&pLldbHandler->kissDb, buffer, size, bOnlySizeNeeded, PersLldbPurpose_RCT);
-      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
-      if (result < 0)
-      {
-         result = PERS_COM_FAILURE;
-      }
+      Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);
+      result = forEachLocked(db, (NIL != prefix) ? prefix : "", true, callback, ctx);
+      Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
    }
    if (bLocked)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      (void) lldb_handles_Unlock(&db->shared->mutex);
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
    }
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
    DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
-
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_LIST, dbHandler, 0, result, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_LIST, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, prefix, result, traceStart);
    return result;
 }
 
-static sint_t SetDataInKissLocalDB(sint_t dbHandler, pconststr_t key, pconststr_t data, sint_t dataSize)
+static sint_t ListKeysPageFromKissDB(sint_t dbHandler, pers_lldb_purpose_e ePurpose, uint64_t cursor, pstr_t buffer, sint_t size, uint64_t* pNextCursor)
 {
    bool_t bCanContinue = true;
    bool_t bLocked = false;
-   Data_Cached_s dataCached = { 0 };
-   int kdbState = 0;
    lldb_handler_s* pLldbHandler = NIL;
-   sint_t bytesWritten = PERS_COM_FAILURE;
-
+   sint_t result = 0;
+   LLDB_TRACE_START(traceStart);
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">, "); DLT_STRING("size<");
-           DLT_INT(dataSize); DLT_STRING(">"));
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("cursor="); DLT_UINT64(cursor); DLT_STRING("size="); DLT_INT(size));
 
-   if ((dbHandler >= 0) && (NIL != key) && (NIL != data) && (dataSize > 0))
+   *pNextCursor = 0;
+   if (dbHandler >= 0)
    {
       pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
       if (NIL == pLldbHandler)
       {
          bCanContinue = false;
-         bytesWritten = PERS_COM_ERR_INVALID_PARAM;
+         result = PERS_COM_ERR_INVALID_PARAM;
       }
-      else
+      else if (ePurpose != pLldbHandler->ePurpose)
       {
-         if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
-         {
-            /* this would be very bad */
-            bCanContinue = false;
-            bytesWritten = PERS_COM_FAILURE;
-         }
+         bCanContinue = false;
+         result = PERS_COM_FAILURE;
       }
    }
    else
    {
       bCanContinue = false;
-      bytesWritten = PERS_COM_ERR_INVALID_PARAM;
+      result = PERS_COM_ERR_INVALID_PARAM;
    }
 
    if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      if (lldb_handles_Lock(&db->shared->mutex))
+      lldb_async_drain(); //keep the order of the asynchronous writes
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
       {
          bLocked = true;
       }
+      (void) memset(buffer, 0, (size_t) size);
 
-      char* metaKey = (char*) key;
-      dataCached.eFlag = CachedDataWrite;
-      dataCached.m_dataSize = dataSize;
-      (void) memcpy(dataCached.m_data, data, (size_t) dataSize);
-
-      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
-      if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
-      {
-         bytesWritten = putToCache(&pLldbHandler->kissDb, dataSize, (char*) metaKey, &dataCached);
-      }
-      else
-      {
-         if (KISSDB_OPEN_MODE_RDONLY != pLldbHandler->kissDb.shared->openMode)
-         {
-            kdbState = KISSDB_put(&pLldbHandler->kissDb, metaKey, dataCached.m_data, dataCached.m_dataSize, &bytesWritten);
-            if (kdbState != 0)
-            {
-               DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
-                     DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_put: key=<"); DLT_STRING(metaKey); DLT_STRING(">, "); DLT_STRING("WriteThrough to file failed with retval=<"); DLT_INT(bytesWritten); DLT_STRING(">"));
-            }
-
-#if USE_FSYNC
-            fsync(pLldbHandler->kissDb.fd);
-#else
-            fdatasync(pLldbHandler->kissDb.fd);
-#endif
-         }
-      }
-      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
+      Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);
+      result = keyDirListPage(db, cursor, buffer, size, pNextCursor);
+      Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
    }
-
    if (bLocked)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      (void) lldb_handles_Unlock(&db->shared->mutex);
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
    }
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">, "); DLT_STRING("size<");
-           DLT_INT(dataSize); DLT_STRING(">, "); DLT_STRING("retval=<"); DLT_INT(bytesWritten); DLT_STRING(">"));
-
-   return bytesWritten;
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_LIST, dbHandler, 0, result, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_LIST, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, NIL, result, traceStart);
+   return result;
 }
 
-static sint_t SetDataInKissRCT(sint_t dbHandler, pconststr_t key, PersistenceConfigurationKey_s const* pConfig)
+static sint_t CommitTxInKissLocalDB(sint_t txId)
 {
    bool_t bCanContinue = true;
    bool_t bLocked = false;
-   Data_Cached_RCT_s dataCached = { 0 };
-   int kdbState = 0;
    lldb_handler_s* pLldbHandler = NIL;
-   sint_t bytesWritten = PERS_COM_FAILURE;
+   lldb_tx_apply_ctx_s sApplyCtx = { NIL, NIL, NIL };
+   sint_t dbHandler = lldb_tx_handler(txId);
+   sint_t result = PERS_COM_FAILURE;
+   uint64_t seq = 0;
+   LLDB_TRACE_START(traceStart);
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">"));
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("txId="); DLT_INT(txId); DLT_STRING("dbHandler="); DLT_INT(dbHandler));
 
-   if ((dbHandler >= 0) && (NIL != key) && (NIL != pConfig))
+   if (dbHandler >= 0)
    {
       pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
-      if (NIL == pLldbHandler)
+      if (NIL == pLldbHandler) //database closed before the commit
       {
          bCanContinue = false;
-         bytesWritten = PERS_COM_ERR_INVALID_PARAM;
+         result = PERS_COM_ERR_INVALID_PARAM;
       }
       else
       {
-         if (PersLldbPurpose_RCT != pLldbHandler->ePurpose)
+         //write cached: entry of the cache, both modes: previous values of the keys
+         sApplyCtx.pDataCached = (Data_Cached_s*) malloc(sizeof(Data_Cached_s));
+         if (NIL == sApplyCtx.pDataCached)
          {
-            /* this would be very bad */
             bCanContinue = false;
-            bytesWritten = PERS_COM_FAILURE;
+            result = PERS_COM_ERR_MALLOC;
          }
-         /* to not use DLT while mutex locked */
       }
    }
    else
    {
       bCanContinue = false;
-      bytesWritten = PERS_COM_ERR_INVALID_PARAM;
+      result = PERS_COM_ERR_INVALID_PARAM;
    }
+
    if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      if (lldb_handles_Lock(&db->shared->mutex))
+      lldb_async_drain(); //keep the order of the asynchronous writes
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
       {
          bLocked = true;
       }
 
-      int dataSize = sizeof(PersistenceConfigurationKey_s);
-      char* metaKey = (char*) key;
-      dataCached.eFlag = CachedDataWrite;
-      dataCached.m_dataSize = dataSize;
-      (void) memcpy(dataCached.m_data, pConfig, (size_t) dataSize);
-
-
-      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
-      if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
-      {
-         bytesWritten = putToCache(&pLldbHandler->kissDb, dataSize, (char*) metaKey, &dataCached);
-      }
-      else
+      Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);
+      seq = db->shared->txLastSeq + 1;
+      result = lldb_tx_write_log(txId, pLldbHandler->dbPathname, seq);
+      if (PERS_COM_SUCCESS == result)
       {
-
-         if (KISSDB_OPEN_MODE_RDONLY != pLldbHandler->kissDb.shared->openMode)
+         //commit point: after a crash the first open applies the record to the database file
+         db->shared->txLastSeq = seq;
+         sApplyCtx.db = db;
+         result = lldb_tx_apply(txId, applyTxOp, &sApplyCtx);
+         if (result < 0)
          {
-            kdbState = KISSDB_put(&pLldbHandler->kissDb, metaKey, dataCached.m_data, dataCached.m_dataSize, &bytesWritten);
-            if (kdbState != 0)
+            //a failed commit changes nothing: the operations already applied are undone and the record leaves the log
+            if (undoTxOps(&sApplyCtx) && (PERS_COM_SUCCESS == lldb_tx_drop_log(txId, pLldbHandler->dbPathname)))
             {
+               db->shared->txLastSeq = seq - 1;
+            }
+            else
+            {
+               //the record stays the committed state of the keys, the next first open applies it completely
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
-                     DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_put: RCT key=<"); DLT_STRING(metaKey); DLT_STRING(">, "); DLT_STRING("WriteThrough to file failed with retval=<"); DLT_INT(bytesWritten); DLT_STRING(">"));
+                       DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("<"); DLT_STRING(pLldbHandler->dbPathname); DLT_STRING(">, ");
+                       DLT_STRING("transaction seq="); DLT_UINT64(seq); DLT_STRING(" neither applied nor undone, retval=<"); DLT_INT(result); DLT_STRING(">, replayed by the next open"));
+               if (0 == db->shared->txReplaySeq)
+               {
+                  db->shared->txReplaySeq = seq;
+               }
+               result = lldb_tx_count(txId);
             }
-
-#if USE_FSYNC
-            fsync(pLldbHandler->kissDb.fd);
-#else
-            fdatasync(pLldbHandler->kissDb.fd);
-#endif
          }
-      }
-      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
-
+         freeTxUndo(&sApplyCtx);
+         if ((result >= 0) && (KISSDB_WRITE_MODE_WC != db->shared->writeMode))
+         {
+            //write through: one sync of the database file for all the operations, then the record is not needed anymore
+            markTxApplied(db, pLldbHandler->dbPathname);
+         }
+         else if ((result >= 0) && (lldb_tx_log_size(txId) >= PERS_LLDB_TXLOG_MAX_SIZE))
+         {
+            //write cached: the records are kept until the cache is written back, by a sync, the last close, or here
+            //when the log has grown too long. A failed write back keeps the log, the next commit retries
+            (void) syncLocked(db, pLldbHandler->dbPathname);
+         }
+      }
+      Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
    }
    if (bLocked)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      (void) lldb_handles_Unlock(&db->shared->mutex);
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
    }
+   free(sApplyCtx.pDataCached);
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">, "); DLT_STRING("retval=<");
-           DLT_INT(bytesWritten); DLT_STRING(">"));
-
-   return bytesWritten;
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("txId="); DLT_INT(txId); DLT_STRING("seq="); DLT_UINT64(seq); DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_COMMIT, dbHandler, 0, result, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_COMMIT, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, NIL, result, traceStart);
+   return result;
 }
 
-static sint_t GetKeySizeFromKissLocalDB(sint_t dbHandler, pconststr_t key)
+static sint_t SyncKissLocalDB(sint_t dbHandler)
 {
    bool_t bCanContinue = true;
    bool_t bLocked = false;
    lldb_handler_s* pLldbHandler = NIL;
-   sint_t bytesRead = PERS_COM_FAILURE;
+   sint_t result = PERS_COM_SUCCESS;
+   LLDB_TRACE_START(traceStart);
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">"));
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler));
 
-   if ((dbHandler >= 0) && (NIL != key))
+   if (dbHandler >= 0)
    {
-      bLocked = true;
       pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
       if (NIL == pLldbHandler)
       {
          bCanContinue = false;
-         bytesRead = PERS_COM_ERR_INVALID_PARAM;
+         result = PERS_COM_ERR_INVALID_PARAM;
       }
-      else
+      else if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
       {
-         if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
-         {
-            /* this would be very bad */
-            bCanContinue = false;
-            bytesRead = PERS_COM_FAILURE;
-         }
+         bCanContinue = false;
+         result = PERS_COM_FAILURE;
+      }
+      else if (KISSDB_OPEN_MODE_RDONLY == pLldbHandler->kissDb.shared->openMode)
+      {
+         bCanContinue = false; //nothing can have been written
       }
    }
    else
    {
       bCanContinue = false;
-      bytesRead = PERS_COM_ERR_INVALID_PARAM;
+      result = PERS_COM_ERR_INVALID_PARAM;
    }
+
    if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      if (lldb_handles_Lock(&db->shared->mutex))
+      lldb_async_drain(); //the asynchronous writes requested before the sync are synced too
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
       {
          bLocked = true;
       }
 
-      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
-      if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
-      {
-         bytesRead = getFromCache(&pLldbHandler->kissDb, (char*) key, NULL, 0, true);
-         if (bytesRead == PERS_STATUS_KEY_NOT_IN_CACHE)
-         {
-            bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, NULL, 0);
-         }
-      }
-      else
-      {
-         bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, NULL, 0);
-      }
-      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
+      Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);
+      result = syncLocked(db, pLldbHandler->dbPathname);
+      Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
    }
    if (bLocked)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      (void) lldb_handles_Unlock(&db->shared->mutex);
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
    }
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">, "); DLT_STRING("retval=<");
-           DLT_INT(bytesRead); DLT_STRING(">"));
 
-   return bytesRead;
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_SYNC, dbHandler, 0, result, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_SYNC, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, NIL, result, traceStart);
+   return result;
 }
 
-/* return no of bytes read, or negative value in case of error */
-static sint_t GetDataFromKissLocalDB(sint_t dbHandler, pconststr_t key, pstr_t buffer_out, sint_t bufSize)
+static sint_t SnapshotKissLocalDB(sint_t dbHandler, str_t const* destPath)
 {
    bool_t bCanContinue = true;
    bool_t bLocked = false;
+   bool_t bCloned = false;
+   int kdbState = 0;
    lldb_handler_s* pLldbHandler = NIL;
-   sint_t bytesRead = PERS_COM_FAILURE;
+   sint_t destFd = -1;
+   sint_t result = PERS_COM_SUCCESS;
+   size_t imageCapacity = 0;
+   size_t imageSize = 0;
+   void* image = NIL;
+   void* newImage = NIL;
+   Header_s header;
+   LLDB_TRACE_START(traceStart);
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("destPath="); DLT_STRING(destPath));
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">, "); DLT_STRING("bufsize=<");
-           DLT_INT(bufSize); DLT_STRING(">"));
-
-   if ((dbHandler >= 0) && (NIL != key) && (NIL != buffer_out) && (bufSize > 0))
+   if (dbHandler >= 0)
    {
       pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
       if (NIL == pLldbHandler)
       {
          bCanContinue = false;
-         bytesRead = PERS_COM_ERR_INVALID_PARAM;
+         result = PERS_COM_ERR_INVALID_PARAM;
+      }
+      else if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
+      {
+         bCanContinue = false;
+         result = PERS_COM_FAILURE;
+      }
+      else if (0 == strcmp(destPath, pLldbHandler->dbPathname))
+      {
+         bCanContinue = false;
+         result = PERS_COM_ERR_INVALID_PARAM;
       }
       else
       {
-         if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
+         destFd = lldb_snapshot_open(destPath);
+         if (destFd < 0)
          {
-            /* this would be very bad */
             bCanContinue = false;
-            bytesRead = PERS_COM_FAILURE;
+            result = destFd;
          }
-         /* to not use DLT while mutex locked */
       }
    }
    else
    {
       bCanContinue = false;
-      bytesRead = PERS_COM_ERR_INVALID_PARAM;
+      result = PERS_COM_ERR_INVALID_PARAM;
    }
 
    if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      if (lldb_handles_Lock(&db->shared->mutex))
+      //without reflinks the file is copied into memory while the database is locked: the memory is mapped before,
+      //so the lock is held for the copy only. The file is cloned again below
+      if (!lldb_snapshot_clone(destFd, db->fd))
+      {
+         imageCapacity = (size_t) db->shared->mappedDbSize; //not locked: only the expected size
+         image = lldb_snapshot_image_map(imageCapacity);
+         if (NIL == image)
+         {
+            imageCapacity = 0;
+         }
+      }
+      lldb_async_drain(); //the asynchronous writes requested before the snapshot are in the copy
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
       {
          bLocked = true;
       }
 
-      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
-      if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
+      Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);
+      if (KISSDB_OPEN_MODE_RDONLY != db->shared->openMode)
       {
-         bytesRead = getFromCache(&pLldbHandler->kissDb, (char*) key, buffer_out, bufSize, false);
-         //if key is not already in cache
-         if (bytesRead == PERS_STATUS_KEY_NOT_IN_CACHE)
+         //the point in time of the copy: the cache is written back (not synced), then the file is complete
+         if (KISSDB_WRITE_MODE_WC == db->shared->writeMode)
+         {
+            result = syncCacheLocked(db);
+         }
+         if (result >= 0)
+         {
+            kdbState = KISSDB_checkpoint(db);
+            if (kdbState != 0)
+            {
+               DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                       DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_checkpoint: <"); DLT_STRING(pLldbHandler->dbPathname); DLT_STRING(">, ");
+                       DLT_STRING("failed with retval=<"); DLT_INT(kdbState); DLT_STRING(">"));
+               result = PERS_COM_FAILURE;
+            }
+         }
+      }
+      else
+      {
+         //nothing to write back, but another process may have grown the file since this instance mapped it
+         kdbState = KISSDB_remap(db);
+         if (kdbState != 0)
          {
-            bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, buffer_out, bufSize);
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                    DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_remap: <"); DLT_STRING(pLldbHandler->dbPathname); DLT_STRING(">, ");
+                    DLT_STRING("failed with retval=<"); DLT_INT(kdbState); DLT_STRING(">"));
+            result = PERS_COM_FAILURE;
          }
       }
-      else //write through mode -> only read from file
+      if ((result >= 0) && (0 != db->shared->txReplaySeq))
       {
-         bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, buffer_out, bufSize);
+         result = PERS_COM_FAILURE; //a transaction is only completely in the database after the replay of the next first open
+      }
+      if (result >= 0)
+      {
+         //the copy is closed correctly and contains all the committed transactions, it has no intent log
+         (void) memcpy(&header, db->mappedDb, sizeof(header));
+         header.closeFailed = 0x00;
+         header.closeOk = 0x01;
+         if (db->shared->txLastSeq > header.txApplied)
+         {
+            header.txApplied = db->shared->txLastSeq;
+         }
+         bCloned = (0 == imageCapacity) && lldb_snapshot_clone(destFd, db->fd);
+         if (!bCloned)
+         {
+            imageSize = (size_t) db->dbMappedSize;
+            if (imageSize > imageCapacity) //the file grew meanwhile
+            {
+               newImage = lldb_snapshot_image_remap(image, imageCapacity, imageSize);
+               if (NIL != newImage)
+               {
+                  image = newImage;
+                  imageCapacity = imageSize;
+               }
+            }
+            if (imageSize <= imageCapacity)
+            {
+               (void) memcpy(image, db->mappedDb, imageSize);
+            }
+            else
+            {
+               result = PERS_COM_ERR_MALLOC;
+            }
+         }
       }
-      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
+      Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
    }
    if (bLocked)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      (void) lldb_handles_Unlock(&db->shared->mutex);
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
    }
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">, "); DLT_STRING("bufsize=<");
-           DLT_INT(bufSize); DLT_STRING(">, "); DLT_STRING("retval=<"); DLT_INT(bytesRead); DLT_STRING(">"));
-   return bytesRead;
+   if (destFd >= 0)
+   {
+      if (result >= 0)
+      {
+         //the writers continue while the copy is written and synced
+         result = lldb_snapshot_close(destFd, destPath, image, imageSize, &header, sizeof(header));
+      }
+      else
+      {
+         lldb_snapshot_abort(destFd, destPath);
+      }
+   }
+   lldb_snapshot_image_unmap(image, imageCapacity);
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("cloned="); DLT_INT(bCloned); DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_SNAPSHOT, dbHandler, 0, result, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_SNAPSHOT, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, NIL, result, traceStart);
+   return (result >= 0) ? PERS_COM_SUCCESS : result;
 }
 
-static sint_t GetDataFromKissRCT(sint_t dbHandler, pconststr_t key, PersistenceConfigurationKey_s* pConfig)
+static sint_t GetAllKeysFromKissRCT(sint_t dbHandler, pstr_t buffer, sint_t size)
 {
    bool_t bCanContinue = true;
    bool_t bLocked = false;
    lldb_handler_s* pLldbHandler = NIL;
-   sint_t bytesRead = PERS_COM_FAILURE;
+   sint_t result = 0;
+   LLDB_TRACE_START(traceStart);
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">"));
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("buffer="); DLT_UINT((uint_t)buffer); DLT_STRING("size="); DLT_INT(size));
 
-   if ((dbHandler >= 0) && (NIL != key) && (NIL != pConfig))
+   if (dbHandler >= 0)
    {
       pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
       if (NIL == pLldbHandler)
       {
          bCanContinue = false;
-         bytesRead = PERS_COM_ERR_INVALID_PARAM;
+         result = PERS_COM_ERR_INVALID_PARAM;
       }
       else
       {
@@ -1610,7 +2249,7 @@ static sint_t GetDataFromKissRCT(sint_t dbHandler, pconststr_t key, PersistenceC
          {
             /* this would be very bad */
             bCanContinue = false;
-            bytesRead = PERS_COM_FAILURE;
+            result = PERS_COM_FAILURE;
          }
          /* to not use DLT while mutex locked */
       }
@@ -1618,323 +2257,904 @@ static sint_t GetDataFromKissRCT(sint_t dbHandler, pconststr_t key, PersistenceC
    else
    {
       bCanContinue = false;
-      bytesRead = PERS_COM_ERR_INVALID_PARAM;
+      result = PERS_COM_ERR_INVALID_PARAM;
    }
 
-   //read RCT
    if (bCanContinue)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      if (lldb_handles_Lock(&db->shared->mutex))
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
       {
          bLocked = true;
       }
 
-      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock);
-      if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
+      if ((buffer != NIL) && (size > 0))
       {
-         bytesRead = getFromCache(&pLldbHandler->kissDb, (char*) key, pConfig, sizeof(PersistenceConfigurationKey_s), false);
-         if (bytesRead == PERS_STATUS_KEY_NOT_IN_CACHE)
-         {
-            bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, pConfig, sizeof(PersistenceConfigurationKey_s));
-         }
+         (void) memset(buffer, 0, (size_t) size);
       }
-      else
+      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+      result = keyDirList(&pLldbHandler->kissDb, buffer, size);
+      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+      if (result < 0)
       {
-         bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, (char*) key, pConfig, sizeof(PersistenceConfigurationKey_s));
+         result = PERS_COM_FAILURE;
       }
-      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock);
    }
    if (bLocked)
    {
       KISSDB* db = &pLldbHandler->kissDb;
-      (void) lldb_handles_Unlock(&db->shared->mutex);
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
    }
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING(">, "); DLT_STRING("retval=<");
-           DLT_INT(bytesRead); DLT_STRING(">"));
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+   DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("retval=<"); DLT_INT(result); DLT_STRING(">"));
 
-   return bytesRead;
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_LIST, dbHandler, 0, result, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_LIST, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, NIL, result, traceStart);
+   return result;
 }
 
-static bool_t lldb_handles_InitLock(pthread_mutex_t *mutex)
+static sint_t SetDataInKissLocalDB(sint_t dbHandler, persComDbKey_t const* pKey, pconststr_t data, sint_t dataSize)
 {
-   bool_t bEverythingOK = true;
-   pthread_mutexattr_t mattr;
-
-   pthread_mutexattr_init(&mattr);
-   pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST);
-   pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
-   sint_t siErr = pthread_mutex_init(mutex, &mattr);
-   if (0 != siErr)
-   {
-      bEverythingOK = false;
-      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
-              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("pthread_mutex_init failed with error=<"); DLT_INT(siErr); DLT_STRING(">"));
-   }
-
-   pthread_mutexattr_destroy(&mattr);
-
-   return bEverythingOK;
-}
+   bool_t bCanContinue = true;
+   bool_t bLocked = false;
+   Data_Cached_s dataCached = { 0 };
+   lldb_handler_s* pLldbHandler = NIL;
+   sint_t bytesWritten = PERS_COM_FAILURE;
+   LLDB_TRACE_START(traceStart);
 
-static bool_t lldb_handles_Lock(pthread_mutex_t *mutex)
-{
-   bool_t bEverythingOK = true;
 
-   sint_t siErr = pthread_mutex_lock(mutex);
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("size<");
+           DLT_INT(dataSize); DLT_STRING(">"));
 
-   if (0 != siErr)
+   if ((dbHandler >= 0) && (NIL != pKey) && (NIL != data) && (dataSize > 0))
    {
-      if (EOWNERDEAD == siErr)
+      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+      if (NIL == pLldbHandler)
       {
-         sint_t siErr = pthread_mutex_consistent(mutex);
-         if (0 != siErr)
-         {
-            bEverythingOK = false;
-            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
-                    DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("pthread_mutex_consistent failed with error=<"); DLT_INT(siErr); DLT_STRING(">"));
-         }
+         bCanContinue = false;
+         bytesWritten = PERS_COM_ERR_INVALID_PARAM;
       }
       else
       {
-         bEverythingOK = false;
-         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
-                 DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("pthread_mutex_lock failed with error=<"); DLT_INT(siErr); DLT_STRING(">"));
+         if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
+         {
+            /* this would be very bad */
+            bCanContinue = false;
+            bytesWritten = PERS_COM_FAILURE;
+         }
       }
    }
+   else
+   {
+      bCanContinue = false;
+      bytesWritten = PERS_COM_ERR_INVALID_PARAM;
+   }
 
-   return bEverythingOK;
-}
+   if (bCanContinue)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      lldb_async_drain(); //keep the order of the asynchronous writes
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
+      {
+         bLocked = true;
+      }
 
-static bool_t lldb_handles_Unlock(pthread_mutex_t *mutex)
-{
-   bool_t bEverythingOK = true;
+      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+      bytesWritten = writeKeyLocked(db, pKey, data, dataSize, &dataCached);
+      if (   (KISSDB_WRITE_MODE_WC != pLldbHandler->kissDb.shared->writeMode)
+          && (KISSDB_OPEN_MODE_RDONLY != pLldbHandler->kissDb.shared->openMode))
+      {
+         syncDatabaseFile(db);
+      }
+      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+   }
 
-   sint_t siErr = pthread_mutex_unlock(mutex);
-   if (0 != siErr)
+   if (bLocked)
    {
-      bEverythingOK = false;
-      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
-              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("pthread_mutex_unlock failed with error=<"); DLT_INT(siErr); DLT_STRING(">"));
+      KISSDB* db = &pLldbHandler->kissDb;
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
    }
 
-   return bEverythingOK;
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("size<");
+           DLT_INT(dataSize); DLT_STRING(">, "); DLT_STRING("retval=<"); DLT_INT(bytesWritten); DLT_STRING(">"));
+
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_WRITE, dbHandler, (NIL != pKey) ? pKey->cacheHash : 0, bytesWritten, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_WRITE, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, (NIL != pKey) ? pKey->key : NIL, bytesWritten, traceStart);
+   return bytesWritten;
 }
 
-/* it is assumed dbHandler is checked by the caller */
-static lldb_handler_s* lldb_handles_FindInUseHandle(sint_t dbHandler)
+/* check the parameters of one key of AccessKeysInKissLocalDB and prepare the key */
+static sint_t prepareKeyAccess(lldb_keys_op_e eOp, str_t const* key, pstr_t const* dataBuffers, str_t const* const* data,
+                               sint_t const* sizes, sint_t i, persComDbKey_t* pKey_out)
 {
-   lldb_handler_s* pHandler = NIL;
+   sint_t eErrorCode = PERS_COM_SUCCESS;
 
-   if (dbHandler <= PERS_LLDB_MAX_STATIC_HANDLES)
+   if (NIL == key)
+   {
+      eErrorCode = PERS_COM_ERR_INVALID_PARAM;
+   }
+   else if (LldbKeysRead == eOp)
    {
-      if (g_sHandlers.asStaticHandles[dbHandler].bIsAssigned)
+      if ((NIL == dataBuffers[i]) || (sizes[i] <= 0))
       {
-         pHandler = &g_sHandlers.asStaticHandles[dbHandler];
+         eErrorCode = PERS_COM_ERR_INVALID_PARAM;
       }
    }
-   else
+   else if (LldbKeysWrite == eOp)
    {
-      lldb_handles_list_el_s* pListElemCurrent = g_sHandlers.pListHead;
-      while (NIL != pListElemCurrent)
+      if ((NIL == data[i]) || (sizes[i] <= 0) || (sizes[i] > PERS_DB_MAX_SIZE_KEY_DATA))
       {
-         if (dbHandler == pListElemCurrent->sHandle.dbHandler)
-         {
-            pHandler = &pListElemCurrent->sHandle;
-            break;
-         }
-         pListElemCurrent = pListElemCurrent->pNext;
+         eErrorCode = PERS_COM_ERR_INVALID_PARAM;
       }
    }
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING((NIL!=pHandler) ? "Found handler <" : "ERROR can't find handler <"); DLT_INT(dbHandler); DLT_STRING(">");
-           DLT_STRING((NIL!=pHandler) ? (dbHandler <= PERS_LLDB_MAX_STATIC_HANDLES ? "in static area" : "in dynamic list") : ""));
-
-   return pHandler;
-}
-
-static lldb_handler_s* lldb_handles_FindAvailableHandle(void)
-{
-   bool_t bCanContinue = true;
-   lldb_handler_s* pHandler = NIL;
-   lldb_handles_list_el_s* psListElemNew = NIL;
-
-   /* first try to find an available handle in the static area */
-   sint_t siIndex = 0;
-   for (siIndex = 0; siIndex <= PERS_LLDB_MAX_STATIC_HANDLES; siIndex++)
+   if (PERS_COM_SUCCESS == eErrorCode)
    {
-      if (!g_sHandlers.asStaticHandles[siIndex].bIsAssigned)
+      initKey(pKey_out, key);
+      if (pKey_out->length >= PERS_DB_MAX_LENGTH_KEY_NAME)
       {
-         //INITIALIZE KISSDB struct
-         /* index setting should be done only once at the initialization of the static array
-          * Anyway, doing it here is more consistent  */
-         g_sHandlers.asStaticHandles[siIndex].dbHandler = siIndex;
-         pHandler = &g_sHandlers.asStaticHandles[siIndex];
-         break;
+         eErrorCode = PERS_COM_ERR_INVALID_PARAM;
       }
    }
+   return eErrorCode;
+}
 
-   if (NIL == pHandler)
+/* read, write or delete count keys with one lock of the database.
+ * returns the number of keys accessed successfully, or negative value in case of error */
+static sint_t AccessKeysInKissLocalDB(sint_t dbHandler, lldb_keys_op_e eOp, str_t const* const* keys, pstr_t const* dataBuffers,
+                                      str_t const* const* data, sint_t const* sizes, sint_t* results_out, sint_t count)
+{
+   bool_t bCanContinue = true;
+   bool_t bLocked = false;
+   bool_t bSync = false;
+   lldb_handler_s* pLldbHandler = NIL;
+   persComDbKey_t* pKeys = NIL;
+   Data_Cached_s* pDataCached = NIL;
+   sint_t keysAccessed = PERS_COM_FAILURE;
+   sint_t i = 0;
+   LLDB_TRACE_START(traceStart);
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("op="); DLT_INT(eOp); DLT_STRING("count=");
+           DLT_INT(count));
+
+   if (   (dbHandler >= 0) && (NIL != keys) && (NIL != results_out) && (count >= 0)
+       && ((LldbKeysRead != eOp) || ((NIL != dataBuffers) && (NIL != sizes)))
+       && ((LldbKeysWrite != eOp) || ((NIL != data) && (NIL != sizes))))
    {
-      /* no position available in the static array => we have to use the list
-       * allocate memory for the new element and process the situation when the list is headless */
-
-      psListElemNew = (lldb_handles_list_el_s*) malloc(sizeof(lldb_handles_list_el_s));
-      memset(psListElemNew, 0, sizeof(lldb_handles_list_el_s));
-      if (NIL == psListElemNew)
+      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+      if (NIL == pLldbHandler)
       {
          bCanContinue = false;
-         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("malloc failed"));
+         keysAccessed = PERS_COM_ERR_INVALID_PARAM;
       }
-      else
+      else if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
       {
-         if (NIL == g_sHandlers.pListHead)
-         {
-            /* the list not yet used/created, so use the new created element as the head */
-            g_sHandlers.pListHead = psListElemNew;
-            g_sHandlers.pListHead->pNext = NIL;
-            g_sHandlers.pListHead->sHandle.dbHandler = PERS_LLDB_MAX_STATIC_HANDLES + 1;
-            /* the rest of the members will be set by lldb_handles_InitHandle */
-            pHandler = &psListElemNew->sHandle;
-         }
+         /* this would be very bad */
+         bCanContinue = false;
+         keysAccessed = PERS_COM_FAILURE;
       }
    }
-   if ((NIL == pHandler) && bCanContinue)
+   else
    {
-      /* no position available in the static array => we have to use the list
-       * the memory for psListElemNew has been allocated and the list has a head
-       * The new element has to get the smallest index
-       * Now lets consider the situation when the head of the list has an index higher than (PERS_LLDB_MAX_STATIC_HANDLES + 1)
-       * => the list will have a new head !!! */
-      if (g_sHandlers.pListHead->sHandle.dbHandler > (PERS_LLDB_MAX_STATIC_HANDLES + 1))
+      bCanContinue = false;
+      keysAccessed = PERS_COM_ERR_INVALID_PARAM;
+   }
+
+   if (bCanContinue && (count > 0))
+   {
+      pKeys = (persComDbKey_t*) malloc((size_t) count * sizeof(persComDbKey_t));
+      if ((LldbKeysWrite == eOp) && (KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode))
+      {
+         pDataCached = (Data_Cached_s*) malloc(sizeof(Data_Cached_s));
+      }
+      if ((NIL == pKeys) || ((LldbKeysWrite == eOp) && (KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode) && (NIL == pDataCached)))
+      {
+         bCanContinue = false;
+         keysAccessed = PERS_COM_ERR_MALLOC;
+      }
+   }
+
+   if (bCanContinue)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      lldb_async_drain(); //keep the order of the asynchronous writes
+
+      /* keys are checked and hashed before the database is locked */
+      for (i = 0; i < count; i++)
+      {
+         results_out[i] = prepareKeyAccess(eOp, keys[i], dataBuffers, data, sizes, i, &pKeys[i]);
+      }
+
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
+      {
+         bLocked = true;
+      }
+
+      Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);
+      keysAccessed = 0;
+      for (i = 0; i < count; i++)
+      {
+         if (PERS_COM_SUCCESS != results_out[i])
+         {
+            continue;
+         }
+         switch (eOp)
+         {
+            case LldbKeysRead:
+               results_out[i] = readKeyLocked(db, &pKeys[i], dataBuffers[i], sizes[i]);
+               break;
+            case LldbKeysWrite:
+               results_out[i] = writeKeyLocked(db, &pKeys[i], data[i], sizes[i], pDataCached);
+               bSync = (bool_t) (KISSDB_OPEN_MODE_RDONLY != db->shared->openMode);
+               break;
+            default:
+               results_out[i] = deleteKeyLocked(db, &pKeys[i]);
+               bSync = true;
+               break;
+         }
+         if (results_out[i] >= 0)
+         {
+            keysAccessed++;
+         }
+      }
+      if (bSync && (KISSDB_WRITE_MODE_WC != db->shared->writeMode))
+      {
+         syncDatabaseFile(db);
+      }
+      Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
+   }
+   else if (NIL != results_out)
+   {
+      for (i = 0; i < count; i++)
+      {
+         results_out[i] = keysAccessed;
+      }
+   }
+
+   if (bLocked)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
+   }
+   free(pDataCached);
+   free(pKeys);
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("op="); DLT_INT(eOp); DLT_STRING("count=");
+           DLT_INT(count); DLT_STRING(", "); DLT_STRING("retval=<"); DLT_INT(keysAccessed); DLT_STRING(">"));
+
+   LLDB_TRACE_EVENT(eOp, dbHandler, 0, keysAccessed, traceStart);
+   LLDB_SLOW_OP(eOp, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, NIL, keysAccessed, traceStart);
+   return keysAccessed;
+}
+
+static sint_t SetDataInKissRCT(sint_t dbHandler, persComDbKey_t const* pKey, PersistenceConfigurationKey_s const* pConfig)
+{
+   bool_t bCanContinue = true;
+   bool_t bLocked = false;
+   Data_Cached_RCT_s dataCached = { 0 };
+   int kdbState = 0;
+   lldb_handler_s* pLldbHandler = NIL;
+   sint_t bytesWritten = PERS_COM_FAILURE;
+   LLDB_TRACE_START(traceStart);
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(pKey->key); DLT_STRING(">"));
+
+   if ((dbHandler >= 0) && (NIL != pKey) && (NIL != pConfig))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+      if (NIL == pLldbHandler)
+      {
+         bCanContinue = false;
+         bytesWritten = PERS_COM_ERR_INVALID_PARAM;
+      }
+      else
+      {
+         if (PersLldbPurpose_RCT != pLldbHandler->ePurpose)
+         {
+            /* this would be very bad */
+            bCanContinue = false;
+            bytesWritten = PERS_COM_FAILURE;
+         }
+         /* to not use DLT while mutex locked */
+      }
+   }
+   else
+   {
+      bCanContinue = false;
+      bytesWritten = PERS_COM_ERR_INVALID_PARAM;
+   }
+   if (bCanContinue)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
+      {
+         bLocked = true;
+      }
+
+      int dataSize = sizeof(PersistenceConfigurationKey_s);
+      KDB_STAT_ADD(&db->shared->stats, writes, 1);
+      dataCached.eFlag = CachedDataWrite;
+      dataCached.m_dataSize = dataSize;
+      (void) memcpy(dataCached.m_data, pConfig, (size_t) dataSize);
+
+
+      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+      if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
+      {
+         bytesWritten = putToCache(&pLldbHandler->kissDb, dataSize, pKey, &dataCached);
+      }
+      else
+      {
+
+         if (KISSDB_OPEN_MODE_RDONLY != pLldbHandler->kissDb.shared->openMode)
+         {
+            kdbState = KISSDB_put_hashed(&pLldbHandler->kissDb, pKey, dataCached.m_data, dataCached.m_dataSize, &bytesWritten);
+            if (kdbState != 0)
+            {
+               DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                     DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_put: RCT key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("WriteThrough to file failed with retval=<"); DLT_INT(bytesWritten); DLT_STRING(">"));
+            }
+
+#if USE_FSYNC
+            fsync(pLldbHandler->kissDb.fd);
+#else
+            fdatasync(pLldbHandler->kissDb.fd);
+#endif
+         }
+      }
+      if (bytesWritten >= 0)
+      {
+         keyDirAdd(&pLldbHandler->kissDb, pKey);
+      }
+      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+
+   }
+   if (bLocked)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
+   }
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("retval=<");
+           DLT_INT(bytesWritten); DLT_STRING(">"));
+
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_WRITE, dbHandler, (NIL != pKey) ? pKey->cacheHash : 0, bytesWritten, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_WRITE, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, (NIL != pKey) ? pKey->key : NIL, bytesWritten, traceStart);
+   return bytesWritten;
+}
+
+static sint_t GetKeySizeFromKissLocalDB(sint_t dbHandler, persComDbKey_t const* pKey)
+{
+   bool_t bCanContinue = true;
+   bool_t bLocked = false;
+   lldb_handler_s* pLldbHandler = NIL;
+   sint_t bytesRead = PERS_COM_FAILURE;
+   LLDB_TRACE_START(traceStart);
+
+   if ((dbHandler >= 0) && (NIL != pKey))
+   {
+      LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(pKey->key); DLT_STRING(">"));
+      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+      if (NIL == pLldbHandler)
+      {
+         bCanContinue = false;
+         bytesRead = PERS_COM_ERR_INVALID_PARAM;
+      }
+      else
+      {
+         if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
+         {
+            /* this would be very bad */
+            bCanContinue = false;
+            bytesRead = PERS_COM_FAILURE;
+         }
+      }
+   }
+   else
+   {
+      bCanContinue = false;
+      bytesRead = PERS_COM_ERR_INVALID_PARAM;
+   }
+   //the latest data of the key is still in the queue of the asynchronous writes
+   if (bCanContinue && lldb_async_find(dbHandler, pKey, NIL, 0, &bytesRead))
+   {
+      bCanContinue = false;
+   }
+   if (bCanContinue)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
+      {
+         bLocked = true;
+      }
+
+      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+      KDB_STAT_ADD(&db->shared->stats, reads, 1);
+      if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
+      {
+         bytesRead = getFromCache(&pLldbHandler->kissDb, pKey, NULL, 0, true);
+         if (bytesRead == PERS_STATUS_KEY_NOT_IN_CACHE)
+         {
+            bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, pKey, NULL, 0);
+         }
+      }
+      else
+      {
+         bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, pKey, NULL, 0);
+      }
+      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+   }
+   if (bLocked)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
+   }
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING((NIL != pKey) ? pKey->key : ""); DLT_STRING(">, "); DLT_STRING("retval=<");
+           DLT_INT(bytesRead); DLT_STRING(">"));
+
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_SIZE, dbHandler, (NIL != pKey) ? pKey->cacheHash : 0, bytesRead, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_SIZE, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, (NIL != pKey) ? pKey->key : NIL, bytesRead, traceStart);
+   return bytesRead;
+}
+
+/* return no of bytes read, or negative value in case of error.
+ * The data is copied to a buffer on the stack with one lookup, the allocator is called after the database is unlocked. */
+static sint_t GetDataAllocFromKissLocalDB(sint_t dbHandler, persComDbKey_t const* pKey, persComDbAllocCallback_t allocator, void* ctx,
+                                          pstr_t* pBuffer_out)
+{
+   bool_t bCanContinue = true;
+   bool_t bLocked = false;
+   lldb_handler_s* pLldbHandler = NIL;
+   sint_t bytesRead = PERS_COM_FAILURE;
+   str_t data[PERS_DB_MAX_SIZE_KEY_DATA];
+   pstr_t buffer = NIL;
+   LLDB_TRACE_START(traceStart);
+
+   *pBuffer_out = NIL;
+   if ((dbHandler >= 0) && (NIL != pKey))
+   {
+      LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(pKey->key); DLT_STRING(">"));
+      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+      if (NIL == pLldbHandler)
+      {
+         bCanContinue = false;
+         bytesRead = PERS_COM_ERR_INVALID_PARAM;
+      }
+      else if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
+      {
+         /* this would be very bad */
+         bCanContinue = false;
+         bytesRead = PERS_COM_FAILURE;
+      }
+   }
+   else
+   {
+      bCanContinue = false;
+      bytesRead = PERS_COM_ERR_INVALID_PARAM;
+   }
+   //the latest data of the key is still in the queue of the asynchronous writes
+   if (bCanContinue && lldb_async_find(dbHandler, pKey, data, (sint_t) sizeof(data), &bytesRead))
+   {
+      bCanContinue = false;
+   }
+   if (bCanContinue)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
+      {
+         bLocked = true;
+      }
+
+      Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);
+      bytesRead = readKeyLocked(db, pKey, data, (sint_t) sizeof(data));
+      Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
+   }
+   if (bLocked)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
+   }
+
+   if (bytesRead > 0)
+   {
+      buffer = (NIL != allocator) ? (pstr_t) allocator(bytesRead, ctx) : (pstr_t) malloc((size_t) bytesRead);
+      if (NIL == buffer)
+      {
+         bytesRead = PERS_COM_ERR_MALLOC;
+      }
+      else
+      {
+         (void) memcpy(buffer, data, (size_t) bytesRead);
+         *pBuffer_out = buffer;
+      }
+   }
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("retval=<"); DLT_INT(bytesRead); DLT_STRING(">"));
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_READ, dbHandler, (NIL != pKey) ? pKey->cacheHash : 0, bytesRead, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_READ, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, (NIL != pKey) ? pKey->key : NIL, bytesRead, traceStart);
+   return bytesRead;
+}
+
+/* return no of bytes read, or negative value in case of error */
+static sint_t GetDataFromKissLocalDB(sint_t dbHandler, persComDbKey_t const* pKey, pstr_t buffer_out, sint_t bufSize)
+{
+   bool_t bCanContinue = true;
+   bool_t bLocked = false;
+   lldb_handler_s* pLldbHandler = NIL;
+   sint_t bytesRead = PERS_COM_FAILURE;
+   LLDB_TRACE_START(traceStart);
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("bufsize=<");
+           DLT_INT(bufSize); DLT_STRING(">"));
+
+   if ((dbHandler >= 0) && (NIL != pKey) && (NIL != buffer_out) && (bufSize > 0))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+      if (NIL == pLldbHandler)
+      {
+         bCanContinue = false;
+         bytesRead = PERS_COM_ERR_INVALID_PARAM;
+      }
+      else
+      {
+         if (PersLldbPurpose_DB != pLldbHandler->ePurpose)
+         {
+            /* this would be very bad */
+            bCanContinue = false;
+            bytesRead = PERS_COM_FAILURE;
+         }
+         /* to not use DLT while mutex locked */
+      }
+   }
+   else
+   {
+      bCanContinue = false;
+      bytesRead = PERS_COM_ERR_INVALID_PARAM;
+   }
+
+   //the latest data of the key is still in the queue of the asynchronous writes
+   if (bCanContinue && lldb_async_find(dbHandler, pKey, buffer_out, bufSize, &bytesRead))
+   {
+      bCanContinue = false;
+   }
+   if (bCanContinue)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
+      {
+         bLocked = true;
+      }
+
+      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+      bytesRead = readKeyLocked(db, pKey, buffer_out, bufSize);
+      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+   }
+   if (bLocked)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
+   }
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("bufsize=<");
+           DLT_INT(bufSize); DLT_STRING(">, "); DLT_STRING("retval=<"); DLT_INT(bytesRead); DLT_STRING(">"));
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_READ, dbHandler, (NIL != pKey) ? pKey->cacheHash : 0, bytesRead, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_READ, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, (NIL != pKey) ? pKey->key : NIL, bytesRead, traceStart);
+   return bytesRead;
+}
+
+static sint_t GetDataFromKissRCT(sint_t dbHandler, persComDbKey_t const* pKey, PersistenceConfigurationKey_s* pConfig)
+{
+   bool_t bCanContinue = true;
+   bool_t bLocked = false;
+   lldb_handler_s* pLldbHandler = NIL;
+   sint_t bytesRead = PERS_COM_FAILURE;
+   LLDB_TRACE_START(traceStart);
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(pKey->key); DLT_STRING(">"));
+
+   if ((dbHandler >= 0) && (NIL != pKey) && (NIL != pConfig))
+   {
+      pLldbHandler = lldb_handles_FindInUseHandle(dbHandler);
+      if (NIL == pLldbHandler)
+      {
+         bCanContinue = false;
+         bytesRead = PERS_COM_ERR_INVALID_PARAM;
+      }
+      else
+      {
+         if (PersLldbPurpose_RCT != pLldbHandler->ePurpose)
+         {
+            /* this would be very bad */
+            bCanContinue = false;
+            bytesRead = PERS_COM_FAILURE;
+         }
+         /* to not use DLT while mutex locked */
+      }
+   }
+   else
+   {
+      bCanContinue = false;
+      bytesRead = PERS_COM_ERR_INVALID_PARAM;
+   }
+
+   //read RCT
+   if (bCanContinue)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      if (lldb_handles_Lock(&db->shared->mutex, &db->shared->stats))
+      {
+         bLocked = true;
+      }
+
+      Kdb_wrlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+      KDB_STAT_ADD(&db->shared->stats, reads, 1);
+      if ( KISSDB_WRITE_MODE_WC == pLldbHandler->kissDb.shared->writeMode)
+      {
+         bytesRead = getFromCache(&pLldbHandler->kissDb, pKey, pConfig, sizeof(PersistenceConfigurationKey_s), false);
+         if (bytesRead == PERS_STATUS_KEY_NOT_IN_CACHE)
+         {
+            bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, pKey, pConfig, sizeof(PersistenceConfigurationKey_s));
+         }
+      }
+      else
+      {
+         bytesRead = getFromDatabaseFile(&pLldbHandler->kissDb, pKey, pConfig, sizeof(PersistenceConfigurationKey_s));
+      }
+      Kdb_unlock(&pLldbHandler->kissDb.shared->rwlock, &pLldbHandler->kissDb.shared->stats);
+   }
+   if (bLocked)
+   {
+      KISSDB* db = &pLldbHandler->kissDb;
+      (void) lldb_handles_Unlock(&db->shared->mutex, &db->shared->stats);
+   }
+
+   LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler="); DLT_INT(dbHandler); DLT_STRING("key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("retval=<");
+           DLT_INT(bytesRead); DLT_STRING(">"));
+
+   LLDB_TRACE_EVENT(LLDB_TRACE_OP_READ, dbHandler, (NIL != pKey) ? pKey->cacheHash : 0, bytesRead, traceStart);
+   LLDB_SLOW_OP(LLDB_TRACE_OP_READ, (NIL != pLldbHandler) ? pLldbHandler->dbPathname : NIL, (NIL != pKey) ? pKey->key : NIL, bytesRead, traceStart);
+   return bytesRead;
+}
+
+static bool_t lldb_handles_InitLock(pthread_mutex_t *mutex)
+{
+   bool_t bEverythingOK = true;
+   pthread_mutexattr_t mattr;
+
+   pthread_mutexattr_init(&mattr);
+   pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST);
+   pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+   sint_t siErr = pthread_mutex_init(mutex, &mattr);
+   if (0 != siErr)
+   {
+      bEverythingOK = false;
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("pthread_mutex_init failed with error=<"); DLT_INT(siErr); DLT_STRING(">"));
+   }
+
+   pthread_mutexattr_destroy(&mattr);
+
+   return bEverythingOK;
+}
+
+static bool_t lldb_handles_Lock(pthread_mutex_t *mutex, Kdb_stats_s* pStats)
+{
+   bool_t bEverythingOK = true;
+#ifdef PERS_LLDB_LOCK_PROFILE
+   uint64_t startNs = kdbLockProfileNow();
+#endif
+
+   sint_t siErr = pthread_mutex_trylock(mutex);
+   if (EBUSY == siErr)
+   {
+      /* only a contended lock is timed */
+      struct timespec waitStart, waitEnd;
+
+      clock_gettime(CLOCK_MONOTONIC, &waitStart);
+      siErr = pthread_mutex_lock(mutex);
+      clock_gettime(CLOCK_MONOTONIC, &waitEnd);
+      KDB_STAT_ADD(pStats, lockWaits, 1);
+      KDB_STAT_ADD(pStats, lockWaitNs, ((waitEnd.tv_sec - waitStart.tv_sec) * 1000000000LL) + (waitEnd.tv_nsec - waitStart.tv_nsec));
+      LLDB_OP_LOCK_WAIT(((waitEnd.tv_sec - waitStart.tv_sec) * 1000000000LL) + (waitEnd.tv_nsec - waitStart.tv_nsec));
+   }
+#ifdef PERS_LLDB_LOCK_PROFILE
+   if (0 == siErr || EOWNERDEAD == siErr)
+   {
+      kdbLockProfileAcquired(pStats, KDB_LOCK_MUTEX, startNs, kdbLockProfileNow());
+   }
+#endif
+
+   if (0 != siErr)
+   {
+      if (EOWNERDEAD == siErr)
+      {
+         sint_t siErr = pthread_mutex_consistent(mutex);
+         if (0 != siErr)
+         {
+            bEverythingOK = false;
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                    DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("pthread_mutex_consistent failed with error=<"); DLT_INT(siErr); DLT_STRING(">"));
+         }
+      }
+      else
+      {
+         bEverythingOK = false;
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                 DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("pthread_mutex_lock failed with error=<"); DLT_INT(siErr); DLT_STRING(">"));
+      }
+   }
+
+   return bEverythingOK;
+}
+
+static bool_t lldb_handles_Unlock(pthread_mutex_t *mutex, Kdb_stats_s* pStats)
+{
+   bool_t bEverythingOK = true;
+   sint_t siErr;
+
+#ifdef PERS_LLDB_LOCK_PROFILE
+   kdbLockProfileRelease(pStats, KDB_LOCK_MUTEX);
+#else
+   (void) pStats;
+#endif
+   siErr = pthread_mutex_unlock(mutex);
+   if (0 != siErr)
+   {
+      bEverythingOK = false;
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("pthread_mutex_unlock failed with error=<"); DLT_INT(siErr); DLT_STRING(">"));
+   }
+
+   return bEverythingOK;
+}
+
+/* it is assumed dbHandler is checked by the caller
+ * lock free: chunks are never freed and the entry is only valid if it is assigned to exactly this handler */
+static lldb_handler_s* lldb_handles_FindInUseHandle(sint_t dbHandler)
+{
+   lldb_handler_s* pChunk;
+   lldb_handler_s* pHandler = NIL;
+   sint_t siIndex = dbHandler & PERS_LLDB_HANDLE_INDEX_MASK;
+
+   pChunk = __atomic_load_n(&g_sHandlers.apChunks[siIndex / PERS_LLDB_NO_OF_STATIC_HANDLES], __ATOMIC_ACQUIRE);
+   if (NIL != pChunk)
+   {
+      lldb_handler_s* pEntry = &pChunk[siIndex % PERS_LLDB_NO_OF_STATIC_HANDLES];
+      if (__atomic_load_n(&pEntry->bIsAssigned, __ATOMIC_ACQUIRE) && (__atomic_load_n(&pEntry->dbHandler, __ATOMIC_RELAXED) == dbHandler))
       {
-         psListElemNew->pNext = g_sHandlers.pListHead;
-         psListElemNew->sHandle.dbHandler = PERS_LLDB_MAX_STATIC_HANDLES + 1;
-         /* the rest of the members will be set by lldb_handles_InitHandle */
-         g_sHandlers.pListHead = psListElemNew;
-         pHandler = &psListElemNew->sHandle;
+         pHandler = pEntry;
       }
    }
 
-   if ((NIL == pHandler) && bCanContinue)
+   if (NIL == pHandler)
+   {
+      //closed or reused (generation mismatch) handles are expected, the caller reports the error
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
+              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("no open database for handler <"); DLT_INT(dbHandler); DLT_STRING(">"));
+   }
+   return pHandler;
+}
+
+/* reserves a free entry of the handle table, the entry is released with lldb_handles_DeinitHandle */
+static lldb_handler_s* lldb_handles_FindAvailableHandle(void)
+{
+   lldb_handler_s* pHandler = NIL;
+   sint_t siIndex = -1;
+
+   (void) pthread_mutex_lock(&g_sHandlers.mutex);
+   if (g_sHandlers.iFreeCount > 0)
+   {
+      siIndex = g_sHandlers.aiFreeIndex[--g_sHandlers.iFreeCount];
+   }
+   else if (g_sHandlers.iNextIndex < PERS_LLDB_MAX_HANDLES)
    {
-      /* no position available in the static array => we have to use the list
-       * the memory for psListElemNew has been allocated and the list has a head (with the smallest index)
-       * The new element has to get the smallest available index
-       * So will search for the first gap between two consecutive elements of the list and will introduce the new element between */
-      lldb_handles_list_el_s* pListElemCurrent1 = g_sHandlers.pListHead;
-      lldb_handles_list_el_s* pListElemCurrent2 = pListElemCurrent1->pNext;
-      while (NIL != pListElemCurrent2)
+      sint_t siChunk = g_sHandlers.iNextIndex / PERS_LLDB_NO_OF_STATIC_HANDLES;
+      if (NIL == g_sHandlers.apChunks[siChunk])
       {
-         if (pListElemCurrent2->sHandle.dbHandler - pListElemCurrent1->sHandle.dbHandler > 1)
+         lldb_handler_s* pChunk = (lldb_handler_s*) calloc(PERS_LLDB_NO_OF_STATIC_HANDLES, sizeof(lldb_handler_s));
+         if (NIL == pChunk)
          {
-            /* found a gap => insert the element between and use the index next to pListElemCurrent1's */
-            psListElemNew->pNext = pListElemCurrent2;
-            psListElemNew->sHandle.dbHandler = pListElemCurrent1->sHandle.dbHandler + 1;
-            pListElemCurrent1->pNext = psListElemNew;
-            pHandler = &psListElemNew->sHandle;
-            break;
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("malloc failed"));
          }
          else
          {
-            pListElemCurrent1 = pListElemCurrent2;
-            pListElemCurrent2 = pListElemCurrent2->pNext;
+            __atomic_store_n(&g_sHandlers.apChunks[siChunk], pChunk, __ATOMIC_RELEASE);
          }
       }
-      if (NIL == pListElemCurrent2)
+      if (NIL != g_sHandlers.apChunks[siChunk])
       {
-         /* reached the end of the list => the list will have a new end */
-         psListElemNew->pNext = NIL;
-         psListElemNew->sHandle.dbHandler = pListElemCurrent1->sHandle.dbHandler + 1;
-         pListElemCurrent1->pNext = psListElemNew;
-         pHandler = &psListElemNew->sHandle;
+         siIndex = g_sHandlers.iNextIndex++;
       }
    }
+   if (siIndex >= 0)
+   {
+      pHandler = &g_sHandlers.apChunks[siIndex / PERS_LLDB_NO_OF_STATIC_HANDLES][siIndex % PERS_LLDB_NO_OF_STATIC_HANDLES];
+      /* keep the generation of the previous use of the entry, the index is set for the first use */
+      pHandler->dbHandler = (pHandler->dbHandler & ~PERS_LLDB_HANDLE_INDEX_MASK) | siIndex;
+   }
+   (void) pthread_mutex_unlock(&g_sHandlers.mutex);
 
-   DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
-           DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING((NIL!=pHandler) ? "Found availble handler <" : "ERROR can't find available handler <");
-           DLT_INT((NIL!=pHandler) ? pHandler->dbHandler : (-1)); DLT_STRING(">");
-           DLT_STRING((NIL!=pHandler) ? (pHandler->dbHandler <= PERS_LLDB_MAX_STATIC_HANDLES ? "in static area" : "in dynamic list") : ""));
-
+   if (NIL == pHandler)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+              DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("ERROR can't find available handler"));
+   }
    return pHandler;
 }
 
 static void lldb_handles_InitHandle(lldb_handler_s* psHandle_inout, pers_lldb_purpose_e ePurpose, str_t const* dbPathname)
 {
-   psHandle_inout->bIsAssigned = true;
    psHandle_inout->ePurpose = ePurpose;
    (void) strncpy(psHandle_inout->dbPathname, dbPathname, sizeof(psHandle_inout->dbPathname));
+   psHandle_inout->kissDb.dbPath = psHandle_inout->dbPathname;
+   __atomic_store_n(&psHandle_inout->bIsAssigned, true, __ATOMIC_RELEASE); /* publish the handler for lookups */
 }
 
 static bool_t lldb_handles_DeinitHandle(sint_t dbHandler)
 {
-   bool_t bEverythingOK = true;
-   bool_t bHandlerFound = false;
+   bool_t bEverythingOK = false;
+   lldb_handler_s* pChunk;
+   sint_t siIndex = dbHandler & PERS_LLDB_HANDLE_INDEX_MASK;
 
-   if (dbHandler <= PERS_LLDB_MAX_STATIC_HANDLES)
-   {
-      bHandlerFound = true;
-      g_sHandlers.asStaticHandles[dbHandler].bIsAssigned = false;
-   }
-   else
+   (void) pthread_mutex_lock(&g_sHandlers.mutex);
+   pChunk = (siIndex < g_sHandlers.iNextIndex) ? g_sHandlers.apChunks[siIndex / PERS_LLDB_NO_OF_STATIC_HANDLES] : NIL;
+   if (NIL != pChunk)
    {
-      /* consider the situation when the handle is the head of the list */
-      if (NIL != g_sHandlers.pListHead)
-      {
-         if (dbHandler == g_sHandlers.pListHead->sHandle.dbHandler)
-         {
-            lldb_handles_list_el_s* pListElemTemp = NIL;
-            bHandlerFound = true;
-            pListElemTemp = g_sHandlers.pListHead;
-            g_sHandlers.pListHead = g_sHandlers.pListHead->pNext;
-            free(pListElemTemp);
-         }
-      }
-      else
+      lldb_handler_s* pEntry = &pChunk[siIndex % PERS_LLDB_NO_OF_STATIC_HANDLES];
+      if (pEntry->dbHandler == dbHandler)
       {
-         bEverythingOK = false;
-      }
-   }
+         sint_t siGeneration = ((dbHandler >> PERS_LLDB_HANDLE_INDEX_BITS) + 1) & PERS_LLDB_HANDLE_GEN_MASK;
 
-   if (bEverythingOK && (!bHandlerFound))
-   {
-      /* consider the situation when the handle is in the list (but not the head) */
-      lldb_handles_list_el_s* pListElemCurrent1 = g_sHandlers.pListHead;
-      lldb_handles_list_el_s* pListElemCurrent2 = pListElemCurrent1->pNext;
-      while (NIL != pListElemCurrent2)
-      {
-         if (dbHandler == pListElemCurrent2->sHandle.dbHandler)
-         {
-            /* found the handle */
-            bHandlerFound = true;
-            pListElemCurrent1->pNext = pListElemCurrent2->pNext;
-            free(pListElemCurrent2);
-            break;
-         }
-         else
-         {
-            pListElemCurrent1 = pListElemCurrent2;
-            pListElemCurrent2 = pListElemCurrent2->pNext;
-         }
-      }
-      if (NIL == pListElemCurrent2)
-      {
-         /* reached the end of the list without finding the handle */
-         bEverythingOK = false;
+         __atomic_store_n(&pEntry->bIsAssigned, false, __ATOMIC_RELEASE);
+         /* a new generation invalidates the released handler */
+         __atomic_store_n(&pEntry->dbHandler, (siGeneration << PERS_LLDB_HANDLE_INDEX_BITS) | siIndex, __ATOMIC_RELAXED);
+         g_sHandlers.aiFreeIndex[g_sHandlers.iFreeCount++] = siIndex;
+         bEverythingOK = true;
       }
    }
+   (void) pthread_mutex_unlock(&g_sHandlers.mutex);
 
    DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
            DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("dbHandler=<"); DLT_INT(dbHandler); DLT_STRING("> ");
-           DLT_STRING(bEverythingOK ? (dbHandler <= PERS_LLDB_MAX_STATIC_HANDLES ? "deinit handler in static area" : "deinit handler in dynamic list") : "ERROR - handler not found"));
+           DLT_STRING(bEverythingOK ? "deinit handler" : "ERROR - handler not found"));
 
    return bEverythingOK;
 }
 
-sint_t getFromCache(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize, bool_t sizeOnly)
+/* update the cache usage counters after a modification of the cache */
+static void cacheSlotStats(KISSDB* db)
+{
+   int maxSlots = 0;
+   int usedSlots = 0;
+
+   (void) db->tbl[0]->size(db->tbl[0], &maxSlots, &usedSlots);
+   KDB_STAT_SET(&db->shared->stats, cacheSlotsUsed, usedSlots);
+   KDB_STAT_SET(&db->shared->stats, cacheSlotsMax, maxSlots);
+}
+
+/* fill the key descriptor: 64 bit hash for the database file, murmur3 hash for the cache */
+static void initKey(persComDbKey_t* pKey, str_t const* key)
+{
+   KISSDB_key_init(pKey, key);
+   pKey->cacheHash = qhashmurmur3_32(key, pKey->length);
+}
+
+static sint_t cacheGet(KISSDB* db, persComDbKey_t const* pKey, void* readBuffer, sint_t bufsize, bool_t sizeOnly)
 {
    char* ptr;
    int datasize = 0;
@@ -1956,7 +3176,7 @@ sint_t getFromCache(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize,
 
       setMemoryAddress(db->sharedCache, db->tbl[0]);
 
-      val = db->tbl[0]->get(db->tbl[0], metaKey, &size);
+      val = db->tbl[0]->get_hashed(db->tbl[0], pKey->key, pKey->length, pKey->cacheHash, &size);
       if (val == NULL)
       {
          bytesRead = PERS_COM_ERR_NOT_FOUND;
@@ -2005,21 +3225,34 @@ sint_t getFromCache(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize,
    //only read from file if key was not found in cache and if key was not marked as deleted in cache
    if ((cacheEmpty == Kdb_true && keyDeleted == Kdb_false) || keyNotFound == Kdb_true)
    {
+      KDB_STAT_ADD(&db->shared->stats, cacheMisses, 1);
       return PERS_STATUS_KEY_NOT_IN_CACHE; //key not found in cache
    }
    else
    {
+      KDB_STAT_ADD(&db->shared->stats, cacheHits, 1);
+      LLDB_OP_FLAG(LLDB_OP_FLAG_CACHE);
       return bytesRead;
    }
 }
 
-sint_t getFromDatabaseFile(KISSDB* db, void* metaKey, void* readBuffer, sint_t bufsize)
+sint_t getFromCache(KISSDB* db, persComDbKey_t const* pKey, void* readBuffer, sint_t bufsize, bool_t sizeOnly)
+{
+   sint_t bytesRead;
+
+   PERS_PROBE3(cache_get_entry, db->dbPath, pKey->key, bufsize);
+   bytesRead = cacheGet(db, pKey, readBuffer, bufsize, sizeOnly);
+   PERS_PROBE3(cache_get_return, db->dbPath, pKey->key, bytesRead);
+   return bytesRead;
+}
+
+sint_t getFromDatabaseFile(KISSDB* db, persComDbKey_t const* pKey, void* readBuffer, sint_t bufsize)
 {
    int kdbState = 0;
    sint_t bytesRead = 0;
    uint32_t size = 0;
 
-   kdbState  = KISSDB_get(db, metaKey, readBuffer, bufsize, &size);
+   kdbState  = KISSDB_get_hashed(db, pKey, readBuffer, bufsize, &size);
    if (kdbState == 0)
    {
       bytesRead = size;
@@ -2029,20 +3262,443 @@ sint_t getFromDatabaseFile(KISSDB* db, void* metaKey, void* readBuffer, sint_t b
       if (kdbState == 1)
       {
          DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
-                 DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_get: key=<"); DLT_STRING(metaKey); DLT_STRING(">, "); DLT_STRING("not found, retval=<"); DLT_INT(kdbState); DLT_STRING(">"));
+                 DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_get: key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("not found, retval=<"); DLT_INT(kdbState); DLT_STRING(">"));
          bytesRead = PERS_COM_ERR_NOT_FOUND;
       }
       else
       {
-         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
-                 DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_get: key=<"); DLT_STRING(metaKey); DLT_STRING(">, "); DLT_STRING("Error with retval=<"); DLT_INT(kdbState); DLT_STRING(">"));
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                 DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_get: key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("Error with retval=<"); DLT_INT(kdbState); DLT_STRING(">"));
+      }
+      bytesRead = PERS_COM_ERR_NOT_FOUND;
+   }
+   return bytesRead;
+}
+
+/* read one key, the caller holds the mutex and the write lock of the database */
+static sint_t readKeyLocked(KISSDB* db, persComDbKey_t const* pKey, pstr_t buffer_out, sint_t bufSize)
+{
+   sint_t bytesRead;
+
+   KDB_STAT_ADD(&db->shared->stats, reads, 1);
+   if ( KISSDB_WRITE_MODE_WC == db->shared->writeMode)
+   {
+      bytesRead = getFromCache(db, pKey, buffer_out, bufSize, false);
+      //if key is not already in cache
+      if (bytesRead == PERS_STATUS_KEY_NOT_IN_CACHE)
+      {
+         bytesRead = getFromDatabaseFile(db, pKey, buffer_out, bufSize);
+      }
+   }
+   else //write through mode -> only read from file
+   {
+      bytesRead = getFromDatabaseFile(db, pKey, buffer_out, bufSize);
+   }
+   return bytesRead;
+}
+
+/* write one key, the caller holds the mutex and the write lock of the database.
+ * In write through mode the caller syncs the database file afterwards. */
+static sint_t writeKeyLocked(KISSDB* db, persComDbKey_t const* pKey, pconststr_t data, sint_t dataSize, Data_Cached_s* pDataCached)
+{
+   sint_t bytesWritten = PERS_COM_FAILURE;
+   int kdbState = 0;
+
+   KDB_STAT_ADD(&db->shared->stats, writes, 1);
+   if ( KISSDB_WRITE_MODE_WC == db->shared->writeMode)
+   {
+      pDataCached->eFlag = CachedDataWrite;
+      pDataCached->m_dataSize = dataSize;
+      (void) memcpy(pDataCached->m_data, data, (size_t) dataSize);
+      bytesWritten = putToCache(db, dataSize, pKey, pDataCached);
+   }
+   else
+   {
+      if (KISSDB_OPEN_MODE_RDONLY != db->shared->openMode)
+      {
+         kdbState = KISSDB_put_hashed(db, pKey, data, dataSize, &bytesWritten);
+         if (kdbState != 0)
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                  DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_put: key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("WriteThrough to file failed with retval=<"); DLT_INT(bytesWritten); DLT_STRING(">"));
+         }
+      }
+   }
+   if (bytesWritten >= 0)
+   {
+      keyDirAdd(db, pKey);
+   }
+   return bytesWritten;
+}
+
+/* delete one key, the caller holds the mutex and the write lock of the database.
+ * In write through mode the caller syncs the database file afterwards. */
+static sint_t deleteKeyLocked(KISSDB* db, persComDbKey_t const* pKey)
+{
+   sint_t bytesDeleted = PERS_COM_FAILURE;
+   int kdbState = 0;
+
+   KDB_STAT_ADD(&db->shared->stats, deletes, 1);
+   if ( KISSDB_WRITE_MODE_WC == db->shared->writeMode)
+   {
+      bytesDeleted = deleteFromCache(db, pKey);
+   }
+   else //write through
+   {
+      kdbState = KISSDB_delete_hashed(db, pKey, &bytesDeleted);
+      if (kdbState != 0)
+      {
+         if (kdbState == 1)
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
+                    DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_delete: key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("not found in database file, retval=<"); DLT_INT(kdbState);
+                    DLT_STRING(">"));
+         }
+         else
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                    DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_delete: key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("Error with retval=<"); DLT_INT(kdbState); DLT_STRING(">");
+                    DLT_STRING("Error Message: "); DLT_STRING(strerror(errno)));
+         }
+      }
+   }
+   if (bytesDeleted >= 0)
+   {
+      keyDirRemove(db, pKey);
+   }
+   return bytesDeleted;
+}
+
+static void syncDatabaseFile(KISSDB* db)
+{
+#if USE_FSYNC
+   fsync(db->fd);
+#else
+   fdatasync(db->fd);
+#endif
+}
+
+/* delete one key of a transaction, the delete of a key which does not exist is not an error of the transaction */
+static sint_t deleteTxKey(KISSDB* db, persComDbKey_t const* pKey)
+{
+   sint_t result = deleteKeyLocked(db, pKey);
+   uint32_t size = 0;
+
+   if (   (PERS_COM_ERR_NOT_FOUND == result)
+       || ((result < 0) && (KISSDB_WRITE_MODE_WC != db->shared->writeMode) && (1 == KISSDB_get_hashed(db, pKey, NULL, 0, &size))))
+   {
+      result = PERS_COM_SUCCESS;
+   }
+   return result;
+}
+
+/* apply one operation of a committed transaction, the caller holds the mutex and the write lock of the database.
+ * The previous value of the key is kept to undo the operation if one of the next ones fails */
+static sint_t applyTxOp(str_t const* key, pconststr_t data, sint_t dataSize, void* ctx)
+{
+   lldb_tx_apply_ctx_s* pCtx = (lldb_tx_apply_ctx_s*) ctx;
+   lldb_tx_undo_s* pUndo;
+   persComDbKey_t sKey;
+   sint_t oldSize;
+   sint_t result;
+
+   initKey(&sKey, key);
+   oldSize = readKeyLocked(pCtx->db, &sKey, pCtx->pDataCached->m_data, PERS_DB_MAX_SIZE_KEY_DATA);
+   if ((oldSize <= 0) && (PERS_COM_ERR_NOT_FOUND != oldSize)) //the data of a key is never empty
+   {
+      return (oldSize < 0) ? oldSize : PERS_COM_FAILURE;
+   }
+   pUndo = (lldb_tx_undo_s*) malloc(sizeof(lldb_tx_undo_s) + sKey.length + 1 + (size_t) ((oldSize > 0) ? oldSize : 0));
+   if (NIL == pUndo)
+   {
+      return PERS_COM_ERR_MALLOC;
+   }
+   pUndo->dataSize = oldSize;
+   (void) memcpy((str_t*) (pUndo + 1), key, sKey.length + 1);
+   if (oldSize > 0)
+   {
+      (void) memcpy((str_t*) (pUndo + 1) + sKey.length + 1, pCtx->pDataCached->m_data, (size_t) oldSize);
+   }
+
+   if (dataSize >= 0)
+   {
+      result = writeKeyLocked(pCtx->db, &sKey, data, dataSize, pCtx->pDataCached);
+   }
+   else
+   {
+      result = deleteTxKey(pCtx->db, &sKey);
+   }
+   if (result >= 0)
+   {
+      pUndo->next = pCtx->pUndo;
+      pCtx->pUndo = pUndo;
+   }
+   else
+   {
+      free(pUndo);
+   }
+   return result;
+}
+
+/* restore the previous values of the keys changed by the operations applied before the failed one of a transaction,
+ * the last one first. Returns true if all of them are restored */
+static bool_t undoTxOps(lldb_tx_apply_ctx_s* pCtx)
+{
+   bool_t bUndone = true;
+   lldb_tx_undo_s* pUndo;
+   persComDbKey_t sKey;
+   str_t const* key;
+   sint_t result;
+
+   while (NIL != pCtx->pUndo)
+   {
+      pUndo = pCtx->pUndo;
+      pCtx->pUndo = pUndo->next;
+      key = (str_t const*) (pUndo + 1);
+      initKey(&sKey, key);
+      if (pUndo->dataSize > 0)
+      {
+         result = writeKeyLocked(pCtx->db, &sKey, key + sKey.length + 1, pUndo->dataSize, pCtx->pDataCached);
+      }
+      else
+      {
+         result = deleteTxKey(pCtx->db, &sKey);
+      }
+      if (result < 0)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                 DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("key=<"); DLT_STRING(key); DLT_STRING("> not restored, retval=<"); DLT_INT(result); DLT_STRING(">"));
+         bUndone = false;
+      }
+      free(pUndo);
+   }
+   return bUndone;
+}
+
+static void freeTxUndo(lldb_tx_apply_ctx_s* pCtx)
+{
+   lldb_tx_undo_s* pUndo;
+
+   while (NIL != pCtx->pUndo)
+   {
+      pUndo = pCtx->pUndo;
+      pCtx->pUndo = pUndo->next;
+      free(pUndo);
+   }
+}
+
+/* write back the cache and checkpoint the database file, then the intent log is not needed anymore.
+ * The caller holds the mutex and the write lock of the database */
+static sint_t syncLocked(KISSDB* db, str_t const* dbPathname)
+{
+   int kdbState = 0;
+   sint_t result = PERS_COM_SUCCESS;
+
+   if (KISSDB_WRITE_MODE_WC == db->shared->writeMode)
+   {
+      struct timespec wbStart, wbEnd;
+
+      PERS_PROBE1(writeback_start, dbPathname);
+      clock_gettime(CLOCK_MONOTONIC, &wbStart);
+      result = syncCacheLocked(db);
+      clock_gettime(CLOCK_MONOTONIC, &wbEnd);
+      KDB_STAT_ADD(&db->shared->stats, writebacks, 1);
+      KDB_STAT_ADD(&db->shared->stats, writebackNs, ((wbEnd.tv_sec - wbStart.tv_sec) * 1000000000LL) + (wbEnd.tv_nsec - wbStart.tv_nsec));
+      PERS_PROBE2(writeback_end, dbPathname, result);
+   }
+   //an entry not written back keeps the cache and the intent log as they are, the next sync or the last close retries
+   if (result >= 0)
+   {
+      kdbState = KISSDB_checkpoint(db);
+      if (kdbState != 0)
+      {
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                 DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_checkpoint: <"); DLT_STRING(dbPathname); DLT_STRING(">, ");
+                 DLT_STRING("failed with retval=<"); DLT_INT(kdbState); DLT_STRING(">"));
+         result = PERS_COM_FAILURE;
+      }
+      else
+      {
+         //the committed transactions are in the database file now, the intent log is not needed anymore
+         markTxApplied(db, dbPathname);
+      }
+   }
+   return result;
+}
+
+/* the committed transactions are in the database file: the header gets the sequence number of the last one and the intent log
+ * is emptied. A transaction neither applied completely nor undone by its commit stays in the log for the next first open.
+ * The caller holds the write lock of the database */
+static void markTxApplied(KISSDB* db, str_t const* dbPathname)
+{
+   Header_s* pHeader = (Header_s*) db->mappedDb;
+   bool_t bClearLog = (0 == db->shared->txReplaySeq) && (db->shared->txLastSeq > pHeader->txApplied);
+
+   pHeader->txApplied = (0 == db->shared->txReplaySeq) ? db->shared->txLastSeq : (db->shared->txReplaySeq - 1);
+   syncDatabaseFile(db);
+   if (bClearLog)
+   {
+      lldb_tx_clear_log(dbPathname);
+   }
+}
+
+/* apply one operation of the intent log to the database file, called by the first instance while opening */
+static sint_t replayTxOp(str_t const* key, pconststr_t data, sint_t dataSize, void* ctx)
+{
+   KISSDB* db = (KISSDB*) ctx;
+   persComDbKey_t sKey;
+   int32_t bytes = 0;
+   int kdbState;
+
+   initKey(&sKey, key);
+   if (dataSize >= 0)
+   {
+      kdbState = KISSDB_put_hashed(db, &sKey, data, dataSize, &bytes);
+   }
+   else
+   {
+      kdbState = KISSDB_delete_hashed(db, &sKey, &bytes);
+      if (kdbState == 1) //not found
+      {
+         kdbState = 0;
+      }
+   }
+   return (kdbState == 0) ? PERS_COM_SUCCESS : PERS_COM_FAILURE;
+}
+
+/* apply the transactions of the intent log which are not yet in the database file (crash before the write back of the cache
+ * or before the sync of the database file). Called by the first instance while opening, with the mutex of the database */
+static void recoverTransactions(KISSDB* db, str_t const* dbPathname)
+{
+   uint64_t lastSeq = ((Header_s*) db->mappedDb)->txApplied;
+   sint_t replayed;
+
+   if (KISSDB_OPEN_MODE_RDONLY != db->shared->openMode)
+   {
+      Kdb_wrlock(&db->shared->rwlock, &db->shared->stats);
+      replayed = lldb_tx_replay_log(dbPathname, lastSeq, replayTxOp, db, &lastSeq);
+      if (replayed > 0)
+      {
+         ((Header_s*) db->mappedDb)->txApplied = lastSeq;
+         syncDatabaseFile(db);
+         DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
+                 DLT_STRING(LT_HDR); DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("<"); DLT_STRING(dbPathname); DLT_STRING(">, ");
+                 DLT_STRING("transactions replayed from the intent log: "); DLT_INT(replayed));
+      }
+      if (replayed >= 0)
+      {
+         lldb_tx_clear_log(dbPathname);
+      }
+      Kdb_unlock(&db->shared->rwlock, &db->shared->stats);
+   }
+   db->shared->txLastSeq = lastSeq;
+   db->shared->txReplaySeq = 0;
+}
+
+/* write back the entries of the cache modified since the previous sync, the database stays open: a written entry is
+ * marked clean and kept for reading, a deleted entry is removed from the cache. The caller holds the mutex and the
+ * write lock of the database, and checkpoints and syncs the database file afterwards.
+ * Returns the number of entries written back or deleted, or the error of the first entry which failed */
+static sint_t syncCacheLocked(KISSDB* db)
+{
+   char* ptr;
+   char** deletedKeys = NIL;
+   char** newKeys;
+   int datasize = 0;
+   int idx = 0;
+   int kdbState = 0;
+   int32_t bytes = 0;
+   persComDbKey_t sKey;
+   pers_lldb_cache_flag_e eFlag;
+   qnobj_t obj;
+   sint_t count = 0;
+   sint_t deletedCount = 0;
+   sint_t i = 0;
+   sint_t result = PERS_COM_SUCCESS;
+
+   if (db->shared->cacheCreated != Kdb_true)
+   {
+      return 0;
+   }
+   if (openCache(db) != 0)
+   {
+      return PERS_COM_FAILURE;
+   }
+   setMemoryAddress(db->sharedCache, db->tbl[0]);
+
+   while (db->tbl[0]->getnext(db->tbl[0], &obj, &idx) == true)
+   {
+      ptr = obj.data;
+      eFlag = (pers_lldb_cache_flag_e) *(int*) ptr;
+      ptr += sizeof(int);
+      datasize = *(int*) ptr;
+      ptr += sizeof(int);
+      initKey(&sKey, obj.name);
+
+      if (CachedDataWrite == eFlag)
+      {
+         kdbState = KISSDB_put_hashed(db, &sKey, ptr, datasize, &bytes);
+         if (kdbState == 0)
+         {
+            //same size: the value is overwritten in place, the iteration is not disturbed
+            *(int*) obj.data = CachedDataWriteClean;
+            (void) db->tbl[0]->put_hashed(db->tbl[0], sKey.key, sKey.length, sKey.cacheHash, obj.data, obj.size);
+            count++;
+         }
+         else
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                    DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_put: key=<"); DLT_STRING(obj.name); DLT_STRING(">, "); DLT_STRING("Writing back to file failed with retval=<");
+                    DLT_INT(kdbState); DLT_STRING(">"));
+            if (result >= 0)
+            {
+               result = PERS_COM_FAILURE;
+            }
+         }
+      }
+      else if (CachedDataDelete == eFlag)
+      {
+         kdbState = KISSDB_delete_hashed(db, &sKey, &bytes);
+         if ((kdbState == 0) || (kdbState == 1)) //1: not in the database file
+         {
+            //removing a key can move other keys of the cache, remove them after the iteration
+            newKeys = (char**) realloc(deletedKeys, (size_t) (deletedCount + 1) * sizeof(char*));
+            if (NIL != newKeys) //else the delete stays marked in the cache, it is done again by the next sync
+            {
+               deletedKeys = newKeys;
+               deletedKeys[deletedCount] = obj.name;
+               deletedCount++;
+               obj.name = NIL;
+            }
+            count++;
+         }
+         else
+         {
+            DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
+                    DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_delete: key=<"); DLT_STRING(obj.name); DLT_STRING(">, "); DLT_STRING("Error with retval=<"); DLT_INT(kdbState); DLT_STRING(">"));
+            if (result >= 0)
+            {
+               result = PERS_COM_FAILURE;
+            }
+         }
       }
-      bytesRead = PERS_COM_ERR_NOT_FOUND;
+      free(obj.name);
+      free(obj.data);
    }
-   return bytesRead;
+
+   for (i = 0; i < deletedCount; i++)
+   {
+      initKey(&sKey, deletedKeys[i]);
+      (void) db->tbl[0]->remove_hashed(db->tbl[0], sKey.key, sKey.length, sKey.cacheHash);
+      free(deletedKeys[i]);
+   }
+   free(deletedKeys);
+   cacheSlotStats(db);
+
+   return (result < 0) ? result : count;
 }
 
-sint_t putToCache(KISSDB* db, sint_t dataSize, char* metaKey, void* cachedData)
+static sint_t cachePut(KISSDB* db, sint_t dataSize, persComDbKey_t const* pKey, void* cachedData)
 {
    sint_t bytesWritten = 0;
 
@@ -2071,10 +3727,14 @@ sint_t putToCache(KISSDB* db, sint_t dataSize, char* metaKey, void* cachedData)
    //printf("setMemoryAddress(db->sharedCache, db->tbl[0] = %p \n", db->sharedCache );
    setMemoryAddress(db->sharedCache, db->tbl[0]); //address to first hashtable
    //put in cache
-   if (db->tbl[0]->put(db->tbl[0], metaKey, cachedData, sizeof(pers_lldb_cache_flag_e) + sizeof(int) + (size_t) dataSize) ==
+   if (db->tbl[0]->put_hashed(db->tbl[0], pKey->key, pKey->length, pKey->cacheHash, cachedData, sizeof(pers_lldb_cache_flag_e) + sizeof(int) + (size_t) dataSize) ==
          false) //store flag , datasize and data as value in cache
    {
       bytesWritten = PERS_COM_FAILURE;
+      if (ENOBUFS == errno)
+      {
+         KDB_STAT_ADD(&db->shared->stats, cacheFull, 1);
+      }
       DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("Failed to put data into cache: "); DLT_STRING(strerror(errno)));
 
 #if 0
@@ -2109,7 +3769,7 @@ sint_t putToCache(KISSDB* db, sint_t dataSize, char* metaKey, void* cachedData)
          {
             putOk = 1;
             printf("INSERT OK \n");
-            DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+            LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
                                           DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("INSERT INTO Cache Nr: "); DLT_INT(k); DLT_STRING("worked : "));
             break;
          }
@@ -2143,7 +3803,7 @@ sint_t putToCache(KISSDB* db, sint_t dataSize, char* metaKey, void* cachedData)
 
          }
          else
-            DLT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
+            LLDB_HOT_LOG(persComLldbDLTCtx, DLT_LOG_INFO,
                   DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("INSERT NEW DATA INTO RESIZE OF CACHE WORKS : "));
       }
       printf("END ----------- \n\n");
@@ -2153,12 +3813,27 @@ sint_t putToCache(KISSDB* db, sint_t dataSize, char* metaKey, void* cachedData)
    {
       bytesWritten = dataSize; // return only size of data that has to be stored
    }
+   cacheSlotStats(db);
+   return bytesWritten;
+}
+
+sint_t putToCache(KISSDB* db, sint_t dataSize, persComDbKey_t const* pKey, void* cachedData)
+{
+   sint_t bytesWritten;
+
+   PERS_PROBE3(cache_put_entry, db->dbPath, pKey->key, dataSize);
+   bytesWritten = cachePut(db, dataSize, pKey, cachedData);
+   if (bytesWritten >= 0)
+   {
+      LLDB_OP_FLAG(LLDB_OP_FLAG_CACHE);
+   }
+   PERS_PROBE3(cache_put_return, db->dbPath, pKey->key, bytesWritten);
    return bytesWritten;
 }
 
 
 
-sint_t deleteFromCache(KISSDB* db, char* metaKey)
+sint_t deleteFromCache(KISSDB* db, persComDbKey_t const* pKey)
 {
    char* ptr;
    Data_Cached_s dataCached = { 0 };
@@ -2194,7 +3869,7 @@ sint_t deleteFromCache(KISSDB* db, char* metaKey)
 
       setMemoryAddress(db->sharedCache, db->tbl[0]);
 
-      val = db->tbl[0]->get(db->tbl[0], metaKey, &size);
+      val = db->tbl[0]->get_hashed(db->tbl[0], pKey->key, pKey->length, pKey->cacheHash, &size);
       if (NULL != val) //check if key to be deleted is in Cache
       {
          ptr = val;
@@ -2205,7 +3880,7 @@ sint_t deleteFromCache(KISSDB* db, char* metaKey)
          //Mark data in cache as deleted
          if (eFlag != CachedDataDelete)
          {
-            if (db->tbl[0]->put(db->tbl[0], metaKey, &dataCached, sizeof(pers_lldb_cache_flag_e) + sizeof(int)) == false) //do not store any data
+            if (db->tbl[0]->put_hashed(db->tbl[0], pKey->key, pKey->length, pKey->cacheHash, &dataCached, sizeof(pers_lldb_cache_flag_e) + sizeof(int)) == false) //do not store any data
             {
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
                      DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("Failed to mark data in cache as deleted"));
@@ -2222,10 +3897,10 @@ sint_t deleteFromCache(KISSDB* db, char* metaKey)
       {
          //get dataSize
          uint32_t size;
-         status = KISSDB_get(db, metaKey, NULL, 0, &size);
+         status = KISSDB_get_hashed(db, pKey, NULL, 0, &size);
          if (status == 0)
          {
-            if (db->tbl[0]->put(db->tbl[0], metaKey, &dataCached, sizeof(pers_lldb_cache_flag_e) + sizeof(int)) == false)
+            if (db->tbl[0]->put_hashed(db->tbl[0], pKey->key, pKey->length, pKey->cacheHash, &dataCached, sizeof(pers_lldb_cache_flag_e) + sizeof(int)) == false)
             {
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
                      DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("Failed to mark existing data as deleted"));
@@ -2242,12 +3917,12 @@ sint_t deleteFromCache(KISSDB* db, char* metaKey)
             {
                found = Kdb_false;
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_WARN,
-                     DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_get: key=<"); DLT_STRING(metaKey); DLT_STRING(">, "); DLT_STRING("not found, retval=<"); DLT_INT(status); DLT_STRING(">"));
+                     DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_get: key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("not found, retval=<"); DLT_INT(status); DLT_STRING(">"));
             }
             else
             {
                DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR,
-                     DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_get: key=<"); DLT_STRING(metaKey); DLT_STRING(">, "); DLT_STRING("failed with retval=<"); DLT_INT(status); DLT_STRING(">"));
+                     DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("KISSDB_get: key=<"); DLT_STRING(pKey->key); DLT_STRING(">, "); DLT_STRING("failed with retval=<"); DLT_INT(status); DLT_STRING(">"));
             }
          }
       }
@@ -2256,6 +3931,7 @@ sint_t deleteFromCache(KISSDB* db, char* metaKey)
       {
          bytesDeleted = PERS_COM_ERR_NOT_FOUND;
       }
+      cacheSlotStats(db);
    }
    else
    {
@@ -2266,213 +3942,91 @@ sint_t deleteFromCache(KISSDB* db, char* metaKey)
 
 
 
-sint_t getListandSize(KISSDB* db, pstr_t buffer, sint_t size, bool_t bOnlySizeNeeded, pers_lldb_purpose_e purpose)
+/* pass every key-value pair whose key starts with prefix to callback: first the keys written or deleted in the cache,
+ * then the keys of the database file which are not in the cache. Without bWithData the values of the file are not
+ * read and the callback gets NIL data. the caller holds the mutex and the write lock of the database */
+static sint_t forEachLocked(KISSDB* db, pconststr_t prefix, bool_t bWithData, persComDbForEachCallback_t callback, void* ctx)
 {
-   char* memory = NULL;
-   char* ptr;
-   char* ptr2;
-   char** tmplist = NULL;
-   char** tmp_deleted_list = NULL;
-   int keyCountFile = 0, keyCountCache = 0, deletedKeysInCacheCount = 0, result = 0, x = 0, idx = 0, max = 0, used = 0, objCount = 0;
    KISSDB_Iterator dbi;
-   pers_lldb_cache_flag_e eFlag;
-   qhasharr_t* tbl;
+   persComDbKey_t key;
    qnobj_t obj;
-   sint_t availableSize = size;
-   void* pt;
-   int iter_ret_val;
-
-   int keylength = (purpose == PersLldbPurpose_RCT) ? PERS_RCT_MAX_LENGTH_RESOURCE_ID : PERS_DB_MAX_LENGTH_KEY_NAME;
+   size_t prefixLen = strlen(prefix);
    char kbuf[PERS_DB_MAX_LENGTH_KEY_NAME];
+   char* ptr;
+   char* value;
+   bool_t bCacheUsed = false;
+   bool_t bStop = false;
+   sint_t count = 0;
+   sint_t size;
+   int idx = 0;
+   int iterState = 0;
 
-   //open existing cache if present and look for keys
    if (db->shared->cacheCreated == Kdb_true)
    {
       if (openCache(db) != 0)
       {
          return PERS_COM_FAILURE;
       }
-      else
-      {
-         setMemoryAddress(db->sharedCache, db->tbl[0]);
+      setMemoryAddress(db->sharedCache, db->tbl[0]);
+      bCacheUsed = true;
 
-         objCount = db->tbl[0]->size(db->tbl[0], &max, &used);
-         if (objCount > 0)
+      while ((!bStop) && (db->tbl[0]->getnext(db->tbl[0], &obj, &idx) == true))
+      {
+         ptr = obj.data;
+         if (((pers_lldb_cache_flag_e) *(int*) ptr != CachedDataDelete) && (strncmp(obj.name, prefix, prefixLen) == 0))
          {
-            tmplist          = malloc(sizeof(char*) * objCount);
-            if (tmplist != NULL)
-            {
-               tmp_deleted_list = malloc(sizeof(char*) * objCount);
-               if(tmp_deleted_list != NULL)
-               {
-                  while (db->tbl[0]->getnext(db->tbl[0], &obj, &idx) == true)
-                  {
-                     size_t keyLen = strlen(obj.name);
-                     pt = obj.data;
-                     eFlag = (pers_lldb_cache_flag_e) *(int*) pt;
-                     if (eFlag != CachedDataDelete)
-                     {
-                        tmplist[keyCountCache] = (char*) malloc(keyLen + 1);
-                        (void) strncpy(tmplist[keyCountCache], obj.name, keyLen);
-                        ptr = tmplist[keyCountCache];
-                        ptr[keyLen] = '\0';
-                        keyCountCache++;
-                     } else { //get all keys marked as deleted in cache
-                       tmp_deleted_list[deletedKeysInCacheCount] = (char*) malloc(keyLen + 1);
-                       (void) strncpy(tmp_deleted_list[deletedKeysInCacheCount], obj.name, keyLen);
-                       ptr2 = tmp_deleted_list[deletedKeysInCacheCount];
-                       ptr2[keyLen] = '\0';
-                       deletedKeysInCacheCount++;
-                     }
-                  }
-               }
-               else
-               {
-                  free(tmp_deleted_list);
-                  return PERS_COM_ERR_MALLOC;
-               }
-            }
-            else
-            {
-               free(tmplist);
-               return PERS_COM_ERR_MALLOC;
-            }
+            ptr = ptr + sizeof(pers_lldb_cache_flag_e);
+            size = *(int*) ptr;
+            ptr = ptr + sizeof(int);
+            count++;
+            bStop = (callback(obj.name, ptr, size, ctx) != 0);
          }
+         free(obj.name);
+         free(obj.data);
       }
    }
 
-   //look for keys in database file
-   //Initialise database iterator
-   KISSDB_Iterator_init(db, &dbi);
-   //get number of keys, stored in database file    
-   while ( (iter_ret_val = KISSDB_Iterator_next(&dbi, &kbuf, NULL)) > 0)
+   if (!bStop)
    {
-      if (iter_ret_val == KISSDB_ITERATOR_NEXT_ITEM_FOUND)
-      {      
-          bool found_deleted = false;
-          for (x = 0; x < deletedKeysInCacheCount; x++)
-          {
-             if (strncmp(kbuf, tmp_deleted_list[x], strnlen(kbuf, sizeof(kbuf))) == 0)
-             {
-               found_deleted = true;
-             }
-          }
-          // Do not count key in file which is already marked as deleted in cache and not yet updated to file.
-          if(!found_deleted )
-          {
-            keyCountFile++;
-          }
+      value = bWithData ? (char*) malloc(PERS_DB_MAX_SIZE_KEY_DATA) : NULL;
+      if (bWithData && (value == NULL))
+      {
+         return PERS_COM_ERR_MALLOC;
       }
-   }
-
-   if ((keyCountCache + keyCountFile) > 0)
-   {
-      int memsize = qhasharr_calculate_memsize(keyCountCache + keyCountFile);
-      //create hashtable that stores the list of keys without duplicates
-      memory = malloc(memsize);
-      if (memory != NULL)
+      KISSDB_Iterator_init(db, &dbi);
+      while ((!bStop) && ((iterState = KISSDB_Iterator_next(&dbi, &kbuf, NULL)) > 0))
       {
-         memset(memory, 0, memsize);
-         tbl = qhasharr(memory, memsize);
-         if (tbl == NULL)
-         {
-            free(tmp_deleted_list);
-            free(tmplist);
-            return PERS_COM_ERR_MALLOC;
-         }
-         //put keys in cache to a hashtable
-         for (x = 0; x < keyCountCache; x++)
+         kbuf[sizeof(kbuf) - 1] = '\0';
+         if ((iterState == KISSDB_ITERATOR_NEXT_ITEM_FOUND) && (kbuf[0] != '\0') && (strncmp(kbuf, prefix, prefixLen) == 0))
          {
-           if( tmplist != NULL)
-           {
-             if (tbl->put(tbl, tmplist[x], "0", 1) == true)
-             {
-                if (tmplist[x] != NULL)
-                {
-                   free(tmplist[x]);
-                }
-             }
-           }
-         }
-         if( tmplist != NULL)
-           free(tmplist);
+            void* cached = NULL;
+            size_t cachedSize = 0;
 
-         //put keys in database file to hashtable (existing key gets overwritten -> no duplicate keys)
-         KISSDB_Iterator_init(db, &dbi);
-         memset(kbuf, 0, keylength);
-         while ( (iter_ret_val = KISSDB_Iterator_next(&dbi, &kbuf, NULL)) > 0)
-         {
-            if (iter_ret_val == KISSDB_ITERATOR_NEXT_ITEM_FOUND)
-            {
-               size_t keyLen = strnlen(kbuf, sizeof(kbuf));
-               if (keyLen > 0)
-               {
-                   //only add keys from file to temporary hashtable if they are not already marked as deleted in cache
-                  bool found_deleted = false;
-                  for (x = 0; x < deletedKeysInCacheCount; x++)
-                  {
-                    if (strncmp(kbuf, tmp_deleted_list[x], keyLen) == 0)
-                    {
-                      found_deleted = true;
-                    }
-                  }
-                  if(!found_deleted )
-                  {
-                    tbl->put(tbl, kbuf, "0", 1);
-                  }
-               }
-            }
-         }
-         // free temporary list which holds the deleted keys that are not yet updated with file
-         if( tmp_deleted_list != NULL) {
-            for (x = 0; x < deletedKeysInCacheCount; x++)
+            initKey(&key, kbuf);
+            if (bCacheUsed)
             {
-               if (tmp_deleted_list[x] != NULL)
-               {
-                 free(tmp_deleted_list[x]);
-               }
+               //keys in the cache were already passed or are deleted
+               cached = db->tbl[0]->get_hashed(db->tbl[0], key.key, key.length, key.cacheHash, &cachedSize);
             }
-            free(tmp_deleted_list);
-         }
-         //count needed size for buffer / copy keys to buffer
-         idx = 0;
-         while (tbl->getnext(tbl, &obj, &idx) == true)
-         {
-            size_t keyLen = strlen(obj.name);
-            if (keyLen > 0)
+            if (cached == NULL)
             {
-               if ((!bOnlySizeNeeded) && ((sint_t) keyLen < availableSize))
+               size = bWithData ? getFromDatabaseFile(db, &key, value, PERS_DB_MAX_SIZE_KEY_DATA) : 0;
+               if (size >= 0)
                {
-                  (void) strncpy(buffer, obj.name, keyLen);
-                  *(buffer + keyLen) = ListItemsSeparator;
-                  buffer += (keyLen + sizeof(ListItemsSeparator));
-                  availableSize -= (sint_t) (keyLen + sizeof(ListItemsSeparator));
+                  count++;
+                  bStop = (callback(kbuf, value, size, ctx) != 0);
                }
             }
-            result += (sint_t) (keyLen + sizeof(ListItemsSeparator));
+            free(cached);
          }
-         //release hashtable and allocated memory
-         tbl->free(tbl);
-         free(memory);
       }
-      else
+      free(value);
+      if (iterState < 0)
       {
-         // free temporary list which holds the deleted keys that are not yet updated with file
-         if( tmp_deleted_list != NULL) {
-            for (x = 0; x < deletedKeysInCacheCount; x++)
-            {
-               if (tmp_deleted_list[x] != NULL)
-               {
-                 free(tmp_deleted_list[x]);
-               }
-            }
-            free(tmp_deleted_list);
-            free(tmplist);
-         }
-         return PERS_COM_ERR_MALLOC;
+         count = PERS_COM_FAILURE;
       }
    }
-   return result;
+   return count;
 }
 
 int createCache(KISSDB* db)
@@ -2480,10 +4034,22 @@ int createCache(KISSDB* db)
    Kdb_bool shmCreator;
    int status = -1;
 
-   db->sharedCacheFd = kdbShmemOpen(db->cacheName, PERS_CACHE_MEMSIZE, &shmCreator);
+   if (db->privateMode == Kdb_true)
+   {
+      //process private: the cache is not shared with other processes
+      db->sharedCacheFd = 0;
+      db->sharedCache = (void*) getKdbPrivatePtr(PERS_CACHE_MEMSIZE);
+   }
+   else
+   {
+      db->sharedCacheFd = kdbShmemOpen(db->cacheName, PERS_CACHE_MEMSIZE, &shmCreator);
+      if (db->sharedCacheFd != -1)
+      {
+         db->sharedCache = (void*) getKdbShmemPtr(db->sharedCacheFd, PERS_CACHE_MEMSIZE);
+      }
+   }
    if (db->sharedCacheFd != -1)
    {
-      db->sharedCache = (void*) getKdbShmemPtr(db->sharedCacheFd, PERS_CACHE_MEMSIZE);
       if (db->sharedCache != ((void*) -1))
       {
          // for dynamic cache -> create reference into array db->tbl[0] = qhasharr(db->sharedCache, PERS_CACHE_MEMSIZE);
@@ -2515,7 +4081,7 @@ int openCache(KISSDB* db)
    int status = -1;
 
    //only open shared memory again if filedescriptor is not initialised yet
-   if (db->sharedCacheFd <= 0) //not shared filedescriptor
+   if (db->sharedCacheFd <= 0 && db->privateMode == Kdb_false) //not shared filedescriptor
    {
       db->sharedCacheFd = kdbShmemOpen(db->cacheName, PERS_CACHE_MEMSIZE, &shmCreator);
       if (db->sharedCacheFd != -1)
@@ -2584,7 +4150,7 @@ int addCache(KISSDB* db)
 int closeCache(KISSDB* db)
 {
    int status = -1;
-   if (kdbShmemClose(db->sharedCacheFd, db->cacheName) != Kdb_false)
+   if (db->privateMode == Kdb_true || kdbShmemClose(db->sharedCacheFd, db->cacheName) != Kdb_false)
    {
       if (freeKdbShmemPtr(db->sharedCache, PERS_CACHE_MEMSIZE) != Kdb_false)
       {
@@ -2597,3 +4163,374 @@ int closeCache(KISSDB* db)
    }
    return status;
 }
+
+
+/* map the key directory with size bytes in this process, the shared memory is resized if bResize is set */
+static int keyDirMap(KISSDB* db, uint64_t size, bool_t bResize)
+{
+   Kdb_bool shmCreator;
+
+   if (db->keyDirTbl != NULL)
+   {
+      db->keyDirTbl->free(db->keyDirTbl);
+      db->keyDirTbl = NULL;
+   }
+   if (db->keyDir != NULL)
+   {
+      (void) freeKdbShmemPtr(db->keyDir, db->keyDirMappedSize);
+      db->keyDir = NULL;
+      db->keyDirMappedSize = 0;
+   }
+
+   if (db->privateMode == Kdb_true)
+   {
+      db->keyDir = getKdbPrivatePtr(size);
+   }
+   else
+   {
+      if (db->keyDirFd <= 0)
+      {
+         db->keyDirFd = kdbShmemOpen(db->keyDirName, size, &shmCreator);
+         if (db->keyDirFd < 0)
+         {
+            db->keyDirFd = 0;
+            return -1;
+         }
+      }
+      if (bResize && (ftruncate(db->keyDirFd, (off_t) size) < 0))
+      {
+         return -1;
+      }
+      db->keyDir = getKdbShmemPtr(db->keyDirFd, size);
+   }
+   if (db->keyDir == ((void*) -1))
+   {
+      db->keyDir = NULL;
+      return -1;
+   }
+   db->keyDirMappedSize = size;
+   return 0;
+}
+
+/* make the key directory usable by this process (it can have been built or resized by another instance).
+ * returns 0 if the key directory holds all keys of the database */
+static int keyDirAttach(KISSDB* db)
+{
+   if (db->shared->keyDirValid != Kdb_true)
+   {
+      return -1;
+   }
+   if ((db->keyDirTbl == NULL) || (db->keyDirMappedSize != db->shared->keyDirShmSize))
+   {
+      if (keyDirMap(db, db->shared->keyDirShmSize, false) != 0)
+      {
+         return -1;
+      }
+      db->keyDirTbl = qhasharr(db->keyDir, 0);
+      if (db->keyDirTbl == NULL)
+      {
+         return -1;
+      }
+   }
+   setMemoryAddress(db->keyDir, db->keyDirTbl);
+   return 0;
+}
+
+static signed int keyDirSkipCallback(char const* key, char const* data, signed int dataSize, void* ctx)
+{
+   return 0;
+}
+
+static signed int keyDirAddCallback(char const* key, char const* data, signed int dataSize, void* ctx)
+{
+   persComDbKey_t sKey;
+
+   initKey(&sKey, key);
+   keyDirAdd((KISSDB*) ctx, &sKey);
+   return 0;
+}
+
+/* build the key directory from the cache and the database file, with twice as many slots as keys.
+ * the memory of the key directory never shrinks, another instance can still access it with the old size */
+static int keyDirBuild(KISSDB* db)
+{
+   sint_t keyCount;
+   uint64_t memsize;
+
+   db->shared->keyDirValid = Kdb_false;
+   keyCount = forEachLocked(db, "", false, keyDirSkipCallback, NIL);
+   if (keyCount < 0)
+   {
+      return -1;
+   }
+   memsize = qhasharr_calculate_memsize((2 * keyCount > PERS_LLDB_KEYDIR_MIN_SLOTS) ? (2 * keyCount) : PERS_LLDB_KEYDIR_MIN_SLOTS);
+   if (memsize < db->shared->keyDirShmSize)
+   {
+      memsize = db->shared->keyDirShmSize;
+   }
+   if (keyDirMap(db, memsize, true) != 0)
+   {
+      DLT_LOG(persComLldbDLTCtx, DLT_LOG_ERROR, DLT_STRING(__FUNCTION__); DLT_STRING(":"); DLT_STRING("Failed to map key directory"); DLT_STRING(strerror(errno)));
+      return -1;
+   }
+   (void) memset(db->keyDir, 0, (size_t) memsize);
+   db->keyDirTbl = qhasharr(db->keyDir, (size_t) memsize);
+   if (db->keyDirTbl == NULL)
+   {
+      return -1;
+   }
+   db->shared->keyDirShmSize = memsize;
+   db->shared->keyDirListSize = 0;
+   db->shared->keyDirValid = Kdb_true;
+
+   //keyDirAdd invalidates the key directory again if a key can not be added
+   if (forEachLocked(db, "", false, keyDirAddCallback, db) < 0)
+   {
+      db->shared->keyDirValid = Kdb_false;
+   }
+   return (db->shared->keyDirValid == Kdb_true) ? 0 : -1;
+}
+
+/* add a written key to the key directory (nothing to do if it is not built yet) */
+static void keyDirAdd(KISSDB* db, persComDbKey_t const* pKey)
+{
+   int maxSlots = 0;
+   int usedSlots = 0;
+   int keyCount;
+
+   if (keyDirAttach(db) == 0)
+   {
+      keyCount = db->keyDirTbl->size(db->keyDirTbl, &maxSlots, &usedSlots);
+      if (db->keyDirTbl->put_hashed(db->keyDirTbl, pKey->key, pKey->length, pKey->cacheHash, "0", 1) == false)
+      {
+         //no free slot: the key directory is built again with more slots by the next listing
+         db->shared->keyDirValid = Kdb_false;
+      }
+      else if (db->keyDirTbl->size(db->keyDirTbl, &maxSlots, &usedSlots) > keyCount)
+      {
+         db->shared->keyDirListSize += (int32_t) (pKey->length + sizeof(ListItemsSeparator));
+      }
+   }
+}
+
+/* remove a deleted key from the key directory (nothing to do if it is not built yet) */
+static void keyDirRemove(KISSDB* db, persComDbKey_t const* pKey)
+{
+   if (keyDirAttach(db) == 0)
+   {
+      if (db->keyDirTbl->remove_hashed(db->keyDirTbl, pKey->key, pKey->length, pKey->cacheHash) == true)
+      {
+         db->shared->keyDirListSize -= (int32_t) (pKey->length + sizeof(ListItemsSeparator));
+      }
+   }
+}
+
+/* make the key directory usable, the first user builds it. returns 0 if the key directory can be used */
+static int keyDirUse(KISSDB* db)
+{
+   if (keyDirAttach(db) != 0)
+   {
+      if (keyDirBuild(db) != 0)
+      {
+         return -1;
+      }
+      setMemoryAddress(db->keyDir, db->keyDirTbl);
+   }
+   return 0;
+}
+
+/* size of the list of all keys, the keys are copied to buffer if buffer is not NIL.
+ * the key directory is built by the first listing, afterwards the size is known without any search */
+static sint_t keyDirList(KISSDB* db, pstr_t buffer, sint_t size)
+{
+   qhasharr_slot_t* slots;
+   sint_t availableSize = size;
+   int idx;
+
+   if (keyDirUse(db) != 0)
+   {
+      return PERS_COM_FAILURE;
+   }
+
+   if (NIL != buffer)
+   {
+      slots = db->keyDirTbl->data->slots;
+      for (idx = 0; idx < db->keyDirTbl->data->maxslots; idx++)
+      {
+         //empty slots and extension blocks hold no key
+         if ((slots[idx].count != 0) && (slots[idx].count != -2))
+         {
+            sint_t keyLen = (sint_t) slots[idx].data.pair.keylen;
+            if (keyLen < availableSize)
+            {
+               (void) memcpy(buffer, slots[idx].data.pair.key, (size_t) keyLen);
+               buffer[keyLen] = ListItemsSeparator;
+               buffer += keyLen + (sint_t) sizeof(ListItemsSeparator);
+               availableSize -= keyLen + (sint_t) sizeof(ListItemsSeparator);
+            }
+         }
+      }
+   }
+   return db->shared->keyDirListSize;
+}
+
+/* max-heap of the keys of a page, ordered by hash and slot */
+static bool_t keyDirEntryGreater(lldb_keydir_entry_s const* a, lldb_keydir_entry_s const* b)
+{
+   return (a->hash > b->hash) || ((a->hash == b->hash) && (a->idx > b->idx));
+}
+
+static void keyDirHeapSiftDown(lldb_keydir_entry_s* heap, sint_t count, sint_t pos)
+{
+   lldb_keydir_entry_s tmp;
+   sint_t child;
+
+   while ((child = (2 * pos) + 1) < count)
+   {
+      if ((child + 1 < count) && keyDirEntryGreater(&heap[child + 1], &heap[child]))
+      {
+         child++;
+      }
+      if (!keyDirEntryGreater(&heap[child], &heap[pos]))
+      {
+         break;
+      }
+      tmp = heap[pos];
+      heap[pos] = heap[child];
+      heap[child] = tmp;
+      pos = child;
+   }
+}
+
+static void keyDirHeapPush(lldb_keydir_entry_s* heap, sint_t count, lldb_keydir_entry_s const* pEntry)
+{
+   sint_t pos = count;
+   sint_t parent;
+
+   heap[pos] = *pEntry;
+   while (pos > 0)
+   {
+      parent = (pos - 1) / 2;
+      if (!keyDirEntryGreater(&heap[pos], &heap[parent]))
+      {
+         break;
+      }
+      heap[pos] = heap[parent];
+      heap[parent] = *pEntry;
+      pos = parent;
+   }
+}
+
+/* copy the keys with the smallest hashes >= cursor - 1 into buffer. The keys of one hash are never split over two pages,
+ * so the next page starts with the first hash which did not fit (cursor = hash + 1, 0 after the last page).
+ * The order does not depend on the slots, a key existing during the whole listing is returned exactly once. */
+static sint_t keyDirListPage(KISSDB* db, uint64_t cursor, pstr_t buffer, sint_t size, uint64_t* pNextCursor)
+{
+   qhasharr_slot_t* slots;
+   lldb_keydir_entry_s* heap;
+   lldb_keydir_entry_s entry;
+   uint64_t minHash = (cursor > 0) ? (cursor - 1) : 0;
+   uint64_t cutHash = 0;
+   bool_t bCut = false;
+   sint_t count = 0;
+   sint_t used = 0;
+   sint_t i;
+   int idx;
+
+   if (keyDirUse(db) != 0)
+   {
+      return PERS_COM_FAILURE;
+   }
+   //every key needs at least 2 bytes in the page, one more entry is pushed before the page is trimmed
+   heap = (lldb_keydir_entry_s*) malloc(((size_t) size / 2 + 2) * sizeof(lldb_keydir_entry_s));
+   if (heap == NULL)
+   {
+      return PERS_COM_ERR_MALLOC;
+   }
+
+   slots = db->keyDirTbl->data->slots;
+   for (idx = 0; idx < db->keyDirTbl->data->maxslots; idx++)
+   {
+      if ((slots[idx].count != 0) && (slots[idx].count != -2) && (slots[idx].keyhash >= minHash)
+          && ((!bCut) || (slots[idx].keyhash < cutHash)))
+      {
+         entry.hash = slots[idx].keyhash;
+         entry.idx = idx;
+         keyDirHeapPush(heap, count, &entry);
+         count++;
+         used += (sint_t) (slots[idx].data.pair.keylen + sizeof(ListItemsSeparator));
+         //drop the keys with the greatest hashes until the page fits
+         while (used > size)
+         {
+            cutHash = heap[0].hash;
+            bCut = true;
+            used -= (sint_t) (slots[heap[0].idx].data.pair.keylen + sizeof(ListItemsSeparator));
+            heap[0] = heap[--count];
+            keyDirHeapSiftDown(heap, count, 0);
+         }
+      }
+   }
+   //the remaining keys of the first hash which did not fit are listed with the next page
+   while (bCut && (count > 0) && (heap[0].hash >= cutHash))
+   {
+      used -= (sint_t) (slots[heap[0].idx].data.pair.keylen + sizeof(ListItemsSeparator));
+      heap[0] = heap[--count];
+      keyDirHeapSiftDown(heap, count, 0);
+   }
+   if (bCut && (count == 0))
+   {
+      free(heap);
+      return PERS_COM_ERR_BUFFER_TOO_SMALL;
+   }
+
+   //heap sort: ascending order of the hashes
+   for (i = count - 1; i > 0; i--)
+   {
+      entry = heap[0];
+      heap[0] = heap[i];
+      heap[i] = entry;
+      keyDirHeapSiftDown(heap, i, 0);
+   }
+   for (i = 0; i < count; i++)
+   {
+      sint_t keyLen = (sint_t) slots[heap[i].idx].data.pair.keylen;
+      (void) memcpy(buffer, slots[heap[i].idx].data.pair.key, (size_t) keyLen);
+      buffer[keyLen] = ListItemsSeparator;
+      buffer += keyLen + (sint_t) sizeof(ListItemsSeparator);
+   }
+   free(heap);
+
+   *pNextCursor = bCut ? (cutHash + 1) : 0;
+   return used;
+}
+
+/* unmap the key directory, the last instance removes the shared memory */
+static void keyDirClose(KISSDB* db, bool_t bLastInstance)
+{
+   if (db->keyDirTbl != NULL)
+   {
+      db->keyDirTbl->free(db->keyDirTbl);
+      db->keyDirTbl = NULL;
+   }
+   if (db->keyDir != NULL)
+   {
+      (void) freeKdbShmemPtr(db->keyDir, db->keyDirMappedSize);
+      db->keyDir = NULL;
+      db->keyDirMappedSize = 0;
+   }
+   if (db->keyDirFd > 0)
+   {
+      close(db->keyDirFd);
+      db->keyDirFd = 0;
+   }
+   if (bLastInstance)
+   {
+      if ((db->privateMode == Kdb_false) && (db->shared->keyDirShmSize > 0))
+      {
+         (void) shm_unlink(db->keyDirName);
+      }
+      db->shared->keyDirValid = Kdb_false;
+      db->shared->keyDirShmSize = 0;
+      db->shared->keyDirListSize = 0;
+   }
+}
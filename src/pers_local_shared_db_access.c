@@ -47,7 +47,7 @@ int persComDbgetMaxKeyValueSize(void)
  * \note : DB is created if it does not exist and (bForceCreationIfNotPresent != 0)
  *
  * \param dbPathname    [in] absolute path to database (length limited to \ref PERS_ORG_MAX_LENGTH_PATH_FILENAME)
- * \param bOption       [in] bitfield option: 0x01: create if not exists, 0x02: write through, 0x04: read only
+ * \param bOption       [in] bitfield option: 0x01: create if not exists, 0x02: write through, 0x04: read only, 0x10: process private (no shared memory, exclusive use by one handle)
  * \Remarks the support of the option depends from backend database realisation
  * \return >= 0 for valid handler, negative value for error (\ref PERS_COM_ERROR_CODES_DEFINES)
  */
@@ -112,9 +112,9 @@ signed int persComDbClose(signed int handlerDB)
 signed int persComDbWriteKey(signed int handlerDB, char const * key, char const * data, signed int dataSize)
 {
     sint_t iErrCode = PERS_COM_SUCCESS ;
+    persComDbKey_t sKey ;
 
     if(     (handlerDB < 0)
-        ||  (NIL == key)
         ||  (NIL == data)
         ||  (dataSize <= 0)
         ||  (dataSize > PERS_DB_MAX_SIZE_KEY_DATA)
@@ -124,15 +124,12 @@ signed int persComDbWriteKey(signed int handlerDB, char const * key, char const
     }
     else
     {
-        if(strlen(key) >= PERS_DB_MAX_LENGTH_KEY_NAME)
-        {
-            iErrCode = PERS_COM_ERR_INVALID_PARAM ;
-        }
+        iErrCode = persComDbPrepareKey(key, &sKey) ;
     }
 
     if(PERS_COM_SUCCESS == iErrCode)
     {
-        iErrCode = pers_lldb_write_key(handlerDB, PersLldbPurpose_DB, key, data, dataSize) ;
+        iErrCode = pers_lldb_write_key_prepared(handlerDB, PersLldbPurpose_DB, &sKey, data, dataSize) ;
     }
 
     return iErrCode ;
@@ -152,9 +149,9 @@ signed int persComDbWriteKey(signed int handlerDB, char const * key, char const
 signed int persComDbReadKey(signed int handlerDB, char const * key, char* dataBuffer_out, signed int dataBufferSize)
 {
     sint_t iErrCode = PERS_COM_SUCCESS ;
+    persComDbKey_t sKey ;
 
     if(     (handlerDB < 0)
-        ||  (NIL == key)
         ||  (NIL == dataBuffer_out)
         ||  (dataBufferSize <= 0)
     )
@@ -163,15 +160,12 @@ signed int persComDbReadKey(signed int handlerDB, char const * key, char* dataBu
     }
     else
     {
-        if(strlen(key) >= PERS_DB_MAX_LENGTH_KEY_NAME)
-        {
-            iErrCode = PERS_COM_ERR_INVALID_PARAM ;
-        }
+        iErrCode = persComDbPrepareKey(key, &sKey) ;
     }
 
     if(PERS_COM_SUCCESS == iErrCode)
     {
-        iErrCode = pers_lldb_read_key(handlerDB, PersLldbPurpose_DB, key, dataBuffer_out, dataBufferSize) ;
+        iErrCode = pers_lldb_read_key_prepared(handlerDB, PersLldbPurpose_DB, &sKey, dataBuffer_out, dataBufferSize) ;
     }
 
     return iErrCode ;
@@ -188,24 +182,58 @@ signed int persComDbReadKey(signed int handlerDB, char const * key, char* dataBu
 signed int persComDbGetKeySize(signed int handlerDB, char const * key)
 {
     sint_t iErrCode = PERS_COM_SUCCESS ;
+    persComDbKey_t sKey ;
+
+    if(handlerDB < 0)
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+    else
+    {
+        iErrCode = persComDbPrepareKey(key, &sKey) ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_get_key_size_prepared(handlerDB, PersLldbPurpose_DB, &sKey) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief read a key's value from local/shared database into a buffer of the key's size
+ * \note : the key is looked up once, replaces \ref persComDbGetKeySize followed by \ref persComDbReadKey.
+ *         No buffer is allocated for a key with empty data (*dataBuffer_out is set to NIL).
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param key               [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param allocator         [in] function returning the buffer for the data, see \ref persComDbAllocCallback_t
+ *                               (NIL: the buffer is allocated with malloc and must be released with free)
+ * \param ctx               [in] context passed to the allocator
+ * \param dataBuffer_out    [out]buffer returned by the allocator, filled with the key's data
+ *
+ * \return read size, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbReadKeyAlloc(signed int handlerDB, char const * key, persComDbAllocCallback_t allocator, void * ctx, char ** dataBuffer_out)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+    persComDbKey_t sKey ;
 
     if(     (handlerDB < 0)
-        ||  (NIL == key)
+        ||  (NIL == dataBuffer_out)
     )
     {
         iErrCode = PERS_COM_ERR_INVALID_PARAM ;
     }
     else
     {
-        if(strlen(key) >= PERS_DB_MAX_LENGTH_KEY_NAME)
-        {
-            iErrCode = PERS_COM_ERR_INVALID_PARAM ;
-        }
+        iErrCode = persComDbPrepareKey(key, &sKey) ;
     }
 
     if(PERS_COM_SUCCESS == iErrCode)
     {
-        iErrCode = pers_lldb_get_key_size(handlerDB, PersLldbPurpose_DB, key) ;
+        iErrCode = pers_lldb_read_key_alloc_prepared(handlerDB, PersLldbPurpose_DB, &sKey, allocator, ctx, dataBuffer_out) ;
     }
 
     return iErrCode ;
@@ -222,24 +250,20 @@ signed int persComDbGetKeySize(signed int handlerDB, char const * key)
 signed int persComDbDeleteKey(signed int handlerDB, char const * key)
 {
     sint_t iErrCode = PERS_COM_SUCCESS ;
+    persComDbKey_t sKey ;
 
-    if(     (handlerDB < 0)
-        ||  (NIL == key)
-    )
+    if(handlerDB < 0)
     {
         iErrCode = PERS_COM_ERR_INVALID_PARAM ;
     }
     else
     {
-        if(strlen(key) >= PERS_DB_MAX_LENGTH_KEY_NAME)
-        {
-            iErrCode = PERS_COM_ERR_INVALID_PARAM ;
-        }
+        iErrCode = persComDbPrepareKey(key, &sKey) ;
     }
 
     if(PERS_COM_SUCCESS == iErrCode)
     {
-        iErrCode = pers_lldb_delete_key(handlerDB, PersLldbPurpose_DB, key) ;
+        iErrCode = pers_lldb_delete_key_prepared(handlerDB, PersLldbPurpose_DB, &sKey) ;
     }
 
     return iErrCode ;
@@ -300,3 +324,587 @@ signed int persComDbGetKeysList(signed int handlerDB, char* listBuffer_out, sign
     return iErrCode ;
 }
 
+
+/**
+ * \brief prepare a key for repeated access: length and hash of the key's name are computed only once
+ *
+ * \param key           [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param pKey_out      [out]prepared key to be used with the persComDb...Prepared functions
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbPrepareKey(char const * key, persComDbKey_t * pKey_out)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (NIL == key)
+        ||  (NIL == pKey_out)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+    else
+    {
+        iErrCode = pers_lldb_prepare_key(key, pKey_out) ;
+        if(     (PERS_COM_SUCCESS == iErrCode)
+            &&  (pKey_out->length >= PERS_DB_MAX_LENGTH_KEY_NAME)
+        )
+        {
+            iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+        }
+    }
+
+    return iErrCode ;
+}
+
+/* check a key given by the application as prepared key */
+static bool_t persComDbIsValidPreparedKey(persComDbKey_t const * pKey)
+{
+    return (bool_t)(    (NIL != pKey)
+                    &&  (NIL != pKey->key)
+                    &&  (pKey->length < PERS_DB_MAX_LENGTH_KEY_NAME) ) ;
+}
+
+/**
+ * \brief write a key-value pair into local/shared database, the key is given as prepared key
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param pKey          [in] key prepared with \ref persComDbPrepareKey
+ * \param data          [in] buffer with key's data
+ * \param dataSize      [in] size of key's data (max allowed \ref PERS_DB_MAX_SIZE_KEY_DATA)
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbWriteKeyPrepared(signed int handlerDB, persComDbKey_t const * pKey, char const * data, signed int dataSize)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (! persComDbIsValidPreparedKey(pKey))
+        ||  (NIL == data)
+        ||  (dataSize <= 0)
+        ||  (dataSize > PERS_DB_MAX_SIZE_KEY_DATA)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_write_key_prepared(handlerDB, PersLldbPurpose_DB, pKey, data, dataSize) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief write a key-value pair into local/shared database without waiting for the write
+ * \note : the write is queued and done by the write worker thread of the process, in the order of the calls.
+ *         Until it is done, reads of the key in this process return the queued data; all other accesses to
+ *         the database (writes, deletes, lists, close) wait until the queued writes are done.
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param key           [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param data          [in] buffer with key's data, copied
+ * \param dataSize      [in] size of key's data (max allowed \ref PERS_DB_MAX_SIZE_KEY_DATA)
+ * \param callback      [in] function called when the write is done, see \ref persComDbWriteCallback_t (can be NIL)
+ * \param ctx           [in] context passed to the callback
+ *
+ * \return 0 if the write is queued, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbWriteKeyAsync(signed int handlerDB, char const * key, char const * data, signed int dataSize,
+                                  persComDbWriteCallback_t callback, void * ctx)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+    persComDbKey_t sKey ;
+
+    if(     (handlerDB < 0)
+        ||  (NIL == data)
+        ||  (dataSize <= 0)
+        ||  (dataSize > PERS_DB_MAX_SIZE_KEY_DATA)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+    else
+    {
+        iErrCode = persComDbPrepareKey(key, &sKey) ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_write_key_async(handlerDB, PersLldbPurpose_DB, &sKey, data, dataSize, callback, ctx) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief file descriptor to poll for the end of writes queued with \ref persComDbWriteKeyAsync
+ * \note : eventfd (non blocking) readable when writes are done, reading it returns the number of writes done
+ *         since the last read. The descriptor belongs to the library and must not be closed.
+ *
+ * \return file descriptor, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbGetAsyncWriteFd(void)
+{
+    return pers_lldb_get_async_write_fd() ;
+}
+
+/**
+ * \brief read a key's value from local/shared database, the key is given as prepared key
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param pKey              [in] key prepared with \ref persComDbPrepareKey
+ * \param dataBuffer_out    [out]buffer where to return the read data
+ * \param dataBufferSize    [in] size of dataBuffer_out
+ *
+ * \return read size, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbReadKeyPrepared(signed int handlerDB, persComDbKey_t const * pKey, char* dataBuffer_out, signed int dataBufferSize)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (! persComDbIsValidPreparedKey(pKey))
+        ||  (NIL == dataBuffer_out)
+        ||  (dataBufferSize <= 0)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_read_key_prepared(handlerDB, PersLldbPurpose_DB, pKey, dataBuffer_out, dataBufferSize) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief read a key's size from local/shared database, the key is given as prepared key
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param pKey              [in] key prepared with \ref persComDbPrepareKey
+ *
+ * \return key's size, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbGetKeySizePrepared(signed int handlerDB, persComDbKey_t const * pKey)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (! persComDbIsValidPreparedKey(pKey))
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_get_key_size_prepared(handlerDB, PersLldbPurpose_DB, pKey) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief delete key from local/shared database, the key is given as prepared key
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param pKey          [in] key prepared with \ref persComDbPrepareKey
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbDeleteKeyPrepared(signed int handlerDB, persComDbKey_t const * pKey)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (! persComDbIsValidPreparedKey(pKey))
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_delete_key_prepared(handlerDB, PersLldbPurpose_DB, pKey) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief read the values of several keys from local/shared database with one access to the database
+ * \note : the keys are read one after the other, an error of one key does not stop the others
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param keys              [in] keys' names (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param dataBuffers_out   [out]buffers where to return the read data, one per key
+ * \param dataBufferSizes   [in] sizes of the buffers
+ * \param results_out       [out]per key: read size, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ * \param count             [in] number of keys (size of the arrays)
+ *
+ * \return number of keys read, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbReadKeys(signed int handlerDB, char const * const * keys, char * const * dataBuffers_out,
+                             signed int const * dataBufferSizes, signed int * results_out, signed int count)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (NIL == keys)
+        ||  (NIL == dataBuffers_out)
+        ||  (NIL == dataBufferSizes)
+        ||  (NIL == results_out)
+        ||  (count < 0)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_read_keys(handlerDB, PersLldbPurpose_DB, keys, dataBuffers_out, dataBufferSizes, results_out, count) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief write several key-value pairs into local/shared database with one access to the database
+ * \note : the keys are written one after the other, an error of one key does not stop the others
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param keys              [in] keys' names (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param data              [in] buffers with the keys' data
+ * \param dataSizes         [in] sizes of the keys' data (max allowed \ref PERS_DB_MAX_SIZE_KEY_DATA)
+ * \param results_out       [out]per key: same value as returned by \ref persComDbWriteKey
+ * \param count             [in] number of keys (size of the arrays)
+ *
+ * \return number of keys written, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbWriteKeys(signed int handlerDB, char const * const * keys, char const * const * data,
+                              signed int const * dataSizes, signed int * results_out, signed int count)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (NIL == keys)
+        ||  (NIL == data)
+        ||  (NIL == dataSizes)
+        ||  (NIL == results_out)
+        ||  (count < 0)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_write_keys(handlerDB, PersLldbPurpose_DB, keys, data, dataSizes, results_out, count) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief delete several keys from local/shared database with one access to the database
+ * \note : the keys are deleted one after the other, an error of one key does not stop the others
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param keys              [in] keys' names (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param results_out       [out]per key: same value as returned by \ref persComDbDeleteKey
+ * \param count             [in] number of keys (size of the arrays)
+ *
+ * \return number of keys deleted, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbDeleteKeys(signed int handlerDB, char const * const * keys, signed int * results_out, signed int count)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (NIL == keys)
+        ||  (NIL == results_out)
+        ||  (count < 0)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_delete_keys(handlerDB, PersLldbPurpose_DB, keys, results_out, count) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief call a function for every key-value pair in local/shared database
+ * \note : the keys are passed in no particular order, without building the list of keys.
+ *         The database is locked during the iteration, the callback must not access the same database.
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param prefix        [in] only keys starting with prefix are passed to the callback (NIL or "" for all keys)
+ * \param callback      [in] function called for every key-value pair, see \ref persComDbForEachCallback_t
+ * \param ctx           [in] context passed to the callback
+ *
+ * \return number of key-value pairs passed to the callback, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbForEach(signed int handlerDB, char const * prefix, persComDbForEachCallback_t callback, void * ctx)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (NIL == callback)
+        ||  ((NIL != prefix) && (strlen(prefix) >= PERS_DB_MAX_LENGTH_KEY_NAME))
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_for_each(handlerDB, PersLldbPurpose_DB, prefix, callback, ctx) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief list the keys' names of local/shared database page by page
+ * \note : keys are separated by '\0'.
+ *         The pages are listed in the order of the keys' hashes, not in alphabetical order.
+ *         A key existing during the whole listing is returned exactly once, keys written or deleted
+ *         during the listing may be returned or not.
+ *
+ * \param handlerDB         [in] handler obtained with persComDbOpen
+ * \param cursor            [in] 0 for the first page, otherwise the value of nextCursor_out of the previous page
+ * \param listBuffer_out    [out]buffer where to return the page
+ * \param listBufferSize    [in] size of listBuffer_out
+ * \param nextCursor_out    [out]cursor of the next page, 0 after the last page
+ *
+ * \return size of the page (can be 0 only for the last page), or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES).
+ *         \ref PERS_COM_ERR_BUFFER_TOO_SMALL if the next key does not fit in listBuffer_out
+ */
+signed int persComDbListKeysPage(signed int handlerDB, unsigned long long cursor, char* listBuffer_out, signed int listBufferSize,
+                                 unsigned long long * nextCursor_out)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (NIL == listBuffer_out)
+        ||  (listBufferSize <= 0)
+        ||  (NIL == nextCursor_out)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_list_keys_page(handlerDB, PersLldbPurpose_DB, cursor, listBuffer_out, listBufferSize, nextCursor_out) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief start a transaction on local/shared database
+ * \note : the puts and deletes of the transaction are not visible before \ref persComDbTxCommit, which applies
+ *         all of them or none of them, also after a crash. The commit costs one sync of the transaction log whatever
+ *         the number of operations (plus one sync of the database file in write through mode).
+ *         A transaction is used by one thread at a time.
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ *
+ * \return transaction id (positive value), or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbTxBegin(signed int handlerDB)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(handlerDB < 0)
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_tx_begin(handlerDB, PersLldbPurpose_DB) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief add the write of a key-value pair to a transaction
+ *
+ * \param txId          [in] transaction id obtained with \ref persComDbTxBegin
+ * \param key           [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ * \param data          [in] buffer with key's data, copied
+ * \param dataSize      [in] size of key's data (max allowed \ref PERS_DB_MAX_SIZE_KEY_DATA)
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbTxPut(signed int txId, char const * key, char const * data, signed int dataSize)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+    persComDbKey_t sKey ;
+
+    if(     (txId < 0)
+        ||  (NIL == data)
+        ||  (dataSize <= 0)
+        ||  (dataSize > PERS_DB_MAX_SIZE_KEY_DATA)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+    else
+    {
+        iErrCode = persComDbPrepareKey(key, &sKey) ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_tx_put(txId, &sKey, data, dataSize) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief add the delete of a key to a transaction
+ * \note : the delete of a key which does not exist is not an error of the commit
+ *
+ * \param txId          [in] transaction id obtained with \ref persComDbTxBegin
+ * \param key           [in] key's name (length limited to \ref PERS_DB_MAX_LENGTH_KEY_NAME)
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbTxDelete(signed int txId, char const * key)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+    persComDbKey_t sKey ;
+
+    if(txId < 0)
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+    else
+    {
+        iErrCode = persComDbPrepareKey(key, &sKey) ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_tx_delete(txId, &sKey) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief apply all the puts and deletes of a transaction, in the order they were added
+ * \note : the transaction is released, also in case of error
+ *
+ * \param txId          [in] transaction id obtained with \ref persComDbTxBegin
+ *
+ * \return number of operations of the transaction, or negative value in case of error (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbTxCommit(signed int txId)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(txId < 0)
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_tx_commit(txId) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief release a transaction without applying its puts and deletes
+ *
+ * \param txId          [in] transaction id obtained with \ref persComDbTxBegin
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbTxAbort(signed int txId)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(txId < 0)
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_tx_abort(txId) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief write the data of a local/shared database to its file without closing the database
+ * \note : in write cached mode only the data written or deleted since the previous sync is written back
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ *
+ * \return number of keys written back or deleted, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbSync(signed int handlerDB)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(handlerDB < 0)
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_sync(handlerDB, PersLldbPurpose_DB) ;
+    }
+
+    return iErrCode ;
+}
+
+/**
+ * \brief write a consistent copy of a local/shared database to a file without closing the database
+ *
+ * \param handlerDB     [in] handler obtained with persComDbOpen
+ * \param destPath      [in] path of the copy, not the path of the database (length limited to \ref PERS_ORG_MAX_LENGTH_PATH_FILENAME)
+ *
+ * \return 0 for success, negative value otherwise (\ref PERS_COM_ERROR_CODES_DEFINES)
+ */
+signed int persComDbSnapshot(signed int handlerDB, char const * destPath)
+{
+    sint_t iErrCode = PERS_COM_SUCCESS ;
+
+    if(     (handlerDB < 0)
+        ||  (NIL == destPath)
+        ||  (strlen(destPath) >= PERS_ORG_MAX_LENGTH_PATH_FILENAME)
+    )
+    {
+        iErrCode = PERS_COM_ERR_INVALID_PARAM ;
+    }
+
+    if(PERS_COM_SUCCESS == iErrCode)
+    {
+        iErrCode = pers_lldb_snapshot(handlerDB, PersLldbPurpose_DB, destPath) ;
+    }
+
+    return iErrCode ;
+}
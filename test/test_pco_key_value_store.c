@@ -30,6 +30,7 @@
 #include <../inc/protected/persComRct.h>
 #include <../inc/protected/persComDbAccess.h>
 #include <../inc/protected/persComErrors.h>
+#include <../src/key-value-store/hashtable/qhasharr.h>
 //#include <../test/pers_com_test_base.h>
 //#include <../test/pers_com_check.h>
 #include <check.h>
@@ -45,57 +46,26 @@
 #define READ_SIZE    1024
 #define MaxAppNameLen 256
 
-#define PIDFILE_PREFIX "perslib_"
-#define PIDFILE_TEMPLATE PIDFILEDIR "/" PIDFILE_PREFIX"%d.pid"   // PIDFILEDIR is defined via configure switch -pidfiledir (default is /var/run if not set)
-
 /// application id
 char gTheAppId[MaxAppNameLen] = { 0 };
 
 // definition of weekday
 char* dayOfWeek[] = { "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday" };
 
-static char gPidfilename[40] = {0};
-
 // forward declaration
 int  check_for_same_file_content(char* file1Path, char* file2Path);
 
 
 
-static void createPidFile(pid_t pid)
-{
-   int fd = -1;
-
-   // create pidfile
-   memset(gPidfilename, 0, 40);
-   snprintf(gPidfilename, 40, PIDFILE_TEMPLATE, pid);
-
-   fd = open(gPidfilename, O_CREAT|O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH );
-   if(fd != -1)
-   {
-      //printf("#### TEST: Created pidfile: %s\n", gPidfilename);
-      close(fd);
-      fd = -1;
-   }
-   else
-   {
-      printf("#### TEST: Failed to create pidfile: %s - error: %s\n", gPidfilename, strerror(errno));
-   }
-}
-
-
 void data_setup(void)
 {
    //ssd
    DLT_REGISTER_APP("PCOt", "tests the persistence common object library");
-
-   createPidFile(getpid());
 }
 
 void data_teardown(void)
 {
    DLT_UNREGISTER_APP();
-
-   remove(gPidfilename);
 }
 
 
@@ -1987,8 +1957,6 @@ START_TEST(test_CachedConcurrentAccess)
 
       snprintf(childSysTimeBuffer, 256, "%s", "1");
 
-      createPidFile(getpid());
-
       //wait so that father has already opened the db
       sleep(3);
 
@@ -2021,7 +1989,6 @@ START_TEST(test_CachedConcurrentAccess)
 
       DLT_UNREGISTER_APP();
 
-      remove(gPidfilename);
       _exit(EXIT_SUCCESS);
    }
    else if (pid > 0)
@@ -2036,8 +2003,6 @@ START_TEST(test_CachedConcurrentAccess)
       char sysTimeBuffer[256] = { 0 };
       int i =0;
 
-      createPidFile(getpid());
-
       handle = persComDbOpen("/tmp/cached-concurrent.db", 0x1); //create test.db if not present
       fail_unless(handle >= 0, "Father failed to create non existent lDB: retval: [%d]", ret);
 
@@ -2080,8 +2045,6 @@ START_TEST(test_CachedConcurrentAccess)
       }
       fail_unless(ret == 0, "Father failed to close database: retval: [%d]", ret);
 
-      remove(gPidfilename);
-
       _exit(EXIT_SUCCESS);
    }
 }
@@ -2115,8 +2078,6 @@ START_TEST(test_CachedConcurrentAccess2)
       char write2[READ_SIZE] = { 0 };
       int i =0;
 
-      createPidFile(getpid());
-
       snprintf(childSysTimeBuffer, 256, "%s", "1");
 
       //open database initially (CREATOR)
@@ -2162,7 +2123,6 @@ START_TEST(test_CachedConcurrentAccess2)
 
       DLT_UNREGISTER_APP();
 
-      remove(gPidfilename);
       _exit(EXIT_SUCCESS);
    }
    else if (pid > 0)
@@ -2176,8 +2136,6 @@ START_TEST(test_CachedConcurrentAccess2)
       char sysTimeBuffer[256] = { 0 };
       int i =0;
 
-      createPidFile(getpid());
-
       //wait until child (CREATOR) has opened the database
       sleep(1);
 
@@ -2224,7 +2182,6 @@ START_TEST(test_CachedConcurrentAccess2)
          printf("persComDbClose() failed: [%d] \n", ret);
       }
       fail_unless(ret == 0, "Father failed to close database: retval: [%d]", ret);
-      remove(gPidfilename);
       _exit(EXIT_SUCCESS);
    }
 }
@@ -2232,6 +2189,68 @@ END_TEST
 
 
 
+START_TEST(test_ConcurrentOpenClose)
+{
+   int ret = 0;
+   int handle = 0;
+   int status = 0;
+   int i = 0;
+   int fds[2];
+   char sync = 0;
+   pid_t pid = 0;
+
+   //Cleaning up testdata folder
+   remove("/tmp/concurrent-open-close.db");
+
+   //close in this process while another process opens the same database, a lock order inversion between both runs into the semaphore timeout
+   for(i=0; i < 100; i++)
+   {
+      handle = persComDbOpen("/tmp/concurrent-open-close.db", 0x1);
+      fail_unless(handle >= 0, "Failed to open database: retval: [%d]", handle);
+      ret = persComDbWriteKey(handle, "open_close_key", "value", strlen("value"));
+      fail_unless(ret == strlen("value"), "Wrong write size: [%d]", ret);
+
+      fail_unless(pipe(fds) == 0, "pipe failed");
+      pid = fork();
+      fail_unless(pid >= 0, "fork failed");
+      if (pid == 0)
+      {
+         int childHandle = 0;
+         int childRet = EXIT_FAILURE;
+         char buffer[32] = { 0 };
+
+         close(fds[0]);
+         (void) write(fds[1], "x", 1);
+         close(fds[1]);
+
+         childHandle = persComDbOpen("/tmp/concurrent-open-close.db", 0x1);
+         if (childHandle >= 0)
+         {
+            if (   (persComDbReadKey(childHandle, "open_close_key", buffer, sizeof(buffer)) == strlen("value"))
+                && (persComDbClose(childHandle) == 0))
+            {
+               childRet = EXIT_SUCCESS;
+            }
+         }
+         _exit(childRet);
+      }
+
+      //vary the point of the close within the open of the other process
+      close(fds[1]);
+      (void) read(fds[0], &sync, 1);
+      close(fds[0]);
+      usleep((i % 20) * 25);
+
+      ret = persComDbClose(handle);
+      fail_unless(ret == 0, "Failed to close database in round %d: retval: [%d]", i, ret);
+      ret = waitpid(pid, &status, 0);
+      fail_unless(ret == pid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS, "Child failed in round %d", i);
+   }
+}
+END_TEST
+
+
+
 
 START_TEST(test_CacheSize)
 {
@@ -2320,6 +2339,91 @@ END_TEST
 
 
 
+START_TEST(test_QhasharrUpdateFull)
+{
+   size_t memsize = qhasharr_calculate_memsize(8);
+   void* memory = calloc(1, memsize);
+   qhasharr_t* tbl = NULL;
+   char key[16] = { 0 };
+   char* value = NULL;
+   size_t size = 0;
+   int used = 0;
+   int i = 0;
+
+   fail_unless(memory != NULL, "No memory for the table");
+   tbl = qhasharr(memory, memsize);
+   fail_unless(tbl != NULL, "Failed to create the table");
+
+   //one slot per key
+   for(i=0; i < 8; i++)
+   {
+      snprintf(key, sizeof(key), "key_%d", i);
+      fail_unless(tbl->put(tbl, key, "value", strlen("value") + 1) == true, "Failed to put key %d", i);
+   }
+   fail_unless(tbl->put(tbl, "key_8", "value", strlen("value") + 1) == false, "Put into a full table succeeded");
+
+   //an existing key is updated in place, even if the table is full
+   fail_unless(tbl->put(tbl, "key_3", "other", strlen("other") + 1) == true, "Failed to update key in a full table");
+   value = (char*) tbl->get(tbl, "key_3", &size);
+   fail_unless(value != NULL && size == strlen("other") + 1 && strcmp(value, "other") == 0, "Wrong value after update");
+   free(value);
+   tbl->size(tbl, NULL, &used);
+   fail_unless(used == 8, "Wrong number of used slots: [%d]", used);
+
+   tbl->free(tbl);
+   free(memory);
+}
+END_TEST
+
+
+
+START_TEST(test_QhasharrRelocateCollision)
+{
+   size_t memsize = qhasharr_calculate_memsize(16);
+   void* memory = calloc(1, memsize);
+   qhasharr_t* tbl = NULL;
+   char bigValue[64] = { 0 };
+   char* value = NULL;
+   size_t size = 0;
+   int used = 0;
+
+   fail_unless(memory != NULL, "No memory for the table");
+   tbl = qhasharr(memory, memsize);
+   fail_unless(tbl != NULL, "Failed to create the table");
+   memset(bigValue, 'B', sizeof(bigValue) - 1);
+
+   //the keys are chosen by their hash: key_34 and key_43 have home slot 3, key_49 slot 4, key_52 slot 5
+   //key_43 collides with key_34 and goes to slot 4, its value does not fit into one slot and is continued in slot 5
+   fail_unless(tbl->put(tbl, "key_34", "a", 2) == true, "Failed to put key_34");
+   fail_unless(tbl->put(tbl, "key_43", bigValue, sizeof(bigValue)) == true, "Failed to put key_43");
+   //key_49 has home slot 4: the collision entry key_43 is moved to another slot
+   fail_unless(tbl->put(tbl, "key_49", "c", 2) == true, "Failed to put key_49");
+   //key_52 has home slot 5: the continuation of key_43 is moved and the link of key_43 is adjusted through the back link
+   fail_unless(tbl->put(tbl, "key_52", "d", 2) == true, "Failed to put key_52");
+
+   value = (char*) tbl->get(tbl, "key_43", &size);
+   fail_unless(value != NULL && size == sizeof(bigValue) && memcmp(value, bigValue, sizeof(bigValue)) == 0, "Wrong value of key_43");
+   free(value);
+   value = (char*) tbl->get(tbl, "key_49", &size);
+   fail_unless(value != NULL && size == 2 && strcmp(value, "c") == 0, "Wrong value of key_49");
+   free(value);
+   tbl->size(tbl, NULL, &used);
+   fail_unless(used == 5, "Wrong number of used slots: [%d]", used);
+
+   fail_unless(tbl->remove(tbl, "key_43") == true, "Failed to remove key_43");
+   fail_unless(tbl->remove(tbl, "key_49") == true, "Failed to remove key_49");
+   fail_unless(tbl->remove(tbl, "key_52") == true, "Failed to remove key_52");
+   fail_unless(tbl->remove(tbl, "key_34") == true, "Failed to remove key_34");
+   tbl->size(tbl, NULL, &used);
+   fail_unless(used == 0, "Wrong number of used slots after remove: [%d]", used);
+
+   tbl->free(tbl);
+   free(memory);
+}
+END_TEST
+
+
+
 
 START_TEST(test_BadParameters)
 {
@@ -2988,8 +3092,6 @@ START_TEST(test_WriteThrough)
          char write2[READ_SIZE] = { 0 };
          int i =0;
 
-         createPidFile(getpid());
-
          snprintf(childSysTimeBuffer, 256, "%s", "1");
 
          //wait so that father has already opened the db
@@ -3024,7 +3126,6 @@ START_TEST(test_WriteThrough)
 
          DLT_UNREGISTER_APP();
 
-         remove(gPidfilename);
          _exit(EXIT_SUCCESS);
       }
       else if (pid > 0)
@@ -3038,8 +3139,6 @@ START_TEST(test_WriteThrough)
          char sysTimeBuffer[256] = { 0 };
          int i =0;
 
-         createPidFile(getpid());
-
          handle = persComDbOpen("/tmp/writethrough-concurrent.db", 0x3| 0x08); //create test.db if not present and writethrough mode
          fail_unless(handle >= 0, "Father failed to create non existent lDB: retval: [%d]", ret);
 
@@ -3081,7 +3180,6 @@ START_TEST(test_WriteThrough)
             printf("persComDbClose() failed: [%d] \n", ret);
          }
          fail_unless(ret == 0, "Father failed to close database: retval: [%d]", ret);
-         remove(gPidfilename);
          _exit(EXIT_SUCCESS);
       }
 
@@ -3405,7 +3503,6 @@ START_TEST(test_CrashingApp)
    char key[128] = {0};
    char writeData[128] = {0};
 
-   createPidFile(getpid());
    //printf("Crashing App - pid: [%d]==> \n", getpid());
 
    //Cleaning up
@@ -3464,7 +3561,6 @@ START_TEST(test_RestartedApp)
    char writeData[128] = {0};
    char readData[128] = {0};
 
-   createPidFile(getpid());
    //printf("Restarted App - pid: [%d] ==> \n", getpid());
 
    //
@@ -3473,7 +3569,9 @@ START_TEST(test_RestartedApp)
    fail_unless(access("/dev/shm/sem._tmp_attachToExistingCacheFragment_db-sem", F_OK)  == 0);
    fail_unless(access("/dev/shm/_tmp_attachToExistingCacheFragment_db-cache", F_OK)    == 0);
    fail_unless(access("/dev/shm/_tmp_attachToExistingCacheFragment_db-ht", F_OK)       == 0);
+#ifndef PERS_SHM_ARENA_ROOT /* shared information is kept in the arena */
    fail_unless(access("/dev/shm/_tmp_attachToExistingCacheFragment_db-shm-info", F_OK) == 0);
+#endif
 
 
    handle = persComDbOpen("/tmp/attachToExistingCacheFragment.db", 0x1);   //write cached create database
@@ -3616,7 +3714,6 @@ START_TEST(test_RestartedApp)
    fail_unless(access("/dev/shm/_tmp_attachToExistingCacheFragment_db-shm-info", F_OK) == -1);
 
 
-   remove(gPidfilename);
    //printf("Restarted App <== \n\n");
 }
 END_TEST
@@ -3682,162 +3779,1706 @@ START_TEST(test_Compare_RCT)
 END_TEST
 
 
-static Suite* persistenceCommonLib_suite()
+/*
+ * Access a key using a prepared key: the key is prepared once, then written, read, its size read and deleted.
+ * Close and reopen the database to read the prepared key from file again.
+ */
+START_TEST(test_PreparedKey)
 {
-   Suite* s = suite_create("Persistence-common-object-test");
+   int ret = 0;
+   int handle = 0;
+   char write1[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
+   persComDbKey_t preparedKey;
 
-   TCase* tc_persOpenLocalDB = tcase_create("OpenlocalDB");
-   tcase_add_test(tc_persOpenLocalDB, test_OpenLocalDB);
+   snprintf(write1, 128, "%s", "prepared key data");
 
-   TCase* tc_persOpenRCT = tcase_create("OpenRCT");
-   tcase_add_test(tc_persOpenRCT, test_OpenRCT);
+   //Cleaning up testdata folder
+   remove("/tmp/prepared-key.db");
 
-   TCase* tc_persSetDataLocalDB = tcase_create("SetDataLocalDB");
-   tcase_add_test(tc_persSetDataLocalDB, test_SetDataLocalDB);
+   handle = persComDbOpen("/tmp/prepared-key.db", 0x1); //create db if not present
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
 
-   TCase* tc_persGetDataLocalDB = tcase_create("GetDataLocalDB");
-   tcase_add_test(tc_persGetDataLocalDB, test_GetDataLocalDB);
+   ret = persComDbPrepareKey(NULL, &preparedKey);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Wrong error code for NULL key: [%d]", ret);
 
-   TCase* tc_persSetDataRCT = tcase_create("SetDataRCT");
-   tcase_add_test(tc_persSetDataRCT, test_SetDataRCT);
+   ret = persComDbPrepareKey("status/prepared_key", &preparedKey);
+   fail_unless(ret == PERS_COM_SUCCESS, "Failed to prepare key: [%d]", ret);
+   fail_unless(preparedKey.length == strlen("status/prepared_key"), "Wrong length of prepared key");
 
-   TCase* tc_persGetDataRCT = tcase_create("GetDataRCT");
-   tcase_add_test(tc_persGetDataRCT, test_GetDataRCT);
+   //write to cache
+   ret = persComDbWriteKeyPrepared(handle, &preparedKey, write1, strlen(write1));
+   fail_unless(ret == strlen(write1), "Wrong write size: [%d]", ret);
 
-   TCase* tc_persGetDataSize = tcase_create("GetDataSize");
-   tcase_add_test(tc_persGetDataSize, test_GetDataSize);
+   //prepared key and key's name must address the same key
+   ret = persComDbReadKey(handle, "status/prepared_key", read, sizeof(read));
+   fail_unless(ret == strlen(write1), "Wrong read size: [%d]", ret);
+   fail_unless(memcmp(read, write1, strlen(write1)) == 0, "Buffer not correctly read");
 
-   TCase* tc_persDeleteDataLocalDB = tcase_create("DeleteDataLocalDB");
-   tcase_add_test(tc_persDeleteDataLocalDB, test_DeleteDataLocalDB);
+   ret = persComDbGetKeySizePrepared(handle, &preparedKey);
+   fail_unless(ret == strlen(write1), "Invalid size read from cache: [%d]", ret);
 
-   TCase* tc_persDeleteDataRct = tcase_create("DeleteDataRct");
-   tcase_add_test(tc_persDeleteDataRct, test_DeleteDataRct);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close cached database: retval: [%d]", ret);
 
-   TCase* tc_persGetKeyListSizeLocalDB = tcase_create("GetKeyListSizeLocalDb");
-   tcase_add_test(tc_persGetKeyListSizeLocalDB, test_GetKeyListSizeLocalDB);
+   handle = persComDbOpen("/tmp/prepared-key.db", 0x1);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
 
-   TCase* tc_persGetKeyListLocalDB = tcase_create("GetKeyListLocalDb");
-   tcase_add_test(tc_persGetKeyListLocalDB, test_GetKeyListLocalDB);
+   //read from file
+   memset(read, 0, sizeof(read));
+   ret = persComDbReadKeyPrepared(handle, &preparedKey, read, sizeof(read));
+   fail_unless(ret == strlen(write1), "Wrong read size: [%d]", ret);
+   fail_unless(memcmp(read, write1, strlen(write1)) == 0, "Buffer not correctly read");
 
-   TCase* tc_persGetResourceListSizeRct = tcase_create("GetResourceListSizeRct");
-   tcase_add_test(tc_persGetResourceListSizeRct, test_GetResourceListSizeRct);
+   ret = persComDbDeleteKeyPrepared(handle, &preparedKey);
+   fail_unless(ret >= 0, "Failed to delete key: [%d]", ret);
 
-   TCase* tc_persGetResourceListRct = tcase_create("GetResourceListRct");
-   tcase_add_test(tc_persGetResourceListRct, test_GetResourceListRct);
+   ret = persComDbReadKeyPrepared(handle, &preparedKey, read, sizeof(read));
+   fail_unless(ret < 0, "Deleted key could be read: [%d]", ret);
 
-   TCase* tc_persCacheSize = tcase_create("CacheSize");
-   tcase_add_test(tc_persCacheSize, test_CacheSize);
-   tcase_set_timeout(tc_persCacheSize, 20);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
 
-   TCase* tc_persCachedConcurrentAccess = tcase_create("CachedConcurrentAccess");
-   tcase_add_test(tc_persCachedConcurrentAccess, test_CachedConcurrentAccess);
-   tcase_set_timeout(tc_persCachedConcurrentAccess, 20);
 
-   TCase* tc_persCachedConcurrentAccess2 = tcase_create("CachedConcurrentAccess2");
-   tcase_add_test(tc_persCachedConcurrentAccess2, test_CachedConcurrentAccess2);
-   tcase_set_timeout(tc_persCachedConcurrentAccess2, 20);
+/*
+ * Read keys which are not in the database (negative lookups) in writethrough mode.
+ * Close and reopen the database (the filter for negative lookups gets rebuilt) and check that
+ * existing keys can still be read while missing and deleted keys are reported as not found.
+ */
+START_TEST(test_NegativeLookup)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   char key[128] = { 0 };
+   char write1[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
 
-   TCase* tc_BadParameters = tcase_create("BadParameters");
-   tcase_add_test(tc_BadParameters, test_BadParameters);
+   snprintf(write1, 128, "%s", "negative lookup data");
 
-   TCase* tc_RebuildHashtables = tcase_create("RebuildHashtables");
-   tcase_add_test(tc_RebuildHashtables, test_RebuildHashtables);
+   //Cleaning up testdata folder
+   remove("/tmp/negative-lookup.db");
 
-   TCase* tc_RecoverDatablocks = tcase_create("RecoverDatablocks");
-   tcase_add_test(tc_RecoverDatablocks, test_RecoverDatablocks);
+   handle = persComDbOpen("/tmp/negative-lookup.db", 0x3); //create db if not present, writethrough mode
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
 
-   TCase* tc_LinkedDatabase = tcase_create("LinkedDatabase");
-   tcase_add_test(tc_LinkedDatabase, test_LinkedDatabase);
+   for(i=0; i < 100; i++)
+   {
+      snprintf(key, 128, "Key_in_loop_%d_%d", i, i * i);
+      ret = persComDbWriteKey(handle, key, write1, strlen(write1));
+      fail_unless(ret == strlen(write1), "Wrong write size: [%d]", ret);
+   }
 
-   TCase* tc_ReadOnlyDatabase = tcase_create("ReadOnlyDatabase");
-   tcase_add_test(tc_ReadOnlyDatabase, test_ReadOnlyDatabase);
+   for(i=0; i < 100; i++)
+   {
+      snprintf(key, 128, "Missing_key_%d", i);
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Missing key could be read: [%d]", ret);
+   }
 
-   TCase* tc_MultipleWrites = tcase_create("MultipleWrites");
-   tcase_add_test(tc_MultipleWrites, test_MultipleWrites);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
 
-   TCase* tc_WriteThrough = tcase_create("WriteThrough");
-   tcase_add_test(tc_WriteThrough, test_WriteThrough);
-   tcase_set_timeout(tc_WriteThrough, 20);
+   handle = persComDbOpen("/tmp/negative-lookup.db", 0x3);
+   fail_unless(handle >= 0, "Failed to reopen existing lDB: retval: [%d]", handle);
 
-   TCase* tc_AddKey_DeleteKey_AddShorterKeyName = tcase_create("AddKey_DeleteKey_AddShorterKeyName");
-   tcase_add_test(tc_AddKey_DeleteKey_AddShorterKeyName, test_AddKey_DeleteKey_AddShorterKeyName);
-   tcase_set_timeout(tc_AddKey_DeleteKey_AddShorterKeyName, 60);
+   for(i=0; i < 100; i++)
+   {
+      snprintf(key, 128, "Key_in_loop_%d_%d", i, i * i);
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      fail_unless(ret == strlen(write1), "Wrong read size for key %s: [%d]", key, ret);
 
-   TCase* tc_Compare_RCT = tcase_create("Compare_RCT");
-   tcase_add_test(tc_Compare_RCT, test_Compare_RCT);
+      snprintf(key, 128, "Missing_key_%d", i);
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Missing key could be read: [%d]", ret);
+   }
 
-#if 1
-   suite_add_tcase(s, tc_persOpenLocalDB);
-   tcase_add_checked_fixture(tc_persOpenLocalDB, data_setup, data_teardown);
+   ret = persComDbDeleteKey(handle, "Key_in_loop_7_49");
+   fail_unless(ret >= 0, "Failed to delete key: [%d]", ret);
+   ret = persComDbReadKey(handle, "Key_in_loop_7_49", read, sizeof(read));
+   fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key could be read: [%d]", ret);
 
-   suite_add_tcase(s, tc_persOpenRCT);
-   tcase_add_checked_fixture(tc_persOpenRCT, data_setup, data_teardown);
+   //write a key which was missing before
+   ret = persComDbWriteKey(handle, "Missing_key_7", write1, strlen(write1));
+   fail_unless(ret == strlen(write1), "Wrong write size: [%d]", ret);
+   ret = persComDbReadKey(handle, "Missing_key_7", read, sizeof(read));
+   fail_unless(ret == strlen(write1), "Wrong read size: [%d]", ret);
 
-   suite_add_tcase(s, tc_persSetDataLocalDB);
-   tcase_add_checked_fixture(tc_persSetDataLocalDB, data_setup, data_teardown);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
 
-   suite_add_tcase(s, tc_persGetDataLocalDB);
-   tcase_add_checked_fixture(tc_persGetDataLocalDB, data_setup, data_teardown);
 
-   suite_add_tcase(s, tc_persSetDataRCT);
-   tcase_add_checked_fixture(tc_persSetDataRCT, data_setup, data_teardown);
+START_TEST(test_PrivateMode)
+{
+   int ret = 0;
+   int handle = 0;
+   int handle2 = 0;
+   int i = 0;
+   char key[128] = { 0 };
+   char write1[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
 
-   suite_add_tcase(s, tc_persGetDataRCT);
-   tcase_add_checked_fixture(tc_persGetDataRCT, data_setup, data_teardown);
+   snprintf(write1, 128, "%s", "process private data");
 
-   suite_add_tcase(s, tc_persGetDataSize);
-   tcase_add_checked_fixture(tc_persGetDataSize, data_setup, data_teardown);
+   //Cleaning up testdata folder
+   remove("/tmp/private-mode.db");
 
-   suite_add_tcase(s, tc_persDeleteDataLocalDB);
-   tcase_add_checked_fixture(tc_persDeleteDataLocalDB, data_setup, data_teardown);
+   handle = persComDbOpen("/tmp/private-mode.db", 0x11); //create db if not present, process private mode
+   fail_unless(handle >= 0, "Failed to create non existent lDB in private mode: retval: [%d]", handle);
 
-   suite_add_tcase(s, tc_persDeleteDataRct);
-   tcase_add_checked_fixture(tc_persDeleteDataRct, data_setup, data_teardown);
+   //a database in process private mode can not be opened a second time
+   handle2 = persComDbOpen("/tmp/private-mode.db", 0x1);
+   fail_unless(handle2 == PERS_COM_ERR_ACCESS_DENIED, "Database in private mode could be opened again: retval: [%d]", handle2);
+   handle2 = persComDbOpen("/tmp/private-mode.db", 0x11);
+   fail_unless(handle2 == PERS_COM_ERR_ACCESS_DENIED, "Database in private mode could be opened again: retval: [%d]", handle2);
 
-   suite_add_tcase(s, tc_persGetKeyListSizeLocalDB);
-   tcase_add_checked_fixture(tc_persGetKeyListSizeLocalDB, data_setup, data_teardown);
+   for(i=0; i < 300; i++) //more keys than one hashtable can hold
+   {
+      snprintf(key, 128, "Key_in_loop_%d_%d", i, i * i);
+      ret = persComDbWriteKey(handle, key, write1, strlen(write1));
+      fail_unless(ret == strlen(write1), "Wrong write size: [%d]", ret);
+   }
+   for(i=0; i < 300; i++)
+   {
+      snprintf(key, 128, "Key_in_loop_%d_%d", i, i * i);
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      fail_unless(ret == strlen(write1), "Wrong read size for key %s: [%d]", key, ret);
+   }
 
-   suite_add_tcase(s, tc_persGetKeyListLocalDB);
-   tcase_add_checked_fixture(tc_persGetKeyListLocalDB, data_setup, data_teardown);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
 
-   suite_add_tcase(s, tc_persGetResourceListSizeRct);
-   tcase_add_checked_fixture(tc_persGetResourceListSizeRct, data_setup, data_teardown);
+   //data written in private mode is available in shared mode
+   handle = persComDbOpen("/tmp/private-mode.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open existing lDB: retval: [%d]", handle);
 
-   suite_add_tcase(s, tc_persGetResourceListRct);
-   tcase_add_checked_fixture(tc_persGetResourceListRct, data_setup, data_teardown);
+   handle2 = persComDbOpen("/tmp/private-mode.db", 0x10);
+   fail_unless(handle2 == PERS_COM_ERR_ACCESS_DENIED, "Shared database could be opened in private mode: retval: [%d]", handle2);
 
-   suite_add_tcase(s, tc_persCacheSize);     //do not run when using writethrough
-   tcase_add_checked_fixture(tc_persCacheSize, data_setup, data_teardown);
+   for(i=0; i < 300; i++)
+   {
+      snprintf(key, 128, "Key_in_loop_%d_%d", i, i * i);
+      ret = persComDbReadKey(handle, key, read, sizeof(read));
+      fail_unless(ret == strlen(write1), "Wrong read size for key %s: [%d]", key, ret);
+      fail_unless(memcmp(read, write1, strlen(write1)) == 0, "Reading Data failed");
+   }
 
-   suite_add_tcase(s, tc_persCachedConcurrentAccess);
-   tcase_add_checked_fixture(tc_persCachedConcurrentAccess, data_setup_thread, data_teardown_thread);
-   suite_add_tcase(s, tc_persCachedConcurrentAccess2);
-   tcase_add_checked_fixture(tc_persCachedConcurrentAccess2, data_setup_thread, data_teardown_thread);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
 
-   suite_add_tcase(s, tc_BadParameters);
-   tcase_add_checked_fixture(tc_BadParameters, data_setup, data_teardown);
 
-   suite_add_tcase(s, tc_RebuildHashtables);
-   tcase_add_checked_fixture(tc_RebuildHashtables, data_setup, data_teardown);
 
-   suite_add_tcase(s, tc_RecoverDatablocks); //add test for writethrough (writeback order is different when using cache)
-   tcase_add_checked_fixture(tc_RecoverDatablocks, data_setup, data_teardown);
+START_TEST(test_HandleTable)
+{
+   int ret = 0;
+   int i = 0;
+   int handles[40] = { 0 };
+   int staleHandle = 0;
+   char path[128] = { 0 };
+   char write1[READ_SIZE] = { 0 };
+   char read[READ_SIZE] = { 0 };
 
-   suite_add_tcase(s, tc_LinkedDatabase);
-   tcase_add_checked_fixture(tc_LinkedDatabase, data_setup, data_teardown);
+   //more databases than handlers in the static area
+   for(i=0; i < 40; i++)
+   {
+      snprintf(path, 128, "/tmp/handle-table-%d.db", i);
+      remove(path);
+      handles[i] = persComDbOpen(path, 0x1);
+      fail_unless(handles[i] >= 0, "Failed to create non existent lDB: retval: [%d]", handles[i]);
 
-   suite_add_tcase(s, tc_ReadOnlyDatabase);
-   tcase_add_checked_fixture(tc_ReadOnlyDatabase, data_setup, data_teardown);
+      snprintf(write1, 128, "data of database %d", i);
+      ret = persComDbWriteKey(handles[i], "handle_key", write1, strlen(write1));
+      fail_unless(ret == strlen(write1), "Wrong write size: [%d]", ret);
+   }
 
-   suite_add_tcase(s, tc_MultipleWrites);
-   tcase_add_checked_fixture(tc_MultipleWrites, data_setup, data_teardown);
+   for(i=0; i < 40; i++)
+   {
+      snprintf(write1, 128, "data of database %d", i);
+      memset(read, 0, sizeof(read));
+      ret = persComDbReadKey(handles[i], "handle_key", read, sizeof(read));
+      fail_unless(ret == strlen(write1), "Wrong read size: [%d]", ret);
+      fail_unless(memcmp(read, write1, strlen(write1)) == 0, "Reading Data failed for database %d", i);
+   }
 
-   suite_add_tcase(s, tc_WriteThrough);
-   tcase_add_checked_fixture(tc_WriteThrough, data_setup_thread, data_teardown_thread);
+   //a closed handler stays invalid if its entry is used again
+   staleHandle = handles[20];
+   ret = persComDbClose(staleHandle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   handles[20] = persComDbOpen("/tmp/handle-table-20.db", 0x0);
+   fail_unless(handles[20] >= 0, "Failed to reopen lDB: retval: [%d]", handles[20]);
+   fail_unless(handles[20] != staleHandle, "Closed handler was returned again: [%d]", staleHandle);
+   ret = persComDbReadKey(staleHandle, "handle_key", read, sizeof(read));
+   fail_unless(ret < 0, "Closed handler can be used: retval: [%d]", ret);
+   ret = persComDbReadKey(handles[20], "handle_key", read, sizeof(read));
+   fail_unless(ret == strlen("data of database 20"), "Wrong read size: [%d]", ret);
+
+   for(i=0; i < 40; i++)
+   {
+      ret = persComDbClose(handles[i]);
+      fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   }
+   ret = persComDbClose(handles[0]);
+   fail_unless(ret < 0, "Closed handler could be closed again: retval: [%d]", ret);
+}
+END_TEST
 
-   suite_add_tcase(s, tc_AddKey_DeleteKey_AddShorterKeyName);
 
-   suite_add_tcase(s, tc_Compare_RCT);
+
+START_TEST(test_MultiKey)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int mode = 0;
+   int results[4] = { 0 };
+   char bufs[4][READ_SIZE];
+   char* readBuffers[4] = { bufs[0], bufs[1], bufs[2], bufs[3] };
+   int readSizes[4] = { READ_SIZE, READ_SIZE, READ_SIZE, READ_SIZE };
+   const char* keys[4] = { "multi_key_1", "multi_key_2", NULL, "multi_key_4" };
+   const char* data[4] = { "first value", "second value", "invalid key", "fourth value" };
+   int dataSizes[4] = { 0 };
+   const char* missingKeys[2] = { "multi_key_2", "multi_key_missing" };
+   const char* paths[2] = { "/tmp/multi-key-wc.db", "/tmp/multi-key-wt.db" };
+   int options[2] = { 0x1, 0x3 }; //cached, write through
+
+   for(i=0; i < 4; i++)
+   {
+      dataSizes[i] = strlen(data[i]);
+   }
+
+   for(mode=0; mode < 2; mode++)
+   {
+      remove(paths[mode]);
+      handle = persComDbOpen(paths[mode], options[mode]);
+      fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+
+      //an invalid key does not stop the other keys
+      ret = persComDbWriteKeys(handle, keys, data, dataSizes, results, 4);
+      fail_unless(ret == 3, "Wrong number of written keys: [%d]", ret);
+      fail_unless(results[0] == dataSizes[0] && results[1] == dataSizes[1] && results[3] == dataSizes[3], "Wrong write sizes");
+      fail_unless(results[2] == PERS_COM_ERR_INVALID_PARAM, "Invalid key was written: [%d]", results[2]);
+
+      memset(bufs, 0, sizeof(bufs));
+      ret = persComDbReadKeys(handle, keys, readBuffers, readSizes, results, 4);
+      fail_unless(ret == 3, "Wrong number of read keys: [%d]", ret);
+      for(i=0; i < 4; i++)
+      {
+         if(i != 2)
+         {
+            fail_unless(results[i] == dataSizes[i], "Wrong read size for key %s: [%d]", keys[i], results[i]);
+            fail_unless(memcmp(bufs[i], data[i], dataSizes[i]) == 0, "Wrong data for key %s", keys[i]);
+         }
+      }
+
+      //the values are the same as read with the single key function
+      ret = persComDbReadKey(handle, keys[3], bufs[0], READ_SIZE);
+      fail_unless(ret == dataSizes[3], "Wrong read size: [%d]", ret);
+
+      ret = persComDbDeleteKeys(handle, missingKeys, results, 2);
+      fail_unless(ret == 1, "Wrong number of deleted keys: [%d]", ret);
+      fail_unless(results[0] >= 0, "Failed to delete key: [%d]", results[0]);
+      fail_unless(results[1] == PERS_COM_ERR_NOT_FOUND, "Missing key could be deleted: [%d]", results[1]);
+      ret = persComDbReadKey(handle, missingKeys[0], bufs[0], READ_SIZE);
+      fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key can be read: [%d]", ret);
+
+      ret = persComDbClose(handle);
+      fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+      //the written keys are stored in the file
+      handle = persComDbOpen(paths[mode], 0x0);
+      fail_unless(handle >= 0, "Failed to open existing lDB: retval: [%d]", handle);
+      ret = persComDbReadKeys(handle, keys, readBuffers, readSizes, results, 4);
+      fail_unless(ret == 2, "Wrong number of read keys after reopen: [%d]", ret);
+      fail_unless(results[1] == PERS_COM_ERR_NOT_FOUND, "Deleted key found after reopen: [%d]", results[1]);
+      ret = persComDbClose(handle);
+      fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   }
+}
+END_TEST
+
+
+
+typedef struct
+{
+   int count;
+   int keyListSize;
+   int stopAfter;
+   int foundUpdated;
+   int foundDeleted;
+} ForEachCtx_s;
+
+static int forEachCallback(char const* key, char const* data, int dataSize, void* ctx)
+{
+   ForEachCtx_s* pCtx = (ForEachCtx_s*) ctx;
+
+   pCtx->count++;
+   pCtx->keyListSize += strlen(key) + 1;
+   if (strcmp(key, "each_key_1") == 0 && dataSize == strlen("updated value") && memcmp(data, "updated value", dataSize) == 0)
+   {
+      pCtx->foundUpdated++;
+   }
+   if (strcmp(key, "each_key_2") == 0)
+   {
+      pCtx->foundDeleted++;
+   }
+   return (pCtx->count == pCtx->stopAfter) ? 1 : 0;
+}
+
+START_TEST(test_ForEach)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   char key[128] = { 0 };
+   char write1[READ_SIZE] = { 0 };
+   ForEachCtx_s ctx;
+
+   //Cleaning up testdata folder
+   remove("/tmp/for-each.db");
+
+   handle = persComDbOpen("/tmp/for-each.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for(i=0; i < 20; i++)
+   {
+      snprintf(key, 128, "each_key_%d", i);
+      snprintf(write1, 128, "value %d", i);
+      ret = persComDbWriteKey(handle, key, write1, strlen(write1));
+      fail_unless(ret == strlen(write1), "Wrong write size: [%d]", ret);
+   }
+   ret = persComDbWriteKey(handle, "other_key", "other value", strlen("other value"));
+   fail_unless(ret == strlen("other value"), "Wrong write size: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   //keys in the file and changes in the cache
+   handle = persComDbOpen("/tmp/for-each.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open existing lDB: retval: [%d]", handle);
+   ret = persComDbWriteKey(handle, "each_key_1", "updated value", strlen("updated value"));
+   fail_unless(ret == strlen("updated value"), "Wrong write size: [%d]", ret);
+   ret = persComDbDeleteKey(handle, "each_key_2");
+   fail_unless(ret >= 0, "Failed to delete key: [%d]", ret);
+   ret = persComDbWriteKey(handle, "each_key_new", "new value", strlen("new value"));
+   fail_unless(ret == strlen("new value"), "Wrong write size: [%d]", ret);
+
+   memset(&ctx, 0, sizeof(ctx));
+   ret = persComDbForEach(handle, NULL, forEachCallback, &ctx);
+   fail_unless(ret == 21, "Wrong number of keys: [%d]", ret);
+   fail_unless(ctx.count == 21, "Wrong number of callbacks: [%d]", ctx.count);
+   fail_unless(ctx.foundUpdated == 1, "Updated value not passed");
+   fail_unless(ctx.foundDeleted == 0, "Deleted key passed");
+   //same keys as listed by persComDbGetKeysList
+   ret = persComDbGetSizeKeysList(handle);
+   fail_unless(ret == ctx.keyListSize, "Wrong size of key list: [%d] [%d]", ret, ctx.keyListSize);
+
+   memset(&ctx, 0, sizeof(ctx));
+   ret = persComDbForEach(handle, "each_key_", forEachCallback, &ctx);
+   fail_unless(ret == 20, "Wrong number of keys with prefix: [%d]", ret);
+
+   //the callback stops the iteration
+   memset(&ctx, 0, sizeof(ctx));
+   ctx.stopAfter = 5;
+   ret = persComDbForEach(handle, "", forEachCallback, &ctx);
+   fail_unless(ret == 5 && ctx.count == 5, "Iteration not stopped: [%d]", ret);
+
+   ret = persComDbForEach(handle, "each_key_", NULL, &ctx);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Missing callback accepted: [%d]", ret);
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+START_TEST(test_KeyDirectory)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int expected = 0;
+   int listSize = 0;
+   int found = 0;
+   char key[128] = { 0 };
+   char* list = NULL;
+   char* ptr = NULL;
+
+   //Cleaning up testdata folder
+   remove("/tmp/key-directory.db");
+
+   handle = persComDbOpen("/tmp/key-directory.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+
+   //the first listing builds the key directory of the empty database
+   ret = persComDbGetSizeKeysList(handle);
+   fail_unless(ret == 0, "Wrong size of empty key list: [%d]", ret);
+
+   //more keys than the first key directory can hold
+   for(i=0; i < 400; i++)
+   {
+      snprintf(key, 128, "dir_key_%d", i);
+      ret = persComDbWriteKey(handle, key, "value", strlen("value"));
+      fail_unless(ret == strlen("value"), "Wrong write size: [%d]", ret);
+      expected += strlen(key) + 1;
+   }
+   //writing an existing key does not change the list
+   ret = persComDbWriteKey(handle, "dir_key_0", "new value", strlen("new value"));
+   fail_unless(ret == strlen("new value"), "Wrong write size: [%d]", ret);
+   ret = persComDbGetSizeKeysList(handle);
+   fail_unless(ret == expected, "Wrong size of key list: [%d], expected [%d]", ret, expected);
+
+   for(i=0; i < 400; i += 2)
+   {
+      snprintf(key, 128, "dir_key_%d", i);
+      ret = persComDbDeleteKey(handle, key);
+      fail_unless(ret >= 0, "Failed to delete key: [%d]", ret);
+      expected -= strlen(key) + 1;
+   }
+   //deleting a deleted key does not change the list
+   (void) persComDbDeleteKey(handle, "dir_key_0");
+   listSize = persComDbGetSizeKeysList(handle);
+   fail_unless(listSize == expected, "Wrong size of key list after delete: [%d], expected [%d]", listSize, expected);
+
+   list = (char*) malloc(listSize);
+   fail_unless(list != NULL, "malloc failed");
+   ret = persComDbGetKeysList(handle, list, listSize);
+   fail_unless(ret == listSize, "Wrong list size: [%d]", ret);
+   for(ptr = list; ptr < list + listSize; ptr += strlen(ptr) + 1)
+   {
+      fail_unless(sscanf(ptr, "dir_key_%d", &i) == 1 && (i % 2) == 1, "Wrong key in list: [%s]", ptr);
+      found++;
+   }
+   fail_unless(found == 200, "Wrong number of keys in list: [%d]", found);
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   //the key directory is built again from the database file
+   handle = persComDbOpen("/tmp/key-directory.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open existing lDB: retval: [%d]", handle);
+   ret = persComDbGetSizeKeysList(handle);
+   fail_unless(ret == expected, "Wrong size of key list after reopen: [%d], expected [%d]", ret, expected);
+   memset(list, 0, listSize);
+   ret = persComDbGetKeysList(handle, list, listSize);
+   fail_unless(ret == listSize, "Wrong list size after reopen: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   free(list);
+}
+END_TEST
+
+
+
+START_TEST(test_ListKeysPage)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int pages = 0;
+   int total = 0;
+   char key[128] = { 0 };
+   char page[64] = { 0 };
+   char seen[300] = { 0 };
+   char* ptr = NULL;
+   unsigned long long cursor = 0;
+   unsigned long long nextCursor = 0;
+
+   //Cleaning up testdata folder
+   remove("/tmp/list-keys-page.db");
+
+   handle = persComDbOpen("/tmp/list-keys-page.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+
+   //empty database: one empty page
+   ret = persComDbListKeysPage(handle, 0, page, sizeof(page), &nextCursor);
+   fail_unless(ret == 0 && nextCursor == 0, "Wrong page of empty database: [%d], next cursor [%llu]", ret, nextCursor);
+
+   for(i=0; i < 300; i++)
+   {
+      snprintf(key, 128, "page_key_%d", i);
+      ret = persComDbWriteKey(handle, key, "value", strlen("value"));
+      fail_unless(ret == strlen("value"), "Wrong write size: [%d]", ret);
+   }
+
+   //every key is listed exactly once, a page never exceeds the buffer
+   do
+   {
+      memset(page, 0, sizeof(page));
+      ret = persComDbListKeysPage(handle, cursor, page, sizeof(page), &nextCursor);
+      fail_unless(ret > 0 && ret <= (int) sizeof(page), "Wrong page size: [%d]", ret);
+      for(ptr = page; ptr < page + ret; ptr += strlen(ptr) + 1)
+      {
+         fail_unless(sscanf(ptr, "page_key_%d", &i) == 1 && i >= 0 && i < 300, "Wrong key in page: [%s]", ptr);
+         fail_unless(seen[i] == 0, "Key listed twice: [%s]", ptr);
+         seen[i] = 1;
+         total++;
+      }
+      fail_unless(nextCursor == 0 || nextCursor > cursor, "Cursor does not advance: [%llu]", nextCursor);
+      cursor = nextCursor;
+      pages++;
+   } while(cursor != 0);
+   fail_unless(total == 300, "Wrong number of listed keys: [%d]", total);
+   fail_unless(pages > 1, "Keys not listed in several pages: [%d]", pages);
+
+   //the next key does not fit
+   ret = persComDbListKeysPage(handle, 0, page, 4, &nextCursor);
+   fail_unless(ret == PERS_COM_ERR_BUFFER_TOO_SMALL, "Too small buffer not detected: [%d]", ret);
+
+   ret = persComDbListKeysPage(handle, 0, NULL, sizeof(page), &nextCursor);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Invalid buffer not detected: [%d]", ret);
+   ret = persComDbListKeysPage(handle, 0, page, sizeof(page), NULL);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Invalid cursor not detected: [%d]", ret);
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+typedef struct
+{
+   char buffer[512];
+   int used;
+   int calls;
+} ReadKeyAllocArena_s;
+
+static void* readKeyAllocArena(signed int size, void* ctx)
+{
+   ReadKeyAllocArena_s* pArena = (ReadKeyAllocArena_s*) ctx;
+   void* ptr = NULL;
+
+   pArena->calls++;
+   if (pArena->used + size <= (int) sizeof(pArena->buffer))
+   {
+      ptr = pArena->buffer + pArena->used;
+      pArena->used += size;
+   }
+   return ptr;
+}
+
+START_TEST(test_ReadKeyAlloc)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int pass = 0;
+   char key[128] = { 0 };
+   char value[600] = { 0 };
+   char* data = NULL;
+   ReadKeyAllocArena_s arena;
+
+   //Cleaning up testdata folder
+   remove("/tmp/read-key-alloc.db");
+
+   handle = persComDbOpen("/tmp/read-key-alloc.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+
+   for(i=1; i <= 10; i++)
+   {
+      snprintf(key, 128, "alloc_key_%d", i);
+      memset(value, 'a' + i, sizeof(value));
+      ret = persComDbWriteKey(handle, key, value, i * 50);
+      fail_unless(ret == i * 50, "Wrong write size: [%d]", ret);
+   }
+
+   //first pass reads from the cache, second pass from the database file
+   for(pass = 0; pass < 2; pass++)
+   {
+      for(i=1; i <= 10; i++)
+      {
+         snprintf(key, 128, "alloc_key_%d", i);
+         data = NULL;
+         ret = persComDbReadKeyAlloc(handle, key, NULL, NULL, &data);
+         fail_unless(ret == i * 50, "Wrong read size: [%d], expected [%d]", ret, i * 50);
+         fail_unless(data != NULL && data[0] == 'a' + i && data[ret - 1] == 'a' + i, "Wrong data read");
+         free(data);
+      }
+
+      //the allocator is called once per key with the key's size
+      memset(&arena, 0, sizeof(arena));
+      ret = persComDbReadKeyAlloc(handle, "alloc_key_4", readKeyAllocArena, &arena, &data);
+      fail_unless(ret == 200 && arena.calls == 1 && arena.used == 200, "Wrong allocation: [%d], calls [%d]", ret, arena.calls);
+      fail_unless(data == arena.buffer && data[199] == 'a' + 4, "Wrong data read in arena");
+      ret = persComDbReadKeyAlloc(handle, "alloc_key_10", readKeyAllocArena, &arena, &data);
+      fail_unless(ret == PERS_COM_ERR_MALLOC, "Failed allocation not detected: [%d]", ret);
+
+      data = value;
+      ret = persComDbReadKeyAlloc(handle, "alloc_key_unknown", NULL, NULL, &data);
+      fail_unless(ret == PERS_COM_ERR_NOT_FOUND && data == NULL, "Unknown key read: [%d]", ret);
+
+      ret = persComDbClose(handle);
+      fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+      handle = persComDbOpen("/tmp/read-key-alloc.db", 0x0);
+      fail_unless(handle >= 0, "Failed to open existing lDB: retval: [%d]", handle);
+   }
+
+   ret = persComDbReadKeyAlloc(handle, NULL, NULL, NULL, &data);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Invalid key not detected: [%d]", ret);
+   ret = persComDbReadKeyAlloc(handle, "alloc_key_1", NULL, NULL, NULL);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Invalid buffer not detected: [%d]", ret);
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+typedef struct
+{
+   int calls;
+   int failed;
+} WriteKeyAsyncResult_s;
+
+static void writeKeyAsyncDone(signed int handlerDB, char const* key, signed int result, void* ctx)
+{
+   WriteKeyAsyncResult_s* pResult = (WriteKeyAsyncResult_s*) ctx;
+
+   //only called by the write worker
+   pResult->calls++;
+   if (result < 0 || strncmp(key, "async_key_", strlen("async_key_")) != 0)
+   {
+      pResult->failed++;
+   }
+}
+
+START_TEST(test_WriteKeyAsync)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+   int fd = -1;
+   char key[128] = { 0 };
+   char value[128] = { 0 };
+   char buffer[128] = { 0 };
+   unsigned long long doneWrites = 0;
+   WriteKeyAsyncResult_s result = { 0 };
+
+   //Cleaning up testdata folder
+   remove("/tmp/write-key-async.db");
+
+   handle = persComDbOpen("/tmp/write-key-async.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+
+   fd = persComDbGetAsyncWriteFd();
+   fail_unless(fd >= 0, "No file descriptor for asynchronous writes: [%d]", fd);
+
+   //the queued data is read back immediately
+   for(i=0; i < 100; i++)
+   {
+      snprintf(key, 128, "async_key_%d", i);
+      snprintf(value, 128, "async value %d", i);
+      ret = persComDbWriteKeyAsync(handle, key, value, strlen(value), writeKeyAsyncDone, &result);
+      fail_unless(ret == 0, "Failed to queue write: [%d]", ret);
+      memset(buffer, 0, sizeof(buffer));
+      ret = persComDbReadKey(handle, key, buffer, sizeof(buffer));
+      fail_unless(ret == strlen(value) && strcmp(buffer, value) == 0, "Wrong data read after queued write: [%d] [%s]", ret, buffer);
+   }
+   //the latest queued data of a key is read
+   ret = persComDbWriteKeyAsync(handle, "async_key_0", "first", strlen("first"), writeKeyAsyncDone, &result);
+   fail_unless(ret == 0, "Failed to queue write: [%d]", ret);
+   ret = persComDbWriteKeyAsync(handle, "async_key_0", "second value", strlen("second value"), writeKeyAsyncDone, &result);
+   fail_unless(ret == 0, "Failed to queue write: [%d]", ret);
+   ret = persComDbGetKeySize(handle, "async_key_0");
+   fail_unless(ret == strlen("second value"), "Wrong size of queued key: [%d]", ret);
+
+   //a synchronous write is done after the queued writes
+   ret = persComDbWriteKey(handle, "async_key_1", "sync", strlen("sync"));
+   fail_unless(ret == strlen("sync"), "Wrong write size: [%d]", ret);
+   fail_unless(result.calls == 102 && result.failed == 0, "Wrong completions: [%d], failed [%d]", result.calls, result.failed);
+   ret = read(fd, &doneWrites, sizeof(doneWrites));
+   fail_unless(ret == sizeof(doneWrites) && doneWrites == 102, "Wrong number of done writes: [%llu]", doneWrites);
+
+   ret = persComDbWriteKeyAsync(handle, "async_key_2", NULL, 4, NULL, NULL);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Invalid data not detected: [%d]", ret);
+   ret = persComDbWriteKeyAsync(handle + 1000, "async_key_2", "data", 4, NULL, NULL);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Invalid handle not detected: [%d]", ret);
+
+   //the queued writes are done before the database is closed
+   ret = persComDbWriteKeyAsync(handle, "async_key_100", "last", strlen("last"), NULL, NULL);
+   fail_unless(ret == 0, "Failed to queue write: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/write-key-async.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open existing lDB: retval: [%d]", handle);
+   for(i=2; i < 100; i++)
+   {
+      snprintf(key, 128, "async_key_%d", i);
+      snprintf(value, 128, "async value %d", i);
+      memset(buffer, 0, sizeof(buffer));
+      ret = persComDbReadKey(handle, key, buffer, sizeof(buffer));
+      fail_unless(ret == strlen(value) && strcmp(buffer, value) == 0, "Wrong data read after reopen: [%d] [%s]", ret, buffer);
+   }
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "async_key_0", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("second value") && strcmp(buffer, "second value") == 0, "Wrong latest data: [%s]", buffer);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "async_key_1", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("sync") && strcmp(buffer, "sync") == 0, "Queued write done after synchronous write: [%s]", buffer);
+   ret = persComDbReadKey(handle, "async_key_100", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("last"), "Queued write lost at close: [%d]", ret);
+
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+static long transactionFile(const char* path, char* buffer, long size, int bStore)
+{
+   FILE* file = fopen(path, bStore ? "wb" : "rb");
+   long done = -1;
+
+   if (file != NULL)
+   {
+      done = bStore ? (long) fwrite(buffer, 1, size, file) : (long) fread(buffer, 1, size, file);
+      fclose(file);
+   }
+   return done;
+}
+
+START_TEST(test_Transaction)
+{
+   int ret = 0;
+   int handle = 0;
+   int tx = 0;
+   int i = 0;
+   long logSize = 0;
+   char key[128] = { 0 };
+   char value[128] = { 0 };
+   char buffer[128] = { 0 };
+   static char log[16384];
+
+   //Cleaning up testdata folder
+   remove("/tmp/transaction.db");
+   remove("/tmp/transaction.db.txlog");
+   remove("/tmp/transaction-wt.db");
+   remove("/tmp/transaction-wt.db.txlog");
+
+   handle = persComDbOpen("/tmp/transaction.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   ret = persComDbWriteKey(handle, "tx_key_old", "old", strlen("old"));
+   fail_unless(ret == strlen("old"), "Wrong write size: [%d]", ret);
+
+   //the operations are not visible before the commit
+   tx = persComDbTxBegin(handle);
+   fail_unless(tx >= 0, "Failed to begin transaction: [%d]", tx);
+   for(i=0; i < 10; i++)
+   {
+      snprintf(key, 128, "tx_key_%d", i);
+      snprintf(value, 128, "tx value %d", i);
+      ret = persComDbTxPut(tx, key, value, strlen(value));
+      fail_unless(ret == 0, "Failed to add put: [%d]", ret);
+   }
+   ret = persComDbTxDelete(tx, "tx_key_old");
+   fail_unless(ret == 0, "Failed to add delete: [%d]", ret);
+   ret = persComDbTxDelete(tx, "tx_key_unknown");
+   fail_unless(ret == 0, "Failed to add delete: [%d]", ret);
+   ret = persComDbReadKey(handle, "tx_key_0", buffer, sizeof(buffer));
+   fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Put visible before commit: [%d]", ret);
+   ret = persComDbGetKeySize(handle, "tx_key_old");
+   fail_unless(ret == strlen("old"), "Delete visible before commit: [%d]", ret);
+
+   ret = persComDbTxCommit(tx);
+   fail_unless(ret == 12, "Failed to commit: [%d]", ret);
+   for(i=0; i < 10; i++)
+   {
+      snprintf(key, 128, "tx_key_%d", i);
+      snprintf(value, 128, "tx value %d", i);
+      memset(buffer, 0, sizeof(buffer));
+      ret = persComDbReadKey(handle, key, buffer, sizeof(buffer));
+      fail_unless(ret == strlen(value) && strcmp(buffer, value) == 0, "Wrong data after commit: [%d] [%s]", ret, buffer);
+   }
+   ret = persComDbGetKeySize(handle, "tx_key_old");
+   fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Key not deleted by commit: [%d]", ret);
+   ret = persComDbTxCommit(tx);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Transaction committed twice: [%d]", ret);
+
+   //an aborted transaction changes nothing
+   tx = persComDbTxBegin(handle);
+   fail_unless(tx >= 0, "Failed to begin transaction: [%d]", tx);
+   ret = persComDbTxPut(tx, "tx_key_0", "aborted", strlen("aborted"));
+   fail_unless(ret == 0, "Failed to add put: [%d]", ret);
+   ret = persComDbTxDelete(tx, "tx_key_1");
+   fail_unless(ret == 0, "Failed to add delete: [%d]", ret);
+   ret = persComDbTxAbort(tx);
+   fail_unless(ret == 0, "Failed to abort: [%d]", ret);
+   ret = persComDbTxPut(tx, "tx_key_0", "aborted", strlen("aborted"));
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Put into aborted transaction: [%d]", ret);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "tx_key_0", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("tx value 0") && strcmp(buffer, "tx value 0") == 0, "Aborted put applied: [%s]", buffer);
+   ret = persComDbGetKeySize(handle, "tx_key_1");
+   fail_unless(ret == strlen("tx value 1"), "Aborted delete applied: [%d]", ret);
+
+   ret = persComDbTxBegin(-1);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Invalid handle not detected: [%d]", ret);
+   ret = persComDbTxPut(-1, "tx_key_0", "data", 4);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Invalid transaction not detected: [%d]", ret);
+
+   //write cached: the record stays in the log until the cache is written back
+   logSize = transactionFile("/tmp/transaction.db.txlog", log, sizeof(log), 0);
+   fail_unless(logSize > 0, "Transaction not in the log: [%ld]", logSize);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   ret = transactionFile("/tmp/transaction.db.txlog", buffer, sizeof(buffer), 0);
+   fail_unless(ret <= 0, "Log not emptied by the write back: [%d]", ret);
+
+   //a record already in the database file is not replayed
+   transactionFile("/tmp/transaction.db.txlog", log, logSize, 1);
+   handle = persComDbOpen("/tmp/transaction.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open existing lDB: retval: [%d]", handle);
+   ret = persComDbWriteKey(handle, "tx_key_2", "newer", strlen("newer"));
+   fail_unless(ret == strlen("newer"), "Wrong write size: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   transactionFile("/tmp/transaction.db.txlog", log, logSize, 1);
+   handle = persComDbOpen("/tmp/transaction.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open existing lDB: retval: [%d]", handle);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "tx_key_2", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("newer") && strcmp(buffer, "newer") == 0, "Old record replayed: [%s]", buffer);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   //a committed record missing in the database file (crash before the write back) is replayed by the next open,
+   //a torn record at the end of the log is ignored
+   remove("/tmp/transaction.db");
+   memset(log + logSize, 0x5a, 40);
+   transactionFile("/tmp/transaction.db.txlog", log, logSize + 40, 1);
+   handle = persComDbOpen("/tmp/transaction.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for(i=0; i < 10; i++)
+   {
+      snprintf(key, 128, "tx_key_%d", i);
+      snprintf(value, 128, "tx value %d", i);
+      memset(buffer, 0, sizeof(buffer));
+      ret = persComDbReadKey(handle, key, buffer, sizeof(buffer));
+      fail_unless(ret == strlen(value) && strcmp(buffer, value) == 0, "Wrong data after replay: [%d] [%s]", ret, buffer);
+   }
+   ret = transactionFile("/tmp/transaction.db.txlog", buffer, sizeof(buffer), 0);
+   fail_unless(ret <= 0, "Log not emptied by the replay: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   //write through: the log is emptied by the commit
+   handle = persComDbOpen("/tmp/transaction-wt.db", 0x3);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   tx = persComDbTxBegin(handle);
+   fail_unless(tx >= 0, "Failed to begin transaction: [%d]", tx);
+   ret = persComDbTxPut(tx, "tx_key_a", "value a", strlen("value a"));
+   fail_unless(ret == 0, "Failed to add put: [%d]", ret);
+   ret = persComDbTxPut(tx, "tx_key_b", "value b", strlen("value b"));
+   fail_unless(ret == 0, "Failed to add put: [%d]", ret);
+   ret = persComDbTxDelete(tx, "tx_key_unknown");
+   fail_unless(ret == 0, "Failed to add delete: [%d]", ret);
+   ret = persComDbTxCommit(tx);
+   fail_unless(ret == 3, "Failed to commit: [%d]", ret);
+   ret = transactionFile("/tmp/transaction-wt.db.txlog", buffer, sizeof(buffer), 0);
+   fail_unless(ret == 0, "Log not emptied by the commit: [%d]", ret);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "tx_key_b", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("value b") && strcmp(buffer, "value b") == 0, "Wrong data after commit: [%d] [%s]", ret, buffer);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/transaction-wt.db", 0x4);
+   fail_unless(handle >= 0, "Failed to open existing lDB read only: retval: [%d]", handle);
+   ret = persComDbTxBegin(handle);
+   fail_unless(ret == PERS_COM_ERR_READONLY, "Transaction on read only database: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+START_TEST(test_Sync)
+{
+   int ret = 0;
+   int handle = 0;
+   int handleCopy = 0;
+   int tx = 0;
+   int i = 0;
+   long fileSize = 0;
+   char key[128] = { 0 };
+   char value[128] = { 0 };
+   char buffer[128] = { 0 };
+   static char image[4 * 1024 * 1024];
+
+   //Cleaning up testdata folder
+   remove("/tmp/sync.db");
+   remove("/tmp/sync.db.txlog");
+   remove("/tmp/sync-copy.db");
+
+   handle = persComDbOpen("/tmp/sync.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   ret = persComDbSync(handle);
+   fail_unless(ret == 0, "Wrong number of keys synced: [%d]", ret);
+   for(i=0; i < 20; i++)
+   {
+      snprintf(key, 128, "sync_key_%d", i);
+      snprintf(value, 128, "sync value %d", i);
+      ret = persComDbWriteKey(handle, key, value, strlen(value));
+      fail_unless(ret == strlen(value), "Wrong write size: [%d]", ret);
+   }
+   ret = persComDbSync(handle);
+   fail_unless(ret == 20, "Wrong number of keys synced: [%d]", ret);
+
+   //only the keys modified since the previous sync are written back, the others are still read from the cache
+   ret = persComDbSync(handle);
+   fail_unless(ret == 0, "Keys synced twice: [%d]", ret);
+   ret = persComDbWriteKey(handle, "sync_key_0", "modified", strlen("modified"));
+   fail_unless(ret == strlen("modified"), "Wrong write size: [%d]", ret);
+   ret = persComDbDeleteKey(handle, "sync_key_1");
+   fail_unless(ret >= 0, "Failed to delete key: [%d]", ret);
+   ret = persComDbSync(handle);
+   fail_unless(ret == 2, "Wrong number of keys synced: [%d]", ret);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "sync_key_0", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("modified") && strcmp(buffer, "modified") == 0, "Wrong data after sync: [%d] [%s]", ret, buffer);
+   ret = persComDbGetKeySize(handle, "sync_key_1");
+   fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key found after sync: [%d]", ret);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "sync_key_2", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("sync value 2") && strcmp(buffer, "sync value 2") == 0, "Wrong data after sync: [%d] [%s]", ret, buffer);
+   ret = persComDbGetSizeKeysList(handle);
+   fail_unless(ret > 0, "Failed to get size of keys list: [%d]", ret);
+
+   //the committed transactions are in the database file after the sync, the intent log is emptied
+   tx = persComDbTxBegin(handle);
+   fail_unless(tx >= 0, "Failed to begin transaction: [%d]", tx);
+   ret = persComDbTxPut(tx, "sync_key_tx", "tx value", strlen("tx value"));
+   fail_unless(ret == 0, "Failed to add put: [%d]", ret);
+   ret = persComDbTxCommit(tx);
+   fail_unless(ret == 1, "Failed to commit: [%d]", ret);
+   ret = transactionFile("/tmp/sync.db.txlog", buffer, sizeof(buffer), 0);
+   fail_unless(ret > 0, "Transaction not in the log: [%d]", ret);
+   ret = persComDbSync(handle);
+   fail_unless(ret == 1, "Wrong number of keys synced: [%d]", ret);
+   ret = transactionFile("/tmp/sync.db.txlog", buffer, sizeof(buffer), 0);
+   fail_unless(ret == 0, "Log not emptied by the sync: [%d]", ret);
+
+   //the database file is complete without a close: a copy taken now (like after a crash) has all the data
+   fileSize = transactionFile("/tmp/sync.db", image, sizeof(image), 0);
+   fail_unless(fileSize > 0 && fileSize < sizeof(image), "Failed to read database file: [%ld]", fileSize);
+   transactionFile("/tmp/sync-copy.db", image, fileSize, 1);
+   handleCopy = persComDbOpen("/tmp/sync-copy.db", 0x0);
+   fail_unless(handleCopy >= 0, "Failed to open copy of lDB: retval: [%d]", handleCopy);
+   for(i=2; i < 20; i++)
+   {
+      snprintf(key, 128, "sync_key_%d", i);
+      snprintf(value, 128, "sync value %d", i);
+      memset(buffer, 0, sizeof(buffer));
+      ret = persComDbReadKey(handleCopy, key, buffer, sizeof(buffer));
+      fail_unless(ret == strlen(value) && strcmp(buffer, value) == 0, "Wrong data in synced file: [%d] [%s]", ret, buffer);
+   }
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handleCopy, "sync_key_0", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("modified") && strcmp(buffer, "modified") == 0, "Wrong data in synced file: [%d] [%s]", ret, buffer);
+   ret = persComDbGetKeySize(handleCopy, "sync_key_1");
+   fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key found in synced file: [%d]", ret);
+   ret = persComDbGetKeySize(handleCopy, "sync_key_tx");
+   fail_unless(ret == strlen("tx value"), "Transaction not in synced file: [%d]", ret);
+   ret = persComDbClose(handleCopy);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   //keys written after the last sync are written back by the close
+   ret = persComDbWriteKey(handle, "sync_key_last", "last", strlen("last"));
+   fail_unless(ret == strlen("last"), "Wrong write size: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/sync.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open existing lDB: retval: [%d]", handle);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "sync_key_last", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("last") && strcmp(buffer, "last") == 0, "Wrong data after close: [%d] [%s]", ret, buffer);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "sync_key_19", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("sync value 19") && strcmp(buffer, "sync value 19") == 0, "Wrong data after close: [%d] [%s]", ret, buffer);
+   ret = persComDbGetKeySize(handle, "sync_key_1");
+   fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key found after close: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   ret = persComDbSync(-1);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Invalid handle not detected: [%d]", ret);
+   ret = persComDbSync(handle);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Closed handle not detected: [%d]", ret);
+}
+END_TEST
+
+
+
+START_TEST(test_Snapshot)
+{
+   int ret = 0;
+   int handle = 0;
+   int handleCopy = 0;
+   int tx = 0;
+   int i = 0;
+   int fd = -1;
+   long fileSize = 0;
+   long copySize = 0;
+   char key[128] = { 0 };
+   char value[128] = { 0 };
+   char buffer[128] = { 0 };
+   static char growth[64 * 1024];
+
+   //Cleaning up testdata folder
+   remove("/tmp/snapshot.db");
+   remove("/tmp/snapshot.db.txlog");
+   remove("/tmp/snapshot-copy.db");
+
+   handle = persComDbOpen("/tmp/snapshot.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for(i=0; i < 20; i++)
+   {
+      snprintf(key, 128, "snapshot_key_%d", i);
+      snprintf(value, 128, "snapshot value %d", i);
+      ret = persComDbWriteKey(handle, key, value, strlen(value));
+      fail_unless(ret == strlen(value), "Wrong write size: [%d]", ret);
+   }
+   tx = persComDbTxBegin(handle);
+   fail_unless(tx >= 0, "Failed to begin transaction: [%d]", tx);
+   ret = persComDbTxPut(tx, "snapshot_key_tx", "tx value", strlen("tx value"));
+   fail_unless(ret == 0, "Failed to add put: [%d]", ret);
+   ret = persComDbTxCommit(tx);
+   fail_unless(ret == 1, "Failed to commit: [%d]", ret);
+
+   ret = persComDbSnapshot(handle, "/tmp/snapshot-copy.db");
+   fail_unless(ret == 0, "Failed to take snapshot: [%d]", ret);
+   ret = access("/tmp/snapshot-copy.db.tmp", F_OK);
+   fail_unless(ret != 0, "Temporary file of the snapshot not renamed");
+
+   //the writes after the snapshot are not in the copy
+   ret = persComDbWriteKey(handle, "snapshot_key_0", "modified", strlen("modified"));
+   fail_unless(ret == strlen("modified"), "Wrong write size: [%d]", ret);
+   ret = persComDbDeleteKey(handle, "snapshot_key_1");
+   fail_unless(ret >= 0, "Failed to delete key: [%d]", ret);
+
+   handleCopy = persComDbOpen("/tmp/snapshot-copy.db", 0x0);
+   fail_unless(handleCopy >= 0, "Failed to open snapshot: retval: [%d]", handleCopy);
+   for(i=0; i < 20; i++)
+   {
+      snprintf(key, 128, "snapshot_key_%d", i);
+      snprintf(value, 128, "snapshot value %d", i);
+      memset(buffer, 0, sizeof(buffer));
+      ret = persComDbReadKey(handleCopy, key, buffer, sizeof(buffer));
+      fail_unless(ret == strlen(value) && strcmp(buffer, value) == 0, "Wrong data in snapshot: [%d] [%s]", ret, buffer);
+   }
+   ret = persComDbGetKeySize(handleCopy, "snapshot_key_tx");
+   fail_unless(ret == strlen("tx value"), "Transaction not in snapshot: [%d]", ret);
+   ret = persComDbClose(handleCopy);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   //a new snapshot replaces the previous one
+   ret = persComDbSnapshot(handle, "/tmp/snapshot-copy.db");
+   fail_unless(ret == 0, "Failed to take snapshot: [%d]", ret);
+   handleCopy = persComDbOpen("/tmp/snapshot-copy.db", 0x0);
+   fail_unless(handleCopy >= 0, "Failed to open snapshot: retval: [%d]", handleCopy);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handleCopy, "snapshot_key_0", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("modified") && strcmp(buffer, "modified") == 0, "Wrong data in snapshot: [%d] [%s]", ret, buffer);
+   ret = persComDbGetKeySize(handleCopy, "snapshot_key_1");
+   fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Deleted key found in snapshot: [%d]", ret);
+   ret = persComDbClose(handleCopy);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   ret = persComDbSnapshot(handle, "/tmp/snapshot.db");
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Snapshot onto the database not detected: [%d]", ret);
+   ret = persComDbSnapshot(handle, NULL);
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Invalid path not detected: [%d]", ret);
+   ret = persComDbSnapshot(-1, "/tmp/snapshot-copy.db");
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Invalid handle not detected: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   //a read only instance copies the whole file, also when the file grew after the instance mapped it
+   handle = persComDbOpen("/tmp/snapshot.db", 0x4);
+   fail_unless(handle >= 0, "Failed to open existing lDB read only: retval: [%d]", handle);
+   fd = open("/tmp/snapshot.db", O_WRONLY | O_APPEND);
+   fail_unless(fd >= 0, "Database file not found");
+   ret = write(fd, growth, sizeof(growth));
+   fail_unless(ret == sizeof(growth), "Failed to grow database file");
+   fileSize = (long) lseek(fd, 0, SEEK_END);
+   close(fd);
+   ret = persComDbSnapshot(handle, "/tmp/snapshot-copy.db");
+   fail_unless(ret == 0, "Failed to take snapshot: [%d]", ret);
+   fd = open("/tmp/snapshot-copy.db", O_RDONLY);
+   fail_unless(fd >= 0, "Snapshot not found");
+   copySize = (long) lseek(fd, 0, SEEK_END);
+   close(fd);
+   fail_unless(copySize == fileSize, "Snapshot truncated: [%ld] [%ld]", copySize, fileSize);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+START_TEST(test_CrashedInstance)
+{
+   int ret = 0;
+   int handle = 0;
+   int handle2 = 0;
+   int status = 0;
+   pid_t pid;
+   char buffer[128] = { 0 };
+
+   //Cleaning up testdata folder
+   remove("/tmp/crashed-instance.db");
+   remove("/tmp/crashed-instance.db.txlog");
+
+   handle = persComDbOpen("/tmp/crashed-instance.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+
+   pid = fork();
+   fail_unless(pid >= 0, "fork failed");
+   if (pid == 0)
+   {
+      //the child ends without closing its instance of the database
+      int childHandle = persComDbOpen("/tmp/crashed-instance.db", 0x1);
+      if (   (childHandle < 0)
+          || (persComDbWriteKey(childHandle, "crashed_key", "crashed value", strlen("crashed value")) != strlen("crashed value")))
+      {
+         _exit(EXIT_FAILURE);
+      }
+      _exit(EXIT_SUCCESS);
+   }
+   ret = waitpid(pid, &status, 0);
+   fail_unless(ret == pid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS, "Child failed");
+
+   //the next instance releases the reference of the crashed instance
+   handle2 = persComDbOpen("/tmp/crashed-instance.db", 0x1);
+   fail_unless(handle2 >= 0, "Failed to open database: retval: [%d]", handle2);
+   ret = persComDbReadKey(handle2, "crashed_key", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("crashed value") && strcmp(buffer, "crashed value") == 0, "Wrong data: [%d] [%s]", ret, buffer);
+   ret = persComDbClose(handle2);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   fail_unless(access("/dev/shm/_tmp_crashed_instance_db-ht", F_OK) == 0, "Database closed while still in use");
+
+   //the last instance writes back the cache and removes the shared memory
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   fail_unless(access("/dev/shm/_tmp_crashed_instance_db-ht", F_OK) == -1, "Reference of the crashed instance not released");
+   fail_unless(access("/dev/shm/_tmp_crashed_instance_db-shm-info", F_OK) == -1, "Reference of the crashed instance not released");
+
+   handle = persComDbOpen("/tmp/crashed-instance.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open database: retval: [%d]", handle);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "crashed_key", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("crashed value") && strcmp(buffer, "crashed value") == 0, "Wrong data: [%d] [%s]", ret, buffer);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+static int gKeySizeQueuedRelease = 0;
+
+static void keySizeQueuedDone(signed int handlerDB, char const* key, signed int result, void* ctx)
+{
+   (void) handlerDB;
+   (void) key;
+   (void) result;
+   (void) ctx;
+
+   //keep the write worker busy, so the following writes stay in the queue
+   while (__atomic_load_n(&gKeySizeQueuedRelease, __ATOMIC_ACQUIRE) == 0)
+   {
+      usleep(1000);
+   }
+}
+
+START_TEST(test_GetKeySizeQueued)
+{
+   int ret = 0;
+   int handle = 0;
+   int i = 0;
+
+   //Cleaning up testdata folder
+   remove("/tmp/key-size-queued.db");
+   __atomic_store_n(&gKeySizeQueuedRelease, 0, __ATOMIC_RELEASE);
+
+   handle = persComDbOpen("/tmp/key-size-queued.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+
+   ret = persComDbWriteKeyAsync(handle, "queued_key_blocker", "blocker", strlen("blocker"), keySizeQueuedDone, NULL);
+   fail_unless(ret == 0, "Failed to queue write: [%d]", ret);
+   ret = persComDbWriteKeyAsync(handle, "queued_key", "queued value", strlen("queued value"), NULL, NULL);
+   fail_unless(ret == 0, "Failed to queue write: [%d]", ret);
+
+   //the size is taken from the queue, no lock of the database is taken or released
+   for(i=0; i < 100; i++)
+   {
+      ret = persComDbGetKeySize(handle, "queued_key");
+      fail_unless(ret == strlen("queued value"), "Wrong size of queued key: [%d]", ret);
+   }
+   ret = persComDbGetKeySize(handle + 1000, "queued_key");
+   fail_unless(ret == PERS_COM_ERR_INVALID_PARAM, "Invalid handle not detected: [%d]", ret);
+
+   __atomic_store_n(&gKeySizeQueuedRelease, 1, __ATOMIC_RELEASE);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/key-size-queued.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open existing lDB: retval: [%d]", handle);
+   ret = persComDbGetKeySize(handle, "queued_key");
+   fail_unless(ret == strlen("queued value"), "Wrong size of written key: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+START_TEST(test_TransactionPartial)
+{
+   int ret = 0;
+   int handle = 0;
+   int tx = 0;
+   int i = 0;
+   char key[128] = { 0 };
+   char buffer[128] = { 0 };
+   static char value[PERS_DB_MAX_SIZE_KEY_DATA];
+
+   //Cleaning up testdata folder
+   remove("/tmp/transaction-partial.db");
+   remove("/tmp/transaction-partial.db.txlog");
+   memset(value, 'x', sizeof(value));
+
+   handle = persComDbOpen("/tmp/transaction-partial.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   ret = persComDbWriteKey(handle, "tx_partial_a", "old", strlen("old"));
+   fail_unless(ret == strlen("old"), "Wrong write size: [%d]", ret);
+   //fill the cache
+   for(i=0; i < 100000; i++)
+   {
+      snprintf(key, 128, "tx_partial_fill_%d", i);
+      ret = persComDbWriteKey(handle, key, value, sizeof(value));
+      if (ret < 0)
+      {
+         break;
+      }
+   }
+   fail_unless(ret < 0, "Cache not full");
+
+   //the update fits into the cache, the insert does not: the commit fails and changes nothing
+   tx = persComDbTxBegin(handle);
+   fail_unless(tx >= 0, "Failed to begin transaction: [%d]", tx);
+   ret = persComDbTxPut(tx, "tx_partial_a", "new", strlen("new"));
+   fail_unless(ret == 0, "Failed to add put: [%d]", ret);
+   ret = persComDbTxPut(tx, "tx_partial_z", value, sizeof(value));
+   fail_unless(ret == 0, "Failed to add put: [%d]", ret);
+   ret = persComDbTxCommit(tx);
+   fail_unless(ret < 0, "Commit into a full cache succeeded: [%d]", ret);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "tx_partial_a", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("old") && strcmp(buffer, "old") == 0, "Failed commit partially applied: [%d] [%s]", ret, buffer);
+   ret = persComDbGetKeySize(handle, "tx_partial_z");
+   fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Failed commit partially applied: [%d]", ret);
+   ret = transactionFile("/tmp/transaction-partial.db.txlog", buffer, sizeof(buffer), 0);
+   fail_unless(ret <= 0, "Failed commit left in the log: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   handle = persComDbOpen("/tmp/transaction-partial.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open existing lDB: retval: [%d]", handle);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "tx_partial_a", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("old") && strcmp(buffer, "old") == 0, "Failed commit in the database file: [%d] [%s]", ret, buffer);
+   ret = persComDbGetKeySize(handle, "tx_partial_z");
+   fail_unless(ret == PERS_COM_ERR_NOT_FOUND, "Failed commit in the database file: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+}
+END_TEST
+
+
+
+START_TEST(test_TransactionLog)
+{
+   int ret = 0;
+   int handle = 0;
+   int tx = 0;
+   int i = 0;
+   int fd = -1;
+   long logSize = 0;
+   char key[128] = { 0 };
+   char buffer[128] = { 0 };
+   char version = 3;
+   unsigned long long txApplied = 0x5a5a5a5a5a5a5a5aULL;
+   static char value[4000];
+   static char log[16384];
+
+   //Cleaning up testdata folder
+   remove("/tmp/transaction-log.db");
+   remove("/tmp/transaction-log.db.txlog");
+   remove("/tmp/transaction-version.db");
+   remove("/tmp/transaction-version.db.txlog");
+   memset(value, 'v', sizeof(value));
+
+   //write cached: a commit writes the cache back when the log has grown beyond 256 KiB (PERS_LLDB_TXLOG_MAX_SIZE)
+   handle = persComDbOpen("/tmp/transaction-log.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   for(i=0; i < 200; i++)
+   {
+      tx = persComDbTxBegin(handle);
+      fail_unless(tx >= 0, "Failed to begin transaction: [%d]", tx);
+      snprintf(key, 128, "tx_log_key_%d", i % 10);
+      snprintf(value, 128, "tx log value %d", i);
+      ret = persComDbTxPut(tx, key, value, sizeof(value));
+      fail_unless(ret == 0, "Failed to add put: [%d]", ret);
+      ret = persComDbTxCommit(tx);
+      fail_unless(ret == 1, "Failed to commit: [%d]", ret);
+   }
+   fd = open("/tmp/transaction-log.db.txlog", O_RDONLY);
+   fail_unless(fd >= 0, "Log not found");
+   logSize = (long) lseek(fd, 0, SEEK_END);
+   close(fd);
+   fail_unless(logSize < 256 * 1024, "Log not emptied by the write back: [%ld]", logSize);
+   ret = persComDbGetKeySize(handle, "tx_log_key_9");
+   fail_unless(ret == sizeof(value), "Wrong size after commit: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   //record of a transaction to replay
+   handle = persComDbOpen("/tmp/transaction-log.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open existing lDB: retval: [%d]", handle);
+   tx = persComDbTxBegin(handle);
+   fail_unless(tx >= 0, "Failed to begin transaction: [%d]", tx);
+   ret = persComDbTxPut(tx, "tx_version_key", "replayed", strlen("replayed"));
+   fail_unless(ret == 0, "Failed to add put: [%d]", ret);
+   ret = persComDbTxCommit(tx);
+   fail_unless(ret == 1, "Failed to commit: [%d]", ret);
+   logSize = transactionFile("/tmp/transaction-log.db.txlog", log, sizeof(log), 0);
+   fail_unless(logSize > 0, "Transaction not in the log: [%ld]", logSize);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+
+   //a database file of version 2.3 has no sequence number of the log in its header, the bytes were padding
+   handle = persComDbOpen("/tmp/transaction-version.db", 0x1);
+   fail_unless(handle >= 0, "Failed to create non existent lDB: retval: [%d]", handle);
+   ret = persComDbWriteKey(handle, "version_key", "value", strlen("value"));
+   fail_unless(ret == strlen("value"), "Wrong write size: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   fd = open("/tmp/transaction-version.db", O_RDWR);
+   fail_unless(fd >= 0, "Database file not found");
+   ret = pwrite(fd, &version, 1, 5); //minor version
+   fail_unless(ret == 1, "Failed to write version");
+   ret = pwrite(fd, &txApplied, sizeof(txApplied), 64); //sequence number of the last record applied
+   fail_unless(ret == sizeof(txApplied), "Failed to write padding");
+   close(fd);
+   transactionFile("/tmp/transaction-version.db.txlog", log, logSize, 1);
+
+   handle = persComDbOpen("/tmp/transaction-version.db", 0x0);
+   fail_unless(handle >= 0, "Failed to open lDB of version 2.3: retval: [%d]", handle);
+   memset(buffer, 0, sizeof(buffer));
+   ret = persComDbReadKey(handle, "tx_version_key", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("replayed") && strcmp(buffer, "replayed") == 0, "Record not replayed: [%d] [%s]", ret, buffer);
+   ret = persComDbReadKey(handle, "version_key", buffer, sizeof(buffer));
+   fail_unless(ret == strlen("value"), "Wrong data after conversion: [%d]", ret);
+   ret = persComDbClose(handle);
+   fail_unless(ret == 0, "Failed to close database: retval: [%d]", ret);
+   fd = open("/tmp/transaction-version.db", O_RDONLY);
+   fail_unless(fd >= 0, "Database file not found");
+   ret = pread(fd, &version, 1, 5);
+   close(fd);
+   fail_unless(ret == 1 && version == 4, "Database file not converted: [%d]", version);
+}
+END_TEST
+
+
+
+static Suite* persistenceCommonLib_suite()
+{
+   Suite* s = suite_create("Persistence-common-object-test");
+
+   TCase* tc_persOpenLocalDB = tcase_create("OpenlocalDB");
+   tcase_add_test(tc_persOpenLocalDB, test_OpenLocalDB);
+
+   TCase* tc_persOpenRCT = tcase_create("OpenRCT");
+   tcase_add_test(tc_persOpenRCT, test_OpenRCT);
+
+   TCase* tc_persSetDataLocalDB = tcase_create("SetDataLocalDB");
+   tcase_add_test(tc_persSetDataLocalDB, test_SetDataLocalDB);
+
+   TCase* tc_persGetDataLocalDB = tcase_create("GetDataLocalDB");
+   tcase_add_test(tc_persGetDataLocalDB, test_GetDataLocalDB);
+
+   TCase* tc_persSetDataRCT = tcase_create("SetDataRCT");
+   tcase_add_test(tc_persSetDataRCT, test_SetDataRCT);
+
+   TCase* tc_persGetDataRCT = tcase_create("GetDataRCT");
+   tcase_add_test(tc_persGetDataRCT, test_GetDataRCT);
+
+   TCase* tc_persGetDataSize = tcase_create("GetDataSize");
+   tcase_add_test(tc_persGetDataSize, test_GetDataSize);
+
+   TCase* tc_persDeleteDataLocalDB = tcase_create("DeleteDataLocalDB");
+   tcase_add_test(tc_persDeleteDataLocalDB, test_DeleteDataLocalDB);
+
+   TCase* tc_persDeleteDataRct = tcase_create("DeleteDataRct");
+   tcase_add_test(tc_persDeleteDataRct, test_DeleteDataRct);
+
+   TCase* tc_persGetKeyListSizeLocalDB = tcase_create("GetKeyListSizeLocalDb");
+   tcase_add_test(tc_persGetKeyListSizeLocalDB, test_GetKeyListSizeLocalDB);
+
+   TCase* tc_persGetKeyListLocalDB = tcase_create("GetKeyListLocalDb");
+   tcase_add_test(tc_persGetKeyListLocalDB, test_GetKeyListLocalDB);
+
+   TCase* tc_persGetResourceListSizeRct = tcase_create("GetResourceListSizeRct");
+   tcase_add_test(tc_persGetResourceListSizeRct, test_GetResourceListSizeRct);
+
+   TCase* tc_persGetResourceListRct = tcase_create("GetResourceListRct");
+   tcase_add_test(tc_persGetResourceListRct, test_GetResourceListRct);
+
+   TCase* tc_persCacheSize = tcase_create("CacheSize");
+   tcase_add_test(tc_persCacheSize, test_CacheSize);
+   tcase_set_timeout(tc_persCacheSize, 20);
+
+   TCase* tc_QhasharrUpdateFull = tcase_create("QhasharrUpdateFull");
+   tcase_add_test(tc_QhasharrUpdateFull, test_QhasharrUpdateFull);
+
+   TCase* tc_QhasharrRelocateCollision = tcase_create("QhasharrRelocateCollision");
+   tcase_add_test(tc_QhasharrRelocateCollision, test_QhasharrRelocateCollision);
+
+   TCase* tc_persCachedConcurrentAccess = tcase_create("CachedConcurrentAccess");
+   tcase_add_test(tc_persCachedConcurrentAccess, test_CachedConcurrentAccess);
+   tcase_set_timeout(tc_persCachedConcurrentAccess, 20);
+
+   TCase* tc_persCachedConcurrentAccess2 = tcase_create("CachedConcurrentAccess2");
+   tcase_add_test(tc_persCachedConcurrentAccess2, test_CachedConcurrentAccess2);
+   tcase_set_timeout(tc_persCachedConcurrentAccess2, 20);
+
+   TCase* tc_ConcurrentOpenClose = tcase_create("ConcurrentOpenClose");
+   tcase_add_test(tc_ConcurrentOpenClose, test_ConcurrentOpenClose);
+   tcase_set_timeout(tc_ConcurrentOpenClose, 60);
+
+   TCase* tc_BadParameters = tcase_create("BadParameters");
+   tcase_add_test(tc_BadParameters, test_BadParameters);
+
+   TCase* tc_RebuildHashtables = tcase_create("RebuildHashtables");
+   tcase_add_test(tc_RebuildHashtables, test_RebuildHashtables);
+
+   TCase* tc_RecoverDatablocks = tcase_create("RecoverDatablocks");
+   tcase_add_test(tc_RecoverDatablocks, test_RecoverDatablocks);
+
+   TCase* tc_LinkedDatabase = tcase_create("LinkedDatabase");
+   tcase_add_test(tc_LinkedDatabase, test_LinkedDatabase);
+
+   TCase* tc_ReadOnlyDatabase = tcase_create("ReadOnlyDatabase");
+   tcase_add_test(tc_ReadOnlyDatabase, test_ReadOnlyDatabase);
+
+   TCase* tc_MultipleWrites = tcase_create("MultipleWrites");
+   tcase_add_test(tc_MultipleWrites, test_MultipleWrites);
+
+   TCase* tc_WriteThrough = tcase_create("WriteThrough");
+   tcase_add_test(tc_WriteThrough, test_WriteThrough);
+   tcase_set_timeout(tc_WriteThrough, 20);
+
+   TCase* tc_AddKey_DeleteKey_AddShorterKeyName = tcase_create("AddKey_DeleteKey_AddShorterKeyName");
+   tcase_add_test(tc_AddKey_DeleteKey_AddShorterKeyName, test_AddKey_DeleteKey_AddShorterKeyName);
+   tcase_set_timeout(tc_AddKey_DeleteKey_AddShorterKeyName, 60);
+
+   TCase* tc_Compare_RCT = tcase_create("Compare_RCT");
+   tcase_add_test(tc_Compare_RCT, test_Compare_RCT);
+
+   TCase* tc_PreparedKey = tcase_create("PreparedKey");
+   tcase_add_test(tc_PreparedKey, test_PreparedKey);
+
+   TCase* tc_NegativeLookup = tcase_create("NegativeLookup");
+   tcase_add_test(tc_NegativeLookup, test_NegativeLookup);
+
+   TCase* tc_PrivateMode = tcase_create("PrivateMode");
+   tcase_add_test(tc_PrivateMode, test_PrivateMode);
+
+   TCase* tc_HandleTable = tcase_create("HandleTable");
+   tcase_add_test(tc_HandleTable, test_HandleTable);
+
+   TCase* tc_MultiKey = tcase_create("MultiKey");
+   tcase_add_test(tc_MultiKey, test_MultiKey);
+
+   TCase* tc_ForEach = tcase_create("ForEach");
+   tcase_add_test(tc_ForEach, test_ForEach);
+
+   TCase* tc_KeyDirectory = tcase_create("KeyDirectory");
+   tcase_add_test(tc_KeyDirectory, test_KeyDirectory);
+
+   TCase* tc_ListKeysPage = tcase_create("ListKeysPage");
+   tcase_add_test(tc_ListKeysPage, test_ListKeysPage);
+
+   TCase* tc_ReadKeyAlloc = tcase_create("ReadKeyAlloc");
+   tcase_add_test(tc_ReadKeyAlloc, test_ReadKeyAlloc);
+
+   TCase* tc_WriteKeyAsync = tcase_create("WriteKeyAsync");
+   tcase_add_test(tc_WriteKeyAsync, test_WriteKeyAsync);
+
+   TCase* tc_Transaction = tcase_create("Transaction");
+   tcase_add_test(tc_Transaction, test_Transaction);
+
+   TCase* tc_Sync = tcase_create("Sync");
+   tcase_add_test(tc_Sync, test_Sync);
+
+   TCase* tc_Snapshot = tcase_create("Snapshot");
+   tcase_add_test(tc_Snapshot, test_Snapshot);
+
+   TCase* tc_CrashedInstance = tcase_create("CrashedInstance");
+   tcase_add_test(tc_CrashedInstance, test_CrashedInstance);
+
+   TCase* tc_GetKeySizeQueued = tcase_create("GetKeySizeQueued");
+   tcase_add_test(tc_GetKeySizeQueued, test_GetKeySizeQueued);
+
+   TCase* tc_TransactionPartial = tcase_create("TransactionPartial");
+   tcase_add_test(tc_TransactionPartial, test_TransactionPartial);
+
+   TCase* tc_TransactionLog = tcase_create("TransactionLog");
+   tcase_add_test(tc_TransactionLog, test_TransactionLog);
+
+#if 1
+   suite_add_tcase(s, tc_persOpenLocalDB);
+   tcase_add_checked_fixture(tc_persOpenLocalDB, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persOpenRCT);
+   tcase_add_checked_fixture(tc_persOpenRCT, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persSetDataLocalDB);
+   tcase_add_checked_fixture(tc_persSetDataLocalDB, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persGetDataLocalDB);
+   tcase_add_checked_fixture(tc_persGetDataLocalDB, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persSetDataRCT);
+   tcase_add_checked_fixture(tc_persSetDataRCT, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persGetDataRCT);
+   tcase_add_checked_fixture(tc_persGetDataRCT, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persGetDataSize);
+   tcase_add_checked_fixture(tc_persGetDataSize, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persDeleteDataLocalDB);
+   tcase_add_checked_fixture(tc_persDeleteDataLocalDB, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persDeleteDataRct);
+   tcase_add_checked_fixture(tc_persDeleteDataRct, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persGetKeyListSizeLocalDB);
+   tcase_add_checked_fixture(tc_persGetKeyListSizeLocalDB, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persGetKeyListLocalDB);
+   tcase_add_checked_fixture(tc_persGetKeyListLocalDB, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persGetResourceListSizeRct);
+   tcase_add_checked_fixture(tc_persGetResourceListSizeRct, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persGetResourceListRct);
+   tcase_add_checked_fixture(tc_persGetResourceListRct, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persCacheSize);     //do not run when using writethrough
+   tcase_add_checked_fixture(tc_persCacheSize, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_QhasharrUpdateFull);
+   tcase_add_checked_fixture(tc_QhasharrUpdateFull, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_QhasharrRelocateCollision);
+   tcase_add_checked_fixture(tc_QhasharrRelocateCollision, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persCachedConcurrentAccess);
+   tcase_add_checked_fixture(tc_persCachedConcurrentAccess, data_setup_thread, data_teardown_thread);
+   suite_add_tcase(s, tc_persCachedConcurrentAccess2);
+   tcase_add_checked_fixture(tc_persCachedConcurrentAccess2, data_setup_thread, data_teardown_thread);
+
+   suite_add_tcase(s, tc_ConcurrentOpenClose);
+   tcase_add_checked_fixture(tc_ConcurrentOpenClose, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_BadParameters);
+   tcase_add_checked_fixture(tc_BadParameters, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_RebuildHashtables);
+   tcase_add_checked_fixture(tc_RebuildHashtables, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_RecoverDatablocks); //add test for writethrough (writeback order is different when using cache)
+   tcase_add_checked_fixture(tc_RecoverDatablocks, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_LinkedDatabase);
+   tcase_add_checked_fixture(tc_LinkedDatabase, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_ReadOnlyDatabase);
+   tcase_add_checked_fixture(tc_ReadOnlyDatabase, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_MultipleWrites);
+   tcase_add_checked_fixture(tc_MultipleWrites, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_WriteThrough);
+   tcase_add_checked_fixture(tc_WriteThrough, data_setup_thread, data_teardown_thread);
+
+   suite_add_tcase(s, tc_AddKey_DeleteKey_AddShorterKeyName);
+
+   suite_add_tcase(s, tc_Compare_RCT);
+
+   suite_add_tcase(s, tc_PreparedKey);
+   tcase_add_checked_fixture(tc_PreparedKey, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_NegativeLookup);
+   tcase_add_checked_fixture(tc_NegativeLookup, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_PrivateMode);
+   tcase_add_checked_fixture(tc_PrivateMode, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_HandleTable);
+   tcase_add_checked_fixture(tc_HandleTable, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_MultiKey);
+   tcase_add_checked_fixture(tc_MultiKey, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_ForEach);
+   tcase_add_checked_fixture(tc_ForEach, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_KeyDirectory);
+   tcase_add_checked_fixture(tc_KeyDirectory, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_ListKeysPage);
+   tcase_add_checked_fixture(tc_ListKeysPage, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_ReadKeyAlloc);
+   tcase_add_checked_fixture(tc_ReadKeyAlloc, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_WriteKeyAsync);
+   tcase_add_checked_fixture(tc_WriteKeyAsync, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_Transaction);
+   tcase_add_checked_fixture(tc_Transaction, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_Sync);
+   tcase_add_checked_fixture(tc_Sync, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_Snapshot);
+   tcase_add_checked_fixture(tc_Snapshot, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_CrashedInstance);
+   tcase_add_checked_fixture(tc_CrashedInstance, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_GetKeySizeQueued);
+   tcase_add_checked_fixture(tc_GetKeySizeQueued, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_TransactionPartial);
+   tcase_add_checked_fixture(tc_TransactionPartial, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_TransactionLog);
+   tcase_add_checked_fixture(tc_TransactionLog, data_setup, data_teardown);
 #else
 
 
@@ -0,0 +1,142 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+/**
+* @file           pers_kvs_slowlog.c
+* @ingroup        Persistence key value store
+* @brief          Dumps the slow operation log of processes using the key value store
+* @see
+*
+* The log of a process is the shared memory "/pers-lldb-slowops-<pid>", it is created by
+* the library built with --with-slowoplog on the first slow operation and kept after the
+* process ends.
+*
+* Usage: pers-kvs-slowlog [-u] <pid> [<pid> ...]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pers_lldb_trace.h"
+
+
+static const char* const gOpNames[] = { "?", "open", "close", "read", "write", "delete", "size", "list", "commit", "sync", "snapshot" };
+
+
+static void printFlags(uint8_t flags)
+{
+   printf("%s%s%s%s", (flags & LLDB_OP_FLAG_CACHE) ? " cache" : "", (flags & LLDB_OP_FLAG_FILE) ? " file" : "",
+          (flags & LLDB_OP_FLAG_REMAP) ? " remap" : "", (flags & LLDB_OP_FLAG_GROWTH) ? " growth" : "");
+}
+
+
+static int dumpLog(const char* name)
+{
+   LldbSlowOpRing_s* ring;
+   uint64_t head, seq;
+   int fd;
+
+   fd = shm_open(name, O_RDONLY, 0);
+   if (fd < 0)
+   {
+      return -1;
+   }
+   ring = (LldbSlowOpRing_s*) mmap(NULL, sizeof(LldbSlowOpRing_s), PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (ring == MAP_FAILED)
+   {
+      return -1;
+   }
+   if (ring->magic != LLDB_SLOW_OP_MAGIC || ring->version != LLDB_SLOW_OP_VERSION || ring->entryCount != PERS_LLDB_SLOW_OP_ENTRIES)
+   {
+      fprintf(stderr, "%s: unknown layout of the slow operation log\n", name);
+      munmap(ring, sizeof(LldbSlowOpRing_s));
+      return -1;
+   }
+
+   head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+   printf("pid %u, threshold %u us, %llu slow operations\n", (unsigned) ring->pid, (unsigned) ring->thresholdUs, (unsigned long long) head);
+   for (seq = (head > PERS_LLDB_SLOW_OP_ENTRIES) ? head - PERS_LLDB_SLOW_OP_ENTRIES : 0; seq < head; seq++)
+   {
+      const LldbSlowOpEntry_s* entry = &ring->entries[seq & (PERS_LLDB_SLOW_OP_ENTRIES - 1)];
+      LldbSlowOpEntry_s copy;
+
+      memcpy(&copy, entry, sizeof(copy));
+      if (__atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE) != seq + 1 || copy.seq != seq + 1) //being overwritten
+      {
+         continue;
+      }
+      copy.path[sizeof(copy.path) - 1] = '\0';
+      copy.key[sizeof(copy.key) - 1] = '\0';
+      printf("  %llu.%06llu tid %u %-6s %8.3f ms (lock wait %.3f ms) size %d",
+             (unsigned long long) (copy.timestampNs / 1000000000ULL), (unsigned long long) ((copy.timestampNs / 1000ULL) % 1000000ULL),
+             (unsigned) copy.tid, gOpNames[(copy.op < (sizeof(gOpNames) / sizeof(gOpNames[0]))) ? copy.op : 0],
+             copy.durationNs / 1000000.0, copy.lockWaitNs / 1000000.0, (int) copy.size);
+      printFlags(copy.flags);
+      printf(" %s%s%s%s\n", copy.path, (copy.key[0] != '\0') ? " <" : "", copy.key, (copy.key[0] != '\0') ? ">" : "");
+   }
+   munmap(ring, sizeof(LldbSlowOpRing_s));
+   return 0;
+}
+
+
+static void usage(const char* prog)
+{
+   fprintf(stderr, "Usage: %s [-u] <pid> [<pid> ...]\n", prog);
+   fprintf(stderr, "  -u  remove the log after it is printed\n");
+}
+
+
+int main(int argc, char* argv[])
+{
+   char name[64];
+   int unlinkLog = 0;
+   int opt, i;
+   int found = 0;
+
+   while ((opt = getopt(argc, argv, "uh")) != -1)
+   {
+      switch (opt)
+      {
+         case 'u':
+            unlinkLog = 1;
+            break;
+         default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+      }
+   }
+   if (optind >= argc)
+   {
+      usage(argv[0]);
+      return 1;
+   }
+
+   for (i = optind; i < argc; i++)
+   {
+      (void) snprintf(name, sizeof(name), "/pers-lldb-slowops-%d", atoi(argv[i]));
+      if (dumpLog(name) != 0)
+      {
+         fprintf(stderr, "%s: no slow operation log for pid %s\n", argv[0], argv[i]);
+         continue;
+      }
+      found++;
+      if (unlinkLog)
+      {
+         (void) shm_unlink(name);
+      }
+   }
+   return (found > 0) ? 0 : 1;
+}
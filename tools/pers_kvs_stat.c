@@ -0,0 +1,224 @@
+/******************************************************************************
+ * Project         Persistence key value store
+ * (c) copyright   2014
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+/**
+* @file           pers_kvs_stat.c
+* @ingroup        Persistence key value store
+* @brief          Prints the performance counters of opened key value store databases
+* @see
+*
+* The counters are read live from the shared information of the database
+* (shared memory "-shm-info" or the shared memory arena), the database must be
+* opened by at least one process. Databases opened in process private mode
+* have no shared information. The lock profile is only printed if the library
+* is built with --enable-lockprofile.
+*
+* Usage: pers-kvs-stat [-i interval] [-n count] <database path> [<database path> ...]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "database/kissdb.h"
+
+
+static void printHistogram(const char* name, const uint64_t* hist)
+{
+   int i;
+
+   printf("    %-5s", name);
+   for (i = 0; i < KDB_LOCK_HIST_BUCKETS; i++)
+   {
+      uint64_t n = __atomic_load_n(&hist[i], __ATOMIC_RELAXED);
+
+      if (n > 0)
+      {
+         if (i == 0)
+         {
+            printf("  <1us:%llu", (unsigned long long) n);
+         }
+         else if (i == KDB_LOCK_HIST_BUCKETS - 1)
+         {
+            printf("  >=%lluus:%llu", 1ULL << (i - 1), (unsigned long long) n);
+         }
+         else
+         {
+            printf("  <%lluus:%llu", 1ULL << i, (unsigned long long) n);
+         }
+      }
+   }
+   printf("\n");
+}
+
+
+static void printLockProfile(Shared_Data_s* shared)
+{
+   static const char* lockNames[KDB_LOCK_COUNT] = { "rwlock", "mutex", "semaphore" };
+   int lock, i;
+
+   for (lock = 0; lock < KDB_LOCK_COUNT; lock++)
+   {
+      Kdb_lock_prof_s* prof = &shared->stats.locks[lock];
+      uint64_t acquisitions = KDB_STAT_GET(prof, acquisitions);
+      uint32_t holder = __atomic_load_n(&prof->holderPid, __ATOMIC_RELAXED);
+
+      if (acquisitions == 0) //not compiled with the lock profile or never used
+      {
+         continue;
+      }
+      printf("  lock %-10s %12llu acquisitions  (avg wait %.1f us, avg hold %.1f us)\n", lockNames[lock], (unsigned long long) acquisitions,
+             (KDB_STAT_GET(prof, waitNs) / 1000.0) / acquisitions, (KDB_STAT_GET(prof, holdNs) / 1000.0) / acquisitions);
+      printHistogram("wait", prof->waitHist);
+      printHistogram("hold", prof->holdHist);
+      if (holder != 0)
+      {
+         printf("    held by pid %u tid %u\n", (unsigned) holder, (unsigned) prof->holderTid);
+      }
+      for (i = 0; i < KDB_LOCK_TOP_HOLDERS; i++)
+      {
+         if (prof->longest[i].holdNs > 0)
+         {
+            printf("    longest hold %.1f us by pid %u tid %u\n", prof->longest[i].holdNs / 1000.0,
+                   (unsigned) prof->longest[i].pid, (unsigned) prof->longest[i].tid);
+         }
+      }
+   }
+}
+
+
+static void printStats(const char* path, Shared_Data_s* shared)
+{
+   Kdb_stats_s* stats = &shared->stats;
+   uint64_t hits = KDB_STAT_GET(stats, cacheHits);
+   uint64_t misses = KDB_STAT_GET(stats, cacheMisses);
+   uint64_t slotsUsed = KDB_STAT_GET(stats, cacheSlotsUsed);
+   uint64_t slotsMax = KDB_STAT_GET(stats, cacheSlotsMax);
+   uint64_t lockWaits = KDB_STAT_GET(stats, lockWaits);
+   uint64_t writebacks = KDB_STAT_GET(stats, writebacks);
+
+   printf("%s (%s, %s, %u instances)\n", path,
+          (shared->writeMode == KISSDB_WRITE_MODE_WT) ? "write through" : "write cached",
+          (shared->openMode == KISSDB_OPEN_MODE_RDONLY) ? "read only" : "read/write", (unsigned) shared->refCount);
+   printf("  reads              %12llu\n", (unsigned long long) KDB_STAT_GET(stats, reads));
+   printf("  writes             %12llu\n", (unsigned long long) KDB_STAT_GET(stats, writes));
+   printf("  deletes            %12llu\n", (unsigned long long) KDB_STAT_GET(stats, deletes));
+   printf("  cache hits         %12llu  (%.1f %%)\n", (unsigned long long) hits,
+          (hits + misses) ? (100.0 * hits) / (hits + misses) : 0.0);
+   printf("  cache misses       %12llu\n", (unsigned long long) misses);
+   printf("  cache slots        %12llu / %llu  (%.1f %%)\n", (unsigned long long) slotsUsed, (unsigned long long) slotsMax,
+          slotsMax ? (100.0 * slotsUsed) / slotsMax : 0.0);
+   printf("  cache full         %12llu\n", (unsigned long long) KDB_STAT_GET(stats, cacheFull));
+   printf("  file bytes written %12llu\n", (unsigned long long) KDB_STAT_GET(stats, fileBytesWritten));
+   printf("  remaps             %12llu\n", (unsigned long long) KDB_STAT_GET(stats, remaps));
+   printf("  lock waits         %12llu  (avg %.1f us)\n", (unsigned long long) lockWaits,
+          lockWaits ? (KDB_STAT_GET(stats, lockWaitNs) / 1000.0) / lockWaits : 0.0);
+   printf("  writebacks         %12llu  (avg %.1f ms)\n", (unsigned long long) writebacks,
+          writebacks ? (KDB_STAT_GET(stats, writebackNs) / 1000000.0) / writebacks : 0.0);
+   printf("  recoveries         %12llu  (last open: check %.3f ms, verify %.3f ms, rebuild %.3f ms, data blocks %.3f ms, bloom filter %.3f ms)\n",
+          (unsigned long long) KDB_STAT_GET(stats, recoveries),
+          KDB_STAT_GET(stats, recoveryNs[KDB_RECOVERY_CHECK_FLAGS]) / 1000000.0,
+          KDB_STAT_GET(stats, recoveryNs[KDB_RECOVERY_VERIFY_HASHTABLES]) / 1000000.0,
+          KDB_STAT_GET(stats, recoveryNs[KDB_RECOVERY_REBUILD_HASHTABLES]) / 1000000.0,
+          KDB_STAT_GET(stats, recoveryNs[KDB_RECOVERY_DATABLOCKS]) / 1000000.0,
+          KDB_STAT_GET(stats, recoveryNs[KDB_RECOVERY_BLOOM_FILTER]) / 1000000.0);
+   printLockProfile(shared);
+}
+
+
+static void usage(const char* prog)
+{
+   fprintf(stderr, "Usage: %s [-i interval] [-n count] <database path> [<database path> ...]\n", prog);
+   fprintf(stderr, "  -i interval  print the counters every interval seconds\n");
+   fprintf(stderr, "  -n count     stop after count outputs (default 1, or endless with -i)\n");
+}
+
+
+int main(int argc, char* argv[])
+{
+   char linkBuffer[256];
+   Shared_Data_s** shared;
+   int interval = 0;
+   int count = -1;
+   int opt, i, n;
+   int found = 0;
+
+   while ((opt = getopt(argc, argv, "i:n:h")) != -1)
+   {
+      switch (opt)
+      {
+         case 'i':
+            interval = atoi(optarg);
+            break;
+         case 'n':
+            count = atoi(optarg);
+            break;
+         default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+      }
+   }
+   if (optind >= argc)
+   {
+      usage(argv[0]);
+      return 1;
+   }
+   if (count < 0)
+   {
+      count = (interval > 0) ? 0 : 1;
+   }
+
+   shared = (Shared_Data_s**) calloc(argc - optind, sizeof(Shared_Data_s*));
+   if (shared == NULL)
+   {
+      return 1;
+   }
+   for (i = optind; i < argc; i++)
+   {
+      const char* path = argv[i];
+
+      //same path resolution as at open of the database
+      memset(linkBuffer, 0, sizeof(linkBuffer));
+      if (checkIsLink(argv[i], linkBuffer) == 1)
+      {
+         path = linkBuffer;
+      }
+      shared[i - optind] = kdbSharedInfoLookup(path);
+      if (shared[i - optind] == NULL)
+      {
+         fprintf(stderr, "%s: no shared information (database not opened or opened in process private mode)\n", argv[i]);
+      }
+      else
+      {
+         found++;
+      }
+   }
+
+   for (n = 0; found > 0 && (count == 0 || n < count); n++)
+   {
+      if (n > 0)
+      {
+         sleep(interval);
+         printf("\n");
+      }
+      for (i = optind; i < argc; i++)
+      {
+         if (shared[i - optind] != NULL)
+         {
+            printStats(argv[i], shared[i - optind]);
+         }
+      }
+      fflush(stdout);
+   }
+
+   free(shared);
+   return (found > 0) ? 0 : 1;
+}